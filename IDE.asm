@@ -16,7 +16,15 @@
 ;    CalculatePhysical - calculates physical address from segment/offset
 ;    CheckIDEBusy      - checks if the IDE is busy
 ;    SetupDMA          - sets up the DMA control registers
+;    IssueReadCommand  - starts the next READ SECTORS command of a request
+;    Get_Blocks_Start  - starts an asynchronous read of blocks from IDE
+;    Get_Blocks_Poll   - checks if an asynchronous read is done
 ;    Get_Blocks        - retrieves number of blocks from IDE
+;    IDEEH             - IDE INTRQ event handler, starts sector DMA
+;    IDEDMAEH          - DMA0 terminal count event handler
+;    IDETimerTick      - retries held back commands and times out requests
+;    IDEAbort          - ends the current request early
+;    InitIDE           - initializes IDE variables and interrupts
 
 ; Revision History:
 ;    5/8/16    Tim Liu    Created file
@@ -31,11 +39,20 @@
 ;    5/17/16   Tim Liu    Rewrote Get_blocks to use a loop
 ;    5/17/16   Tim Liu    Wrote SetupDMA function
 ;    5/17/16   Tim Liu    Updated comments
+;    6/6/16    Tim Liu    Get_Blocks reads a run with one multi-sector command
+;    6/7/16    Tim Liu    Added asynchronous Get_Blocks_Start/Get_Blocks_Poll
+;                         driven by IDE INTRQ and DMA terminal count
+;    6/8/16    Tim Liu    Removed CheckIDEBusy spin loops, added timeout
+;    6/16/16   Tim Liu    IDEAbort resets the IDE (SRST) so a timed out
+;                         command doesn't leave the drive stuck busy
+;    6/17/16   Tim Liu    IDEAbort only resets the IDE if IDEUseSRST is set,
+;                         otherwise it just ends the request
 ;    
 
 
 ; local include files
 $INCLUDE(IDE.INC)
+$INCLUDE(MIRQ.INC)
 $INCLUDE(GENERAL.INC)
 
 CGROUP    GROUP    CODE
@@ -177,24 +194,22 @@ CalculatePhysical    ENDP
 ;Name:               CheckIDEBusy
 ;
 ;Description:        This function checks the IDE to see if it is busy.
-;                    The function loops repeatedly checking the IDE until
-;                    it is no longer busy. The function does not return
-;                    until the IDE is ready. 
+;                    The function reads the status register once and
+;                    returns whether the IDE is ready. The function does
+;                    not wait for the IDE, so a slow or stuck drive never
+;                    holds up the caller.
 ; 
 ;Operation:          The function loads the segment of the IDE status register
 ;                    into ES and the offset into SI. The function then
 ;                    reads the IDE status register and masks the bits with
 ;                    IDEBitMask which is passed through DH. The function
-;                    then compares the result to ReadyMask passed in DL.
-;                    If the value is the same, then the
-;                    function returns and restores the registers. If the
-;                    IDE status register is not ready, then the function
-;                    loops repeatedly until the IDE is ready.
+;                    then compares the result to ReadyMask passed in DL
+;                    and returns with the zero flag set if they are equal.
 ;
 ;Arguments:          ReadyMask (DL)  - bit pattern indicating ready
 ;                    IDEBitMask (DH) - bit mask ANDed with the status register
 ;
-;Return Values:      None
+;Return Values:      ZF - set if the IDE is ready, reset if it is busy
 ;
 ;Local Variables:    None
 ;
@@ -206,15 +221,15 @@ CalculatePhysical    ENDP
 ;
 ;Algorithms:         None
 ;
-;Registers Used:     None
+;Registers Used:     flags
 ;
 ;Known Bugs:         None
 ;
-;Limitations:        None
-;
+;Limitations:        None
+;
 ;Author:             Timothy Liu
-;
-;Last Modified       5/17/16
+;
+;Last Modified       6/8/16
 
 CheckIDEBusy    PROC    NEAR
 
@@ -228,12 +243,11 @@ CheckIDEBusyAddress:                    ;set up address of status register
     MOV  ES, BX                         ;segment of the IDE Status register
     MOV  SI, IDEStatusOffset            ;offset of the IDE status register
 
-CheckIDEBusyLoop:                       ;loop reading the status register
+CheckIDEBusyRead:                       ;read the status register once
     MOV  BL, ES:[SI]                    ;read the status register
     AND  BL, DH                         ;bit mask passed in DH
     CMP  BL, DL                         ;check if the register is ready
-    JE   CheckIDEBusyDone               ;IDE ready - done
-    JMP  CheckIDEBusyLoop               ;otherwise keep looping until ready
+                                        ;ZF set if ready
 
 CheckIDEBusyDone:
     POP   BX
@@ -247,11 +261,12 @@ CheckIDEBusy    ENDP
 ;Name:               SetupDMA
 ;
 ;Description:        This writes to 5 DMA control registers to set
-;                    up a DMA transfer.
+;                    up a DMA transfer of one sector to the current
+;                    destination of the IDE request.
 ; 
 ;Operation:          The function first calculates the physical
-;                    address of the destination pointer by calling
-;                    the function CalculatePhysical. The function
+;                    address of the destination pointer (Request.ReqDestOff)
+;                    by calling the function CalculatePhysical. The function
 ;                    then writes to D0STL, D0SRCH, D0SRCL, and D0TC.
 ;                    The function restores all registers and returns
 ;
@@ -261,7 +276,7 @@ CheckIDEBusy    ENDP
 ;
 ;Local Variables:    None
 ;
-;Shared Variables:   None
+;Shared Variables:   Request (R) - destination of the IDE request
 ;
 ;Output:             None
 ;
@@ -273,11 +288,11 @@ CheckIDEBusy    ENDP
 ;
 ;Known Bugs:         None
 ;
-;Limitations:        None
-;
+;Limitations:        None
+;
 ;Author:             Timothy Liu
 ;
-;Last Modified:      5/17/16
+;Last Modified:      6/7/16
 
 SetupDMA        PROC    NEAR
 
@@ -290,10 +305,9 @@ SetupDMAStart:                                ;save registers
     PUSH    ES
 
 SetupDMAWrite:                                ;write to DMA control registers
-    MOV   AX, SS                              ;copy stack segment to ES
+    MOV   AX, DS                              ;request is in the data segment
     MOV   ES, AX
-    MOV   SI, BP                              ;copy base pointer
-    ADD   SI, DestPointer                     ;calculate address of destination ptr
+    LEA   SI, Request.ReqDestOff              ;address of destination ptr
     CALL  CalculatePhysical                   ;physical address returned in CX, BX
 
     MOV   DX, D0DSTH                          ;address of high destination pointer
@@ -328,6 +342,283 @@ SetupDMADone:                                 ;restore registers and return
 SetupDMA        ENDP
 
 
+;Name:               IssueReadCommand
+;
+;Description:        This function starts the next multi-sector READ SECTORS
+;                    command of the current IDE request. Up to MaxSecPerCmd
+;                    sectors are requested with one command. The sectors
+;                    are transferred by the IDE and DMA event handlers. If
+;                    the IDE is not ready for a command the function does
+;                    not wait. It sets IssuePending and IDETimerTick tries
+;                    again on the next timer tick.
+; 
+;Operation:          The function calls CheckIDEBusy once to check that the
+;                    IDE is not busy and is ready for a command. If it is
+;                    not, IssuePending is set and the function returns.
+;                    Otherwise IssuePending is cleared, IDETimer is reset,
+;                    and the function sets Request.ReqSectors to the
+;                    smaller of SectorsRemaining and MaxSecPerCmd and
+;                    copies it to CmdSectorsLeft. The function then loops
+;                    through IDERegTable and writes to the IDE registers.
+;                    The function indexes into Request and copies the IDE
+;                    register values to write (the LBA and sector count) or
+;                    it writes a constant value to the IDE register,
+;                    depending on register. A sector count of MaxSecPerCmd
+;                    is written as 0, which the IDE treats as 256 sectors.
+;
+;Arguments:          None
+;
+;Return Values:      None
+;
+;Local Variables:    None
+;
+;Shared Variables:   Request (R/W) - LBA and sector count of the command
+;                    SectorsRemaining (R) - number of sectors left to read
+;                    CmdSectorsLeft (W) - sectors left in current command
+;                    IssuePending (W) - set if the IDE was not ready
+;                    IDETimer (W) - reset when the command is written
+;
+;Output:             The READ SECTORS command is written to the IDE.
+;
+;Error Handling:     None
+;
+;Algorithms:         None
+;
+;Registers Used:     None
+;
+;Known Bugs:         None
+;
+;Limitations:        Must be called with interrupts disabled.
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/8/16
+
+IssueReadCommand  PROC    NEAR
+
+IssueReadStart:                               ;save registers
+    PUSH    AX
+    PUSH    BX
+    PUSH    DX
+    PUSH    SI
+    PUSH    ES
+
+IssueReadCheckReady:                          ;check if IDE takes a command
+    MOV    DH, IDECmdRdyMask                  ;care about BSY, DRDY, and DRQ
+    MOV    DL, IDECmdRdy                      ;value indicating IDE is ready
+    CALL   CheckIDEBusy                       ;ZF set if IDE is ready
+    JZ     IssueReadSizeCommand               ;ready - write the command
+    MOV    IssuePending, TRUE                 ;busy - try again next tick
+    JMP    IssueReadDone
+
+IssueReadSizeCommand:                         ;find sectors for this command
+    MOV    IssuePending, FALSE                ;command is being written now
+    MOV    IDETimer, IDETimeout               ;restart the timeout
+    MOV    AX, SectorsRemaining               ;try to read all remaining sectors
+    CMP    AX, MaxSecPerCmd                   ;check if more than one command holds
+    JBE    IssueReadStoreCount                ;fits in one command - use it
+    MOV    AX, MaxSecPerCmd                   ;otherwise read the most allowed
+
+IssueReadStoreCount:                          ;save the sector count
+    MOV    Request.ReqSectors, AX             ;sector count register argument
+    MOV    CmdSectorsLeft, AX                 ;sectors left in this command
+
+IssueReadWriteSegment:                        ;load IDE segment into ES
+    MOV    AX, IDESegment
+    MOV    ES, AX                             ;segment of IDE register
+    MOV    AX, 0                              ;number of registers written to
+
+IssueReadIDELoop:                             ;loop writing instructions to IDE
+    CMP    AX, NumIDERegisters                ;number of IDE registers written to
+    JE     IssueReadDone                      ;done writing - command started
+    IMUL   BX, AX, SIZE IDERegEntry           ;calculate table offset
+
+IssueReadPrepReg:                             ;prepare to a register
+    MOV    SI, CS:IDERegTable[BX].ReqIndex    ;index of request argument
+    CMP    SI, NoReqArg                       ;check if reg value is request arg
+    JE     IssueReadConstant                  ;go to label to prepare constant command
+    ;JMP   IssueReadReqArg                    ;otherwise it's a request argument
+
+IssueReadReqArg:                              ;argument is in the request
+    MOV    DL, BYTE PTR Request[SI]           ;load the argument
+    OR     DL, CS:IDERegTable[BX].ArgMask     ;apply mask
+    JMP    IssueReadOutput                    ;go write to the register
+
+IssueReadConstant:
+    MOV    DL, CS:IDERegTable[BX].ConstComm   ;write the constant command
+
+IssueReadOutput:
+    MOV    SI, CS:IDERegTable[BX].RegOffset   ;offset of IDE register
+    MOV    ES:[SI], DL                        ;output to the IDE register - value in DL
+    INC    AX                                 ;one more command written
+    JMP    IssueReadIDELoop                   ;back to top of loop for writing to regs
+
+IssueReadDone:                                ;restore registers and return
+    POP    ES
+    POP    SI
+    POP    DX
+    POP    BX
+    POP    AX
+    RET
+
+IssueReadCommand  ENDP
+
+
+;Name:       Get_Blocks_Start(unsigned long int, int, unsigned short int far *)
+;
+;Description:        This function starts an asynchronous read of a number
+;                    of blocks from the IDE to a specified address and
+;                    returns without waiting for the data. The function is
+;                    passed three arguments - the address of the blocks,
+;                    the number of blocks, and the address to write to.
+;                    The transfer is driven by the IDE INTRQ and DMA
+;                    terminal count interrupts and its completion is
+;                    checked with Get_Blocks_Poll.
+; 
+;Operation:          The function first waits for any previous request to
+;                    finish, halting until the next interrupt between
+;                    checks. The function then uses BP to index into the
+;                    stack and copy the arguments into Request, copies the
+;                    number of sectors to read to SectorsRemaining and sets
+;                    SectorsRead to 0. If there are sectors to read the
+;                    function disables interrupts, sets IDEActive and
+;                    IDETimer, and calls IssueReadCommand to start the
+;                    first READ SECTORS command. IDEEH starts a
+;                    DMA transfer for each sector the IDE has ready and
+;                    IDEDMAEH advances the request after each sector.
+;
+;Arguments:          StartBlock(unsigned long int) - starting logical block
+;                    to read from
+;
+;                    NumBlocks(int) - number of blocks to retrieve
+;
+;                    DestinationPointer(unsigned short in far *) -
+;                    address of destination
+;
+;Return Values:      None
+;
+;Local Variables:    None
+;
+;Shared Variables:   Request (W) - LBA and destination of the read
+;                    SectorsRemaining (W) - number of sectors left to read
+;                    SectorsRead (W) - sectors the function has read
+;                    IDEActive (R/W) - set while the read is in progress
+;                    IDETimer (W) - set to the request timeout
+;
+;Output:             The READ SECTORS command is written to the IDE.
+;
+;Error Handling:     If the IDE does not make progress within IDETimeout
+;                    milliseconds IDETimerTick ends the request.
+;
+;Algorithms:         None
+;
+;Registers Used:     None
+;
+;Known Bugs:         None
+;
+;Limitations:        Only one request may be in progress at a time.
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/8/16   
+
+Get_Blocks_Start  PROC    NEAR
+                  PUBLIC  Get_Blocks_Start
+
+GetBlocksStartStart:                          ;starting label
+    PUSH    BP                                ;save base pointer
+    MOV     BP, SP                            ;use BP to index into stack
+    PUSH    AX                                ;save registers
+
+GetBlocksStartWait:                           ;wait for previous request
+    CMP     IDEActive, FALSE                  ;check if a request is running
+    JE      GetBlocksStartCopy                ;not running - start this one
+    HLT                                       ;running - sleep until interrupt
+    JMP     GetBlocksStartWait                ;and check again
+
+GetBlocksStartCopy:                           ;copy the arguments to Request
+    MOV     AX, SS:[BP+BlockArg]              ;low word of the starting LBA
+    MOV     WORD PTR Request.ReqLBA07, AX
+    MOV     AX, SS:[BP+BlockArg+2]            ;high word of the starting LBA
+    MOV     WORD PTR Request.ReqLBA2316, AX
+    MOV     AX, SS:[BP+DestArg]               ;offset of the destination
+    MOV     Request.ReqDestOff, AX
+    MOV     AX, SS:[BP+DestArg+2]             ;segment of the destination
+    MOV     Request.ReqDestSeg, AX
+
+GetBlocksStartLoadRemaining:                  ;load number of sectors remaining
+    MOV     AX, SS:[BP+CountArg]              ;total sectors to read
+    MOV     SectorsRemaining, AX              ;shared variable number of sectors
+    MOV     SectorsRead, 0                    ;no sectors have been read
+    CMP     AX, 0                             ;check if anything to read
+    JLE     GetBlocksStartDone                ;nothing to read - request is done
+
+GetBlocksStartIssue:                          ;start the first command
+    PUSHF                                     ;save interrupt flag
+    CLI                                       ;handlers also issue commands
+    MOV     IDEActive, TRUE                   ;request is now in progress
+    MOV     IDETimer, IDETimeout              ;start the timeout
+    CALL    IssueReadCommand                  ;handlers take it from here
+    POPF                                      ;restore interrupt flag
+
+GetBlocksStartDone:                           ;restore registers and return
+    POP     AX
+    POP     BP
+    RET
+
+Get_Blocks_Start  ENDP
+
+
+;Name:               Get_Blocks_Poll
+;
+;Description:        This function checks whether the read started by
+;                    Get_Blocks_Start has finished. It returns IDEBusyRet
+;                    while the read is in progress and the number of blocks
+;                    actually read once it is done.
+; 
+;Operation:          If IDEActive is set the function returns IDEBusyRet.
+;                    Otherwise it returns SectorsRead.
+;
+;Arguments:          None
+;
+;Return Values:      AX - IDEBusyRet if busy, otherwise number of blocks read
+;
+;Local Variables:    None
+;
+;Shared Variables:   IDEActive (R) - set while the read is in progress
+;                    SectorsRead (R) - sectors that have been read
+;
+;Output:             None
+;
+;Error Handling:     None
+;
+;Algorithms:         None
+;
+;Registers Used:     AX
+;
+;Known Bugs:         None
+;
+;Limitations:        None
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/7/16   
+
+Get_Blocks_Poll   PROC    NEAR
+                  PUBLIC  Get_Blocks_Poll
+
+GetBlocksPollCheck:                           ;check if the read is running
+    MOV     AX, IDEBusyRet                    ;assume still busy
+    CMP     IDEActive, FALSE                  ;check if request is running
+    JNE     GetBlocksPollDone                 ;still running - return busy
+    MOV     AX, SectorsRead                   ;done - return sectors read
+
+GetBlocksPollDone:                            ;return with value in AX
+    RET
+
+Get_Blocks_Poll   ENDP
+
+
 ;Name:       Get_Blocks(unsigned long int, int, unsigned short int far *)
 
 ;
@@ -338,27 +629,15 @@ SetupDMA        ENDP
 ;                    address to write to. The function reads from the 
 ;                    IDE and performs a DMA transfer to the specified
 ;                    location. The function returns the number of blocks
-;                    actually read.
+;                    actually read. This is the synchronous form of
+;                    Get_Blocks_Start and Get_Blocks_Poll.
 ; 
-;Operation:          The function first saves the registers to the stack.
-;                    The function then uses BP to index into the stack and
-;                    copy the number of sectors to read to SectorsRemaining
-;                    and sets SectorsRead to 0. The function then loops through
-;                    IDERegTable and writes to the IDE registers. The function
-;                    calls CheckIDEBusy to check that the appropriate 
-;                    status flags are set before writing to the IDE register.
-;                    The function indexes into the stack and copies the 
-;                    IDE register values to write into the stack or it
-;                    writes a constant value to the IDE register, depending on
-;                    register. After writing to the IDE registers, the function
-;                    calls SetupDMA to set up the DMA control registers, except
-;                    for D0Con. The function checks that the IDE is ready to
-;                    transfer data and then writes to D0Con to initiate the
-;                    DMA transfer. After the transfer is complete, the function 
-;                    increments SectorsRead and recalculates the DMA
-;                    destination pointer and the LBA. The function loops
-;                    repeatedly until all sectors have been read. The function
-;                    returns with the number of sectors read in AX.                 
+;Operation:          The function pushes a copy of its arguments and calls
+;                    Get_Blocks_Start to start the read. The function then
+;                    calls Get_Blocks_Poll until it no longer returns
+;                    IDEBusyRet, halting until the next interrupt (IDE,
+;                    DMA, timer, or audio) between calls, and returns the
+;                    number of sectors read in AX.
 ;
 ;Arguments:          StartBlock(unsigned long int) - starting logical block
 ;                    to read from
@@ -373,24 +652,24 @@ SetupDMA        ENDP
 ;
 ;Local Variables:    None
 ;
-;Shared Variables:   SectorsRemaining (R/W) - number of sectors left to read
-;                    SectorsRead(R/W) - sectors the function has read
+;Shared Variables:   None
 ;
 ;Output:             None
 ;
-;Error Handling:     None
+;Error Handling:     If the IDE fails or times out fewer blocks than
+;                    requested are returned.
 ;
 ;Algorithms:         None
 ;
-;Registers Used:     None
+;Registers Used:     AX
 ;
 ;Known Bugs:         None
 ;
-;Limitations:        None
-;
+;Limitations:        Must be called with interrupts enabled.
+;
 ;Author:             Timothy Liu
-;
-;Last Modified       5/17/16   
+;
+;Last Modified       6/8/16   
 
 Get_Blocks        PROC    NEAR
                   PUBLIC  Get_Blocks
@@ -398,127 +677,524 @@ Get_Blocks        PROC    NEAR
 GetBlocksStart:                               ;starting label
     PUSH    BP                                ;save base pointer
     MOV     BP, SP                            ;use BP to index into stack
-    PUSH    BX                                ;save registers
-    PUSH    CX
+
+GetBlocksCopyArgs:                            ;push the arguments again
+    PUSH    WORD PTR SS:[BP+DestArg+2]        ;segment of destination
+    PUSH    WORD PTR SS:[BP+DestArg]          ;offset of destination
+    PUSH    WORD PTR SS:[BP+CountArg]         ;number of blocks
+    PUSH    WORD PTR SS:[BP+BlockArg+2]       ;high word of starting block
+    PUSH    WORD PTR SS:[BP+BlockArg]         ;low word of starting block
+    CALL    Get_Blocks_Start                  ;start reading the blocks
+    ADD     SP, GetBlocksArgSize              ;remove the arguments
+
+GetBlocksWait:                                ;wait for the read to finish
+    CALL    Get_Blocks_Poll                   ;check the read
+    CMP     AX, IDEBusyRet                    ;check if still busy
+    JNE     GetBlocksDone                     ;done - return sectors read
+    HLT                                       ;busy - sleep until interrupt
+    JMP     GetBlocksWait                     ;and check again
+
+GetBlocksDone:
+    POP    BP                                 ;restore base pointer
+    RET
+
+Get_Blocks      ENDP
+
+
+;Name:               IDEEH
+;
+;Description:        This function handles IDE INTRQ interrupts. The IDE
+;                    interrupts when a sector of a READ SECTORS command is
+;                    ready to be transferred or when the command fails.
+;                    The function starts the DMA transfer of the sector.
+; 
+;Operation:          The function reads the IDE status register, which also
+;                    clears the IDE interrupt. If no request is in progress
+;                    or the IDE is being reset the interrupt is ignored.
+;                    If the IDE reports an error the request is ended by
+;                    clearing IDEActive. Otherwise, if the IDE has data
+;                    ready the function calls SetupDMA
+;                    and writes D0ConIntVal to D0Con to start the transfer,
+;                    which interrupts at terminal count. The function then
+;                    sends an INT1 EOI.
+;
+;Arguments:          None
+;
+;Return Values:      None
+;
+;Local Variables:    None
+;
+;Shared Variables:   IDEActive (R/W) - cleared if the IDE reports an error
+;                    IDEResetting (R) - set while the IDE is being reset
+;                    IDETimer (W) - reset when a sector is ready
+;
+;Output:             None
+;
+;Error Handling:     A READ SECTORS error ends the request early so the
+;                    number of sectors read is less than requested.
+;
+;Algorithms:         None
+;
+;Registers Used:     None
+;
+;Known Bugs:         None
+;
+;Limitations:        None
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/16/16
+
+IDEEH           PROC    NEAR
+                PUBLIC  IDEEH
+
+IDEEHStart:                                   ;save the registers
+    PUSH    AX
     PUSH    DX
     PUSH    SI
+    PUSH    ES
 
-GetBlocksLoadRemaining:                       ;load number of sectors remaining
-    MOV    CX, SS:[BP+8]                      ;total sectors to read
-    MOV    SectorsRemaining, CX               ;shared variable number of sectors
-    MOV    SectorsRead, 0                     ;no sectors have been read
+IDEEHReadStatus:                              ;read status to clear INTRQ
+    MOV     AX, IDESegment
+    MOV     ES, AX                            ;segment of the IDE status register
+    MOV     SI, IDEStatusOffset               ;offset of the IDE status register
+    MOV     AL, ES:[SI]                       ;read the status register
+    CMP     IDEActive, FALSE                  ;check if a request is running
+    JE      IDEEHSendEOI                      ;nothing running - ignore it
+    CMP     IDEResetting, FALSE               ;check if the IDE is being reset
+    JNE     IDEEHSendEOI                      ;yes - ignore it
+
+IDEEHCheckError:                              ;check if the command failed
+    TEST    AL, IDEErrorMask                  ;check the error bit
+    JZ      IDEEHCheckData                    ;no error - check for data
+    MOV     IDEActive, FALSE                  ;error - end the request
+    JMP     IDEEHSendEOI                      ;and done
+
+IDEEHCheckData:                               ;check if a sector is ready
+    AND     AL, IDETransferMask               ;mask out unimportant status bits
+    CMP     AL, IDETransfer                   ;check if data is ready
+    JNE     IDEEHSendEOI                      ;no data - nothing to do
+
+IDEEHStartDMA:                                ;start the sector transfer
+    MOV     IDETimer, IDETimeout              ;IDE is making progress
+    CALL    SetupDMA                          ;set up DMA registers
+    MOV     DX, D0Con                         ;address of DxCon register
+    MOV     AX, D0ConIntVal                   ;transfer with TC interrupt
+    OUT     DX, AX                            ;write to DMA to initiate transfer
+
+IDEEHSendEOI:
+    MOV     DX, INTCtrlrEOI                   ;address of interrupt EOI register
+    MOV     AX, INT1EOI                       ;INT1 end of interrupt
+    OUT     DX, AX                            ;output to peripheral control block
+
+IDEEHDone:                                    ;restore registers and return
+    POP     ES
+    POP     SI
+    POP     DX
+    POP     AX
+    IRET                                      ;IRET from interrupt handlers
+
+IDEEH           ENDP
+
+
+;Name:               IDEDMAEH
+;
+;Description:        This function handles DMA channel 0 terminal count
+;                    interrupts, which occur when a sector has been moved
+;                    from the IDE. The function advances the request and
+;                    starts the next command or ends the request.
+; 
+;Operation:          The function increments SectorsRead, decrements
+;                    SectorsRemaining, and advances the destination segment
+;                    by one sector. If the current command has no sectors
+;                    left the LBA is advanced by the sectors of the command
+;                    and either IssueReadCommand is called for the next
+;                    command or, if no sectors remain, IDEActive is
+;                    cleared. The function then sends a DMA0 EOI.
+;
+;Arguments:          None
+;
+;Return Values:      None
+;
+;Local Variables:    None
+;
+;Shared Variables:   Request (R/W) - LBA and destination of the read
+;                    SectorsRemaining (R/W) - number of sectors left to read
+;                    SectorsRead (R/W) - sectors that have been read
+;                    CmdSectorsLeft (R/W) - sectors left in current command
+;                    IDEActive (W) - cleared when the request is done
+;                    IDETimer (W) - reset when a sector is done
+;
+;Output:             None
+;
+;Error Handling:     None
+;
+;Algorithms:         None
+;
+;Registers Used:     None
+;
+;Known Bugs:         None
+;
+;Limitations:        None
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/8/16
 
-GetBlocksCheckLeft:
-    CMP    SectorsRemaining, 0                ;check if no sectors left
-    JE     GetBlocksDone                      ;finished - go to end
+IDEDMAEH        PROC    NEAR
+                PUBLIC  IDEDMAEH
 
-GetBlocksWriteSegment:                        ;load IDE segment into ES
-    MOV    AX, IDESegment
-    MOV    ES, AX                             ;segment of IDE register
-    MOV    AX, 0                              ;number of registers written to
+IDEDMAEHStart:                                ;save the registers
+    PUSH    AX
+    PUSH    DX
+    PUSH    SI
+    PUSH    ES
+    CMP     IDEActive, FALSE                  ;check if a request is running
+    JE      IDEDMAEHSendEOI                   ;nothing running - ignore it
+
+IDEDMAEHSector:                               ;one more sector read
+    MOV     IDETimer, IDETimeout              ;IDE is making progress
+    INC     SectorsRead                       ;one more sector has been read
+    DEC     SectorsRemaining                  ;one fewer sector to read
+    ADD     Request.ReqDestSeg, NumTransfers/ParaSize
+                                              ;advance the segment one sector
+    DEC     CmdSectorsLeft                    ;one fewer sector in this command
+    JNZ     IDEDMAEHSendEOI                   ;more sectors - wait for the IDE
+    ;JZ     IDEDMAEHNextCommand               ;otherwise the command is done
+
+IDEDMAEHNextCommand:                          ;recalculate LBA for next command
+    MOV     AX, DS                            ;request is in the data segment
+    MOV     ES, AX
+    LEA     SI, Request.ReqLBA07              ;address of the LBA
+    MOV     AX, Request.ReqSectors            ;number of blocks read by command
+    CALL    Add32Bit                          ;recalculate the LBA start block
+    CMP     SectorsRemaining, 0               ;check if any sectors are left
+    JE      IDEDMAEHRequestDone               ;none left - request is done
+    CALL    IssueReadCommand                  ;otherwise start the next command
+    JMP     IDEDMAEHSendEOI                   ;and done
+
+IDEDMAEHRequestDone:                          ;all sectors have been read
+    MOV     IDEActive, FALSE                  ;request is no longer running
+
+IDEDMAEHSendEOI:
+    MOV     DX, INTCtrlrEOI                   ;address of interrupt EOI register
+    MOV     AX, DMA0EOI                       ;DMA0 end of interrupt
+    OUT     DX, AX                            ;output to peripheral control block
+
+IDEDMAEHDone:                                 ;restore registers and return
+    POP     ES
+    POP     SI
+    POP     DX
+    POP     AX
+    IRET                                      ;IRET from interrupt handlers
+
+IDEDMAEH        ENDP
+
+
+;Name:               IDETimerTick
+;
+;Description:        This function is called by the timer 0 event handler
+;                    every millisecond. It issues a command that was held
+;                    back because the IDE was busy and ends a request that
+;                    has not made progress within IDETimeout milliseconds,
+;                    so a slow or stuck drive never hangs a read. While the
+;                    IDE is being reset after a timeout it waits for the
+;                    drive to be ready before ending the request.
+; 
+;Operation:          If no request is in progress the function returns.
+;                    If the IDE is being reset (IDEResetting) IDETimer is
+;                    decremented and, once IDEResetWait milliseconds have
+;                    passed, the status register is checked. When BSY is
+;                    clear, or IDETimer reaches zero (the drive didn't come
+;                    back), IDEResetting and IDEActive are cleared to end
+;                    the request. Otherwise, if IssuePending is set
+;                    IssueReadCommand is called to try the command again.
+;                    IDETimer is then decremented and if it reaches zero
+;                    IDEAbort is called to end the request.
+;
+;Arguments:          None
+;
+;Return Values:      None
+;
+;Local Variables:    None
+;
+;Shared Variables:   IDEActive (R/W) - set while the read is in progress,
+;                                      cleared when a reset is done
+;                    IDEResetting (R/W) - set while the IDE is being reset
+;                    IssuePending (R) - set if a command must be retried
+;                    IDETimer (R/W) - milliseconds left before timeout
+;
+;Output:             None
+;
+;Error Handling:     A timed out request is ended early (after the IDE is
+;                    reset if IDEUseSRST is set), so the number of sectors
+;                    read is less than requested.
+;
+;Algorithms:         None
+;
+;Registers Used:     None
+;
+;Known Bugs:         None
+;
+;Limitations:        Must be called with interrupts disabled.
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/16/16
+
+IDETimerTick    PROC    NEAR
+                PUBLIC  IDETimerTick
+
+IDETimerTickCheck:                            ;check if a request is running
+    CMP     IDEActive, FALSE
+    JE      IDETimerTickDone                  ;nothing running - done
+    CMP     IDEResetting, FALSE               ;check if the IDE is being reset
+    JE      IDETimerTickIssue                 ;no - normal request
+    ;JMP    IDETimerTickReset                 ;yes - wait for it
+
+IDETimerTickReset:                            ;wait for the reset to finish
+    DEC     IDETimer                          ;one more millisecond waited
+    JZ      IDETimerTickResetDone             ;drive didn't come back - give up
+    CMP     IDETimer, IDEResetTimeout - IDEResetWait
+    JA      IDETimerTickDone                  ;too soon to check BSY - done
+    PUSH    DX                                ;check if the drive is busy
+    MOV     DH, IDEBusyMask
+    MOV     DL, IDENotBusy
+    CALL    CheckIDEBusy                      ;ZF set if BSY is clear
+    POP     DX
+    JNZ     IDETimerTickDone                  ;still busy - check next time
+    ;JZ     IDETimerTickResetDone             ;ready - reset is done
+
+IDETimerTickResetDone:                        ;reset is over, end the request
+    MOV     IDEResetting, FALSE
+    MOV     IDEActive, FALSE
+    JMP     IDETimerTickDone
+
+IDETimerTickIssue:                            ;retry a held back command
+    CMP     IssuePending, FALSE               ;check if a command is waiting
+    JE      IDETimerTickCount                 ;nothing waiting - count down
+    CALL    IssueReadCommand                  ;try to write the command again
+
+IDETimerTickCount:                            ;count down the timeout
+    DEC     IDETimer                          ;one more millisecond waited
+    JNZ     IDETimerTickDone                  ;not timed out - done
+    CALL    IDEAbort                          ;timed out - end the request
+
+IDETimerTickDone:                             ;done - return
+    RET
 
-GetBlocksIDELoop:                             ;loop writing instructions to IDE
-    CMP    AX, NumIDERegisters                ;number of IDE registers written to
-    JE     GetBlocksPrepareDMA                ;done writing - send read sector com.
-    IMUL   BX, AX, SIZE IDERegEntry           ;calculate table offset
+IDETimerTick    ENDP
 
-GetBlocksPrepReg:                             ;prepare to a register
-    MOV    DH, CS:IDERegTable[BX].FlagMask    ;look up bit mask
-    MOV    DL, CS:IDERegTable[BX].IDEReady    ;value indicating IDE is ready
-    CALL   CheckIDEBusy                       ;return when IDE is not busy
-    MOV    SI, CS:IDERegTable[BX].RegOffset   ;offset of IDE register
-    CMP    CS:IDERegTable[BX].BPIndex, NoStackArg    ;check if reg value is stack arg
-    JE     GetBlocksConstant                  ;go to label to prepare constant command
-    ;JMP   GetBlocksStackArg                  ;otherwise it’s a stack argument
-
-GetBlocksStackArg:                            ;argument is on the stack
-    PUSH   BP                                 ;save base pointer
-    ADD    BP, CS:IDERegTable[BX].BPIndex     ;change base pointer to point to address
-    MOV    DL, SS:[BP]                        ;load the argument
-    OR     DL, CS:IDERegTable[BX].ArgMask     ;apply mask
-    POP    BP                                 ;restore the base pointer
-    JMP    GetBlocksOutput                    ;go write to the register
 
-GetBlocksConstant:
-    MOV    DL, CS:IDERegTable[BX].ConstComm   ;write the constant command
+;Name:               IDEAbort
+;
+;Description:        This function ends the current IDE request early. Any
+;                    DMA transfer in progress is stopped. If IDEUseSRST is
+;                    set the IDE is also given a software reset, so a
+;                    drive left in the middle of a command (BSY or DRQ
+;                    set) is ready for the next request instead of making
+;                    every later command wait out IDETimeout. When the
+;                    drive is ready again (or IDEResetTimeout passes)
+;                    IDETimerTick marks the request done. Otherwise the
+;                    request is marked done right away. Either way
+;                    Get_Blocks_Poll returns the number of sectors read
+;                    before the failure.
+; 
+;Operation:          The function writes D0ConStopVal to D0Con to stop the
+;                    DMA channel and clears IssuePending. If IDEUseSRST is
+;                    FALSE IDEActive is cleared and the function returns.
+;                    Otherwise it writes IDESRST to the device control
+;                    register, holds it for IDEResetHold loops (at least
+;                    5 us), and writes IDECtrlRun to end the reset.
+;                    IDEResetting is set and IDETimer is set to
+;                    IDEResetTimeout. IDEActive is left set so
+;                    Get_Blocks_Poll still returns busy until IDETimerTick
+;                    sees BSY clear.
+;
+;Arguments:          None
+;
+;Return Values:      None
+;
+;Local Variables:    None
+;
+;Shared Variables:   IDEActive (W) - cleared if the IDE isn't reset
+;                    IDEResetting (W) - set while the IDE is being reset
+;                    IDETimer (W) - set to the reset timeout
+;                    IssuePending (W) - cleared
+;
+;Output:             None
+;
+;Error Handling:     None
+;
+;Algorithms:         None
+;
+;Registers Used:     None
+;
+;Known Bugs:         None
+;
+;Limitations:        Must be called with interrupts disabled. Without the
+;                    reset a drive left busy makes the next request wait
+;                    until it is ready (or times out).
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/17/16
 
-GetBlocksOutput:
-    MOV    ES:[SI], DL                        ;output to the IDE register - value in DL
-    INC    AX                                 ;one more command written
-    JMP    GetBlocksIDELoop                   ;back to top of loop for writing to regs
+IDEAbort        PROC    NEAR
 
-GetBlocksPrepareDMA:                          ;set up DMA control registers
-    CALL   SetupDMA                           ;call function to set up DMA registers
+IDEAbortStart:                                ;save registers
+    PUSH    AX
+    PUSH    CX
+    PUSH    DX
+    PUSH    SI
+    PUSH    ES
 
-GetBlocksCheckTransfer:                       ;check if IDE is ready to transfer data
-    MOV   DH, IDETransferMask                 ;mask out unimportant status bits
-    MOV   DL, IDETransfer                     ;value to compare to
-    CALL  CheckIDEBusy                        ;return when IDE is ready
+IDEAbortDMA:                                  ;stop any DMA transfer
+    MOV     DX, D0Con                         ;address of DxCon register
+    MOV     AX, D0ConStopVal                  ;value to disarm the channel
+    OUT     DX, AX
+
+IDEAbortCheck:                                ;check if the IDE can be reset
+    MOV     IssuePending, FALSE               ;no command will be retried
+    MOV     AX, IDEUseSRST
+    CMP     AX, FALSE                         ;is the CS1 address confirmed
+    JNE     IDEAbortReset                     ;yes - reset the IDE
+    ;JE     IDEAbortFail                      ;no - just end the request
+
+IDEAbortFail:                                 ;end the request without a reset
+    MOV     IDEActive, FALSE
+    JMP     IDEAbortDone
+
+IDEAbortReset:                                ;software reset the IDE
+    MOV     AX, IDESegment
+    MOV     ES, AX                            ;segment of the IDE registers
+    MOV     SI, IDECtrlOffset                 ;offset of device control register
+    MOV     BYTE PTR ES:[SI], IDESRST         ;start the reset
+    MOV     CX, IDEResetHold                  ;hold SRST for at least 5 us
+
+IDEAbortHold:
+    LOOP    IDEAbortHold
+    MOV     BYTE PTR ES:[SI], IDECtrlRun      ;end the reset
+
+IDEAbortWait:                                 ;IDETimerTick ends the request
+    MOV     IDEResetting, TRUE                ;   once the drive is ready
+    MOV     IDETimer, IDEResetTimeout
+
+IDEAbortDone:                                 ;restore registers and return
+    POP     ES
+    POP     SI
+    POP     DX
+    POP     CX
+    POP     AX
+    RET
 
-GetBlocksDMA:                                 ;write to DxCON and perform DMA
-    MOV   DX, D0Con                           ;address of DxCon register
-    MOV   AX, D0ConVal                        ;value to write to DxCon
-    OUT   DX, AX                              ;write to DMA to initiate transfer
-    INC   SectorsRead                         ;one more sector has been read 
+IDEAbort        ENDP
 
-GetBlocksRecalculate:                         ;recalculate LBA and destination pointer
-    MOV   AX, SS                              ;copy stack segment to extra segment
-    MOV   ES, AX
-    MOV   SI, BP                              ;pointer to LBA start block
-    ADD   SI, LBA07                           ;calculate address of LBA0:7 register
-    MOV   AX, SecPerTran                      ;number of blocks read
-    CALL  Add32Bit                            ;recalculate the LBA start block
-    
-    MOV   SI, BP                              ;pointer to destination pointer
-    ADD   SI, DestPointer                     ;calculate address of dest. pointer
-    MOV   AX, NumTransfers                    ;amount to increment destination pointer
-    CALL  Add32Bit                            ;recalculate destination pointer
-    DEC   SectorsRemaining                    ;one fewer sector to read
-    JMP   GetBlocksCheckLeft                  ;jump to top of loop
-  
-GetBlocksDone:
-    MOV    AX, SectorsRead                    ;return number of sectors read
-    POP    SI
-    POP    DX                                 ;restore registers
-    POP    CX
-    POP    BX
-    POP    BP
+
+;Name:               InitIDE
+;
+;Description:        This function initializes the IDE read shared variables
+;                    and enables the IDE INTRQ (INT1) and DMA channel 0
+;                    interrupts in the interrupt controller.
+; 
+;Operation:          The function clears IDEActive, IDEResetting, and
+;                    SectorsRead. It then writes ICON1Val to ICON1Address
+;                    and DMA0CtrlVal to DMA0CtrlAddress and sends EOIs for
+;                    both interrupts.
+;
+;Arguments:          None
+;
+;Return Values:      None
+;
+;Local Variables:    None
+;
+;Shared Variables:   IDEActive (W) - no request is in progress
+;                    IDEResetting (W) - the IDE is not being reset
+;                    IssuePending (W) - no command is waiting to be issued
+;                    SectorsRead (W) - no sectors have been read
+;
+;Output:             None
+;
+;Error Handling:     None
+;
+;Algorithms:         None
+;
+;Registers Used:     AX, DX
+;
+;Known Bugs:         None
+;
+;Limitations:        Must be called with interrupts disabled.
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/8/16
+
+InitIDE         PROC    NEAR
+                PUBLIC  InitIDE
+
+InitIDEVariables:                             ;no request in progress
+    MOV     IDEActive, FALSE
+    MOV     IDEResetting, FALSE
+    MOV     IssuePending, FALSE
+    MOV     SectorsRead, 0
+
+InitIDEInterrupts:                            ;enable INTRQ and DMA interrupts
+    MOV     DX, ICON1Address                  ;address of INT1 control register
+    MOV     AX, ICON1Val                      ;value to enable IDE interrupts
+    OUT     DX, AX
+    MOV     DX, DMA0CtrlAddress               ;address of DMA0 control register
+    MOV     AX, DMA0CtrlVal                   ;value to enable DMA interrupts
+    OUT     DX, AX
+
+    MOV     DX, INTCtrlrEOI                   ;clear out pending interrupts
+    MOV     AX, INT1EOI
+    OUT     DX, AX
+    MOV     AX, DMA0EOI
+    OUT     DX, AX
+
+InitIDEDone:                                  ;done - return
     RET
 
-Get_Blocks      ENDP
+InitIDE         ENDP
 
 ; IDERegTable
 ; Description:   This table contains IDERegEntry structs describing what
 ;                values to output to the IDE registers. Each table entry
 ;                corresponds to a different IDE register being written to.
-;                The function get_blocks indexes into the table and looks
-;                up the values to be written, where to write them to, and 
-;                other information.
+;                The function IssueReadCommand indexes into the table and
+;                looks up the values to be written, where to write them to,
+;                and other information.
 ;
-; Last Modified: 5/17/16
+; Last Modified: 6/8/16
 ;                
 ; Author:        Timothy Liu
 ;  
               
 IDERegTable        LABEL    IDERegEntry
 
-;   IDERegEntry<FlagMask    , IDEREady, RegOffset    , BPIndex   , ConstComm    , ArgMask  > ;IDERegEntry Struc
+;   IDERegEntry<RegOffset    , ReqIndex   , ConstComm    , ArgMask  > ;IDERegEntry Struc
 
-    IDERegEntry<SCRdyMask   , SCRdy   , SCOffset     , NoStackArg, SecPerTran   , BlankMask> ;sector count register
-    IDERegEntry<LBARdyMask  , LBARdy  , LBA70Offset  , LBA07     , NoConstant   , BlankMask> ;LBA (0:7) register
-    IDERegEntry<LBARdyMask  , LBARdy  , LBA158Offset , LBA815    , NoConstant   , BlankMask> ;LBA (8:15) register
-    IDERegEntry<LBARdyMask  , LBARdy  , LBA2316Offset, LBA2316   , NoConstant   , BlankMask> ;LBA (16:23) register
-    IDERegEntry<DeLBARdyMask, DeLBARdy, DeLBAOffset  , DeLBA     , NoConstant   , DeLBAMask> ;Device LBA register
-    IDERegEntry<ComRdyMask  , ComRdy  , ComOffset    , NoStackArg, ReadSector   , BlankMask> ;IDE Command register
+    IDERegEntry<SCOffset     , ReqSectors , NoConstant   , BlankMask> ;sector count register
+    IDERegEntry<LBA70Offset  , ReqLBA07   , NoConstant   , BlankMask> ;LBA (0:7) register
+    IDERegEntry<LBA158Offset , ReqLBA815  , NoConstant   , BlankMask> ;LBA (8:15) register
+    IDERegEntry<LBA2316Offset, ReqLBA2316 , NoConstant   , BlankMask> ;LBA (16:23) register
+    IDERegEntry<DeLBAOffset  , ReqDeLBA   , NoConstant   , DeLBAMask> ;Device LBA register
+    IDERegEntry<ComOffset    , NoReqArg   , ReadSector   , BlankMask> ;IDE Command register
 
 
 CODE ENDS
 
-DATA    SEGMENT PUBLIC  'DATA'
-
-SectorsRemaining    DW    ?      ;sectors left to read
-SectorsRead         DW    ?      ;sectors that have been read
+DATA    SEGMENT PUBLIC  'DATA'
+
+Request             IDERequest <>  ;LBA, destination, and sector count of read
+SectorsRemaining    DW    ?      ;sectors left to read
+SectorsRead         DW    ?      ;sectors that have been read
+CmdSectorsLeft      DW    ?      ;sectors left in the current command
+IDEActive           DB    ?      ;TRUE while a read request is in progress
+IssuePending        DB    ?      ;TRUE if a command waits for the IDE
+IDEResetting        DB    ?      ;TRUE while the IDE is reset after a timeout
+IDETimer            DW    ?      ;milliseconds left before request times out
 DATA    ENDS
 
 
-        END
\ No newline at end of file
+            END
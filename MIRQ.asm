@@ -18,6 +18,7 @@
 ;    ClrIRQVectors          -clear the interrupt vector table
 ;    IllegalEventHandler    -takes care of illegal events
 ;    InstallDreqHandler     -installs VS1011 data request IRQ handler
+;    InstallIDEHandlers     -installs IDE INTRQ and DMA0 IRQ handlers
 ;    InstallTimer0Handler   -installs the timer0 handler
 ;    InstallTimer1Handler   -installs the timer1 handler
 
@@ -28,6 +29,9 @@
 ;    5/7/16     Tim Liu    wrote InstallTimer1Handler
 ;    5/19/16    Tim Liu    wrote InstallDreqHandler
 ;    5/30/16    Tim Liu    uncommented InstallDreqHanlder
+;    6/7/16     Tim Liu    wrote InstallIDEHandlers
+;    6/16/16    Tim Liu    InstallDreqHandler also installs the DMA1 audio
+;                          burst done handler
 
 $INCLUDE(MIRQ.INC)
 $INCLUDE(GENERAL.INC)
@@ -41,8 +45,11 @@ CODE SEGMENT PUBLIC 'CODE'
 ; external function declarations
 
     EXTRN    AudioEH:NEAR        ;VS1011 data request IRQ handler
+    EXTRN    AudioDMAEH:NEAR     ;DMA1 audio burst done IRQ handler
     EXTRN    ButtonEH:NEAR       ;checks if a button is pressed
     EXTRN    DRAMRefreshEH:NEAR  ;access PCS4 to refresh DRAM
+    EXTRN    IDEEH:NEAR          ;IDE INTRQ handler - starts sector DMA
+    EXTRN    IDEDMAEH:NEAR       ;DMA0 terminal count handler
 
 ; ClrIRQVectors
 ;
@@ -167,13 +174,16 @@ IllegalEventHandler     ENDP
 ; InstallDreqHandler
 ;
 ; Description:       This function installs the event handler for the data
-;                    request interrupt from the VS1011 MP3 decoder. The
-;                    function does not write to the interrupt controller.
-;                    The interrupt controller is turned on and off by
-;                    the function audio_play
+;                    request interrupt from the VS1011 MP3 decoder and the
+;                    DMA channel 1 terminal count interrupt (the end of an
+;                    audio burst in DMA mode). The function does not write
+;                    to the interrupt controller. The interrupt controller
+;                    is turned on and off by the function audio_play (and
+;                    InitAudioDMA for DMA1).
 ;
-; Operation:         Writes the address of the data request event handler
-;                    (AudioEH) to the address of the INT0 interrupt vector. 
+; Operation:         Writes the address of the data request event handler
+;                    (AudioEH) to the address of the INT0 interrupt vector
+;                    and the address of AudioDMAEH to the DMA1 vector.
 ;
 ; Arguments:         None.
 ;
@@ -193,7 +203,7 @@ IllegalEventHandler     ENDP
 ;
 ;
 ; Author:            Timothy Liu
-; Last Modified:     5/19/16
+; Last Modified:     6/16/16
 
 
 InstallDreqHandler    PROC    NEAR
@@ -209,6 +219,10 @@ InstallDreqHandler    PROC    NEAR
 
     MOV     ES: WORD PTR (INTERRUPT_SIZE * INT0Vec), OFFSET(AudioEH)
     MOV     ES: WORD PTR (INTERRUPT_SIZE * INT0Vec + 2), SEG(AudioEH)
+
+                                ;DMA1 terminal count handler (audio burst done)
+    MOV     ES: WORD PTR (INTERRUPT_SIZE * DMA1Vec), OFFSET(AudioDMAEH)
+    MOV     ES: WORD PTR (INTERRUPT_SIZE * DMA1Vec + 2), SEG(AudioDMAEH)
 
 
     RET
@@ -216,6 +230,58 @@ InstallDreqHandler    PROC    NEAR
 InstallDreqHandler    ENDP
 
 
+; InstallIDEHandlers
+;
+; Description:       This function installs the event handlers for the IDE
+;                    INTRQ interrupt and the DMA channel 0 terminal count
+;                    interrupt. The function does not write to the interrupt
+;                    controller. The interrupts are turned on by InitIDE.
+;
+; Operation:         Writes the address of the IDE event handler (IDEEH) to
+;                    the INT1 interrupt vector and the address of the DMA
+;                    event handler (IDEDMAEH) to the DMA0 interrupt vector.
+;
+; Arguments:         None.
+;
+; Return Value:      None.
+;
+; Local Variables:   None.
+;
+; Shared Variables:  None.
+;
+; Input:             None.
+;
+; Output:            None.
+;
+; Error Handling:    None.
+;
+; Algorithms:        None.
+;
+;
+; Author:            Timothy Liu
+; Last Modified:     6/7/16
+
+
+InstallIDEHandlers    PROC    NEAR
+                      PUBLIC  InstallIDEHandlers
+
+    XOR    AX, AX        ;clear ES (irq vector in segment 0)
+    MOV    ES, AX
+
+                                ;store the vectors - IDE INTRQ goes to INT1
+    MOV     ES: WORD PTR (INTERRUPT_SIZE * INT1Vec), OFFSET(IDEEH)
+    MOV     ES: WORD PTR (INTERRUPT_SIZE * INT1Vec + 2), SEG(IDEEH)
+
+                                ;DMA0 terminal count handler
+    MOV     ES: WORD PTR (INTERRUPT_SIZE * DMA0Vec), OFFSET(IDEDMAEH)
+    MOV     ES: WORD PTR (INTERRUPT_SIZE * DMA0Vec + 2), SEG(IDEDMAEH)
+
+
+    RET
+
+InstallIDEHandlers    ENDP
+
+
 ; InstallTimer0Handler
 ;
 ; Description:       Install the event handler for the timer0 interrupt.
@@ -14,10 +14,16 @@
 ;
 ;    AudioIRQOn   -turns on INT0 audio data request interrupts
 ;    AudioEH      -event handler for audio data request interrupts
+;    AudioDMAEH   -event handler for DMA1 terminal count (burst done)
 ;    AudioOutput  -outputs audio data to the MP3 decoder
 ;    Audio_Play   -sets up shared variables for outputting audio
 ;    Audio_Halt   -stops audio play by turning off ICON0 interrupts
-;    Update       -returns if NextBuffer is empty
+;    Update       -adds a buffer to the audio queue if there is room
+;    Audio_Queue  -adds a buffer (possibly ending a track) to the queue
+;    AudioQueueAdd -adds a buffer descriptor to the audio queue
+;    Audio_Done   -returns the number of buffers played since last call
+;    Audio_Low    -returns if the audio queue ran low since last call
+;    InitAudioDMA -selects DMA or bit-bang output of MP3 data
 
 
 ; Revision History:
@@ -43,11 +49,73 @@
 ;    6/2/16     Tim Liu    Fixed critical code bug in Update
 ;    6/2/16     Tim Liu    ChangedAudioIRQOn to turn off interrupts during
 ;                          function call
+;    6/16/16    Tim Liu    Replaced CurrentBuffer/NextBuffer with a queue
+;                          of buffer descriptors the event handler takes
+;                          buffers from on its own; added Audio_Queue,
+;                          Audio_Done, and Audio_Low (low-water flag)
+;    6/16/16    Tim Liu    Sped up AudioOutput: pointer normalized once per
+;                          burst, LODSW word fetches, unrolled burst, port
+;                          addresses kept in registers
+;    6/16/16    Tim Liu    Added DMA channel 1 output mode through the CPLD
+;                          serializer (AUDIO_DMA_MODE); the bit-bang output
+;                          is kept for boards without the serializer
+;    6/16/16    Tim Liu    INT0 is masked while a DMA burst runs and turned
+;                          back on by the DMA1 terminal count interrupt
+;                          (AudioDMAEH) instead of polling D1TC
 ;
 ; local include files
+$INCLUDE(GENERAL.INC)
 $INCLUDE(AUDIO.INC)
 $INCLUDE(MIRQ.INC)
-$INCLUDE(GENERAL.INC)
+
+
+;OutWord macro - serially outputs the word at DS:SI to the MP3 decoder (low
+;byte first, each byte MSB first) and moves SI to the next word. DH must hold
+;the high byte of the PCS2 and PCS3 addresses, BL the low byte of PCS3 and BH
+;the low byte of PCS2. Changes AX, DL, and SI. 168 clocks on the 80C188.
+
+%*DEFINE(OutWord)(
+    LODSW                                    ;get the next two bytes
+                                             ;first byte is in AL
+    MOV   DL, BL                             ;first bit goes to PCS3 to
+    ROL   AL, 1                              ;   trigger BSYNC, MSB on DB0
+    OUT   DX, AL
+    MOV   DL, BH                             ;other bits go to PCS2
+    ROL   AL, 1                              ;shift so DB6 is LSB
+    OUT   DX, AL
+    ROL   AL, 1                              ;shift so DB5 is LSB
+    OUT   DX, AL
+    ROL   AL, 1                              ;shift so DB4 is LSB
+    OUT   DX, AL
+    ROL   AL, 1                              ;shift so DB3 is LSB
+    OUT   DX, AL
+    ROL   AL, 1                              ;shift so DB2 is LSB
+    OUT   DX, AL
+    ROL   AL, 1                              ;shift so DB1 is LSB
+    OUT   DX, AL
+    ROL   AL, 1                              ;shift so DB0 is LSB
+    OUT   DX, AL
+
+    MOV   AL, AH                             ;now the second byte
+    MOV   DL, BL                             ;first bit goes to PCS3 to
+    ROL   AL, 1                              ;   trigger BSYNC, MSB on DB0
+    OUT   DX, AL
+    MOV   DL, BH                             ;other bits go to PCS2
+    ROL   AL, 1                              ;shift so DB6 is LSB
+    OUT   DX, AL
+    ROL   AL, 1                              ;shift so DB5 is LSB
+    OUT   DX, AL
+    ROL   AL, 1                              ;shift so DB4 is LSB
+    OUT   DX, AL
+    ROL   AL, 1                              ;shift so DB3 is LSB
+    OUT   DX, AL
+    ROL   AL, 1                              ;shift so DB2 is LSB
+    OUT   DX, AL
+    ROL   AL, 1                              ;shift so DB1 is LSB
+    OUT   DX, AL
+    ROL   AL, 1                              ;shift so DB0 is LSB
+    OUT   DX, AL
+)
 
 CGROUP    GROUP    CODE
 DGROUP    GROUP    DATA
@@ -65,9 +133,11 @@ CODE SEGMENT PUBLIC 'CODE'
 ;Description:        This function enables data request interrupts from the
 ;                    MP3 decoder. The function writes ICON0ON to ICON0Address.
 ;                    The function also sends an EOI to clear out the interrupt
-;                    handler.
+;                    handler. While a DMA burst is running the interrupts are
+;                    left off, AudioDMAEH turns them on when it is done.
 ; 
-;Operation:          The function copies ICON0ON to AX and copies ICON0Address
+;Operation:          If DMABusy is set the function does nothing. Otherwise
+;                    the function copies ICON0ON to AX and copies ICON0Address
 ;                    to DX. The function then outputs the address to the
 ;                    peripheral control block. The function then outputs
 ;                    INT0EOI to INTCtrlrEOI to clear the interrupt controller.
@@ -78,7 +148,7 @@ CODE SEGMENT PUBLIC 'CODE'
 ;
 ;Local Variables:    None
 ;
-;Shared Variables:   None
+;Shared Variables:   DMABusy(R) - a DMA burst is running
 ;
 ;Output:             None
 ;
@@ -94,7 +164,7 @@ CODE SEGMENT PUBLIC 'CODE'
 ;
 ;Author:             Timothy Liu
 ;
-;Last Modified       6/2/16
+;Last Modified       6/16/16
 
 AudioIRQOn            PROC    NEAR
                       PUBLIC  AudioIRQOn
@@ -104,6 +174,9 @@ AudioIRQOnStart:                          ;save registers
     PUSH    DX
     PUSHF                                 ;save flag register
     CLI                                   ;shut off interrupts
+    CMP     DMABusy, TRUE                 ;see if a DMA burst is running
+    JE      AudioIRQOnDone                ;yes - AudioDMAEH turns INT0 on
+    ;JMP    AudioIRQOnOutput              ;no - turn it on now
 
 AudioIRQOnOutput:                         ;turn on INT0 data request interrupts
                                           ;and send an EOI
@@ -188,101 +261,252 @@ AudioEHDone:                              ;restore registers and return
 AudioEH        ENDP
 
 
+;Name:               AudioDMAEH
+;
+;Description:        This function handles DMA channel 1 terminal count
+;                    interrupts, which occur when a DMA burst of MP3 data
+;                    has all been written to the CPLD serializer. Data
+;                    request interrupts are off during the burst (the
+;                    level triggered request stays active until the burst
+;                    fills the decoder), so the function turns them back on
+;                    for the next burst.
+; 
+;Operation:          If DMABusy is set it is cleared and ICON0ON is written
+;                    to ICON0Address. If it is not set the audio was halted
+;                    during the burst and the data request interrupts are
+;                    left off. The function then sends a DMA1 EOI.
+;
+;Arguments:          None
+;
+;Return Values:      None
+;
+;Local Variables:    None
+;
+;Shared Variables:   DMABusy(R/W) - cleared (the burst is done)
+;
+;Output:             None
+;
+;Error Handling:     None
+;
+;Algorithms:         None
+;
+;Registers Used:     None
+;
+;Known Bugs:         None
+;
+;Limitations:        None
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/16/16
+
+AudioDMAEH     PROC    NEAR
+               PUBLIC  AudioDMAEH
+
+AudioDMAEHStart:                         ;save the registers
+    PUSH    AX
+    PUSH    DX
+    CMP     DMABusy, TRUE                ;check if a burst was running
+    JNE     AudioDMAEHSendEOI            ;no - audio was halted, leave INT0 off
+    ;JMP    AudioDMAEHIRQOn              ;yes - burst is done
+
+AudioDMAEHIRQOn:                         ;turn data requests back on
+    MOV     DMABusy, FALSE               ;burst is done
+    MOV     DX, ICON0Address             ;address of INT0 control register
+    MOV     AX, ICON0ON                  ;value to start int 0 interrupts
+    OUT     DX, AX
+
+AudioDMAEHSendEOI:
+    MOV     DX, INTCtrlrEOI              ;address of interrupt EOI register
+    MOV     AX, DMA1EOI                  ;DMA1 end of interrupt
+    OUT     DX, AX                       ;output to peripheral control block
+
+AudioDMAEHDone:                          ;restore registers and return
+    POP     DX
+    POP     AX
+    IRET                                 ;IRET from interrupt handlers
+
+AudioDMAEH     ENDP
+
+
 ;Name:               AudioOutput
 ;
 ;Description:        This function sends data serially to the MP3 decoder.
 ;                    The function copies bytes from CurrentBuffer and performs
 ;                    bit banging to output the bytes. The function transfers
 ;                    Bytes_Per_Transfer each time the function is called. If
-;                    CurBuffLeft is equal to zero, then the function swaps
-;                    the NextBuffer into CurrentBuffer and continues playing
-;                    from CurrentBuffer. The function also sets the NeedData
-;                    flag to indicate that more data is need so that
-;                    NextBuffer is filled. The function is called whenever
+;                    CurBuffLeft is equal to zero, then the current buffer
+;                    is done (DoneCount is incremented) and the function
+;                    takes the next descriptor from the audio queue and
+;                    continues playing from its buffer. If that leaves
+;                    AUDIO_LOW_WATER or fewer descriptors in the queue the
+;                    AudioLow flag is set. The function is called whenever
 ;                    the MP3 decoder sends a data request interrupt.
-;                    If both the current buffer and next buffer are empty, the
-;                    function calls Audio_Halt to shut off data request interrupts.
+;                    If the current buffer is empty and the queue is empty,
+;                    the function calls Audio_Halt to shut off data request
+;                    interrupts. If the last buffer was not marked as the end
+;                    of the track this is an underrun and AudioLow is set.
 ;                    Interrupts are not restored until more data is provided.
+;                    If AudioDMA is set the bytes are not bit-banged; instead
+;                    DMA channel 1 is armed to write Bytes_Per_Transfer bytes
+;                    to the CPLD serializer, which shifts them out to the
+;                    decoder. While that DMA burst is running data request
+;                    interrupts are masked (the level triggered request
+;                    stays active for the whole burst), AudioDMAEH turns
+;                    them back on at the DMA terminal count.
 ; 
 ;Operation:          The function first checks if CurBuffLeft is equal to
 ;                    to zero, indicating the current buffer is empty.
-;                    If the current data buffer is empty, the function
-;                    makes the next buffer the current buffer and sets
-;                    NeedData to indicate that a new buffer is needed. If
-;                    the next buffer is also empty, then the function 
-;                    calls Audio_Halt to turns off ICON0 interrupts and returns.
+;                    If the current data buffer is empty and was being
+;                    played (CurActive), DoneCount is incremented. Then if
+;                    QueueCount is zero the function calls Audio_Halt to
+;                    turn off ICON0 interrupts and returns. Otherwise the
+;                    descriptor at QueueHead is copied to CurrentBuffer,
+;                    CurBuffLeft, and CurFlags, QueueHead is advanced
+;                    (mod AUDIO_QUEUE_SIZE), and QueueCount is decremented.
 ;                    If there is data in the current buffer, then the
 ;                    function outputs BytesPerTransfer bytes starting at
 ;                    CurrentBuffer. The address pointed to by CurrentBuffer 
-;                    is copied to ES:SI. AudioOutput copies the byte ES:SI
-;                    points to to AL and outputs the bits serially.  The MSB
-;                    is output to PCS3. After the first bit is output, the
-;                    other bits are shifted to DB0 and output to PCS2
-;                    until the byte is fully output. The function increments
-;                    SI after each byte transfer and outputs BytesPerTransfer
-;                    bytes. After the bytes are output, the function
+;                    is normalized (offset less than 16) once and loaded
+;                    into DS:SI, so the offset can't overflow during the
+;                    burst. The bytes are fetched two at a time with LODSW
+;                    and each byte is output serially (OutWord macro). The
+;                    MSB is output to PCS3. After the first bit is output,
+;                    the other bits are shifted to DB0 and output to PCS2
+;                    until the byte is fully output. The port addresses are
+;                    kept in registers (DH, BL, BH) for the whole burst. A
+;                    full burst is fully unrolled; a partial burst at the
+;                    end of a buffer is output a word at a time in a loop.
+;                    After the bytes are output, the function
 ;                    decrements CurBuffLeft by BytesPerTransfer. The function
 ;                    copies SI to CurrentBuffer[0] to update the offset of
-;                    the buffer. The function copies ES to CurrentBuffer[2] to
+;                    the buffer. The function copies DS to CurrentBuffer[2] to
 ;                    update the segment. CurrentBuffer always points to the next byte
-;                    to output The size of the passed buffers MUST be
-;                    a multiple of BytesPerTransfer. 
+;                    to output. The size of the passed buffers must be a
+;                    whole number of words.
+;                    In DMA mode, after the buffer checks, the normalized
+;                    CurrentBuffer is converted to a 20 bit physical address
+;                    and written to D1SRCH/D1SRCL. DMABusy is set and INT0
+;                    is masked (ICON0OFF), so the handler isn't entered
+;                    again until the burst is done and a buffer is never
+;                    given back before the DMA has read it. The smaller of
+;                    CurBuffLeft and Bytes_Per_Transfer is written to D1TC,
+;                    and D1ConVal is written to D1CON to start the burst.
+;                    The serializer paces the burst with DRQ1 (destination
+;                    synchronized) and the terminal count interrupts to
+;                    AudioDMAEH. CurrentBuffer and CurBuffLeft are then
+;                    updated by the size of the burst.
 ;                    
 ;
 ;Arguments:          None
 ;
 ;Return Values:      None
 ;
-;Local Variables:    CX - Bytes left to transfer
+;Local Variables:    BX - address of the descriptor being taken
+;                    BL - low byte of PCS3Address
+;                    BH - low byte of PCS2Address
+;                    CX - Bytes left to transfer
+;                    DX - port address to output to
 ;                    SI - offset of current buffer pointer
-;                    ES - segment of current buffer pointer
-;
-;Shared Variables:   CurrentBuffer(R/W) - 32 bit address of current data buffer
+;                    DS - segment of current buffer pointer (during burst)
+;
+;Shared Variables:   AudioDMA(R)        - output through DMA channel 1
+;                    DMABusy(W)         - set when a DMA burst is started
+;                    AudioQueue(R)      - descriptors of buffers to play
+;                    AudioLow(W)        - set when the queue runs low
+;                    CurActive(R/W)     - a buffer is being played
+;                    CurrentBuffer(R/W) - 32 bit address of current data buffer
 ;                                         being played from
 ;                    CurBuffLeft(R/W)   - bytes left in the data buffer
-;                    NextBuffer(R)      - 32 bit address of next data buffer
-;                    NextBuffLeft(R)    - bytes left in next data buffer
-;                    NeedData(R/W)      - indicates more data is needed 
+;                    CurFlags(R/W)      - flags of the current buffer
+;                    DoneCount(R/W)     - incremented when a buffer is done
+;                    QueueCount(R/W)    - decremented when a descriptor is taken
+;                    QueueHead(R/W)     - advanced when a descriptor is taken
 ;
 ;Output:             MP3 audio output data output to MP3 decoder through
-;                    DB0
+;                    DB0, or through the CPLD serializer in DMA mode
 ;
-;Error Handling:     None
+;Error Handling:     Running out of data in the middle of a track sets
+;                    AudioLow and halts the audio.
 ;
 ;Algorithms:         None
 ;
-;Registers Used:     AX, CX - these registers are preserved by event handler
+;Data Structures:    Audio queue - circular array of AudioDesc descriptors
+;
+;Registers Used:     AX, CX, DX - these registers are preserved by event
+;                    handler
 ;                    Flag register
 ;
+;Timing:             Clock counts from the 80C188 instruction timings (no
+;                    wait states, interrupt entry, AudioEH and descriptor
+;                    handling not included) for a full 32 byte burst:
+;                                   setup   per byte   burst   finish  total
+;                      old loop       61       121      3888      61    4010
+;                      new loop      106        84      2688      73    2867
+;                    The old loop spent 121 clocks a byte: the byte fetch
+;                    (14), reloading DX twice (8), the 8 bit outputs (72),
+;                    and the counter and segment wrap checks (27). The new
+;                    loop spends 168 clocks a word: LODSW (14), the port
+;                    register moves (8), getting the second byte (2), and
+;                    the 16 bit outputs (144). This
+;                    saves about 1140 clocks a burst (28%). At 128 kbps
+;                    (500 bursts a second) that is about 570,000 clocks a
+;                    second freed for the disk and user interface.
+;                    In DMA mode the function only does a few port writes
+;                    (about 250 clocks including masking INT0) and
+;                    AudioDMAEH about 120 more at the end of the burst;
+;                    the DMA takes 2 bus cycles (8 clocks, more with wait
+;                    states) for each byte, paced by the serializer. The
+;                    CPU is not interrupted by the data requests during
+;                    the burst.
+;
 ;Known Bugs:         None
 ;
-;Limitations:        None
-;
+;Limitations:        The OutWord macro assumes PCS2Address and PCS3Address
+;                    have the same high byte. DMA mode assumes DMA channel 1
+;                    was set up by InitAudioDMA.
+;
 ;Author:             Timothy Liu
 ;
-;Last Modified       5/30/16
+;Last Modified       6/16/16
 
 
 ;Outline
 ;AudioOutput()
 ;    IF    CurBuffLeft = 0:          ;Current buffer going to run out
-;        IF NeedData == True:        ;both buffers are empty - panic!
-;            ICON0 = ICON0Off        ;shut off the interrupt handler
-;            CALL AudioHalt          ;these two are the same things
-;        CurrentBuffer = NextBuffer  ;make the next buffer the current buffer
-;        CurBufferLeft = NextBuffLeft
-;        NeedData = TRUE             ;indicate more data is needed
-;    ELSE:                           ;there is enough data
-;        For i in BytesPerTransfer   ;loop outputting 32 bytes
-;            AL = [CurrentBuffer]    ;load byte to output
-;            SHL                         ;put most significant byte in DB0
-;            OUT AL, PCS3                ;first bit goes to PCS3
-;            For j in LowBits            ;loop outputting other 7 bits
-;                                        ;loop will be unrolled for speed
-;                SHL                     ;shift to next bit
-;                OUT AL, PCS2            ;output the next bit
-;            [CurrentBuffer] += 1           ;increment to next byte
-;        CurBufferLeft -= BytesPerTransfer ;32 fewer bytes in buffer
+;        IF CurActive:               ;the buffer was played - it is done
+;            DoneCount += 1
+;            CurActive = FALSE
+;        IF QueueCount == 0:         ;nothing queued - stop
+;            IF NOT CurFlags.END:    ;not the end of the track - underrun
+;                AudioLow = TRUE
+;            CALL AudioHalt          ;shut off the interrupt handler
+;        CurrentBuffer = AudioQueue[QueueHead]   ;take the next descriptor
+;        QueueHead = (QueueHead + 1) MOD AUDIO_QUEUE_SIZE
+;        QueueCount -= 1
+;        CurActive = TRUE
+;        IF QueueCount <= AUDIO_LOW_WATER:
+;            AudioLow = TRUE         ;indicate the queue is running low
+;    IF AudioDMA:                    ;let DMA channel 1 output the burst
+;        D1SRC = physical address of CurrentBuffer
+;        DMABusy = TRUE              ;INT0 off until the burst is done
+;        ICON0 = ICON0OFF            ;(AudioDMAEH turns it back on)
+;        D1TC = MIN(CurBuffLeft, BytesPerTransfer)
+;        D1CON = D1ConVal            ;start the burst
+;        CurrentBuffer += D1TC, CurBuffLeft -= D1TC
+;        RETURN
+;    DS:SI = normalized CurrentBuffer  ;offset < 16, can't overflow
+;    For i in BytesPerTransfer / 2   ;output 16 words - unrolled for speed
+;        AX = [DS:SI], SI += 2       ;LODSW - load two bytes to output
+;        For each byte AL, AH:
+;            ROL                     ;put most significant bit in DB0
+;            OUT AL, PCS3            ;first bit goes to PCS3
+;            For j in LowBits        ;loop outputting other 7 bits
+;                                    ;loop is unrolled for speed
+;                ROL                 ;shift to next bit
+;                OUT AL, PCS2        ;output the next bit
+;    CurrentBuffer = DS:SI           ;next byte to output
+;    CurBufferLeft -= BytesPerTransfer ;32 fewer bytes in buffer
         
 
 
@@ -290,109 +514,169 @@ AudioOutput        PROC    NEAR
                    PUBLIC  AudioOutput
 
 AudioOutputStart:                            ;starting label - save registers
+    PUSH    BX
     PUSH    SI
-    PUSH    ES
 
 AudioOutputCheckCur:                         ;check if current buffer is empty
     CMP    CurBuffLeft, 0                    ;check no bytes left in buffer
-    JE     AudioOutputCheckNext              ;go check if next buffer empty
+    JE     AudioOutputCheckDone              ;go finish the buffer
     JMP    AudioOutputByteLoopPrep           ;Current buffer not empty - 
                                              ;output data
 
-AudioOutputCheckNext:
-    CMP    NeedData, TRUE                    ;see if next buffer is empty
-    JE     AudioOutputEmpty                  ;both buffers are empty
-    ;JMP    AudioOutputSwap                  ;make NextBuffer -> CurrentBuffer
+AudioOutputCheckDone:                        ;current buffer is empty
+    CMP    CurActive, TRUE                   ;see if it was being played
+    JNE    AudioOutputCheckQueue             ;no - nothing to finish
+    ;JMP   AudioOutputBufferDone             ;yes - it is done now
 
-AudioOutputSwap:                             ;read from NextBuffer
-   MOV    AX, NextBuffer[0]                  ;copy segment of NextBuffer
-   MOV    CurrentBuffer[0], AX               ;make NextBuffer CurrentBuffer
+AudioOutputBufferDone:                       ;played all of the buffer
+    INC    DoneCount                         ;one more buffer done for Update
+    MOV    CurActive, FALSE                  ;not playing a buffer now
+    ;JMP   AudioOutputCheckQueue             ;see if there is another buffer
 
-   MOV    AX, NextBuffer[2]                  ;copy offset of NextBuffer
+AudioOutputCheckQueue:
+    CMP    QueueCount, 0                     ;see if any buffers are queued
+    JE     AudioOutputEmpty                  ;no buffers left to play
+    ;JMP   AudioOutputTake                   ;take the next buffer
+
+AudioOutputTake:                             ;take descriptor at head of queue
+   MOV    BX, QueueHead                      ;get address of the descriptor
+   SHL    BX, DESC_SHIFT
+   ADD    BX, OFFSET(AudioQueue)
+
+   MOV    AX, [BX].DescOffset                ;copy offset of the buffer
+   MOV    CurrentBuffer[0], AX               ;make it the CurrentBuffer
+
+   MOV    AX, [BX].DescSegment               ;copy segment of the buffer
    MOV    CurrentBuffer[2], AX
 
-   MOV    AX, NextBuffLeft                   ;copy bytes left of NextBuffer
+   MOV    AX, [BX].DescBytes                 ;copy bytes in the buffer
    MOV    CurBuffLeft, AX                    ;to CurBuffLeft
 
-   MOV    NeedData, TRUE                     ;indicate more data is needed
-   MOV    NextBuffLeft, 0                    ;the next buffer is now empty
+   MOV    AX, [BX].DescFlags                 ;copy the buffer flags
+   MOV    CurFlags, AX
+
+   INC    QueueHead                          ;move to the next descriptor
+   AND    QueueHead, AUDIO_QUEUE_MASK        ;wrap around the queue
+   DEC    QueueCount                         ;one fewer buffer queued
+   MOV    CurActive, TRUE                    ;now playing this buffer
+
+AudioOutputCheckLow:                         ;see if the queue is running low
+   CMP    QueueCount, AUDIO_LOW_WATER
+   JA     AudioOutputByteLoopPrep            ;enough queued - output data
+   MOV    AudioLow, TRUE                     ;running low - let Update know
    JMP    AudioOutputByteLoopPrep            ;prepare to output data
 
-AudioOutputEmpty:                            ;both audio buffers are empty
+AudioOutputEmpty:                            ;no buffers left to play
+   TEST   CurFlags, AUDIO_END_TRACK          ;see if last buffer ended track
+   JNZ    AudioOutputHalt                    ;yes - expected to run out
+   MOV    AudioLow, TRUE                     ;no - ran out of data (underrun)
+
+AudioOutputHalt:
    CALL   Audio_Halt                         ;switch off audio interrupts
-   JMP    AudioOutputDone                    ;can’t output any data
+   JMP    AudioOutputDone                    ;can't output any data
 
 AudioOutputByteLoopPrep:                     ;prepare to output buffer data
     MOV   CX, CurBuffLeft                    ;number of bytes left in buffer
-    CMP   CX, Bytes_Per_Transfer             ;see if less bytes than full transfer left
-    JBE   AudioOutputAddress                 ;if fewer bytes than full transfer,
-                                             ;go and output MP3 data
-
-AudioOutputFullT:
-    MOV   CX, Bytes_Per_Transfer             ;enough bytes for full transfer - 
-                                             ;overwrite number of bytes left
+    CMP   AudioDMA, TRUE                     ;see how to output it
+    JNE   AudioOutputAddress                 ;bit-bang it out
+    ;JMP  AudioOutputDMA                     ;let DMA channel 1 output it
+
+AudioOutputDMA:                              ;output the burst with DMA
+    CMP   CX, Bytes_Per_Transfer             ;get the size of the burst
+    JBE   AudioOutputDMAAddress              ;rest of buffer fits in a burst
+    MOV   CX, Bytes_Per_Transfer             ;otherwise a full burst
+
+AudioOutputDMAAddress:                       ;get the physical address
+    MOV   BX, CurrentBuffer[0]               ;normalize the buffer pointer
+    MOV   SI, BX                             ;   into BX:SI with SI < 16
+    AND   SI, Para_Mask
+    SHR   BX, BitsPerNibble
+    ADD   BX, CurrentBuffer[2]
+    MOV   AX, BX                             ;low 16 bits of the address are
+    SHL   AX, BitsPerNibble                  ;   the segment times 16 plus
+    OR    AX, SI                             ;   the offset (SI < 16, no carry)
+    MOV   DX, D1SRCL                         ;write them to the DMA source
+    OUT   DX, AX
+    MOV   AX, BX                             ;top 4 bits are the top of
+    SHR   AX, Seg_High_Shift                 ;   the segment
+    MOV   DX, D1SRCH
+    OUT   DX, AX
+
+AudioOutputDMAStart:                         ;start the burst
+    MOV   DMABusy, TRUE                      ;no data requests until the burst
+    MOV   DX, ICON0Address                   ;   is done (the request stays
+    MOV   AX, ICON0OFF                       ;   active during the burst)
+    OUT   DX, AX
+    MOV   AX, CX                             ;bytes to transfer
+    MOV   DX, D1TC
+    OUT   DX, AX
+    MOV   DX, D1Con                          ;arm the channel - the serializer
+    MOV   AX, D1ConVal                       ;   requests each byte
+    OUT   DX, AX
+
+AudioOutputDMAUpdate:                        ;update the shared variables
+    ADD   SI, CX                             ;buffer pointer moves past the
+    MOV   CurrentBuffer[0], SI               ;   burst
+    MOV   CurrentBuffer[2], BX
+    SUB   CurBuffLeft, CX                    ;burst is no bigger than the
+    JMP   AudioOutputDone                    ;   buffer - done with the burst
 
 AudioOutputAddress:                          ;setup address to output from
                                              ;for this interrupt
-    MOV   AX, CurrentBuffer[2]               ;copy buffer segment to ES
-    MOV   ES, AX
-
-    MOV   SI, CurrentBuffer[0]               ;copy buffer offset to SI
-    ;JMP  AudioOutputLoop                    ;go to loop
-
-AudioOutputLoop:
-    CMP   CX, 0                              ;check if no bytes left
-    JE    AudioOutputUpdateShared            ;no bytes left to output
-    MOV   AL, ES:[SI]                        ;copy byte to be transferred
-
-AudioOutputSerial:                           ;serially send data to MP3 - MSB
-                                             ;first
-    MOV   DX, PCS3Address                    ;address to output DB7 to
-    ROL   AL, 1                              ;output MSB on DB0
-    OUT   DX, AL                             ;first bit goes to PCS3 to trigger
-                                             ;BSYNC
-
-    MOV   DX, PCS2Address                    ;address to output bits 0-6
-    ROL   AL, 1                              ;shift so DB6 is LSB
-    OUT   DX, AL                             ;output other bits to PCS2
-    
-    ROL   AL, 1                              ;shift so DB5 is LSB
-    OUT   DX, AL                             ;output other bits to PCS2
-    
-    ROL   AL, 1                              ;shift so DB4 is LSB
-    OUT   DX, AL                             ;output other bits to PCS2
-    
-    ROL   AL, 1                              ;shift so DB3 is LSB
-    OUT   DX, AL                             ;output other bits to PCS2
-    
-    ROL   AL, 1                              ;shift so DB2 is LSB
-    OUT   DX, AL                             ;output other bits to PCS2
-    
-    ROL   AL, 1                              ;shift so DB1 is LSB
-    OUT   DX, AL                             ;output other bits to PCS2
-    
-    ROL   AL, 1                              ;shift so DB0 is LSB
-    OUT   DX, AL                             ;output other bits to PCS2
-
-AudioOutputUpdateByte:
-    DEC   CX                                 ;one fewer byte left to transfer
-    ADD   SI, 1                              ;update pointer to next byte
-    JNC   AudioOutputLoop                    ;SI didn’t overflow - same segment
-                                             ;go back to loop
-    ;JMP  AudioOutputUpdateSegment           ;SI overflowed - update the segment
-
-AudioOutputUpdateSegment:
-    MOV   AX, ES                             ;use accumulator to perform addition
-    ADD   AX, Segment_Overlap                ;change segment so ES:SI points to
-                                             ;next physical address
-    MOV   ES, AX                             ;write new segment back to ES
-    JMP   AudioOutputLoop                    ;go back to loop
+    MOV   BX, CurrentBuffer[0]               ;normalize the buffer pointer so
+    MOV   SI, BX                             ;   the offset is less than 16 and
+    AND   SI, Para_Mask                      ;   can't overflow during a burst
+    SHR   BX, BitsPerNibble                  ;rest of the offset goes into the
+    ADD   BX, CurrentBuffer[2]               ;   segment
+    PUSH  DS                                 ;LODSW reads through DS:SI, so
+    MOV   DS, BX                             ;   point DS at the buffer
+                                             ;(no shared variables until POP DS)
+
+    MOV   DX, PCS2Address                    ;keep low bytes of the PCS2 and
+    MOV   BH, DL                             ;   PCS3 addresses in BH and BL
+    MOV   DX, PCS3Address                    ;   (the high bytes are the same)
+    MOV   BL, DL
+    CLD                                      ;LODSW moves forward in the buffer
+
+    CMP   CX, Bytes_Per_Transfer             ;see if a full burst is left
+    JAE   AudioOutputBurst                   ;yes - output the full burst
+    ;JMP  AudioOutputPartial                 ;no - output what is left
+
+AudioOutputPartial:                          ;less than a burst left (the end
+    SHR   CX, 1                              ;   of a buffer), get words to output
+    JCXZ  AudioOutputPartialDone             ;nothing to output
+
+AudioOutputPartialLoop:                      ;output the words one at a time
+    %OutWord
+    LOOP  AudioOutputPartialLoop             ;until all are output
+
+AudioOutputPartialDone:                      ;done with the partial burst
+    JMP   AudioOutputUpdateShared            ;go update the pointer
+
+AudioOutputBurst:                            ;full burst, fully unrolled
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    %OutWord                                 ;output the burst 2 bytes at a time
+    ;JMP  AudioOutputUpdateShared            ;done with the burst
 
 AudioOutputUpdateShared:                     ;update shared variables
+    MOV    CX, DS                            ;get the buffer segment
+    POP    DS                                ;can access shared variables again
     MOV    CurrentBuffer[0], SI              ;store the buffer location to 
-                                             ;start reading from
-    MOV    AX, ES                            ;store the updated buffer segment
-    MOV    CurrentBuffer[2], AX
+    MOV    CurrentBuffer[2], CX              ;start reading from
     SUB    CurBuffLeft, Bytes_Per_Transfer   ;update number of bytes left in
                                              ;the buffer
     JNC    AudioOutputDone                   ;more than Bytes_Per_Transfer bytes
@@ -401,8 +685,8 @@ AudioOutputUpdateShared:                     ;update shared variables
                                              ;bytes left - CurBuff empty
 
 AudioOutputDone:                             ;function finished
-    POP    ES
     POP    SI
+    POP    BX
     RET
 
 AudioOutput    ENDP
@@ -416,19 +700,19 @@ AudioOutput    ENDP
 ;                    The function multiplies the second argument, the length
 ;                    of the buffer in words, by WORD_SIZE and moves the 
 ;                    product to the shared variable
-;                    CurBuffLeft. The function then calls AudioIRQON enable
-;                    data request interrupts. Finally, the function indicates
-;                    that the next buffer is empty and more data is needed.
+;                    CurBuffLeft. The function empties the audio queue and
+;                    clears the done count and low-water flag. The function
+;                    then calls AudioIRQON enable data request interrupts.
 ; 
 ;Operation:          The function first copies the stack pointer to BP and 
 ;                    indexes into the stack. The function copies the 32 bit 
 ;                    address passed as the first argument to CurrentBuffer.
 ;                    The function indexes into the stack to copy the second
 ;                    argument into CurBuffLeft, which is the number of words
-;                    left in the buffer to play. The function then calls
-;                    AudioIRQON to enable data request
-;                    interrupts. The function writes TRUE to NeedData to indicate
-;                    that the next buffer is empty.
+;                    left in the buffer to play. The buffer is not the end
+;                    of a track. The function resets QueueHead, QueueTail,
+;                    QueueCount, DoneCount, and AudioLow and then calls
+;                    AudioIRQON to enable data request interrupts.
 ;
 ;Arguments:          unsigned short int far * - address of data buffer
 ;                    int - length of buffer in words
@@ -437,9 +721,16 @@ AudioOutput    ENDP
 ;
 ;Local Variables:    None
 ;
-;Shared Variables:   CurrentBuffer(W) - 16 bit address of current data buffer
+;Shared Variables:   AudioLow(W)      - cleared
+;                    CurActive(W)     - set (playing a buffer)
+;                    CurrentBuffer(W) - 16 bit address of current data buffer
 ;                                       being played from
 ;                    CurBuffLeft(W) -   number of words left in the data buffer
+;                    CurFlags(W)      - cleared (not the end of the track)
+;                    DoneCount(W)     - cleared
+;                    QueueCount(W)    - cleared (queue is empty)
+;                    QueueHead(W)     - reset to start of queue
+;                    QueueTail(W)     - reset to start of queue
 ;
 ;Output:             None
 ;
@@ -451,11 +742,11 @@ AudioOutput    ENDP
 ;
 ;Known Bugs:         None
 ;
-;Limitations:        None
-;
+;Limitations:        Must only be called when audio output is halted.
+;
 ;Author:             Timothy Liu
 ;
-;Last Modified       5/30/16
+;Last Modified       6/16/16
 
 Audio_Play        PROC    NEAR
                   PUBLIC  Audio_Play
@@ -476,9 +767,15 @@ AudioPlayArgs:                           ;pull the arguments from the stack
     SHL     AX, 1                        ;double to convert to number of bytes
     MOV     CurBuffLeft, AX              ;load number of bytes left
 
-AudioPlayNeedData:                       ;indicate that the next buffer is empty
-    MOV     NextBuffLeft, 0              ;next buffer is empty
-    MOV     NeedData, TRUE               ;more data is needed
+    MOV     CurFlags, 0                  ;not the end of the track
+    MOV     CurActive, TRUE              ;playing this buffer
+
+AudioPlayQueue:                          ;nothing queued behind this buffer
+    MOV     QueueHead, 0                 ;queue is empty
+    MOV     QueueTail, 0
+    MOV     QueueCount, 0
+    MOV     DoneCount, 0                 ;no buffers done yet
+    MOV     AudioLow, FALSE              ;not low on data yet
 
 AudioPlayIRQON:
     CALL    AudioIRQOn                   ;turn audio data request interrupts on
@@ -495,11 +792,16 @@ Audio_Play    ENDP
 ;Name:               Audio_Halt
 ;
 ;Description:        This function terminates the output of audio data. The 
-;                    function does not return any value.
+;                    function does not return any value. A DMA burst that
+;                    is running is stopped.
 ; 
 ;Operation:          The function writes the value ICON0OFF to ICON0ADDRESS.
 ;                    This disables interrupts from INT0 and disables MP3
-;                    audio data request interrupts. The function then returns.
+;                    audio data request interrupts. In DMA mode D1ConStopVal
+;                    is written to D1CON to disarm the channel and DMABusy
+;                    is cleared so AudioDMAEH doesn't turn INT0 back on.
+;                    This is done with interrupts off. The function then
+;                    returns.
 ;
 ;Arguments:          None
 ;
@@ -507,7 +809,8 @@ Audio_Play    ENDP
 ;
 ;Local Variables:    None
 ;
-;Shared Variables:   None
+;Shared Variables:   AudioDMA(R) - output through DMA channel 1
+;                    DMABusy(W)  - cleared
 ;
 ;Output:             None
 ;
@@ -523,7 +826,7 @@ Audio_Play    ENDP
 ;
 ;Author:             Timothy Liu
 ;
-;Last Modified       5/21/16
+;Last Modified       6/16/16
 
 Audio_Halt        PROC    NEAR
                   PUBLIC  Audio_Halt
@@ -531,13 +834,26 @@ Audio_Halt        PROC    NEAR
 AudioHaltStart:                        ;starting label - save registers
     PUSH    AX
     PUSH    DX
+    PUSHF                              ;save flag register
+    CLI                                ;no DMA1 interrupt while stopping
 
 AudioHaltWrite:                        ;turn off data request interrupts
     MOV    DX, ICON0Address            ;address of INT0 control register
     MOV    AX, ICON0OFF                ;value to turn off data request IRQ
     OUT    DX, AX                      ;shut off interrupts
+    CMP    AudioDMA, TRUE              ;see if a DMA burst may be running
+    JNE    AudioHaltDone               ;no - done
+    ;JMP   AudioHaltDMA                ;yes - stop it
+
+AudioHaltDMA:                          ;stop any DMA burst
+    MOV    DX, D1Con                   ;disarm the channel
+    MOV    AX, D1ConStopVal
+    OUT    DX, AX
+    MOV    DMABusy, FALSE              ;no burst running - AudioDMAEH must
+                                       ;   not turn INT0 back on
 
 AudioHaltDone:                         ;done - restore labels and return
+    POPF                               ;restore the flag register
     POP    DX
     POP    AX
     RET
@@ -547,43 +863,26 @@ Audio_Halt    ENDP
 
 ;Name:               Update
 ;
-;Description:        This function stores the address of a fresh audio buffer
-;                    if the secondary audio buffer is empty. The function
-;                    returns TRUE if the passed buffer was stored and a new
-;                    buffer with more audio data is needed. The function
-;                    returns FALSE if more audio data is not needed. The
-;                    function is passed the address of the new buffer, and the
-;                    length of the new buffer. If the new audio buffer is
-;                    stored, then the length of the new audio buffer is 
-;                    stored in NextBufferLeft.
+;Description:        This function adds a fresh audio buffer to the audio
+;                    queue if there is room in the queue. The function
+;                    returns TRUE if the passed buffer was queued and FALSE
+;                    if the queue is full. The buffer is not marked as the
+;                    end of a track. The function is passed the address of
+;                    the new buffer, and the length of the new buffer.
 ; 
 ;Operation:          The function copies SP to BP and uses the base pointer
-;                    to index into the stack. The checks the flag NeedData
-;                    to see if more data is needed. If more data is needed,
-;                    then the function copies the first argument - the address
-;                    of the data buffer - into NextBuffer. Next, 
-;                    the function multiplies the second argument (the 
-;                    address of the new buffer) by WORD_SIZE and moves the
-;                    product into NextBufferLeft, which is the number of 
-;                    bytes remaining in NextBuffer. The function then resets
-;                    the NeedData flag to FALSE, indicating that
-;                    there is data in NextBuffer. If the passed pointer is
-;                    used, then the function returns TRUE. If more data is
-;                    not needed (NeedData was False) , then the function                  
-;                    does nothing but return FALSE. The function calls
-;                    AudioIRQOn to turn on INT0 data request interrupts if the
-;                    new buffer was used.
+;                    to index into the stack. It loads the buffer address
+;                    and length into registers with no flags and calls
+;                    AudioQueueAdd to queue the buffer.
 ;
 ;Arguments:          unsigned short int far* - address of new audio buffer
 ;                    int - length of the new buffer in words
 ;
-;Return Values:      TRUE if more data was needed; FALSE otherwise
+;Return Values:      TRUE if the buffer was queued; FALSE otherwise
 ;
 ;Local Variables:    None
 ;
-;Shared Variables:   NextBuffer(W) - pointer to second data buffer
-;                    NextBufferLen(W) - length of the passed data buffer
-;                    NeedData(R/W) - indicates if more data is needed
+;Shared Variables:   None
 ;
 ;Output:             None
 ;
@@ -595,11 +894,11 @@ Audio_Halt    ENDP
 ;
 ;Known Bugs:         None
 ;
-;Limitations:        None
-;
+;Limitations:        None
+;
 ;Author:             Timothy Liu
 ;
-;Last Modified       5/30/16
+;Last Modified       6/16/16
 
 Update            PROC    NEAR
                   PUBLIC  Update
@@ -607,53 +906,384 @@ Update            PROC    NEAR
 UpdateStart:                            ;prepare BP to index into stack
     PUSH    BP                          ;preserve BP
     MOV     BP, SP                      ;use BP as stack index
+    PUSH    BX                          ;save registers
+    PUSH    CX
+    PUSH    DX
+
+UpdateQueue:                            ;queue the buffer
+    MOV    AX, SS:[BP+4]                ;offset of the new buffer
+    MOV    BX, SS:[BP+6]                ;segment of the new buffer
+    MOV    CX, SS:[BP+8]                ;length of the new buffer in words
+    MOV    DX, 0                        ;not the end of the track
+    CALL   AudioQueueAdd                ;AX is TRUE if the buffer was queued
+
+UpdateDone:
+    POP    DX
+    POP    CX
+    POP    BX
+    POP    BP
+    RET
+
+
+Update        ENDP
+
+
+;Name:               Audio_Queue(unsigned short int far *, int, int)
+;
+;Description:        This function adds a fresh audio buffer to the audio
+;                    queue if there is room in the queue, the same as
+;                    Update. The third argument is TRUE if the buffer is the
+;                    last one of a track so running out of data after it
+;                    is not an underrun. The function returns TRUE if the
+;                    buffer was queued and FALSE if the queue is full.
+; 
+;Operation:          The function copies SP to BP and uses the base pointer
+;                    to index into the stack. It loads the buffer address
+;                    and length into registers, sets the AUDIO_END_TRACK
+;                    flag if the third argument is non-zero, and calls
+;                    AudioQueueAdd to queue the buffer.
+;
+;Arguments:          unsigned short int far* - address of new audio buffer
+;                    int - length of the new buffer in words
+;                    int - TRUE if the buffer ends a track
+;
+;Return Values:      TRUE if the buffer was queued; FALSE otherwise
+;
+;Local Variables:    None
+;
+;Shared Variables:   None
+;
+;Output:             None
+;
+;Error Handling:     None
+;
+;Algorithms:         None
+;
+;Registers Used:     AX
+;
+;Known Bugs:         None
+;
+;Limitations:        None
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/16/16
 
-UpdateCheckNeed:                        ;see if more data is needed
-    CMP    NeedData, FALSE              ;
-    JE     UpdateNoNeed                 ;next buffer filled - no data needed
-    ;JMP   UpdateNextEmpty              ;more data is needed
+Audio_Queue       PROC    NEAR
+                  PUBLIC  Audio_Queue
 
-UpdateNextEmpty:                        ;next buffer is empty
+AudioQueueStart:                        ;prepare BP to index into stack
+    PUSH    BP                          ;preserve BP
+    MOV     BP, SP                      ;use BP as stack index
+    PUSH    BX                          ;save registers
+    PUSH    CX
+    PUSH    DX
+
+AudioQueueArgs:                         ;get the buffer from the stack
     MOV    AX, SS:[BP+4]                ;offset of the new buffer
-    MOV    NextBuffer[0], AX            ;load offset of the new buffer
+    MOV    BX, SS:[BP+6]                ;segment of the new buffer
+    MOV    CX, SS:[BP+8]                ;length of the new buffer in words
+    MOV    DX, 0                        ;assume not the end of the track
+    CMP    WORD PTR SS:[BP+10], FALSE   ;check the end of track argument
+    JE     AudioQueueAdd1               ;not the end - queue it
+    MOV    DX, AUDIO_END_TRACK          ;end of the track - set the flag
+
+AudioQueueAdd1:                         ;queue the buffer
+    CALL   AudioQueueAdd                ;AX is TRUE if the buffer was queued
+
+AudioQueueDone:
+    POP    DX
+    POP    CX
+    POP    BX
+    POP    BP
+    RET
+
+
+Audio_Queue   ENDP
 
-    MOV    AX, SS:[BP+6]                ;segment of the new buffer
-    MOV    NextBuffer[2], AX            ;load the offset of the new buffer
 
-    MOV    AX, SS:[BP+8]                ;length of the new buffer in words
-    SHL    AX, 1                        ;double to get length of buffer in bytes
-    MOV    NextBuffLeft, AX             ;store the length in bytes
+;Name:               AudioQueueAdd
+;
+;Description:        This function adds a buffer descriptor to the tail of
+;                    the audio queue if the queue isn't full and turns on
+;                    data request interrupts (in case the audio ran out of
+;                    data and halted). It returns TRUE if the buffer was
+;                    queued and FALSE if the queue was full.
+; 
+;Operation:          If QueueCount is less than AUDIO_QUEUE_SIZE the
+;                    passed address, length (doubled to get bytes), and
+;                    flags are written to the descriptor at QueueTail and
+;                    QueueTail is advanced (mod AUDIO_QUEUE_SIZE). Then
+;                    QueueCount is incremented. This is a single
+;                    instruction so the event handler either sees the whole
+;                    descriptor or doesn't see it at all. Finally
+;                    AudioIRQOn is called.
+;
+;Arguments:          AX - offset of the buffer
+;                    BX - segment of the buffer
+;                    CX - length of the buffer in words
+;                    DX - descriptor flags
+;
+;Return Values:      AX - TRUE if the buffer was queued; FALSE otherwise
+;
+;Local Variables:    SI - address of the descriptor
+;
+;Shared Variables:   AudioQueue(W)  - descriptor written
+;                    QueueCount(R/W) - incremented
+;                    QueueTail(R/W) - advanced
+;
+;Output:             None
+;
+;Error Handling:     None
+;
+;Algorithms:         None
+;
+;Data Structures:    Audio queue - circular array of AudioDesc descriptors
+;
+;Registers Used:     AX, CX
+;
+;Known Bugs:         None
+;
+;Limitations:        None
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/16/16
+
+AudioQueueAdd     PROC    NEAR
+
+AudioQueueAddStart:                     ;save registers
+    PUSH    SI
+
+AudioQueueAddCheck:                     ;see if there is room in the queue
+    CMP    QueueCount, AUDIO_QUEUE_SIZE
+    JAE    AudioQueueAddFull            ;queue is full - can't add buffer
+    ;JMP   AudioQueueAddStore           ;room - add the buffer
+
+AudioQueueAddStore:                     ;write the descriptor at the tail
+    MOV    SI, QueueTail                ;get address of the descriptor
+    SHL    SI, DESC_SHIFT
+    ADD    SI, OFFSET(AudioQueue)
+
+    MOV    [SI].DescOffset, AX          ;store the buffer address
+    MOV    [SI].DescSegment, BX
+    SHL    CX, 1                        ;double to get length in bytes
+    MOV    [SI].DescBytes, CX           ;store the length
+    MOV    [SI].DescFlags, DX           ;store the flags
+
+    INC    QueueTail                    ;move tail to next descriptor
+    AND    QueueTail, AUDIO_QUEUE_MASK  ;wrap around the queue
+    INC    QueueCount                   ;descriptor is now in the queue
 
-    MOV    NeedData, False              ;NextBuffer is filled - no need for data
     CALL   AudioIRQOn                   ;turn on data request interrupts
     MOV    AX, TRUE                     ;passed buffer was used
-    JMP    UpdateDone
+    JMP    AudioQueueAddDone
 
-UpdateNoNeed:
-    MOV    AX, FALSE                    ;not ready for more data
+AudioQueueAddFull:
+    MOV    AX, FALSE                    ;no room for the buffer
 
-UpdateDone:
-    POP    BP
+AudioQueueAddDone:
+    POP    SI
     RET
 
 
-Update        ENDP
+AudioQueueAdd ENDP
+
+
+;Name:               Audio_Done
+;
+;Description:        This function returns the number of queued buffers
+;                    that have been completely played since the last call
+;                    (or since Audio_Play was called). Those buffers can be
+;                    reused.
+; 
+;Operation:          DoneCount is exchanged with zero. The exchange is a
+;                    single instruction so no count from the event handler
+;                    is lost.
+;
+;Arguments:          None
+;
+;Return Values:      AX - number of buffers done
+;
+;Local Variables:    None
+;
+;Shared Variables:   DoneCount(R/W) - returned and cleared
+;
+;Output:             None
+;
+;Error Handling:     None
+;
+;Algorithms:         None
+;
+;Registers Used:     AX
+;
+;Known Bugs:         None
+;
+;Limitations:        None
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/16/16
+
+Audio_Done        PROC    NEAR
+                  PUBLIC  Audio_Done
+
+AudioDoneGet:                           ;get and clear the count
+    MOV    AX, 0
+    XCHG   AX, DoneCount
+    RET
+
+
+Audio_Done    ENDP
+
+
+;Name:               Audio_Low
+;
+;Description:        This function returns TRUE if the audio queue has run
+;                    low (AUDIO_LOW_WATER or fewer buffers queued behind the
+;                    one playing) or run out of data since the last call and
+;                    FALSE otherwise.
+; 
+;Operation:          AudioLow is exchanged with FALSE. The exchange is a
+;                    single instruction so a flag set by the event handler
+;                    is not lost.
+;
+;Arguments:          None
+;
+;Return Values:      AL - TRUE if the queue ran low; FALSE otherwise
+;
+;Local Variables:    None
+;
+;Shared Variables:   AudioLow(R/W) - returned and cleared
+;
+;Output:             None
+;
+;Error Handling:     None
+;
+;Algorithms:         None
+;
+;Registers Used:     AX
+;
+;Known Bugs:         None
+;
+;Limitations:        None
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/16/16
+
+Audio_Low         PROC    NEAR
+                  PUBLIC  Audio_Low
+
+AudioLowGet:                            ;get and clear the flag
+    MOV    AX, FALSE
+    XCHG   AL, AudioLow
+    RET
+
+
+Audio_Low     ENDP
+
+
+;Name:               InitAudioDMA
+;
+;Description:        This function selects how MP3 data is output to the
+;                    decoder. If AUDIO_DMA_MODE is TRUE, DMA channel 1 is set
+;                    up to write to the CPLD serializer and AudioOutput starts
+;                    a DMA burst for each data request. Otherwise the data
+;                    is bit-banged out by the CPU.
+; 
+;Operation:          The function copies AUDIO_DMA_MODE to AudioDMA and
+;                    clears DMABusy. In DMA mode it writes D1ConStopVal to
+;                    D1CON so the channel is disarmed, clears D1TC so no
+;                    burst is running, and writes the serializer address to
+;                    D1DSTH/D1DSTL. The destination is not incremented, so
+;                    it only has to be written once. Finally DMA1CtrlVal is
+;                    written to the DMA1 interrupt control register so the
+;                    terminal count interrupts AudioDMAEH.
+;
+;Arguments:          None
+;
+;Return Values:      None
+;
+;Local Variables:    None
+;
+;Shared Variables:   AudioDMA(W) - set to AUDIO_DMA_MODE
+;                    DMABusy(W)  - cleared
+;
+;Output:             None
+;
+;Error Handling:     None
+;
+;Algorithms:         None
+;
+;Registers Used:     AX, DX
+;
+;Known Bugs:         None
+;
+;Limitations:        Must be called with interrupts disabled, before any
+;                    audio is played and after InstallDreqHandler.
+;
+;Author:             Timothy Liu
+;
+;Last Modified       6/16/16
+
+InitAudioDMA      PROC    NEAR
+                  PUBLIC  InitAudioDMA
+
+InitAudioDMAMode:                       ;select the output mode
+    MOV    AudioDMA, AUDIO_DMA_MODE
+    MOV    DMABusy, FALSE               ;no DMA burst running
+    CMP    AudioDMA, TRUE               ;see if DMA channel 1 is used
+    JNE    InitAudioDMADone             ;no - nothing to set up
+    ;JMP   InitAudioDMAChannel          ;yes - set up the channel
+
+InitAudioDMAChannel:                    ;set up DMA channel 1
+    MOV    DX, D1Con                    ;make sure the channel is disarmed
+    MOV    AX, D1ConStopVal
+    OUT    DX, AX
+    MOV    DX, D1TC                     ;no burst running
+    MOV    AX, 0
+    OUT    DX, AX
+    MOV    DX, D1DSTL                   ;always write to the serializer
+    MOV    AX, SerialAddress
+    OUT    DX, AX
+    MOV    DX, D1DSTH
+    MOV    AX, D1DSTHVal
+    OUT    DX, AX
+    MOV    DX, DMA1CtrlAddress          ;interrupt at the end of each burst
+    MOV    AX, DMA1CtrlVal
+    OUT    DX, AX
+    ;JMP   InitAudioDMADone
+
+InitAudioDMADone:                       ;done - return
+    RET
+
+
+InitAudioDMA  ENDP
 
 CODE ENDS
 
 ;start data segment
 
-
-DATA    SEGMENT    PUBLIC  'DATA'
-
+
+DATA    SEGMENT    PUBLIC  'DATA'
+
 CurrentBuffer    DW FAR_SIZE DUP (?)     ;32 bit address of current audio buffer
-NextBuffer       DW FAR_SIZE DUP (?)     ;32 bit address of next audio buffer
 CurBuffLeft      DW               ?      ;bytes left in current buffer
-NextBuffLeft     DW               ?      ;bytes left in next buffer
+CurFlags         DW               ?      ;flags of the current buffer
+CurActive        DB               ?      ;TRUE while a buffer is being played
+
+AudioQueue       AudioDesc AUDIO_QUEUE_SIZE DUP (<>) ;buffers queued to play
+QueueHead        DW               ?      ;descriptor to play next
+QueueTail        DW               ?      ;descriptor to fill next
+QueueCount       DW               ?      ;descriptors waiting in the queue
+
+DoneCount        DW               ?      ;buffers played since Audio_Done
+AudioLow         DB               ?      ;flag set when the queue runs low
+
+AudioDMA         DB               ?      ;TRUE if output through DMA channel 1
+DMABusy          DB               ?      ;TRUE while a DMA burst is running
 
-NeedData         DB               ?      ;flag set when NextBuffer is empty
-                                         ;and more data is needed
-
 DATA ENDS
 
-        END
\ No newline at end of file
+        END
@@ -0,0 +1,150 @@
+#!/bin/sh
+# benchmark the jukebox host build (build it with host.sh first)
+#
+#    sh bench.sh [-d profile] [-n count] image ...
+#
+# Each image is run through the same key script: start up (boot), count
+# Track Downs, Play (until the audio starts), Stop, Fast Forward at each
+# FFRev_rate step, Reverse, and Play and Stop again.  Fast forward and
+# reverse only move the track position (from the frame index), the disk is
+# read when play resumes there, so each Fast Forward starts from play at
+# the start of the track, goes for 2 seconds, and then presses Play and
+# waits for the audio (ff_rate is that time and those reads).  Reverse
+# starts from where the fastest Fast Forward resumed play, goes back at
+# that rate for 1 second (not back to the start, which play may have kept
+# buffered), and resumes play the same way.  The disk profile (see disk.prf) sets how long the disk reads
+# take, without one they take no time.  Images with large directories, deep
+# trees, or fragmented files can be made with mkimage (built by host.sh).
+# The output is CSV, one line per image and operation:
+#
+#    image,op,count,total_us,mean_us,max_us,reads,blocks,bytes
+#
+# where the times are simulated time and reads, blocks, and bytes are the
+# totals from the disk for all count of the operation.
+
+juke=./juke
+profile=
+count=500
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+    -d) profile="-d $2"; shift 2 ;;
+    -n) count="$2"; shift 2 ;;
+    -*) echo "usage: $0 [-d profile] [-n count] image ..." >&2; exit 1 ;;
+    *)  break ;;
+    esac
+done
+if [ $# -eq 0 ]; then
+    echo "usage: $0 [-d profile] [-n count] image ..." >&2
+    exit 1
+fi
+
+# the fast forward/reverse rates come from mp3defs.h
+min=`awk '$2 == "MIN_FFREV_RATE" { print $3 }' mp3defs.h`
+max=`awk '$2 == "MAX_FFREV_RATE" { print $3 }' mp3defs.h`
+delta=`awk '$2 == "DELTA_FFREV_RATE" { print $3 }' mp3defs.h`
+
+script=`mktemp`
+trap 'rm -f "$script"' 0
+
+# build the key script (the start up is marked so it isn't counted in the
+# first Track Down)
+{
+    echo mark boot
+
+    i=0
+    while [ $i -lt $count ]; do
+        echo down
+        echo mark down
+        i=`expr $i + 1`
+    done
+
+    echo play
+    echo audio 60000
+    echo mark play
+    echo wait 2000
+    echo mark playing
+    echo stop
+    echo mark stop
+
+    # fast forward at each rate from play (each faster steps up from the
+    # minimum) and resume play there, the last one is left playing for the
+    # reverse
+    rate=$min
+    steps=0
+    while [ $rate -le $max ]; do
+        echo play
+        echo audio 60000
+        echo mark play
+        echo ff
+        i=0
+        while [ $i -lt $steps ]; do
+            echo faster
+            i=`expr $i + 1`
+        done
+        echo wait 2000
+        echo play
+        echo audio 60000
+        echo mark ff_$rate
+        if [ $rate -lt $max ]; then
+            echo stop
+            echo mark stop
+        fi
+        if [ $rate -eq $max ]; then
+            rate=`expr $max + 1`
+        else
+            rate=`expr $rate + $delta`
+            if [ $rate -gt $max ]; then
+                rate=$max
+            fi
+        fi
+        steps=`expr $steps + 1`
+    done
+
+    # reverse at the fastest rate from there and resume play
+    echo rev
+    i=1
+    while [ $i -lt $steps ]; do
+        echo faster
+        i=`expr $i + 1`
+    done
+    echo wait 1000
+    echo play
+    echo audio 60000
+    echo mark reverse
+    echo stop
+    echo mark stop
+
+    echo play
+    echo audio 60000
+    echo mark play
+    echo wait 2000
+    echo mark playing
+    echo stop
+    echo mark stop
+    echo quit
+} > "$script"
+
+# run each image and total the marks by operation (in order)
+echo "image,op,count,total_us,mean_us,max_us,reads,blocks,bytes"
+for image in "$@"; do
+    $juke $profile "$image" "$script" | awk -v image="$image" '
+        $3 == "mark" {
+            if (!($4 in n))
+                ops[nops++] = $4
+            n[$4]++
+            t[$4] += $5
+            if ($5 > m[$4])
+                m[$4] = $5
+            r[$4] += $6
+            b[$4] += $7
+            x[$4] += $8
+        }
+        END {
+            for (i = 0; i < nops; i++) {
+                op = ops[i]
+                printf "%s,%s,%d,%d,%.1f,%d,%d,%d,%d\n", image, op, n[op],
+                       t[op], t[op] / n[op], m[op], r[op], b[op], x[op]
+            }
+        }'
+done
@@ -0,0 +1,96 @@
+#!/bin/sh
+# check every file of an mkimage image by browsing to it (build the jukebox
+# host build and mkimage with host.sh first)
+#
+#    sh check.sh [-d profile] image [manifest]
+#
+# The key script is made from the manifest (the image name with .man added
+# if none is given).  It walks the directory tree depth first the way a
+# user would: Track Down to each file and check it, Play to go into each
+# subdirectory, and Play on .. to come back out (which goes back to the
+# first entry of the parent).  Each check reads the file through the FAT
+# code and compares it with the MP3 file it was made from (see hostsys.c),
+# so an image made with mkimage -j checks the library index (the names,
+# sizes, and extents all come from it).  The failed checks are output along
+# with a count and the disk totals, and the exit status is 0 only if every
+# file in the manifest checked ok.
+
+juke=./juke
+profile=
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+    -d) profile="-d $2"; shift 2 ;;
+    -*) echo "usage: $0 [-d profile] image [manifest]" >&2; exit 1 ;;
+    *)  break ;;
+    esac
+done
+if [ $# -eq 0 ] || [ $# -gt 2 ]; then
+    echo "usage: $0 [-d profile] image [manifest]" >&2
+    exit 1
+fi
+image="$1"
+manifest="${2:-$1.man}"
+
+script=`mktemp`
+trap 'rm -f "$script"' 0
+
+# build the key script (each key is followed by a wait so the keys don't
+# repeat)
+awk -F'\t' -v manifest="$manifest" '
+    function parent(path) {
+        sub(/\/[^\/]*$/, "", path)
+        return path
+    }
+    function move(from, to) {
+        for (; from < to; from++)
+            print "down\nwait 600"
+        for (; from > to; from--)
+            print "up\nwait 600"
+        return to
+    }
+    function walk(dir,    first, pos, i) {
+        # subdirectories start with .., the root does not
+        first = (dir == "") ? 0 : 1
+        pos = 0
+        # the files come first, then the subdirectories
+        for (i = 0; i < files[dir]; i++) {
+            pos = move(pos, first + i)
+            print "check " manifest
+        }
+        for (i = 0; i < subs[dir]; i++) {
+            pos = move(pos, first + files[dir] + i)
+            print "play\nwait 600"
+            walk(subdir[dir, i])
+            pos = 0
+        }
+        # and back out through ..
+        if (dir != "") {
+            move(pos, 0)
+            print "play\nwait 600"
+        }
+    }
+    $1 == "d" { d = parent($2); subdir[d, subs[d]++] = $2 }
+    $1 == "f" { d = parent($2); files[d]++ }
+    END {
+        walk("")
+        print "quit"
+    }' "$manifest" > "$script"
+
+# run it and count the checks
+total=`grep -c '^f	' "$manifest"`
+$juke $profile "$image" "$script" | awk -v total="$total" -v image="$image" '
+    $3 == "check" {
+        n++
+        if ($(NF - 1) == "ok")
+            ok++
+        else
+            print
+    }
+    $3 == "disk" {
+        print
+    }
+    END {
+        printf "%s: %d of %d files ok\n", image, ok, total
+        exit (ok != total)
+    }'
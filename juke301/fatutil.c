@@ -11,51 +11,142 @@
    This file contains utility functions for reading a FAT16 hard drive.  The
    current directory information and the path are kept locally in this file.
    The functions included are:
+      at_dir_end             - did the last move stop at the end of the directory
       cur_isDir              - is the current file a directory
       cur_isParentDir        - is the current file the parent directory (..)
+      fill_tag_cache         - read the ID3 tags and probes of nearby files ahead
       get_cur_file_attr      - get the attributes of the current file
       get_cur_file_name      - get the name of the current file
       get_cur_file_sector    - get the starting sector of the current file
       get_cur_file_size      - get the size in bytes of the current file
       get_cur_file_time      - get the time of the current file
       get_file_blocks        - get data blocks from the current file
+      get_file_blocks_poll   - check if an asynchronous file read is done
+      get_file_blocks_start  - start reading data blocks from the current file
       get_first_dir_entry    - get the first file in the current directory
       get_ID3_tag            - get the possible ID3 tag for the current file
       get_next_dir_entry     - get next file in the current directory
       get_partition_start    - get the start of the current partition
       get_previous_dir_entry - get previous file in the current directory
+      get_saved_probe        - get the saved probe results for the current file
+      get_sector_cache_hits  - get the number of sector cache hits
+      get_sector_cache_misses- get the number of sector cache misses
       init_FAT_system        - initialize the FAT file system
+      move_dir_entry         - move by a number of files in the directory
+      save_probe             - save the probe results of the current file
 
    The local functions included are:
+      build_dir_table        - fill the directory table for a directory
+      build_extent_index     - fill the extent index for a file
+      find_dir_index         - find the current directory in the library index
+      find_index_file        - find and check the library index file
       get_block_info         - get file FAT information for a block
+      get_cached_blocks      - get sectors through the sector cache
+      get_contig_count       - get number of blocks to read contiguously
       get_contig_sectors     - get contiguous sectors of a file
+      get_dir_size           - get the number of sectors in a directory
       get_dir_tos_name       - get name on the top of the stack
       get_dir_tos_sector     - get starting sector of directory at tos
+      get_dir_tos_stamp      - get time and date of directory at tos
       get_disk_blocks        - get sectors of a file from the disk
+      get_FAT_entry          - get a cluster's FAT entry from the FAT mirror
       get_file_info          - fill in passed structure with file information
+      get_next_dir_walk      - get next file by reading directory sectors
+      get_previous_dir_walk  - get previous file by reading directory sectors
       init_dir_stack         - initialize the directory name stack
+      load_FAT_mirror        - read FAT sectors into the FAT mirror
+      load_index_entry       - make a library index entry the current file
+      load_table_entry       - make a directory table entry the current file
+      make_ID3_tag           - build an ID3 tag from its saved parts
+      move_index_entry       - move through the library index entries
       new_directory          - entering a new directory, update the stack
+      read_ID3_tag           - read the ID3 tag at the end of a file
+      read_index_sector      - read a sector of the library index file
+      save_probe_cache       - save a directory table entry's probe results
+      save_tag_cache         - save a directory table entry's ID3 tag
+      setup_entry_info       - set the block information of the current file
+      start_disk_xfer        - start the next disk read of a file read
+      tag_cached             - check if an entry's ID3 tag is cached
 
    The locally global variable definitions included are:
+      cache_age              - time each sector cache block was last used
+      cache_hits             - number of sectors found in the sector cache
+      cache_misses           - number of sectors read into the sector cache
+      cache_sector           - sector number held in each sector cache block
+      cache_time             - time of the last sector cache access
+      cur_attr               - attributes of the current entry
       cur_dir                - current file entry in dir_sector[]
+      cur_fdate              - date of the current entry
+      cur_ftime              - time of the current entry
       cur_info               - file information of current directory entry
+      cur_parent             - flag indicating current entry is ".."
+      cur_size               - size in bytes of the current entry
+      dir_end                - flag indicating the last move stopped at the end
+      dir_indexed            - flag indicating directory is in the library index
       dir_info               - file information of current directory
       dir_offset             - current sector offset in the current directory
       dir_sector             - array of directory entries in a sector
+      dir_names              - names of the directory table entries
+      dir_stamp              - time and date of the current directory's entry
+      dir_table              - directory table records of current directory
+      dir_tabled             - flag indicating directory is in the table
       dirclusterstack        - stack of starting directory cluster numbers
       dirname                - name of current directory
       dirnames               - names of directories on stack as a char []
       dirnamestack           - stack of name positions in dirnames[]
       dirstack_ptr           - the stack pointer into directory info stacks
+      dirstampstack          - stack of directory times and dates
+      extent_next            - next cluster after the last indexed extent
+      extents                - extent index of the current file
       fat16                  - flag indicating FAT16 or FAT32 disk
+      FAT_mirror             - memory holding the FAT mirror (PC version)
+      FAT_size               - number of sectors in one FAT
       filename               - filename of current directory entry
       first_FAT_sector       - sector number of the start of the first FAT
       first_file_sector      - sector of the first file on the hard drive
+      idx_artist             - artist of the current library index entry
+      idx_buf                - sector of the library index file
+      idx_buf_sector         - library index sector in idx_buf[]
+      idx_bit_rate           - bit rate of the current library index entry
+      idx_count              - number of index entries in current directory
+      idx_cur                - current index entry in current directory
+      idx_dir_sector         - first directory record sector of the index
+      idx_entry_sector       - first entry record sector of the index
+      idx_ext_buf            - sector of library index extent or seek table records
+      idx_ext_sector         - library index sector in idx_ext_buf[]
+      idx_extent_sector      - first extent record sector of the index
+      idx_first              - first index entry of the current directory
+      idx_flags              - flags of the current library index entry
+      idx_frames             - frames in the current library index entry
+      idx_info               - file information of the library index file
+      idx_num_dirs           - number of directory records in the index
+      idx_probe_time         - probed time of the current library index entry
+      idx_start              - audio start of the current library index entry
+      idx_tag_time           - ID3 tag time of the current index entry
+      idx_title              - title of the current library index entry
+      idx_toc                - seek table record of the current index entry
+      idx_toc_sector         - first seek table record sector of the index
+      idx_valid              - flag indicating library index file is usable
+      mirror_blocks          - number of FAT sectors in the FAT mirror
+      mirror_first           - first FAT sector in the FAT mirror
+      mirror_max             - most FAT sectors the FAT mirror can hold
+      names_used             - characters used in dir_names[]
+      num_extents            - number of extents in the extent index
       partition_start        - starting sector of the first partition
       root_dir_size          - size of the root directory in sectors (FAT16)
       root_start_sector      - starting sector of root directory (FAT16)
+      sector_cache           - DRAM holding the sector cache blocks
       sectors_per_cluster    - number of sectors per cluster
-
+      tag_cache              - ID3 tags of directory table entries
+      tbl_count              - number of entries in the directory table
+      tbl_cur                - current entry in the directory table
+      xfer_block             - next file block of the asynchronous read
+      xfer_busy              - flag indicating asynchronous read in progress
+      xfer_cnt               - blocks in the current asynchronous disk read
+      xfer_dest              - where the next block read is to be written
+      xfer_info              - file information for the asynchronous read
+      xfer_left              - blocks left in the asynchronous read
+      xfer_read              - blocks read by the asynchronous read
 
    Revision History
       6/5/03   Glen George       Initial revision.
@@ -113,6 +204,72 @@
                                  function.
       4/5/13   Glen George       Fixed bug in how the far pointer is formed,
                                  it was crossing a segment boundary.
+      6/7/16   Tim Liu           Added get_file_blocks_start() and
+                                 get_file_blocks_poll() for asynchronous
+                                 reads of the current file.
+      6/7/16   Tim Liu           Moved the contiguous block calculation out
+                                 of get_disk_blocks() into get_contig_count().
+      6/9/16   Tim Liu           Added an LRU sector cache in DRAM for FAT,
+                                 directory, and tag sectors (short reads),
+                                 long reads bypass it.
+      6/10/16  Tim Liu           Added a FAT mirror in DRAM holding the whole
+                                 FAT (or a window of it if too large) so
+                                 cluster chains are followed from memory.
+      6/11/16  Tim Liu           Replaced the FAT cache with an extent index
+                                 of the current file that is binary searched
+                                 in get_block_info().
+      6/12/16  Tim Liu           Added browsing from the library index file
+                                 \JUKEBOX.IDX when it is present and matches
+                                 the directory, split the directory walking
+                                 into get_next_dir_walk() and
+                                 get_previous_dir_walk(), and keep the
+                                 current entry's attributes, size, and time.
+      6/13/16  Tim Liu           Added a directory table in DRAM filled in
+                                 one pass when a directory is entered so
+                                 moving through it doesn't read the disk,
+                                 and added move_dir_entry() to move by more
+                                 than one entry.
+      6/13/16  Tim Liu           Moved setting up the block information out
+                                 of get_next_dir_walk() into
+                                 setup_entry_info() so walking past entries
+                                 doesn't fill the extent index for each one.
+      6/14/16  Tim Liu           Added an ID3 tag cache for the directory
+                                 table entries, filled for the entries near
+                                 the current one by fill_tag_cache() in the
+                                 background, and moved reading the tag into
+                                 read_ID3_tag().
+      6/16/16  Tim Liu           Don't include alloc.h in the Linux host
+                                 build (LINUX) and local function
+                                 declarations are static (gcc requires it).
+      6/16/16  Tim Liu           Deleted entries are found with DELETED_ENTRY
+                                 (the '\xE5' compare never matched with
+                                 USE_ARRAY) and deleted long filename
+                                 entries are skipped.
+      6/16/16  Tim Liu           FAT32 entries are read as two words and
+                                 masked to 28 bits (a 64-bit host long read
+                                 the wrong entry and end of chain markers
+                                 were never seen).
+      6/16/16  Tim Liu           Added get_saved_probe() to set up tracks
+                                 from the probe results in the library index
+                                 (version 2) and the extent and seek table
+                                 records are read into a buffer of their own
+                                 (idx_ext_buf[]) so they don't replace the
+                                 entry records.
+      6/16/16  Tim Liu           Added at_dir_end() so the end of the
+                                 directory can be found without comparing
+                                 entry names (move_dir_entry() and
+                                 get_next_dir_walk() set dir_end).
+      6/16/16  Tim Liu           The PC version allocates the directory
+                                 table records at their own size plus the
+                                 names (its records are bigger and left no
+                                 room for names in the Linux host build).
+      6/16/16  Tim Liu           The tag cache also holds the probe results
+                                 (from probe_track()) of its files, read
+                                 ahead by fill_tag_cache() and kept for the
+                                 current file by save_probe(), so
+                                 get_saved_probe() has them for a cached
+                                 file in the directory table too.  Added
+                                 #include of frameidx.h.
 */
 
 
@@ -120,33 +277,84 @@
 
 /* library include files */
 #ifdef  PCVERSION
+#ifndef  LINUX
     #include  <alloc.h>
 #endif
+#endif
 
 /* local include files */
 #include  "mp3defs.h"
 #include  "interfac.h"
 #include  "vfat.h"
 #include  "fatutil.h"
+#include  "jukeidx.h"
+#include  "frameidx.h"
 
 
 
 
 /* local definitions */
-  /* none */
+#define  EMPTY_SECTOR   0xFFFFFFFFUL    /* sector number of an unused cache block */
+
+/* maximum number of extents in the extent index */
+#define  MAX_EXTENTS    ((EXTENT_INDEX_SIZE * sizeof(short int)) / sizeof(struct extent))
+
+/* segment of the FAT mirror (embedded version), it follows the sector cache */
+#define  FAT_MIRROR_SEG  (DRAM_STARTSEG + (((NO_BUFFERS + 1L) * BUFFER_SIZE + EXTENT_INDEX_SIZE + \
+                                            SECTOR_CACHE_BLOCKS * IDE_BLOCK_SIZE) * sizeof(short int)) / 16L)
+
+/* segment of the directory table (embedded version), it follows the FAT mirror */
+#define  DIR_TABLE_SEG   (FAT_MIRROR_SEG + (FAT_MIRROR_BLOCKS * IDE_BLOCK_SIZE * sizeof(short int)) / 16L)
+
+/* size of the directory table name storage (follows the records) */
+#ifdef  PCVERSION
+/*    the table is allocated and the records may be bigger than on the */
+/*    board (they take all of the DRAM with 64-bit longs), so the names */
+/*    get the room they have on the board (half of the table) */
+#define  DIR_NAMES_SIZE  ((unsigned int) (DIR_TABLE_BLOCKS * IDE_BLOCK_SIZE * sizeof(short int) / 2))
+#else
+#define  DIR_NAMES_SIZE  ((unsigned int) (DIR_TABLE_BLOCKS * IDE_BLOCK_SIZE * sizeof(short int) - \
+                                          DIR_TABLE_ENTRIES * sizeof(struct dir_record)))
+#endif
 
 
 
 
 /* local function declarations */
-void                get_block_info(struct block_info *, unsigned long int);     /* get file FAT information */
-unsigned long int   get_contig_sectors(unsigned long int, struct cache_entry *);   /* get contiguous sectors of file */
-int                 get_disk_blocks(struct block_info *, unsigned long int,
-                                    int, unsigned short int far *);     /* get blocks from disk */
-void                init_dir_stack(void);       /* initialize stack of directory names */
-void                new_directory(void);        /* entering a new directory, update stack */
-const char         *get_dir_tos_name(void);     /* get name of directory at top of stack */
-unsigned long int   get_dir_tos_sector(void);   /* get starting sector of directory at top of stack */
+static  void                get_block_info(struct block_info *, unsigned long int);     /* get file FAT information */
+static  void                build_extent_index(unsigned long int);  /* fill extent index for a file */
+static  unsigned long int   get_contig_sectors(unsigned long int, struct cache_entry *);   /* get contiguous sectors of file */
+static  unsigned long int   get_FAT_entry(unsigned long int);   /* get FAT entry for a cluster */
+static  char                load_FAT_mirror(unsigned long int, int);    /* read FAT sectors into mirror */
+static  int                 get_contig_count(struct block_info *, unsigned long int, int);  /* get contiguous blocks to read */
+static  int                 get_disk_blocks(struct block_info *, unsigned long int,
+                                            int, unsigned short int far *);     /* get blocks from disk */
+static  int                 get_cached_blocks(unsigned long int, int,
+                                              unsigned short int far *);        /* get blocks through cache */
+static  void                start_disk_xfer(void);      /* start next disk read of a file read */
+static  void                init_dir_stack(void);       /* initialize stack of directory names */
+static  void                new_directory(void);        /* entering a new directory, update stack */
+static  const char         *get_dir_tos_name(void);     /* get name of directory at top of stack */
+static  unsigned long int   get_dir_tos_sector(void);   /* get starting sector of directory at top of stack */
+static  unsigned long int   get_dir_tos_stamp(void);    /* get time and date of directory at top of stack */
+static  char                get_next_dir_walk(void);    /* get next entry from directory sectors */
+static  char                get_previous_dir_walk(void);    /* get previous entry from directory sectors */
+static  unsigned long int   get_dir_size(unsigned long int);    /* get sectors in a directory */
+static  void                find_index_file(void);      /* find the library index file */
+static  char                read_index_sector(unsigned long int, unsigned short int *,
+                                              unsigned long int *); /* read library index sector */
+static  char                find_dir_index(void);       /* find directory in library index */
+static  char                load_index_entry(int);      /* load a library index entry */
+static  char                move_index_entry(int);      /* move through library index entries */
+static  char                build_dir_table(void);      /* fill the directory table */
+static  void                load_table_entry(int);      /* load a directory table entry */
+static  void                setup_entry_info(void);     /* set current file block information */
+static  char                read_ID3_tag(struct block_info *, long int, char *);    /* read ID3 tag of a file */
+static  void                make_ID3_tag(char *, char, const char *, const char *,
+                                         unsigned long int);    /* build ID3 tag from its parts */
+static  char                tag_cached(int);            /* check if entry's ID3 tag is cached */
+static  void                save_tag_cache(int, const char *);  /* save entry's ID3 tag */
+static  void                save_probe_cache(int, const struct track_header *, unsigned int);  /* save entry's probe */
 
 
 
@@ -163,6 +371,8 @@ static  unsigned long int      dir_offset;          /* sector offset in director
 
 static  char  dirname[MAX_LFN_LEN];                 /* name of current directory */
 
+static  char                   dir_end;             /* last move stopped at the end */
+
 
 /* information about current file */
 
@@ -170,6 +380,14 @@ static  struct  block_info     cur_info;            /* current file information
 
 static  char  filename[MAX_LFN_LEN];                /* filename of current entry */
 
+static  unsigned char          cur_attr;            /* attributes of current entry */
+static  unsigned int           cur_ftime;           /* time of current entry */
+static  unsigned int           cur_fdate;           /* date of current entry */
+static  long int               cur_size;            /* size of current entry */
+static  char                   cur_parent;          /* current entry is ".." */
+
+static  unsigned long int      dir_stamp;           /* date and time of current directory */
+
 
 /* general drive variables */
 
@@ -184,7 +402,91 @@ static  unsigned long int      first_file_sector;   /* sector of the first file
 static  unsigned long int      root_start_sector;   /* starting sector of root directory (FAT 16) */
 static  long int               root_dir_size;       /* size of root directory (FAT16) */
 
-static  struct cache_entry  far  *FAT_cache;        /* cache of FAT entries */
+
+/* extent index of the current file (sorted by file offset) */
+
+static  struct extent  far  *extents;               /* the extents of the file */
+static  int                  num_extents;           /* number of extents */
+static  unsigned long int    extent_next;           /* cluster after last extent */
+
+
+/* FAT mirror (whole FAT if it fits, otherwise a sliding window) */
+
+#ifdef  PCVERSION
+static  unsigned short int  far *FAT_mirror;        /* memory for the FAT mirror */
+#endif
+static  unsigned long int        FAT_size;          /* sectors in one FAT */
+static  unsigned long int        mirror_first;      /* first FAT sector in mirror */
+static  int                      mirror_blocks;     /* FAT sectors in mirror */
+static  int                      mirror_max;        /* most FAT sectors mirror holds */
+
+
+/* sector cache (least recently used replacement) */
+
+static  unsigned short int  far *sector_cache;      /* cached sector data */
+static  unsigned long int        cache_sector[SECTOR_CACHE_BLOCKS]; /* sector in each block */
+static  unsigned long int        cache_age[SECTOR_CACHE_BLOCKS];    /* last use of each block */
+static  unsigned long int        cache_time;        /* time of last cache access */
+static  unsigned long int        cache_hits;        /* sectors found in the cache */
+static  unsigned long int        cache_misses;      /* sectors read into the cache */
+
+
+/* library index (\JUKEBOX.IDX) */
+
+static  struct  block_info     idx_info;            /* index file information */
+static  char                   idx_valid;           /* index file is usable */
+static  unsigned long int      idx_num_dirs;        /* number of directory records */
+static  unsigned long int      idx_dir_sector;      /* first directory record sector */
+static  unsigned long int      idx_entry_sector;    /* first entry record sector */
+static  unsigned long int      idx_extent_sector;   /* first extent record sector */
+static  unsigned long int      idx_toc_sector;      /* first seek table record sector */
+
+static  unsigned short int     idx_buf[IDE_BLOCK_SIZE];  /* a sector of the index */
+static  unsigned long int      idx_buf_sector;      /* index sector in idx_buf[] */
+static  unsigned short int     idx_ext_buf[IDE_BLOCK_SIZE];  /* extent or seek table records */
+static  unsigned long int      idx_ext_sector;      /* index sector in idx_ext_buf[] */
+
+static  char                   dir_indexed;         /* current directory is indexed */
+static  unsigned long int      idx_first;           /* first entry of directory */
+static  int                    idx_count;           /* entries in directory */
+static  int                    idx_cur;             /* current entry in directory */
+
+
+/* directory table (the visible entries of the current directory) */
+
+static  struct dir_record  far  *dir_table;         /* the directory records */
+static  char               far  *dir_names;         /* the entry names */
+static  unsigned int             names_used;        /* characters in dir_names[] */
+
+static  char                     dir_tabled;        /* current directory is in table */
+static  int                      tbl_count;         /* entries in the table */
+static  int                      tbl_cur;           /* current entry in the table */
+
+
+/* ID3 tag cache (direct mapped by directory table entry) */
+
+static  struct tag_record        tag_cache[TAG_CACHE_ENTRIES];  /* the cached tags */
+
+static  char  idx_title[ID3_TAG_TITLE_SIZE];        /* title of current entry */
+static  char  idx_artist[ID3_TAG_ARTIST_SIZE];      /* artist of current entry */
+static  unsigned long int      idx_tag_time;        /* ID3 time of current entry */
+static  unsigned int           idx_flags;           /* flags of current entry */
+static  long int               idx_start;           /* audio start of current entry */
+static  long int               idx_frames;          /* frames in current entry */
+static  int                    idx_bit_rate;        /* bit rate of current entry */
+static  unsigned int           idx_probe_time;      /* probed time of current entry */
+static  unsigned long int      idx_toc;             /* seek table of current entry */
+
+
+/* state of the asynchronous file read */
+
+static  struct  block_info      *xfer_info;         /* file information for the read */
+static  unsigned long int        xfer_block;        /* next block of the file to read */
+static  int                      xfer_left;         /* blocks left to read */
+static  int                      xfer_cnt;          /* blocks in current disk read */
+static  int                      xfer_read;         /* blocks read so far */
+static  unsigned short int  far *xfer_dest;         /* where next block is written */
+static  char                     xfer_busy;         /* read is in progress */
 
 
 
@@ -197,7 +499,9 @@ static  struct cache_entry  far  *FAT_cache;        /* cache of FAT entries */
    Operation:        The function reads the partition table and boot record to
                      set up the directory parameters: the starting sector
                      number for files on the drive, and the number of sectors
-                     per cluster.  It also initializes the directory stack and
+                     per cluster.  If the whole FAT fits in the FAT mirror
+                     it is read into memory.  Finally the root directory is
+                     checked for a library index file.  It also initializes the directory stack and
                      the directory name and filename.
 
    Arguments:        None.
@@ -213,26 +517,56 @@ static  struct cache_entry  far  *FAT_cache;        /* cache of FAT entries */
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: clusters_per_sector - set based on the FAT type.
+   Shared Variables: cache_age           - cleared.
+                     cache_hits          - cleared.
+                     cache_misses        - cleared.
+                     cache_sector        - set to EMPTY_SECTOR.
+                     cache_time          - cleared.
+                     clusters_per_sector - set based on the FAT type.
+                     cur_fdate           - cleared (root has no date).
+                     cur_ftime           - cleared (root has no time).
                      cur_info            - set to the information for the
                                            root directory.
+                     cur_parent          - set to FALSE.
+                     dir_indexed         - set to FALSE.
+                     dir_names           - set to point after the records.
+                     dir_stamp           - cleared.
+                     dir_table           - set to point at the directory table.
+                     dir_tabled          - set to FALSE.
                      dirname             - set to the read volume label.
-                     FAT_cache           - set to point at the cache.
+                     extent_next         - set to CHAIN_END.
+                     extents             - set to point at the extent index.
                      fat16               - set to the read filesystem type.
+                     FAT_mirror          - set to point at the FAT mirror
+                                           (PC version).
+                     FAT_size            - set to the read FAT size.
                      filename            - set to the empty string.
                      first_FAT_sector    - set to computed sector number.
                      first_file_sector   - set to the computed sector number.
+                     idx_buf_sector      - set to EMPTY_SECTOR.
+                     idx_ext_sector      - set to EMPTY_SECTOR.
+                     idx_valid           - set if a library index is found.
+                     mirror_blocks       - set to the FAT sectors loaded.
+                     mirror_first        - set to zero (0).
+                     mirror_max          - set to the FAT mirror size.
+                     names_used          - set to zero (0).
+                     num_extents         - set to zero (0).
                      partition_start     - starting sector number of the
                                            partition.
                      root_dir_size       - set to the read size of the root
                                            directory (FAT16 only).
                      root_start_sector   - set to the starting sector of the
                                            root directory (FAT16 only).
+                     sector_cache        - set to point at the cache.
                      sectors_per_cluster - set to the read sectors per
                                            cluster.
+                     tag_cache           - set to empty.
+                     tbl_count           - set to zero (0).
+                     xfer_busy           - set to FALSE (no asynchronous
+                                           read in progress).
 
    Author:           Glen George
-   Last Modified:    April 5, 2013
+   Last Modified:    June 14, 2016
 
 */
 
@@ -249,18 +583,81 @@ char  init_FAT_system()
 
 
 
-    /* setup the FAT cache - just make it point at memory for it */
+    /* setup the extent index - just make it point at memory for it */
     /* allocate the buffer (different on PC vs. embedded system) */
 #ifdef  PCVERSION
-    /* in PC version, allocate the cache */
-    FAT_cache = (struct cache_entry far *) farmalloc(FAT_CACHE_SIZE * sizeof(short int));
+    /* in PC version, allocate the index */
+    extents = (struct extent far *) farmalloc(EXTENT_INDEX_SIZE * sizeof(short int));
 #else
-    /* embedded version, FAT cache comes after the audio buffers */
+    /* embedded version, extent index comes after the audio buffers */
     /*    note that this can cause a segment boundary to be crossed so need */
     /*    to do the calculation in the segment number just in case */
-    FAT_cache = (struct cache_entry far *) MAKE_FARPTR(DRAM_STARTSEG +
-                   ((NO_BUFFERS + 1L) * BUFFER_SIZE * sizeof(short int)) / 16L, 0);
+    extents = (struct extent far *) MAKE_FARPTR(DRAM_STARTSEG +
+                 ((NO_BUFFERS + 1L) * BUFFER_SIZE * sizeof(short int)) / 16L, 0);
+#endif
+    /* nothing in the index yet */
+    num_extents = 0;
+    extent_next = CHAIN_END;
+
+    /* setup the sector cache the same way, it comes after the extent index */
+#ifdef  PCVERSION
+    sector_cache = (unsigned short int far *) farmalloc(SECTOR_CACHE_BLOCKS * IDE_BLOCK_SIZE * sizeof(short int));
+#else
+    sector_cache = (unsigned short int far *) MAKE_FARPTR(DRAM_STARTSEG +
+                      (((NO_BUFFERS + 1L) * BUFFER_SIZE + EXTENT_INDEX_SIZE) * sizeof(short int)) / 16L, 0);
+#endif
+
+    /* setup the FAT mirror the same way, it comes after the sector cache */
+#ifdef  PCVERSION
+    /* in PC version, only allocate a window */
+    FAT_mirror = (unsigned short int far *) farmalloc(FAT_WINDOW_BLOCKS * IDE_BLOCK_SIZE * sizeof(short int));
+    mirror_max = FAT_WINDOW_BLOCKS;
+#else
+    /* embedded version, enough for the largest FAT16 FAT */
+    mirror_max = FAT_MIRROR_BLOCKS;
+#endif
+    /* nothing is in the FAT mirror yet */
+    mirror_first = 0;
+    mirror_blocks = 0;
+
+    /* setup the directory table the same way, it comes after the FAT mirror */
+#ifdef  PCVERSION
+    dir_table = (struct dir_record far *) farmalloc(DIR_TABLE_ENTRIES * sizeof(struct dir_record) + DIR_NAMES_SIZE);
+#else
+    dir_table = (struct dir_record far *) MAKE_FARPTR(DIR_TABLE_SEG, 0);
 #endif
+    /* the names follow the records */
+    dir_names = (char far *) (dir_table + DIR_TABLE_ENTRIES);
+    /* nothing in the table yet */
+    dir_tabled = FALSE;
+    tbl_count = 0;
+    names_used = 0;
+
+    /* no ID3 tags are cached */
+    for (i = 0; i < TAG_CACHE_ENTRIES; i++)
+        tag_cache[i].entry = -1;
+
+    /* nothing is in the sector cache yet */
+    for (i = 0; i < SECTOR_CACHE_BLOCKS; i++)  {
+        cache_sector[i] = EMPTY_SECTOR;
+        cache_age[i] = 0;
+    }
+    cache_time = 0;
+    cache_hits = 0;
+    cache_misses = 0;
+
+    /* no asynchronous file read in progress */
+    xfer_busy = FALSE;
+
+    /* no library index yet and the root directory has no time and date */
+    idx_valid = FALSE;
+    dir_indexed = FALSE;
+    idx_buf_sector = EMPTY_SECTOR;
+    idx_ext_sector = EMPTY_SECTOR;
+    cur_parent = FALSE;
+    cur_ftime = 0;
+    cur_fdate = 0;
+    dir_stamp = 0;
 
 
     /* read the first sector from the harddrive to get the partition table */
@@ -293,6 +690,8 @@ char  init_FAT_system()
         /* get the start of the root directory (sector number) for FAT16 */
         root_start_sector = partition_start + RESERVED_SECTORS(s) +
                             (NUMFATS(s) * FAT_SECTORS_16(s));
+        /* and the size of the FAT */
+        FAT_size = FAT_SECTORS_16(s);
         /* get the root directory size as well */
         root_dir_size = (ROOT_ENTRIES(s) / ENTRIES_PER_SECTOR);
 
@@ -317,6 +716,8 @@ char  init_FAT_system()
         /* get the starting sector for files */
         first_file_sector = partition_start + RESERVED_SECTORS(s) +
                             (NUMFATS(s) * FAT_SECTORS_32(s));
+        /* and the size of the FAT */
+        FAT_size = FAT_SECTORS_32(s);
 
         /* get the start of the volume label */
         vid = VOLUME_ID_32(s);
@@ -329,14 +730,25 @@ char  init_FAT_system()
     }
 
 
-    /* not using FAT cache yet */
-    cur_info.cache_idx = -1;
+    /* load the FAT mirror - the whole FAT if it fits (always for FAT16 on */
+    /*    the embedded system), otherwise it is a window loaded as needed */
+    if (!error && (FAT_size <= mirror_max))
+        error = load_FAT_mirror(0, (int) FAT_size);
+
+
+    /* root directory has no extent index */
+    cur_info.extent_idx = -1;
     /* and point to end of file so will reset to beginning */
     cur_info.offset = 0xFFFFFFFF;
     /* get the information for the root directory */
     get_block_info(&cur_info, 0);
 
 
+    /* look for a library index in the root directory */
+    if (!error)
+        find_index_file();
+
+
     /* set the directory name to the volume label and the filename to blank */
     for (i = 0; i < VOL_LABEL_LEN; i++)
         dirname[i] = vid[i];
@@ -412,6 +824,87 @@ unsigned long int  get_partition_start()
 
 
 
+/*
+   get_sector_cache_hits
+
+   Description:      This function returns the number of sectors that have
+                     been found in the sector cache since the file system was
+                     initialized.
+
+   Arguments:        None.
+   Return Value:     (unsigned long int) - the number of sector cache hits.
+
+   Inputs:           None.
+   Outputs:          None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: cache_hits - accessed by this function.
+
+   Author:           Tim Liu
+   Last Modified:    June 9, 2016
+
+*/
+
+unsigned long int  get_sector_cache_hits()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* just return the number of hits */
+    return  cache_hits;
+
+}
+
+
+
+
+/*
+   get_sector_cache_misses
+
+   Description:      This function returns the number of sectors that have
+                     been read from the hard drive into the sector cache since
+                     the file system was initialized.  Reads that bypass the
+                     cache are not counted.
+
+   Arguments:        None.
+   Return Value:     (unsigned long int) - the number of sector cache misses.
+
+   Inputs:           None.
+   Outputs:          None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: cache_misses - accessed by this function.
+
+   Author:           Tim Liu
+   Last Modified:    June 9, 2016
+
+*/
+
+unsigned long int  get_sector_cache_misses()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* just return the number of misses */
+    return  cache_misses;
+
+}
+
+
+
+
 /*
    get_cur_file_name
 
@@ -474,11 +967,10 @@ const char  *get_cur_file_name()
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: dir_sector - accessed to determine attribute.
-                     cur_dir    - accessed to determine current attribute.
+   Shared Variables: cur_attr - accessed to determine attribute.
 
    Author:           Glen George
-   Last Modified:    April 29, 2006
+   Last Modified:    June 12, 2016
 
 */
 
@@ -490,7 +982,7 @@ unsigned char  get_cur_file_attr()
 
 
     /* just return the attribute of the current directory entry */
-    return  ATTR(dir_sector[cur_dir]);
+    return  cur_attr;
 
 }
 
@@ -556,11 +1048,10 @@ char  cur_isDir()
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: dir_sector - accessed to determine directory status.
-                     cur_dir    - accessed to determine directory status.
+   Shared Variables: cur_parent - accessed to determine directory status.
 
    Author:           Glen George
-   Last Modified:    April 29, 2006
+   Last Modified:    June 12, 2016
 
 */
 
@@ -572,8 +1063,7 @@ char  cur_isParentDir()
 
 
     /* just return whether or not current entry is the parent directory */
-    /* it's the parent if the name starts with '.' */
-    return  (cur_isDir() && (FILENAME(dir_sector[cur_dir], 0) == '.'));
+    return  (cur_isDir() && cur_parent);
 
 }
 
@@ -599,11 +1089,10 @@ char  cur_isParentDir()
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: dir_sector - accessed by this function.
-                     cur_dir    - accessed by this function.
+   Shared Variables: cur_ftime - accessed by this function.
 
    Author:           Glen George
-   Last Modified:    April 29, 2006
+   Last Modified:    June 12, 2016
 
 */
 
@@ -615,10 +1104,10 @@ unsigned int  get_cur_file_time()
 
 
     /* first get the seconds (kept in units of 2 seconds) */
-    t = 2 * DIR_SECONDS(FTIME(dir_sector[cur_dir]));
+    t = 2 * DIR_SECONDS(cur_ftime);
     /* then add in the minutes and hours */
-    t += 60 * DIR_MINUTES(FTIME(dir_sector[cur_dir]));
-    t += 60 * 60 * DIR_HOURS(FTIME(dir_sector[cur_dir]));
+    t += 60 * DIR_MINUTES(cur_ftime);
+    t += 60 * 60 * DIR_HOURS(cur_ftime);
 
 
     /* and return the resulting time in seconds */
@@ -648,11 +1137,10 @@ unsigned int  get_cur_file_time()
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: dir_sector - accessed by this function.
-                     cur_dir    - accessed by this function.
+   Shared Variables: cur_size - accessed by this function.
 
    Author:           Glen George
-   Last Modified:    April 29, 2006
+   Last Modified:    June 12, 2016
 
 */
 
@@ -664,7 +1152,7 @@ long int  get_cur_file_size()
 
 
     /* return the length in bytes of the current directory entry */
-    return  FSIZE(dir_sector[cur_dir]);
+    return  cur_size;
 
 }
 
@@ -725,7 +1213,15 @@ unsigned long int  get_cur_file_sector()
 
    Description:      This function reads the ID3 tag into the passed buffer.
                      It just reads the last ID3_TAG_SIZE bytes of the current
-                     file into the passed buffer.
+                     file into the passed buffer.  If the current directory
+                     is in the library index the tag is built from the
+                     index entry instead (only the identifier, title,
+                     artist, and time are filled in, the title and artist
+                     are the ones the index has for the file, which are
+                     from its ID3v2 tag if it has one), and if the tag is in
+                     the tag cache it is built from there the same way.  A
+                     tag read for a directory table entry is saved in the
+                     tag cache.
 
    Arguments:        buffer (char *) - buffer into which the the ID3 tag is to
                                        be read.
@@ -739,62 +1235,197 @@ unsigned long int  get_cur_file_sector()
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: None.
+   Shared Variables: cur_info     - used to read the tag.
+                     cur_size     - accessed to find the tag.
+                     dir_indexed  - accessed to see if using the index.
+                     dir_tabled   - accessed to see if using the table.
+                     idx_artist   - accessed for the artist.
+                     idx_flags    - accessed to see if there is a tag.
+                     idx_tag_time - accessed for the time.
+                     idx_title    - accessed for the title.
+                     tag_cache    - accessed and possibly updated with the
+                                    tag.
+                     tbl_cur      - accessed for the table entry.
 
    Author:           Glen George
-   Last Modified:    March 17, 2013
+   Last Modified:    June 14, 2016
 
 */
 
 void  get_ID3_tag(char *buffer)
 {
     /* variables */
-    char  s[IDE_BLOCK_SIZE * 2];        /* sector from the hard drive */
+    struct tag_record  *t;              /* the cached tag */
 
-    int   sector;                       /* sector where ID3 tag starts */
-    int   offset;                       /* offset within sector for ID3 tag */
+    char                error;          /* error reading the file */
 
-    char  error;                        /* error reading the file */
 
-    int   i;                            /* general loop index */
 
+    /* check if the tag information is in the library index or tag cache */
+    if (dir_indexed)  {
 
+        /* build the tag from the index */
+        make_ID3_tag(buffer, ((idx_flags & IDX_FLAG_ID3) != 0), idx_title, idx_artist,
+                     idx_tag_time);
+    }
+    else if (dir_tabled && tag_cached(tbl_cur))  {
 
-    /* get the sector number of the start of the ID3 tag and its offset */
-    /* the ID3 tag is at the end of the file (doing byte calculations) */
-    sector = (get_cur_file_size() - ID3_TAG_SIZE) / (2 * IDE_BLOCK_SIZE);
-    offset = (get_cur_file_size() - ID3_TAG_SIZE) % (2 * IDE_BLOCK_SIZE);
+        /* build the tag from the tag cache */
+        t = &tag_cache[tbl_cur % TAG_CACHE_ENTRIES];
+        make_ID3_tag(buffer, t->has_tag, t->title, t->artist, t->time);
+    }
+    else  {
 
+        /* have to read it, finish any asynchronous read first since it */
+        /*    may be using cur_info */
+        while (get_file_blocks_poll() == IDE_BUSY);
 
-    /* try to read a sector from the harddrive to get the ID3 tag */
-    error = (get_file_blocks(sector, 1, (unsigned short int far *) s) != 1);
+        /* read the tag from the end of the file */
+        error = read_ID3_tag(&cur_info, cur_size, buffer);
 
-    /* now fill the tag with the data read watching for errors */
-    for (i = 0; (!error && (i < ID3_TAG_SIZE)); i++, offset++)  {
+        /* save it in case come back to this entry */
+        if (dir_tabled && !error)
+            save_tag_cache(tbl_cur, buffer);
+    }
 
-        /* check if past the end of the sector (working with bytes, not words) */
-        if (offset >= (2 * IDE_BLOCK_SIZE))  {
-            /* past the end of this sector, need to read next sector */
-            error = (get_file_blocks(++sector, 1, (unsigned short int far *) s) != 1);
-            /* and at the start of this new sector */
-            offset = 0;
+
+    /* all done getting the ID3 tag, return */
+    return;
+
+}
+
+
+
+
+/*
+   get_saved_probe
+
+   Description:      This function gets what probe_track() finds for the
+                     current file if it was saved, so the track can be set
+                     up without reading the file.  It is saved in the
+                     library index for the files of an indexed directory
+                     and in the tag cache for the files of the directory
+                     table that have been probed (see fill_tag_cache()).
+                     The start, frames, bit_rate, has_toc, and toc elements
+                     of the passed track information are set, the time
+                     element is set to the probed time, and the title and
+                     artist elements are set from the ID3v2 tag (empty if
+                     the file doesn't have one with a title).
+
+   Arguments:        info (struct track_header *) - track information in
+                                   which to store the probe results.
+   Return Value:     (char) - TRUE if the probe results were saved (and are
+                     now in info), FALSE if the file has to be probed.
+
+   Input:            A seek table record may be read from the library index.
+   Output:           None.
+
+   Error Handling:   If the seek table record can't be read the track is set
+                     to not have a seek table.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: dir_indexed    - accessed to see if using the index.
+                     dir_tabled     - accessed to see if using the table.
+                     idx_artist     - accessed for the artist.
+                     idx_bit_rate   - accessed for the bit rate.
+                     idx_ext_buf    - filled with the seek table record.
+                     idx_flags      - accessed for the ID3v2 tag and seek
+                                      table.
+                     idx_frames     - accessed for the number of frames.
+                     idx_probe_time - accessed for the probed time.
+                     idx_start      - accessed for the start of the audio.
+                     idx_title      - accessed for the title.
+                     idx_toc        - accessed to find the seek table.
+                     idx_toc_sector - accessed to find the seek table.
+                     tag_cache      - accessed for the cached probe results.
+                     tbl_cur        - accessed for the table entry.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+char  get_saved_probe(struct track_header *info)
+{
+    /* variables */
+    struct tag_record  *t;              /* the cached probe results */
+
+    unsigned long int  rec;             /* seek table record number */
+    int                w;               /* word offset of the record */
+
+    char               saved = FALSE;   /* the probe results were saved */
+
+    int                i;               /* general loop index */
+
+
+
+    /* only files in the library index have saved probe results */
+    if (dir_indexed && !cur_isDir())  {
+
+        /* have them, get the numbers */
+        saved = TRUE;
+        info->start = idx_start;
+        info->frames = idx_frames;
+        info->bit_rate = idx_bit_rate;
+        info->time = idx_probe_time;
+
+        /* the title and artist are only the probed ones if from an ID3v2 tag */
+        info->title[0] = '\0';
+        info->artist[0] = '\0';
+        if ((idx_flags & IDX_FLAG_ID3V2) != 0)  {
+            for (i = 0; i < ID3_TAG_TITLE_SIZE; i++)
+                info->title[i] = idx_title[i];
+            info->title[ID3_TAG_TITLE_SIZE] = '\0';
+            for (i = 0; i < ID3_TAG_ARTIST_SIZE; i++)
+                info->artist[i] = idx_artist[i];
+            info->artist[ID3_TAG_ARTIST_SIZE] = '\0';
         }
 
-        /* can always copy a byte, even if there was an error */
-        buffer[i] = s[offset];
+        /* and read the seek table if there is one */
+        info->has_toc = ((idx_flags & IDX_FLAG_TOC) != 0);
+        if (info->has_toc)  {
+            rec = idx_toc;
+            info->has_toc = !read_index_sector(idx_toc_sector + rec / IDX_TOCS_PER_SECTOR,
+                                               idx_ext_buf, &idx_ext_sector);
+            w = (int) (rec % IDX_TOCS_PER_SECTOR) * IDX_TOC_WORDS;
+            for (i = 0; info->has_toc && (i < SEEK_TOC_SIZE); i++)
+                info->toc[i] = IDX_BYTE(idx_ext_buf, w + IDX_TOC_TABLE, i);
+        }
     }
+    else if (dir_tabled && !cur_isDir() && tag_cached(tbl_cur) &&
+             tag_cache[tbl_cur % TAG_CACHE_ENTRIES].probed)  {
+
+        /* they are in the tag cache, get them from there */
+        saved = TRUE;
+        t = &tag_cache[tbl_cur % TAG_CACHE_ENTRIES];
+        info->start = t->start;
+        info->frames = t->frames;
+        info->bit_rate = t->bit_rate;
+        info->time = t->probe_time;
+
+        /* the title and artist are only the probed ones if from an ID3v2 tag */
+        info->title[0] = '\0';
+        info->artist[0] = '\0';
+        if (t->id3v2)  {
+            for (i = 0; i < ID3_TAG_TITLE_SIZE; i++)
+                info->title[i] = t->title[i];
+            info->title[ID3_TAG_TITLE_SIZE] = '\0';
+            for (i = 0; i < ID3_TAG_ARTIST_SIZE; i++)
+                info->artist[i] = t->artist[i];
+            info->artist[ID3_TAG_ARTIST_SIZE] = '\0';
+        }
 
-
-    /* if there was an error reading the tag, clear out the tag */
-    if (error)  {
-        /* there was an error, fill tag with <null> */
-        for (i = 0; i < ID3_TAG_SIZE; i++)
-            buffer[i] = '\0';
+        /* and the seek table */
+        info->has_toc = t->has_toc;
+        for (i = 0; info->has_toc && (i < SEEK_TOC_SIZE); i++)
+            info->toc[i] = t->toc[i];
     }
 
 
-    /* all done reading the ID3 tag, return */
-    return;
+    /* return whether the probe results were saved */
+    return  saved;
 
 }
 
@@ -802,26 +1433,22 @@ void  get_ID3_tag(char *buffer)
 
 
 /*
-   get_file_blocks
-
-   Description:      This function reads blocks from the current file.  The
-                     data "read" is written to the memory pointed to by the
-                     third argument.  The number of blocks requested is given
-                     as the second argument.  The starting block number in the
-                     file to read is passed as the first argument.  The
-                     function just calls get_disk_blocks() with the current
-                     file block information to read the actual hard drive.
-
-   Arguments:        block (unsigned long int)       - sector number (relative
-                                                       to the start of the
-                                                       file) at which to start
-                                                       reading.
-                     length (int)                    - number of blocks to be
-                                                       read.
-                     dest (unsigned short int far *) - pointer to the memory
-                                                       where the read data is
-                                                       to be written.
-   Return Value:     The number of blocks actually read.
+   save_probe
+
+   Description:      This function saves the passed probe results of the
+                     current file (from probe_track()) so setting up the
+                     track again doesn't read the file.  They are saved in
+                     the tag cache, so only for a file of the directory
+                     table whose ID3 tag is already cached (get_ID3_tag()
+                     caches it).  Otherwise nothing is done.
+
+   Arguments:        info (const struct track_header *) - track information
+                                   with the probe results (the start,
+                                   frames, bit_rate, has_toc, toc, title,
+                                   and artist elements).
+                     time (unsigned int) - the probed time (in tenths of a
+                                   second).
+   Return Value:     None.
 
    Input:            None.
    Output:           None.
@@ -831,22 +1458,29 @@ void  get_ID3_tag(char *buffer)
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: None.
+   Shared Variables: dir_tabled - accessed to see if using the table.
+                     tag_cache  - possibly updated with the probe results.
+                     tbl_cur    - accessed for the table entry.
 
-   Author:           Glen George
-   Last Modified:    March 17, 2013
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
 
 */
 
-int  get_file_blocks(unsigned long int block, int length, unsigned short int far *dest)
+void  save_probe(const struct track_header *info, unsigned int time)
 {
     /* variables */
       /* none */
 
 
 
-    /* just call the get_disk_blocks function and return its result */
-    return  get_disk_blocks(&cur_info, block, length, dest);
+    /* only files with a cached tag in the table can be saved */
+    if (dir_tabled && !cur_isDir() && tag_cached(tbl_cur))
+        save_probe_cache(tbl_cur, info, time);
+
+
+    /* all done, return */
+    return;
 
 }
 
@@ -854,755 +1488,3079 @@ int  get_file_blocks(unsigned long int block, int length, unsigned short int far
 
 
 /*
-   get_first_dir_entry
-
-   Description:      This function gets the first valid directory entry in
-                     the directory whose starting sector number is that of the
-                     current file.  The long filename of this directory entry
-                     is also read and the filename variable is set to this
-                     long filename if it exists or the 8.3 filename if there
-                     is no long filename.  Finally the starting sector number
-                     of this entry is also saved and that FAT cache is filled
-                     with information for this file.  If there is an error
-                     reading the directory entry the filename is set to the
-                     empty string, the starting sector number is set to 0, the
-                     directory information is properly initialized, and TRUE
-                     is returned.  The function get_next_dir_entry is used to
-                     actually get the first directory entry.
+   fill_tag_cache
+
+   Description:      This function reads ahead one ID3 tag or probe for the
+                     entries near the current entry in the directory table
+                     so they are already in the tag cache when they are
+                     browsed to (and setting up the track reads nothing).
+                     The entries up to TAG_CACHE_SPAN away are checked,
+                     closest first and after the current entry before the
+                     one before it.  The first file without a cached tag
+                     has its tag read and saved, or if its tag is cached
+                     but it hasn't been probed, it is probed (probe_track())
+                     and the results saved.  It is meant to be called
+                     repeatedly in the background, each call reads at most
+                     one tag or probe so keys are still handled quickly.
 
    Arguments:        None.
-   Return Value:     (char) - TRUE if there is an error reading the directory
-                     information, FALSE otherwise.
+   Return Value:     None.
 
-   Inputs:           Data is read from the disk drive.
-   Outputs:          None.
+   Input:            An ID3 tag or the start of a file may be read from the
+                     hard drive.
+   Output:           None.
 
-   Error Handling:   If there is an error reading the directory, the saved
-                     information is set to reasonable values and TRUE is
-                     returned.
+   Error Handling:   If the tag can't be read the file is saved as having no
+                     tag so it isn't read again, if the probe can't read the
+                     file its results are saved anyway (nothing known).
 
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: cur_dir    - set to the current file entry.
-                     cur_info   - set to the info for current file entry.
-                     dir_info   - set to the current value of cur_info.
-                     dir_offset - set to zero (0), 1st sector of directory.
-                     dir_sector - filled with a sector of directory entries.
-                     dirname    - set to the old value of filename.
-                     filename   - set to the filename of the current entry.
+   Shared Variables: cur_info   - the entry's block information while it is
+                                  probed (restored after).
+                     cur_size   - the entry's size while it is probed
+                                  (restored after).
+                     dir_tabled - accessed to see if using the table.
+                     dir_table  - accessed for the entries.
+                     tag_cache  - possibly updated with a tag or probe.
+                     tbl_count  - accessed to stay in the table.
+                     tbl_cur    - accessed for the current entry.
+                     xfer_busy  - accessed to check for a read in progress.
 
-   Author:           Glen George
-   Last Modified:    March 17, 2013
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
 
 */
 
-char  get_first_dir_entry()
+void  fill_tag_cache()
 {
     /* variables */
-    char  error = FALSE;        /* read error flag */
+    struct  block_info  info;           /* block information of the file */
+    struct  block_info  file_info;      /* block information of current file */
+    long int            file_size;      /* size of the current file */
 
+    char                tag[ID3_TAG_SIZE];  /* the read tag */
 
+    struct track_header  probe;         /* the probe results */
+    unsigned int        time;           /* the probed time */
 
-    /* first save the current directory information */
-    new_directory();
+    int                 d = 0;          /* distance from current entry */
+    int                 n = 0;          /* entry being checked */
 
-    /* now entering a directory, so save it as the directory name */
-    strcpy(dirname, filename);
+    char                found = FALSE;  /* found an entry to read */
 
-    /* and set the block information for the directory */
-    dir_info.sector   = cur_info.sector;
-    dir_info.size     = cur_info.size;
-    dir_info.next     = cur_info.next;
-    dir_info.offset   = cur_info.offset;
-    dir_info.cluster1 = cur_info.cluster1;
-    /* directories never cache their FAT information */
-    dir_info.cache_idx = -1;
 
 
-    /* setup the directory variables for the get_next_dir_entry function */
-    /* have to point at entry "before" first entry */
-    cur_dir = ENTRIES_PER_SECTOR - 1;   /* point at end of previous sector */
-    dir_offset = -1;                    /* will be updated to 0 */
+    /* only have entries to read ahead in the directory table and */
+    /*    don't disturb an asynchronous read of the current file */
+    if (dir_tabled && !xfer_busy)  {
 
+        /* look for the closest file without a cached tag or probe */
+        while (!found && (d < (2 * TAG_CACHE_SPAN)))  {
 
-    /* now can just use the get_next_dir_entry function to get first file */
-    error = get_next_dir_entry();
+            /* check alternately after and before the current entry */
+            if ((d % 2) == 0)
+                n = tbl_cur + (d / 2) + 1;
+            else
+                n = tbl_cur - (d / 2) - 1;
+            d++;
 
+            /* need a file in the table whose tag or probe isn't cached */
+            found = (n >= 0) && (n < tbl_count) &&
+                    ((dir_table[n].attr & ATTRIB_DIR) == 0) &&
+                    (!tag_cached(n) || !tag_cache[n % TAG_CACHE_ENTRIES].probed);
+        }
 
-    /* done, return with the error status */
-    return  error;
 
-}
+        /* if found one, read and save its tag or probe */
+        if (found)  {
 
+            /* setup block information at the start of the file */
+            info.cluster1 = dir_table[n].cluster;
+            /* point to end of file so will reset to beginning */
+            info.offset = 0xFFFFFFFF;
+            info.size = 0;
+            /* there is only an extent index for the current file */
+            info.extent_idx = -1;
 
+            /* the tag is read first (the probe is saved with it) */
+            if (!tag_cached(n))  {
 
+                /* read the tag, on an error it is cleared so saved as no tag */
+                (void) read_ID3_tag(&info, dir_table[n].size, tag);
+                save_tag_cache(n, tag);
+            }
+            else  {
 
-/*
-   get_next_dir_entry
+                /* probe_track() reads the current file, so the entry is */
+                /*    the current file while it is probed */
+                file_info = cur_info;
+                file_size = cur_size;
+                cur_info = info;
+                cur_size = dir_table[n].size;
+
+                /* probe it (the length of the file must be set) */
+                probe.length = dir_table[n].size;
+                time = probe_track(&probe);
+
+                /* put back the current file and save the results */
+                cur_info = file_info;
+                cur_size = file_size;
+                save_probe_cache(n, &probe, time);
+            }
+        }
+    }
 
-   Description:      This function gets the next valid directory entry in
-                     the directory.  As necessary it reads sectors of 
-                     directory entries from the hard drive.  The long filename
-                     of the next directory entry is also read and the filename
-                     variable is set to this long filename if it exists or the
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/* local functions to support the ID3 tag cache */
+
+
+/*
+   read_ID3_tag
+
+   Description:      This function reads the ID3 tag of a file into the
+                     passed buffer.  It just reads the last ID3_TAG_SIZE
+                     bytes of the file into the passed buffer.
+
+   Arguments:        info (struct block_info *) - block information for the
+                                                  file.
+                     size (long int)            - size of the file in bytes.
+                     buffer (char *)            - buffer into which the ID3
+                                                  tag is to be read.
+   Return Value:     (char) - TRUE if there was an error reading the tag,
+                     FALSE otherwise.
+
+   Input:            The end of the file is read from the hard drive.
+   Output:           None.
+
+   Error Handling:   If there is an error reading the tag or the file is too
+                     small to have one, the buffer is filled with <null>
+                     characters and TRUE is returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Glen George
+   Last Modified:    June 14, 2016
+
+*/
+
+static  char  read_ID3_tag(struct block_info *info, long int size, char *buffer)
+{
+    /* variables */
+    char               s[IDE_BLOCK_SIZE * 2];   /* sector from the hard drive */
+
+    unsigned long int  sector;          /* sector where ID3 tag starts */
+    int                offset;          /* offset within sector for ID3 tag */
+
+    char               error;           /* error reading the file */
+
+    int                i;               /* general loop index */
+
+
+
+    /* make sure the file is big enough to have a tag */
+    error = (size < ID3_TAG_SIZE);
+
+    /* get the sector number of the start of the ID3 tag and its offset */
+    /* the ID3 tag is at the end of the file (doing byte calculations) */
+    sector = (size - ID3_TAG_SIZE) / (2 * IDE_BLOCK_SIZE);
+    offset = (size - ID3_TAG_SIZE) % (2 * IDE_BLOCK_SIZE);
+
+
+    /* try to read a sector from the harddrive to get the ID3 tag */
+    if (!error)
+        error = (get_disk_blocks(info, sector, 1, (unsigned short int far *) s) != 1);
+
+    /* now fill the tag with the data read watching for errors */
+    for (i = 0; (!error && (i < ID3_TAG_SIZE)); i++, offset++)  {
+
+        /* check if past the end of the sector (working with bytes, not words) */
+        if (offset >= (2 * IDE_BLOCK_SIZE))  {
+            /* past the end of this sector, need to read next sector */
+            error = (get_disk_blocks(info, ++sector, 1, (unsigned short int far *) s) != 1);
+            /* and at the start of this new sector */
+            offset = 0;
+        }
+
+        /* can always copy a byte, even if there was an error */
+        buffer[i] = s[offset];
+    }
+
+
+    /* if there was an error reading the tag, clear out the tag */
+    if (error)  {
+        /* there was an error, fill tag with <null> */
+        for (i = 0; i < ID3_TAG_SIZE; i++)
+            buffer[i] = '\0';
+    }
+
+
+    /* all done reading the ID3 tag, return with the error status */
+    return  error;
+
+}
+
+
+
+
+/*
+   make_ID3_tag
+
+   Description:      This function builds an ID3 tag in the passed buffer
+                     from the parts of it that are saved (in the library
+                     index or the tag cache).  Only the identifier, title,
+                     artist, and time are filled in, the rest of the tag is
+                     <null> characters.  If there is no tag, the whole
+                     buffer is <null> characters (no identifier).
+
+   Arguments:        buffer (char *)       - buffer in which to build the
+                                             tag.
+                     has_tag (char)        - whether there is a tag.
+                     title (const char *)  - the title (ID3_TAG_TITLE_SIZE
+                                             characters).
+                     artist (const char *) - the artist (ID3_TAG_ARTIST_SIZE
+                                             characters).
+                     time (unsigned long int) - the time bytes (first byte
+                                             in the low byte).
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 14, 2016
+
+*/
+
+static  void  make_ID3_tag(char *buffer, char has_tag, const char *title,
+                           const char *artist, unsigned long int time)
+{
+    /* variables */
+    int  i;                     /* general loop index */
+
+
+
+    /* start with an empty tag (no identifier) */
+    for (i = 0; i < ID3_TAG_SIZE; i++)
+        buffer[i] = '\0';
+
+    /* if there is a tag, fill in the identifier, title, artist, and time */
+    if (has_tag)  {
+        for (i = 0; i < ID3_TAG_ID_SIZE; i++)
+            buffer[i] = ID3_TAG_ID[i];
+        for (i = 0; i < ID3_TAG_TITLE_SIZE; i++)
+            buffer[ID3_TAG_TITLE_OFFSET + i] = title[i];
+        for (i = 0; i < ID3_TAG_ARTIST_SIZE; i++)
+            buffer[ID3_TAG_ARTIST_OFFSET + i] = artist[i];
+        for (i = 0; i < ID3_TAG_TIME_SIZE; i++)
+            buffer[ID3_TAG_TIME_OFFSET + i] = (time >> (8 * i)) & 0xFF;
+    }
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   tag_cached
+
+   Description:      This function checks if the ID3 tag of the passed
+                     directory table entry is in the tag cache.  The cached
+                     tag has to be for the same directory, entry, and file
+                     size.
+
+   Arguments:        n (int) - directory table entry to check.
+   Return Value:     (char) - TRUE if the tag is cached, FALSE otherwise.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       The cache is direct mapped by entry number.
+   Data Structures:  None.
+
+   Shared Variables: dir_info  - accessed for the directory.
+                     dir_table - accessed for the file size.
+                     tag_cache - accessed to check the entry.
+
+   Author:           Tim Liu
+   Last Modified:    June 14, 2016
+
+*/
+
+static  char  tag_cached(int n)
+{
+    /* variables */
+    struct tag_record  *t;      /* the cache entry for the entry */
+
+
+
+    /* get the only cache entry that can hold the tag */
+    t = &tag_cache[n % TAG_CACHE_ENTRIES];
+
+
+    /* and check if it does */
+    return  ((t->entry == n) && (t->dir == dir_info.cluster1) &&
+             (t->size == dir_table[n].size));
+
+}
+
+
+
+
+/*
+   save_tag_cache
+
+   Description:      This function saves the passed ID3 tag of the passed
+                     directory table entry in the tag cache, replacing
+                     whatever tag was in its cache entry.  The entry hasn't
+                     been probed yet.
+
+   Arguments:        n (int)              - directory table entry of the tag.
+                     buffer (const char *) - the ID3 tag (ID3_TAG_SIZE
+                                            bytes).
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       The cache is direct mapped by entry number.
+   Data Structures:  None.
+
+   Shared Variables: dir_info  - accessed for the directory.
+                     dir_table - accessed for the file size.
+                     tag_cache - updated with the tag.
+
+   Author:           Tim Liu
+   Last Modified:    June 14, 2016
+
+*/
+
+static  void  save_tag_cache(int n, const char *buffer)
+{
+    /* variables */
+    struct tag_record  *t;      /* the cache entry for the entry */
+
+    int                 i;      /* general loop index */
+
+
+
+    /* get the cache entry for the tag */
+    t = &tag_cache[n % TAG_CACHE_ENTRIES];
+
+    /* it is now for this entry */
+    t->dir = dir_info.cluster1;
+    t->entry = n;
+    t->size = dir_table[n].size;
+
+    /* check if there really is a tag */
+    t->has_tag = (buffer[0] == 'T') && (buffer[1] == 'A') && (buffer[2] == 'G');
+
+    /* save the displayed parts of the tag */
+    for (i = 0; i < ID3_TAG_TITLE_SIZE; i++)
+        t->title[i] = buffer[ID3_TAG_TITLE_OFFSET + i];
+    for (i = 0; i < ID3_TAG_ARTIST_SIZE; i++)
+        t->artist[i] = buffer[ID3_TAG_ARTIST_OFFSET + i];
+    t->time = 0;
+    for (i = ID3_TAG_TIME_SIZE - 1; i >= 0; i--)
+        t->time = (t->time << 8) | (buffer[ID3_TAG_TIME_OFFSET + i] & 0xFF);
+
+    /* and there are no probe results yet */
+    t->probed = FALSE;
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   save_probe_cache
+
+   Description:      This function saves the passed probe results of the
+                     passed directory table entry in its tag cache entry
+                     (which must hold the entry's tag).  If the probe found
+                     an ID3v2 title, the saved title and artist are
+                     replaced by the ID3v2 ones (they are shown instead).
+
+   Arguments:        n (int)                             - directory table
+                                   entry of the probe results.
+                     info (const struct track_header *) - the probe results
+                                   (the start, frames, bit_rate, has_toc,
+                                   toc, title, and artist elements).
+                     time (unsigned int)                 - the probed time
+                                   (in tenths of a second).
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       The cache is direct mapped by entry number.
+   Data Structures:  None.
+
+   Shared Variables: tag_cache - updated with the probe results.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  save_probe_cache(int n, const struct track_header *info, unsigned int time)
+{
+    /* variables */
+    struct tag_record  *t;      /* the cache entry for the entry */
+
+    int                 i;      /* general loop index */
+
+
+
+    /* get the cache entry for the probe results */
+    t = &tag_cache[n % TAG_CACHE_ENTRIES];
+
+    /* save the numbers */
+    t->probed = TRUE;
+    t->probe_time = time;
+    t->start = info->start;
+    t->frames = info->frames;
+    t->bit_rate = info->bit_rate;
+
+    /* and the seek table */
+    t->has_toc = info->has_toc;
+    for (i = 0; t->has_toc && (i < SEEK_TOC_SIZE); i++)
+        t->toc[i] = info->toc[i];
+
+    /* an ID3v2 title and artist replace the tag's */
+    t->id3v2 = (info->title[0] != '\0');
+    for (i = 0; t->id3v2 && (i < ID3_TAG_TITLE_SIZE); i++)
+        t->title[i] = info->title[i];
+    for (i = 0; t->id3v2 && (i < ID3_TAG_ARTIST_SIZE); i++)
+        t->artist[i] = info->artist[i];
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   get_file_blocks
+
+   Description:      This function reads blocks from the current file.  The
+                     data "read" is written to the memory pointed to by the
+                     third argument.  The number of blocks requested is given
+                     as the second argument.  The starting block number in the
+                     file to read is passed as the first argument.  The
+                     function just calls get_disk_blocks() with the current
+                     file block information to read the actual hard drive.
+                     Any asynchronous file read is finished first.
+
+   Arguments:        block (unsigned long int)       - sector number (relative
+                                                       to the start of the
+                                                       file) at which to start
+                                                       reading.
+                     length (int)                    - number of blocks to be
+                                                       read.
+                     dest (unsigned short int far *) - pointer to the memory
+                                                       where the read data is
+                                                       to be written.
+   Return Value:     The number of blocks actually read.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Glen George
+   Last Modified:    June 7, 2016
+
+*/
+
+int  get_file_blocks(unsigned long int block, int length, unsigned short int far *dest)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* finish any asynchronous read first, it may be using cur_info */
+    while (get_file_blocks_poll() == IDE_BUSY);
+
+    /* now just call the get_disk_blocks function and return its result */
+    return  get_disk_blocks(&cur_info, block, length, dest);
+
+}
+
+
+
+
+/*
+   get_file_blocks_start
+
+   Description:      This function starts reading blocks from the current
+                     file and returns without waiting for the data.  The
+                     arguments are the same as for get_file_blocks().  The
+                     read is finished by calling get_file_blocks_poll() until
+                     it no longer returns IDE_BUSY.
+
+   Operation:        Any previous asynchronous read is finished first.  The
+                     read state is then saved and start_disk_xfer() is called
+                     to start reading the first contiguous group of blocks.
+                     Each later group is started by get_file_blocks_poll()
+                     when the previous one is done.
+
+   Arguments:        block (unsigned long int)       - sector number (relative
+                                                       to the start of the
+                                                       file) at which to start
+                                                       reading.
+                     length (int)                    - number of blocks to be
+                                                       read.
+                     dest (unsigned short int far *) - pointer to the memory
+                                                       where the read data is
+                                                       to be written.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: xfer_block - set to the passed block.
+                     xfer_dest  - set to the passed destination.
+                     xfer_info  - set to point at cur_info.
+                     xfer_left  - set to the passed length.
+                     xfer_read  - set to zero (0).
+
+   Author:           Tim Liu
+   Last Modified:    June 7, 2016
+
+*/
+
+void  get_file_blocks_start(unsigned long int block, int length, unsigned short int far *dest)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* finish any previous asynchronous read first */
+    while (get_file_blocks_poll() == IDE_BUSY);
+
+    /* save the state of the new read */
+    xfer_info = &cur_info;
+    xfer_block = block;
+    xfer_left = length;
+    xfer_read = 0;
+    xfer_dest = dest;
+
+    /* and start reading the first group of contiguous blocks */
+    start_disk_xfer();
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   get_file_blocks_poll
+
+   Description:      This function checks on the read started by
+                     get_file_blocks_start().  If the read is still in
+                     progress IDE_BUSY is returned, otherwise the number of
+                     blocks actually read is returned.
+
+   Operation:        If a disk read is in progress get_blocks_poll() is
+                     called.  When that read is done the read state is
+                     updated and start_disk_xfer() is called to start the
+                     next group of contiguous blocks (or to end the read).
+
+   Arguments:        None.
+   Return Value:     (int) - IDE_BUSY if the read is still in progress,
+                     otherwise the number of blocks actually read.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   If fewer blocks are read from the disk than requested
+                     the read is ended.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: xfer_block - updated by the blocks read.
+                     xfer_busy  - accessed to check for a read in progress.
+                     xfer_cnt   - accessed to check for errors.
+                     xfer_dest  - updated by the blocks read.
+                     xfer_left  - updated by the blocks read.
+                     xfer_read  - updated by the blocks read.
+
+   Author:           Tim Liu
+   Last Modified:    June 7, 2016
+
+*/
+
+int  get_file_blocks_poll()
+{
+    /* variables */
+    int  blk_cnt;               /* number of blocks read by get_blocks */
+
+
+
+    /* check if waiting on the disk */
+    if (xfer_busy)  {
+
+        /* have a disk read - see if it is done */
+        blk_cnt = get_blocks_poll();
+
+        if (blk_cnt != IDE_BUSY)  {
+
+            /* disk read is done, update the state of the transfer */
+            xfer_block += blk_cnt;                  /* next block to be read */
+            xfer_read += blk_cnt;                   /* total blocks read */
+            xfer_left -= blk_cnt;                   /* blocks left to read */
+            xfer_dest += blk_cnt * IDE_BLOCK_SIZE;  /* buffer position */
+
+            /* check for an error */
+            if (blk_cnt < xfer_cnt)
+                /* couldn't read all the sectors so stop reading */
+                xfer_left = 0;
+
+            /* start the next group of blocks (or finish) */
+            start_disk_xfer();
+        }
+    }
+
+
+    /* return busy or the number of blocks read */
+    if (xfer_busy)
+        return  IDE_BUSY;
+    else
+        return  xfer_read;
+
+}
+
+
+
+
+/*
+   get_first_dir_entry
+
+   Description:      This function gets the first valid directory entry in
+                     the directory whose starting sector number is that of the
+                     current file.  The long filename of this directory entry
+                     is also read and the filename variable is set to this
+                     long filename if it exists or the 8.3 filename if there
+                     is no long filename.  Finally the starting sector number
+                     of this entry is also saved and the extent index is filled
+                     with information for this file.  If there is an error
+                     reading the directory entry the filename is set to the
+                     empty string, the starting sector number is set to 0, the
+                     directory information is properly initialized, and TRUE
+                     is returned.  If the directory is in the library index
+                     the first index entry for the directory is used.
+                     Otherwise the whole directory is read into the directory
+                     table and its first entry is used, or if it doesn't fit
+                     get_next_dir_walk() is used to get the first entry.
+
+   Arguments:        None.
+   Return Value:     (char) - TRUE if there is an error reading the directory
+                     information, FALSE otherwise.
+
+   Inputs:           Data is read from the disk drive.
+   Outputs:          None.
+
+   Error Handling:   If there is an error reading the directory, the saved
+                     information is set to reasonable values and TRUE is
+                     returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: cur_dir     - set to the current file entry.
+                     cur_info    - set to the info for current file entry.
+                     cur_parent  - accessed to find the directory's stamp.
+                     dir_indexed - set if the directory is in the index.
+                     dir_info    - set to the current value of cur_info.
+                     dir_offset  - set to zero (0), 1st sector of directory.
+                     dir_sector  - filled with a sector of directory entries.
+                     dir_stamp   - set to the time and date of the entry.
+                     dir_tabled  - set if the directory is in the table.
+                     dirname     - set to the old value of filename.
+                     filename    - set to the filename of the current entry.
+                     idx_cur     - set to zero (0) if using the index.
+                     idx_valid   - accessed to see if there is an index.
+                     tbl_cur     - set to zero (0) if using the table.
+
+   Author:           Glen George
+   Last Modified:    June 13, 2016
+
+*/
+
+char  get_first_dir_entry()
+{
+    /* variables */
+    unsigned long int  stamp;   /* time and date of the new directory */
+
+    char  error = FALSE;        /* read error flag */
+
+
+
+    /* get the time and date of the directory being entered, for the */
+    /*    parent directory it was saved on the stack when it was entered */
+    if (cur_parent)
+        stamp = get_dir_tos_stamp();
+    else
+        stamp = ((unsigned long int) cur_fdate << 16) | cur_ftime;
+
+    /* first save the current directory information */
+    new_directory();
+    /* now have the new directory's time and date */
+    dir_stamp = stamp;
+
+    /* now entering a directory, so save it as the directory name */
+    strcpy(dirname, filename);
+
+    /* and set the block information for the directory */
+    dir_info.sector   = cur_info.sector;
+    dir_info.size     = cur_info.size;
+    dir_info.next     = cur_info.next;
+    dir_info.offset   = cur_info.offset;
+    dir_info.cluster1 = cur_info.cluster1;
+    /* directories never have an extent index */
+    dir_info.extent_idx = -1;
+
+    /* a block from the extent index doesn't know the cluster following */
+    /*    it, so in that case start at the beginning of the cluster chain */
+    if (cur_info.extent_idx != -1)  {
+        dir_info.size   = 0;
+        dir_info.offset = 0;
+        dir_info.next   = cur_info.cluster1;
+    }
+
+
+    /* check if the library index has this directory */
+    dir_indexed = idx_valid && find_dir_index();
+    /* if not, try reading the whole directory into the directory table */
+    dir_tabled = !dir_indexed && build_dir_table();
+
+
+    /* get the first file from the index, the table, or the directory itself */
+    if (dir_indexed)  {
+
+        /* directory is in the index - just use its first entry */
+        idx_cur = 0;
+        error = move_index_entry(0);
+    }
+    else if (dir_tabled)  {
+
+        /* directory is in the table - just use its first entry */
+        tbl_cur = 0;
+        load_table_entry(0);
+    }
+    else  {
+
+        /* setup the directory variables for the get_next_dir_walk function */
+        /* have to point at entry "before" first entry */
+        cur_dir = ENTRIES_PER_SECTOR - 1;   /* point at end of previous sector */
+        dir_offset = -1;                    /* will be updated to 0 */
+
+        /* now can just use the get_next_dir_walk function to get first file */
+        error = get_next_dir_walk();
+        /* and setup its block information */
+        if (!error)
+            setup_entry_info();
+    }
+
+
+    /* done, return with the error status */
+    return  error;
+
+}
+
+
+
+
+/*
+   get_next_dir_entry
+
+   Description:      This function gets the next valid directory entry in
+                     the directory.  It just uses move_dir_entry() to move
+                     forward one entry.  At the end of the directory the last
+                     entry stays the current entry (and at_dir_end() returns
+                     TRUE).
+
+   Arguments:        None.
+   Return Value:     (char) - TRUE if there is an error reading the directory
+                     information, FALSE otherwise.
+
+   Inputs:           Data is read from the disk drive.
+   Outputs:          None.
+
+   Error Handling:   If there is an error reading the directory, the saved
+                     information is set to reasonable values and TRUE is
+                     returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 13, 2016
+
+*/
+
+char  get_next_dir_entry()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* move forward one entry and return with the error status */
+    return  move_dir_entry(1);
+
+}
+
+
+
+
+/*
+   get_next_dir_walk
+
+   Description:      This function gets the next valid directory entry in
+                     the directory.  As necessary it reads sectors of 
+                     directory entries from the hard drive.  The long filename
+                     of the next directory entry is also read and the filename
+                     variable is set to this long filename if it exists or the
                      8.3 filename if it does not exist.  The current sector
-                     number and directory entry number are also updated.  The
-                     FAT cache is also filled with the information for this
-                     file.  If there is an error reading the directory entry
+                     number and directory entry number are also updated.  Only
+                     the first cluster of the entry is set in cur_info, the
+                     caller uses setup_entry_info() for the rest of the block
+                     information once it has the entry it wants.  If there is
+                     an error reading the directory entry
                      the filename is set to the empty string, the starting
                      sector number is set to 0, the directory information is
                      properly initialized, and TRUE is returned.
 
    Arguments:        None.
-   Return Value:     (char) - TRUE if there is an error reading the directory
-                     information, FALSE otherwise.
+   Return Value:     (char) - TRUE if there is an error reading the directory
+                     information, FALSE otherwise.
+
+   Inputs:           Data is read from the disk drive.
+   Outputs:          None.
+
+   Error Handling:   If there is an error reading the directory, the saved
+                     information is set to reasonable values and TRUE is
+                     returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: cur_attr            - set to the current entry's
+                                           attributes.
+                     cur_dir             - accessed and updated to the current
+                                           entry.
+                     cur_fdate           - set to the current entry's date.
+                     cur_ftime           - set to the current entry's time.
+                     cur_info            - set to the first cluster of the
+                                           current directory entry.
+                     cur_parent          - set if the current entry is "..".
+                     cur_size            - set to the current entry's size.
+                     dir_end             - set at the end of the directory.
+                     dir_info            - accessed to get the starting
+                                           cluster of the current directory.
+                     dir_offset          - accessed and possibly updated to
+                                           the sector offset of the directory
+                                           entries.
+                     dir_sector          - accessed and possibly filled with a
+                                           sector of directory entries.
+                     filename            - set to the filename of the current
+                                           entry.
+                     first_file_sector   - accessed to set the block
+                                           information on an error.
+                     sectors_per_cluster - accessed to set the block
+                                           information on an error.
+
+   Author:           Glen George
+   Last Modified:    June 16, 2016
+
+*/
+
+static  char  get_next_dir_walk()
+{
+    /* variables */
+    char  longfilename[MAX_LFN_LEN];    /* long filename of current entry */
+    int   lfn_seq;                      /* sequence number for LFN */
+    int   chksum;                       /* long filename checksum */
+
+    unsigned long int  old_dir_offset;  /* previous directory offset */
+    int                old_cur_dir;     /* old file entry in directory */
+
+    char  error = FALSE;                /* read error flag */
+    char  done = FALSE;                 /* done reading the directory info */
+
+    int   i;                            /* general loop indices */
+    int   k;
+
+
+
+    /* reset the filename to setup for this file */
+    longfilename[0] = '\0';
+
+    /* keep track of the old values (in case can't find a next entry */
+    old_dir_offset = dir_offset;
+    old_cur_dir = cur_dir;
+
+
+    /* now find the next entry in this directory */
+    while (!error && !done)  {
+
+        /* check if need to read a new sector's worth of entries */
+        if (cur_dir >= (ENTRIES_PER_SECTOR - 1))  {
+
+            /* need to read in a new sector of directory entries */
+            /* update the directory sector number */
+            dir_offset++;
+            /* read a sector of directory entries, watching for an error */
+            error = (get_disk_blocks(&dir_info, dir_offset, 1,
+                               (unsigned short int far *) dir_sector) != 1);
+            /* reset the pointer into the sector of entries */
+            /* set to -1 so will be properly incremented in a couple lines */
+            cur_dir = -1;
+        }
+
+
+        /* is this the first entry or the end of the directory */
+        if ((cur_dir == -1) || (FILENAME(dir_sector[cur_dir], 0) != '\0'))
+            /* not end of the directory - update the entry number */
+            cur_dir++;
+
+
+        /* try to find the next directory entry */
+        while (!error && !done && (cur_dir < ENTRIES_PER_SECTOR))  {
+
+            /* check if this is a long filename or a normal entry */
+            /*    (deleted long filename entries are handled as deleted) */
+            if ((ATTR(dir_sector[cur_dir]) == ATTRIB_LFN) &&
+                ((unsigned char) FILENAME(dir_sector[cur_dir], 0) != DELETED_ENTRY))  {
+
+                /* this is a long filename - collect characters */
+                /* assume ASCII instead of Unicode */
+
+                /* get the sequence number for this part of the filename */
+                /* make it zero-based */
+                lfn_seq = (L_SEQ_NUM(dir_sector[cur_dir]) & LFN_SEQ_MASK) - 1;
+
+                /* collect the pieces of the long filename */
+                for (k = 0; k < LFN_CHARS; k++)  {
+                    /* figure out where the LFN characters are */
+                    if (k < LFN1_CHARS)
+                        longfilename[LFN_CHARS * lfn_seq + k] = L_LFN1(dir_sector[cur_dir], 2 * k);
+                    else if (k < (LFN1_CHARS + LFN2_CHARS))
+                        longfilename[LFN_CHARS * lfn_seq + k] = L_LFN2(dir_sector[cur_dir], 2 * (k - LFN1_CHARS));
+                    else
+                        longfilename[LFN_CHARS * lfn_seq + k] = L_LFN3(dir_sector[cur_dir], 2 * (k - LFN1_CHARS - LFN2_CHARS));
+                }
+
+                /* check if this is the last entry */
+                if ((L_SEQ_NUM(dir_sector[cur_dir]) & LAST_LFN_ENTRY) != 0)  {
+                    /* last entry so remember the checksum */
+                    chksum = CHECKSUM(dir_sector[cur_dir]);
+                    /* also terminate the filename */
+                    longfilename[LFN_CHARS * (lfn_seq + 1)] = '\0';
+                }
+                
+                /* go to the next directory entry */
+                cur_dir++;
+            }
+            else  {
+
+                /* this is a normal entry */
+                /* first check if this entry really exists */
+                if ((unsigned char) FILENAME(dir_sector[cur_dir], 0) == DELETED_ENTRY)  {
+
+                    /* deleted entry */
+                    /* not a valid file, clear the long filename */
+                    longfilename[0] = '\0';
+                    /* and move to the next entry */
+                    cur_dir++;
+                }
+
+                /* is it the end of directory marker */
+                else if (FILENAME(dir_sector[cur_dir], 0) == '\0')  {
+
+                    /* end of directory marker */
+                    /* not a valid file, clear the filename */
+                    longfilename[0] = '\0';
+                    /* need to restore the old file state (on last file) */
+                    cur_dir = old_cur_dir;
+                    /* check if need to restore the directory sector */
+                    if (dir_offset != old_dir_offset)  {
+                        /* need to restore the old directory sector */
+                        error = (get_disk_blocks(&dir_info, old_dir_offset, 1,
+                                     (unsigned short int far *) dir_sector) != 1);
+                        /* also restore the actual offset */
+                        dir_offset = old_dir_offset;
+                    }
+                    /* restored state, now we're done */
+                    done = TRUE;
+                    /* and the move stopped at the end of the directory */
+                    dir_end = TRUE;
+                }
+
+                /* is it . or .. */
+                else if (FILENAME(dir_sector[cur_dir], 0) == '.')  {
+
+                    /* is it pointer to this directory or parent directory */
+                    if (FILENAME(dir_sector[cur_dir], 1) == '.')  {
+
+                        /* pointer to parent directory */
+                        /* so get starting cluster number and parent name */
+                        /*    (setup_entry_info() fills in the rest) */
+                        cur_info.cluster1 = get_dir_tos_sector();
+                        strcpy(filename, get_dir_tos_name());
+
+                        /* and we are done */
+                        done = TRUE;
+                    }
+                    else  {
+
+                        /* pointer to current directory - skip it */
+                        /* not a valid file, clear the long filename */
+                        longfilename[0] = '\0';
+                        /* and move to the next entry */
+                        cur_dir++;
+                    }
+                }
+
+                /* is it a volume label */
+                else if ((ATTR(dir_sector[cur_dir]) & ATTRIB_VOLUME) != 0)  {
+
+                    /* it is a volume label, see if already have a directory name */
+                    if (dirname[0] == '\0')  {
+
+                        /* no directory name currently, use volume label */
+                        /* now check if there is a long filename (shouldn't be) */
+                        /* first compute the checksum for this entry */
+                        /* if checksum OK and there is a filename - keep it */
+                        if (longfilename[0] == '\0')  {
+
+                            /* no long filename, set the directory name from 8.3 name */
+                            /* copy the filename and extension (but no .) */
+                            /* start at first character of filename */
+                            k = 0;
+                            /* copy the full filename */
+                            for (i = 0; (i < DOS_FILENAME_LEN); i++)
+                                dirname[k++] = FILENAME(dir_sector[cur_dir], i);
+
+                            /* now append the extension */
+                            for (i = 0; (i < DOS_EXTENSION_LEN); i++)
+                                dirname[k++] = EXTENSION(dir_sector[cur_dir], i);
+
+                            /* finally, null terminate the string */
+                            dirname[k] = '\0';
+                        }
+                        else  {
+
+                            /* have a long filename - save it as the  directory name */
+                            strcpy(dirname, longfilename);
+                        }
+                    }
+                    else  {
+
+                        /* already have a directory name so ignore volume label */
+                        /* means we cursored back up to the directory */
+                        ;
+                    }
+
+                    /* in any case, erase any long file name */
+                    longfilename[0] = '\0';
+                    /* and move to the next entry (ignore volume label) */
+                    cur_dir++;
+                }
+
+                /* none of the above, so must actually be a file */
+                else  {
+
+                    /* need to set the first cluster and filename */
+                    /*    (setup_entry_info() fills in the rest) */
+                    /* get the first cluster from the directory information */
+                    if (fat16)
+                        cur_info.cluster1 = START_CLUSTER(dir_sector[cur_dir]);
+                    else
+                        cur_info.cluster1 = START_CLUSTER32(dir_sector[cur_dir]);
+
+                    /* now check if there is a long filename */
+                    /* first compute the checksum for this entry */
+                    /* if checksum OK and there is a filename - keep it */
+                    if (longfilename[0] == '\0')  {
+
+                        /* no long filename, set the filename from 8.3 name */
+                        /* copy the filename and extension */
+                        /* start at first character of filename */
+                        k = 0;
+                        /* copy the filename without the trailing spaces */
+                        for (i = 0; ((i < DOS_FILENAME_LEN) && (FILENAME(dir_sector[cur_dir], i) != ' ')); i++)
+                            filename[k++] = FILENAME(dir_sector[cur_dir], i);
+
+                        /* add the '.' separating name and extension */
+                        filename[k++] = '.';
+
+                        /* now add the extension, skipping trailing spaces */
+                        for (i = 0; ((i < DOS_EXTENSION_LEN) && (EXTENSION(dir_sector[cur_dir], i) != ' ')); i++)
+                            filename[k++] = EXTENSION(dir_sector[cur_dir], i);
+
+                        /* finally, null terminate the string */
+                        filename[k] = '\0';
+                    }
+                    else  {
+
+                        /* have a long filename - save it as the filename */
+                        strcpy(filename, longfilename);
+                    }
+
+                    /* got to the next entry so set the done flag */
+                    done = TRUE;
+                }
+            }
+        }
+    }
+
+
+    /* remember the information for the current entry */
+    if (!error)  {
+        cur_attr = ATTR(dir_sector[cur_dir]);
+        cur_ftime = FTIME(dir_sector[cur_dir]);
+        cur_fdate = FDATE(dir_sector[cur_dir]);
+        cur_size = FSIZE(dir_sector[cur_dir]);
+        /* the only '.' entry that can be current is ".." */
+        cur_parent = (FILENAME(dir_sector[cur_dir], 0) == '.');
+    }
+
+
+    /* check if there was an error */
+    if (error)  {
+        /* had an error - clear out the data */
+        /* clear the filename */
+        filename[0] = '\0';
+        /* set the file info to the first sector */
+        cur_info.sector    = first_file_sector;
+        cur_info.size      = sectors_per_cluster;
+        cur_info.next      = CHAIN_END;
+        cur_info.offset    = 0;
+        cur_info.cluster1   = 2;
+        cur_info.extent_idx = -1;
+        /* and there is no entry information */
+        cur_attr = 0;
+        cur_size = 0;
+        cur_parent = FALSE;
+    }
+
+
+    /* finally done, return with the error status */
+    return  error;
+
+}
+
+
+
+
+/*
+   get_previous_dir_entry
+
+   Description:      This function gets the previous valid directory entry
+                     in the directory.  It just uses move_dir_entry() to move
+                     back one entry.  At the start of the directory the first
+                     entry stays the current entry.
+
+   Arguments:        None.
+   Return Value:     (char) - TRUE if there is an error reading the directory
+                     information, FALSE otherwise.
+
+   Inputs:           Data is read from the disk drive.
+   Outputs:          None.
+
+   Error Handling:   If there is an error reading the directory, the saved
+                     information is set to reasonable values and TRUE is
+                     returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 13, 2016
+
+*/
+
+char  get_previous_dir_entry()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* move back one entry and return with the error status */
+    return  move_dir_entry(-1);
+
+}
+
+
+
+
+/*
+   move_dir_entry
+
+   Description:      This function moves the passed number of valid entries
+                     through the directory and makes that entry the current
+                     file.  The move stops at the first and last entries of
+                     the directory.  If the directory is in the library index
+                     or the directory table this is just an index change,
+                     otherwise the directory sectors are walked one entry at
+                     a time and only the entry reached gets its block
+                     information set up.  If the move forward is stopped by
+                     the end of the directory dir_end is set (see
+                     at_dir_end()).
+
+   Arguments:        n (int) - number of entries to move (negative to move
+                               back toward the start of the directory).
+   Return Value:     (char) - TRUE if there is an error reading the directory
+                     information, FALSE otherwise.
+
+   Inputs:           Data may be read from the disk drive.
+   Outputs:          None.
+
+   Error Handling:   If there is an error reading the directory, the saved
+                     information is set to reasonable values and TRUE is
+                     returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: dir_end     - set if stopped at the end.
+                     dir_indexed - accessed to see if using the index.
+                     dir_tabled  - accessed to see if using the table.
+                     idx_count   - accessed to check for the end.
+                     idx_cur     - accessed to check for the end.
+                     tbl_count   - accessed to limit the move.
+                     tbl_cur     - updated to the new table entry.
+
+   Author:           Tim Liu
+   Last Modified:    June 13, 2016
+
+*/
+
+char  move_dir_entry(int n)
+{
+    /* variables */
+    int   i;                    /* entries moved so far */
+
+    char  error = FALSE;        /* read error flag */
+
+
+
+    /* not at the end of the directory unless the move gets there */
+    dir_end = FALSE;
+
+
+    /* move using the library index, the table, or the directory itself */
+    if (dir_indexed)  {
+
+        /* directory is in the index, it handles the move */
+        /* (it stops on the last entry if the move goes past it) */
+        dir_end = (n >= (idx_count - idx_cur));
+        error = move_index_entry(n);
+    }
+    else if (dir_tabled)  {
+
+        /* directory is in the table, just move in the table */
+        /* staying inside the directory */
+        if (n < -tbl_cur)
+            tbl_cur = 0;
+        else if (n >= (tbl_count - tbl_cur))  {
+            /* can't move that far, stop on the last entry */
+            tbl_cur = tbl_count - 1;
+            dir_end = TRUE;
+        }
+        else
+            tbl_cur += n;
+
+        /* and make the new entry the current file */
+        load_table_entry(tbl_cur);
+    }
+    else  {
+
+        /* walk the directory sectors an entry at a time */
+        /*    (get_next_dir_walk() sets dir_end at the end) */
+        for (i = 0; !error && (i < n); i++)
+            error = get_next_dir_walk();
+        for (i = 0; !error && (i > n); i--)
+            error = get_previous_dir_walk();
+
+        /* now setup the block information for the entry reached */
+        if (!error)
+            setup_entry_info();
+    }
+
+
+    /* done, return with the error status */
+    return  error;
+
+}
+
+
+
+
+/*
+   at_dir_end
+
+   Description:      This function returns whether or not the last move
+                     through the directory (move_dir_entry() or
+                     get_next_dir_entry()) was stopped by the end of the
+                     directory.  The current entry is then the last entry
+                     of the directory.
+
+   Arguments:        None.
+   Return Value:     (char) - TRUE if the last move stopped at the end of
+                     the directory, FALSE if it did not.
+
+   Inputs:           None.
+   Outputs:          None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: dir_end - accessed to determine the end status.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+char  at_dir_end()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* just return whether or not the last move stopped at the end */
+    return  dir_end;
+
+}
+
+
+
+
+/*
+   get_previous_dir_walk
+
+   Description:      This function gets the previous valid directory entry in
+                     the directory.  As necessary it reads sectors of 
+                     directory entries from the hard drive.  The function
+                     backs up through the directory to the first standard
+                     directory entry prior the current one and then back
+                     before any long filename for that entry.  The long
+                     filename of the previous directory entry is also read and
+                     the filename variable is set to this long filename if it
+                     exists or the 8.3 filename if there is no long filename.
+                     The current sector number and directory entry number are
+                     also updated.  If there is an error reading the directory
+                     entry the filename is set to the empty string, the
+                     starting sector number is set to 0, the directory
+                     information is properly initialized, and TRUE is
+                     returned.
+
+   Arguments:        None.
+   Return Value:     (char) - TRUE if there is an error reading the directory
+                     information, FALSE otherwise.
+
+   Inputs:           Data is read from the disk drive.
+   Outputs:          None.
+
+   Error Handling:   If there is an error reading the directory, the saved
+                     information is set to reasonable values and TRUE is
+                     returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: cur_attr      - cleared on an error.
+                     cur_dir       - accessed and updated to the current
+                                     entry.
+                     cur_info      - set to the first cluster of the
+                                     current entry.
+                     cur_parent    - cleared on an error.
+                     cur_size      - cleared on an error.
+                     dir_offset    - accessed and possibly updated to the
+                                     sector offset of the directory entries.
+                     dir_sector    - accessed and possibly filled with a
+                                     sector of directory entries.
+                     filename      - set to the filename of the current entry.
+
+   Author:           Glen George
+   Last Modified:    June 16, 2016
+
+*/
+
+static  char  get_previous_dir_walk()
+{
+    /* variables */
+    unsigned long int  new_offset;      /* new directory sector offset */
+    int                new_entry;       /* new directory entry */
+
+    char  error = FALSE;        /* read error flag */
+    char  done = FALSE;         /* done getting the previous directory info */
+    char  have_entry = FALSE;   /* have the entry (but maybe not the filename) */
+
+
+
+    /* find the previous entry in this directory */
+    /* loop until find the entry or get an error */
+    while (!error && !done)  {
+
+        /* check if need to read a new sector's worth of entries */
+        if (cur_dir == 0)  {
+
+            /* need to read in the previous sector of directory entries */
+            /* check if out of directory entries */
+            if (dir_offset == 0)  {
+                /* out of directory entries - reset to the start */
+                new_offset = 0;
+                new_entry = 0;
+                /* and done */
+                done = TRUE;
+            }
+            else  {
+                /* have a previous directory entry to check, read the */
+                /*    sector of directory entries, watching for an error */
+                error = (get_disk_blocks(&dir_info, --dir_offset, 1,
+                                 (unsigned short int far *) dir_sector) != 1);
+                /* and reset to the last file entry in the directory */
+                cur_dir = ENTRIES_PER_SECTOR - 1;
+            }
+        }
+        else  {
+
+            /* still more files in this directory, just check the previous entry */
+            cur_dir--;
+        }
+
+
+        /* if not an error or done, keep processing */
+        if (!done && !error)  {
+
+            /* check if have already found a previous entry */
+            if (have_entry)  {
+
+                /* already found a previous entry, but need to skip its */
+                /* potentional long filename too */
+                if ((ATTR(dir_sector[cur_dir]) != ATTRIB_LFN) ||
+                    ((unsigned char) FILENAME(dir_sector[cur_dir], 0) == DELETED_ENTRY))  {
+                    /* not a long filename, must be done */
+                    done = TRUE;
+                }
+                else  {
+                    /* still part of a long filename for the entry */
+                    /* so remember that this is potentially where new entry will start */
+                    new_offset = dir_offset;
+                    new_entry = cur_dir;
+                }
+            }
+            else  {
+
+                /* have not found a previous entry yet, is this one */
+                /* ignore empty entries, deleted entries, long filenames, */
+                /*    volume labels, and '.' directory */
+                if ((FILENAME(dir_sector[cur_dir], 0) != '\0')  &&
+                     ((unsigned char) FILENAME(dir_sector[cur_dir], 0) != DELETED_ENTRY)  &&
+                     (ATTR(dir_sector[cur_dir]) != ATTRIB_LFN) &&
+                     (ATTR(dir_sector[cur_dir]) != ATTRIB_VOLUME) &&
+                     ((FILENAME(dir_sector[cur_dir], 0) != '.')  ||
+                      (FILENAME(dir_sector[cur_dir], 1) == '.')))  {
+
+                    /* have the previous directory entry, remember that */
+                    have_entry = TRUE;
+                    /* and keep track of where the entry starts */
+                    new_offset = dir_offset;
+                    new_entry = cur_dir;
+                }
+                else  {
+
+                    /* not a previous entry, ignore it and keep looking */
+                    ;
+                }
+            }
+        }
+    }
+
+    /* if no error, update to the new sector, offset, and directory entry */
+    if (!error)  {
+
+        /* first read in the new sector if had moved past it */
+        if (new_offset != dir_offset)
+            error = (get_disk_blocks(&dir_info, new_offset, 1,
+                                 (unsigned short int far *) dir_sector) != 1);
+        /* now update the sector offset and directory entry */
+        dir_offset = new_offset;
+        cur_dir = new_entry - 1;    /* get_next_dir_walk() will inc this */
+    }
+
+
+    /* if finished without an error then get the actual previous filename */
+    if (done & !error)  {
+
+        /* get the entry watching for errors */
+        /* since we've backed up past the previous entry, this will now */
+        /*    find the previous entry */
+        error = get_next_dir_walk();
+    }
+
+
+    /* check if there was an error */
+    /*    note that this is redundant if error is from get_next_dir_entry() */
+    /*    but it's needed if error is from get_disk_blocks() */
+    if (error)  {
+        /* had an error - clear out the data */
+        /* clear the filename */
+        filename[0] = '\0';
+        /* set the file info to the first sector */
+        cur_info.sector    = first_file_sector;
+        cur_info.size      = sectors_per_cluster;
+        cur_info.next      = CHAIN_END;
+        cur_info.offset    = 0;
+        cur_info.cluster1   = 2;
+        cur_info.extent_idx = -1;
+        /* and there is no entry information */
+        cur_attr = 0;
+        cur_size = 0;
+        cur_parent = FALSE;
+    }
+
+
+    /* finally done, return with the error status */
+    return  error;
+
+}
+
+
+
+
+/* local functions to support FAT16/FAT32 fragmented files */
+
+
+/*
+   get_disk_blocks
+
+   Description:      This function reads blocks from the file whose
+                     information block is passed as the first argument.  The
+                     data "read" is written to the memory pointed to by the
+                     fourth argument.  The number of blocks requested is given
+                     as the third argument.  The starting block number in the
+                     file to read is passed as the second argument.  The
+                     number of sectors (blocks) actually read is returned.
+                     The sectors are read through the sector cache, so short
+                     reads (directory sectors, tags) may not need the disk.
+
+   Arguments:        info (struct block_info *)      - block information to be
+                                                       used and possibly
+                                                       updated by this
+                                                       function to get file
+                                                       data.
+                     block (unsigned long int)       - sector number (relative
+                                                       to the start of the
+                                                       file) at which to start
+                                                       reading.
+                     length (int)                    - number of blocks to be
+                                                       read.
+                     dest (unsigned short int far *) - pointer to the memory
+                                                       where the read data is
+                                                       to be written.
+   Return Value:     The number of blocks actually read.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Glen George
+   Last Modified:    June 9, 2016
+
+*/
+
+int  get_disk_blocks(struct block_info *info, unsigned long int block,
+                     int length, unsigned short int far *dest)
+{
+    /* variables */
+    int   sectors_read = 0;     /* total number of sectors actually read */
+
+    int   xfer_cnt;             /* number of blocks to try to read */
+    int   blk_cnt;              /* number of blocks read by get_blocks */
+
+    char  error = FALSE;        /* error reading the disk */
+
+
+
+    /* read contiguous groups of blocks until error or all are read */
+    while (!error && (sectors_read < length))  {
+
+        /* see how many sectors can be read contiguously */
+        xfer_cnt = get_contig_count(info, block, length - sectors_read);
+
+        /* now read the sectors (through the cache) */
+        blk_cnt = get_cached_blocks(info->sector + block - info->offset, xfer_cnt, dest);
+
+        /* update the state of the transfer */
+        block += blk_cnt;                   /* update next block to be read */
+        sectors_read += blk_cnt;            /* update total sectors read */
+        dest += blk_cnt * IDE_BLOCK_SIZE;   /* update buffer position */
+
+        /* check for an error (including sectors past the end of the file) */
+        if ((blk_cnt < xfer_cnt) || (blk_cnt == 0))
+            /* couldn't read all the sectors so an error must have occurred */
+            error = TRUE;
+    }
+
+
+    /* return the number of sectors actually read */
+    return  sectors_read;
+
+}
+
+
+
+
+/*
+   get_cached_blocks
+
+   Description:      This function reads the passed number of sectors,
+                     starting at the passed sector number, into the memory
+                     pointed to by the third argument.  Short reads (at most
+                     SECTOR_CACHE_MAX_READ sectors) go through the sector
+                     cache.  Longer reads are streaming file data (MP3
+                     payload) and bypass the cache so they do not evict the
+                     FAT, directory, and tag sectors that are read again and
+                     again.  The number of sectors actually read is returned.
+
+   Arguments:        sector (unsigned long int)      - sector number on the
+                                                       hard drive at which to
+                                                       start reading.
+                     length (int)                    - number of sectors to be
+                                                       read.
+                     dest (unsigned short int far *) - pointer to the memory
+                                                       where the read data is
+                                                       to be written.
+   Return Value:     The number of sectors actually read.
+
+   Input:            Sectors not in the cache are read from the hard drive.
+   Output:           None.
+
+   Error Handling:   If a sector cannot be read the cache block it was to be
+                     read into is marked empty and reading stops.
+
+   Algorithms:       Least recently used replacement.  Each cache block has
+                     the time of its last use and the oldest (or an empty)
+                     block is replaced on a miss.
+   Data Structures:  None.
+
+   Shared Variables: cache_age    - updated when a block is used.
+                     cache_hits   - incremented for sectors in the cache.
+                     cache_misses - incremented for sectors read into the
+                                    cache.
+                     cache_sector - updated when a block is replaced.
+                     cache_time   - incremented on each block use.
+                     sector_cache - accessed and updated with sector data.
+
+   Author:           Tim Liu
+   Last Modified:    June 9, 2016
+
+*/
+
+static  int  get_cached_blocks(unsigned long int sector, int length,
+                               unsigned short int far *dest)
+{
+    /* variables */
+    unsigned short int  far *p;         /* pointer into a cache block */
+
+    int   sectors_read = 0;             /* number of sectors actually read */
+
+    int   idx;                          /* cache block with the sector */
+    int   lru;                          /* least recently used cache block */
+
+    char  error = FALSE;                /* error reading the disk */
+
+    int   i;                            /* general loop index */
+
+
+
+    /* check if this is a streaming read */
+    if (length > SECTOR_CACHE_MAX_READ)  {
+
+        /* long read, just get it from the disk */
+        sectors_read = get_blocks(sector, length, dest);
+    }
+    else  {
+
+        /* short read, get each sector from the cache */
+        while (!error && (sectors_read < length))  {
+
+            /* look for the sector, remembering the least recently used */
+            /*    block in case it isn't there (empty blocks are oldest) */
+            for (idx = 0, lru = 0; (idx < SECTOR_CACHE_BLOCKS) &&
+                                   (cache_sector[idx] != sector); idx++)
+                if (cache_age[idx] < cache_age[lru])
+                    lru = idx;
+
+            /* check if the sector was found */
+            if (idx < SECTOR_CACHE_BLOCKS)  {
+                /* have the sector */
+                cache_hits++;
+            }
+            else  {
+
+                /* don't have the sector, read it over the oldest block */
+                cache_misses++;
+                idx = lru;
+                error = (get_blocks(sector, 1, sector_cache + idx * IDE_BLOCK_SIZE) != 1);
+
+                /* block now holds this sector unless there was an error */
+                if (!error)  {
+                    cache_sector[idx] = sector;
+                }
+                else  {
+                    cache_sector[idx] = EMPTY_SECTOR;
+                    cache_age[idx] = 0;
+                }
+            }
+
+            /* if have the sector, copy it out and mark the block used */
+            if (!error)  {
+
+                cache_age[idx] = ++cache_time;
+
+                p = sector_cache + idx * IDE_BLOCK_SIZE;
+                for (i = 0; i < IDE_BLOCK_SIZE; i++)
+                    *dest++ = *p++;
+
+                /* on to the next sector */
+                sector++;
+                sectors_read++;
+            }
+        }
+    }
+
+
+    /* return the number of sectors actually read */
+    return  sectors_read;
+
+}
+
+
+
+
+/*
+   get_contig_count
+
+   Description:      This function returns the number of blocks that can be
+                     read contiguously from the hard drive starting at the
+                     passed block of the file whose information block is
+                     passed.  At most the passed number of blocks is
+                     returned.  The information block is updated to the
+                     block of the file holding the passed sector if needed.
+
+   Arguments:        info (struct block_info *) - block information to be
+                                                  used and possibly updated.
+                     block (unsigned long int)  - sector number (relative to
+                                                  the start of the file) at
+                                                  which the read starts.
+                     length (int)               - maximum number of blocks to
+                                                  be read.
+   Return Value:     (int) - number of contiguous blocks to read.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Glen George
+   Last Modified:    June 7, 2016
+
+*/
+
+static  int  get_contig_count(struct block_info *info, unsigned long int block, int length)
+{
+    /* variables */
+    int  cnt;                   /* number of blocks to read */
+
+
+
+    /* see if can get sectors from current file block */
+    if ((block < info->offset) || (block >= (info->offset + info->size)))
+        /* the sector isn't in current block, get new block */
+        get_block_info(info, block);
+
+    /* should now be able to find/read the desired sectors */
+    /* see how many sectors are contiguous */
+    if ((block < info->offset) || (block >= (info->offset + info->size)))
+        /* the sector isn't in the file (past its end) */
+        cnt = 0;
+    else if ((info->offset + info->size - block) >= length)
+        /* all the sectors we need are contiguous in this block */
+        cnt = length;
+    else
+        /* can only get contiguous sectors up to the end of the block */
+        cnt = info->offset + info->size - block;
+
+
+    /* return the number of contiguous sectors */
+    return  cnt;
+
+}
+
+
+
+
+/*
+   start_disk_xfer
+
+   Description:      This function starts the next disk read of the
+                     asynchronous file read.  If there is nothing left to
+                     read the asynchronous read is finished.
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   If no contiguous blocks can be found (past the end of
+                     the file) the read is finished.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: xfer_block - accessed to get the block to read.
+                     xfer_busy  - set if a disk read is started, cleared
+                                  otherwise.
+                     xfer_cnt   - set to the number of blocks being read.
+                     xfer_dest  - accessed to get the read destination.
+                     xfer_info  - used and updated to find the blocks.
+                     xfer_left  - accessed to get the blocks left to read.
+
+   Author:           Tim Liu
+   Last Modified:    June 7, 2016
+
+*/
+
+static  void  start_disk_xfer()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* assume there is nothing to read */
+    xfer_busy = FALSE;
+
+    /* check if there is anything left to read */
+    if (xfer_left > 0)  {
+
+        /* see how many sectors can be read contiguously */
+        xfer_cnt = get_contig_count(xfer_info, xfer_block, xfer_left);
+
+        /* start reading them if there are any */
+        if (xfer_cnt > 0)  {
+            get_blocks_start(xfer_info->sector + xfer_block - xfer_info->offset,
+                             xfer_cnt, xfer_dest);
+            xfer_busy = TRUE;
+        }
+    }
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   get_block_info
+
+   Description:      This function fills in the passed block information
+                     structure with information from the extent index or
+                     the FAT.  The passed sector within the file along with
+                     the current value of the block information are used to
+                     figure out which block to load the structure with.  The
+                     cluster1 element of the structure is not changed.
+
+   Operation:        If the structure has an extent index (extent_idx is not
+                     -1) the index is binary searched for the extent holding
+                     the sector.  If the sector is past the end of the index
+                     (the index was full) the FAT chain is followed from the
+                     end of the index.  Without an extent index (directories)
+                     the FAT chain is followed from the current block, or
+                     from the start of the chain if moving backward.
+
+   Arguments:        info (struct block_info *) - block information to be used
+                                                  and updated by this
+                                                  function.
+                     sector (unsigned long int) - sector number within a file
+                                                  for which the block
+                                                  information is to be found.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       Binary search of the extent index.
+   Data Structures:  None.
+
+   Shared Variables: extent_next - accessed to continue past the index.
+                     extents     - accessed to get block information.
+                     num_extents - accessed to get the index size.
+
+   Author:           Glen George
+   Last Modified:    June 11, 2016
+
+*/
+
+static  void  get_block_info(struct block_info *info, unsigned long int sector)
+{
+    /* variables */
+    struct  cache_entry  e;                     /* information on clusters */
+
+    int                  lo;                    /* binary search range */
+    int                  hi;
+    int                  mid;
+
+    char                 have_block = FALSE;    /* have the requested block */
+
+
+
+    /* check if already have the sector */
+    if ((sector >= info->offset) && (sector < (info->offset + info->size)))
+        /* have the sector in the current block */
+        have_block = TRUE;
+
+
+    /* if don't have the block yet, search the extent index if there is one */
+    if (!have_block && (info->extent_idx != -1) && (num_extents > 0))  {
+
+        /* find the last extent starting at or before the sector */
+        lo = 0;
+        hi = num_extents - 1;
+        while (lo < hi)  {
+            /* round up so the range always shrinks */
+            mid = (lo + hi + 1) / 2;
+            if (extents[mid].offset <= sector)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+
+        /* check if the sector is in that extent */
+        if (sector < (extents[lo].offset + extents[lo].size))  {
+
+            /* have the sector, use this extent */
+            info->offset = extents[lo].offset;
+            info->sector = extents[lo].sector;
+            info->size = extents[lo].size;
+            info->next = extent_next;
+            info->extent_idx = lo;
+            have_block = TRUE;
+        }
+        else if ((info->extent_idx < num_extents) || (sector < info->offset))  {
+
+            /* sector is past the end of the index, follow the FAT from */
+            /*    the last extent (unless already past it and going forward) */
+            info->offset = extents[num_extents - 1].offset;
+            info->sector = extents[num_extents - 1].sector;
+            info->size = extents[num_extents - 1].size;
+            info->next = extent_next;
+            /* mark that the block is past the index */
+            info->extent_idx = num_extents;
+        }
+    }
+
+
+    /* if still don't have the sector will need to search the FAT on the */
+    /*    hard drive for it - either start at beginning or next cluster */
+    if (!have_block && (info->extent_idx == -1))  {
+
+        /* no extent index, check where to start searching */
+        if (sector < info->offset)  {
+            /* moving backward in file, have to start at beginning */
+            info->next = info->cluster1;
+            /* reset block information to zero sized block at beginning of file */
+            info->size = 0;
+            info->offset = 0;
+        }
+    }
+
+    /* now search through the hard drive FAT for the sector */
+    while (!have_block && (info->next != CHAIN_END) &&
+           (sector >= (info->offset + info->size)))  {
+
+        /* get information on the contiguous sectors starting at current cluster */
+        info->next = get_contig_sectors(info->next, &e);
+
+        /* now fill in the block information based on this */
+        /* watch for special case of FAT16 root directory */
+        if (info->cluster1 == 0)
+            /* FAT16 root use FAT16 starting sector, not returned cluster */
+            info->sector = root_start_sector;
+        else
+            /* not FAT16 root, use returned cluster to get sector */
+            info->sector = (e.cluster - 2) * sectors_per_cluster + first_file_sector;
+
+        /* get the rest of the information */
+        info->offset += info->size;
+        info->size = e.size;
+    }
+
+
+    /* we've looked everywhere at this point so we'd better have the sector */
+    /* no way to report errors if we don't, so just return now */
+    return;
+
+}
+
+
+
+
+/*
+   build_extent_index
+
+   Description:      This function fills the extent index with the extents
+                     of the file whose first cluster is passed.  Each extent
+                     is a run of contiguous sectors with its offset in the
+                     file, so the index is sorted by file offset.  If the file
+                     has more than MAX_EXTENTS extents only the first
+                     MAX_EXTENTS are indexed and the cluster following them
+                     is saved so the rest of the file can still be found.
+
+   Arguments:        cluster (unsigned long int) - first cluster of the file.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: extent_next         - set to the cluster following the
+                                           last extent (CHAIN_END if the
+                                           whole file is indexed).
+                     extents             - filled with the file's extents.
+                     first_file_sector   - accessed to compute sectors.
+                     num_extents         - set to the number of extents.
+                     sectors_per_cluster - accessed to compute sectors.
+
+   Author:           Tim Liu
+   Last Modified:    June 11, 2016
+
+*/
+
+static  void  build_extent_index(unsigned long int cluster)
+{
+    /* variables */
+    struct  cache_entry  e;             /* a run of contiguous clusters */
+
+    unsigned long int    offset = 0;    /* file offset of the next extent */
+
+
+
+    /* start with an empty index */
+    num_extents = 0;
+
+    /* add the runs of contiguous clusters until the end of the chain */
+    /*    (there is always at least one, possibly empty, extent) */
+    do  {
+
+        /* get the contiguous sectors at current position */
+        cluster = get_contig_sectors(cluster, &e);
+
+        /* add this extent to the index */
+        extents[num_extents].offset = offset;
+        extents[num_extents].sector = (e.cluster - 2) * sectors_per_cluster + first_file_sector;
+        extents[num_extents].size = e.size;
+        num_extents++;
+
+        /* next extent starts after this one */
+        offset += e.size;
+
+    } while ((num_extents < MAX_EXTENTS) && (cluster != CHAIN_END));
+
+    /* remember where the chain continues (if the index is full) */
+    extent_next = cluster;
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   get_contig_sectors
+
+   Description:      This function reads the FAT information in the FAT mirror
+                     to fill in the passed structure with information for the
+                     passed cluster.  The returned information gives the
+                     number of contiguous sectors starting at the passed
+                     cluster number.  The cluster number of the first
+                     non-contiguous cluster is returned.
+
+   Operation:        The function first checks for the special cases of
+                     cluster 0 (FAT16 root directory) and END_CHAIN (returns
+                     a zero length entry).  If it is neither special case the
+                     FAT entry for the passed cluster number is looked up with
+                     get_FAT_entry() and the information for that entry is
+                     entered in the structure.  The function continues
+                     following the FAT as long as the clusters are
+                     contiguous, updating the size of the contiguous block as
+                     it goes.
+
+   Arguments:        cluster (unsigned long int)  - starting cluster number 
+                                                    at which the number of
+                                                    contiguous sectors is to
+                                                    be found.
+                     entry (struct cache_entry *) - cache entry (general FAT)
+                                                    information to be filled
+                                                    in by this function.
+   Return Value:     (unsigned long int) - cluster number of the first
+                     non-contiguous cluster following the passed cluster
+                     number, CHAIN_END if the end of the file is reached
+                     before a non-contiguous cluster is found.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: fat16               - accessed to determine FAT type.
+                     root_dir_size       - accessed if cluster is FAT16 root.
+                     root_start_sector   - accessed if cluster is FAT16 root.
+                     sectors_per_cluster - accessed.
+
+   Author:           Glen George
+   Last Modified:    June 10, 2016
+
+*/
+
+static  unsigned long int  get_contig_sectors(unsigned long int cluster,
+                                              struct cache_entry *entry)
+{
+    /* variables */
+    unsigned long int   next;                   /* next cluster from FAT */
+
+    char                contig = TRUE;          /* clusters are contiguous */
+
+
+
+    /* first check for special cluster values */
+    if (cluster == 0)  {
+
+        /* zero cluster is illegal, so this indicates want FAT16 root */
+        entry->cluster = root_start_sector;     /* use root values */
+        entry->size = root_dir_size;
+        next = CHAIN_END;                       /* no next cluster */
+    }
+    else if (cluster == CHAIN_END)  {
+
+        /* end of chain indicator, return a zero length cluster */
+        entry->cluster = 0;
+        entry->size = 0;
+        next = CHAIN_END;                       /* no next cluster */
+    }
+    else  {
+
+        /* normal cluster number */
+        /* first sector for entry is based on cluster number */
+        entry->cluster = cluster;
+        /* nothing in it yet */
+        entry->size = 0;
+
+        /* while there are contiguous clusters, get the FAT information */
+        while (contig)  {
+
+            /* get the next cluster number from the FAT mirror */
+            /*    errors come back as CHAIN_END which ends the loop */
+            next = get_FAT_entry(cluster);
+
+            /* check if the cluster contiguous */
+            /* note that end of chain markers will not be contiguous */
+            contig = (next == (cluster + 1));
+
+            /* this cluster was already found to be contiguous, so update size */
+            entry->size += sectors_per_cluster;
+
+            /* can update the cluster number assuming contiguous */
+            cluster++;
+        }
+
+        /* set the next cluster pointer in chain to CHAIN_END if there was */
+        /* an error or hit the end of the cluster chain in the FAT */
+        if ((fat16 && (next >= FAT16_BAD)) || (!fat16 && (next >= FAT32_BAD)))  {
+            /* have an error or a bad cluster or end of chain marker */
+            /* next pointer is end of chain */
+            next = CHAIN_END;
+        }
+    }
+
+
+    /* done getting the cluster information, return */
+    return  next;
+
+}
+
+
+
+
+/*
+   get_FAT_entry
+
+   Description:      This function returns the FAT entry (the next cluster
+                     number in the chain) for the passed cluster.  The entry
+                     is read from the FAT mirror in memory.  If the FAT
+                     sector holding the entry is not in the mirror (the FAT
+                     is too large to be mirrored whole) the mirror is moved
+                     to a window of FAT sectors starting at that sector.
+
+   Arguments:        cluster (unsigned long int) - cluster number whose FAT
+                                                   entry is to be returned.
+   Return Value:     (unsigned long int) - the FAT entry for the cluster or
+                     CHAIN_END if it could not be read.
+
+   Input:            FAT sectors may be read from the hard drive.
+   Output:           None.
+
+   Error Handling:   If the FAT sector cannot be read or the cluster is past
+                     the end of the FAT, CHAIN_END is returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: clusters_per_sector - accessed.
+                     fat16               - accessed to determine FAT type.
+                     FAT_mirror          - accessed (PC version).
+                     FAT_size            - accessed.
+                     mirror_blocks       - accessed.
+                     mirror_first        - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  unsigned long int  get_FAT_entry(unsigned long int cluster)
+{
+    /* variables */
+    unsigned short int  far *p;         /* FAT sector in the mirror */
+
+    unsigned long int   s;              /* FAT sector of the entry */
+    int                 c;              /* entry within the FAT sector */
+
+    unsigned long int   next;           /* the FAT entry */
+
+    int                 n;              /* number of sectors in a window */
+
+    char                error = FALSE;  /* error getting the FAT sector */
+
+
+
+    /* get the FAT sector (relative to the start of the FAT) and entry */
+    s = cluster / clusters_per_sector;
+    c = cluster % clusters_per_sector;
+
+    /* check if the sector is in the mirror */
+    if ((s < mirror_first) || (s >= (mirror_first + mirror_blocks)))  {
+
+        /* not in the mirror, slide the window to start at the sector */
+        if (s < FAT_size)  {
+            /* sector is in the FAT, don't load past the end of it */
+            n = ((FAT_size - s) < FAT_WINDOW_BLOCKS) ? (int) (FAT_size - s) : FAT_WINDOW_BLOCKS;
+            error = load_FAT_mirror(s, n);
+        }
+        else  {
+            /* past the end of the FAT - bad cluster number */
+            error = TRUE;
+        }
+    }
+
+    /* get the entry if have the sector */
+    if (!error)  {
+
+        /* find the sector in the mirror */
+#ifdef  PCVERSION
+        p = FAT_mirror + (s - mirror_first) * IDE_BLOCK_SIZE;
+#else
+        /* sector may be in a different segment */
+        p = (unsigned short int far *) MAKE_FARPTR(FAT_MIRROR_SEG + (s - mirror_first) *
+                                                   (IDE_BLOCK_SIZE * sizeof(short int) / 16L), 0);
+#endif
+
+        /* get the entry (based on FAT type) */
+        if (fat16)
+            /* FAT16 so each entry is one word */
+            next = p[c];
+        else
+            /* FAT32, each entry is two words (low word first), only */
+            /*    the low 28 bits are the cluster number */
+            next = (((unsigned long int) (p[2 * c] & 0xFFFF)) |
+                    (((unsigned long int) (p[2 * c + 1] & 0xFFFF)) << 16)) & FAT32_MASK;
+    }
+    else  {
+
+        /* couldn't get the entry, treat it as the end of the chain */
+        next = CHAIN_END;
+    }
+
+
+    /* return the FAT entry */
+    return  next;
+
+}
+
+
+
+
+/*
+   load_FAT_mirror
+
+   Description:      This function reads the passed number of FAT sectors,
+                     starting at the passed sector of the FAT, into the FAT
+                     mirror.  The mirror then holds those sectors only.  The
+                     sectors are read FAT_WINDOW_BLOCKS at a time since the
+                     mirror may cross segment boundaries.
+
+   Arguments:        first (unsigned long int) - sector of the FAT (relative
+                                                 to its start) to start at.
+                     blocks (int)              - number of FAT sectors to
+                                                 read.
+   Return Value:     (char) - TRUE if there was an error reading the FAT,
+                     FALSE otherwise.
+
+   Input:            FAT sectors are read from the hard drive.
+   Output:           None.
+
+   Error Handling:   If there is an error only the sectors read before the
+                     error are left in the mirror and TRUE is returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: first_FAT_sector - accessed.
+                     FAT_mirror       - filled with FAT data (PC version).
+                     mirror_blocks    - set to the number of sectors read.
+                     mirror_first     - set to the passed sector.
+                     mirror_max       - accessed to limit the sectors read.
+
+   Author:           Tim Liu
+   Last Modified:    June 10, 2016
+
+*/
+
+static  char  load_FAT_mirror(unsigned long int first, int blocks)
+{
+    /* variables */
+    unsigned short int  far *p;         /* where to read FAT sectors to */
+
+    int                 n;              /* sectors to read at a time */
+    int                 blk_cnt;        /* sectors read by get_blocks */
+
+    char                error = FALSE;  /* error reading the FAT */
+
+
+
+    /* the mirror is empty while it is being loaded */
+    mirror_first = first;
+    mirror_blocks = 0;
+
+    /* don't load more than will fit */
+    if (blocks > mirror_max)
+        blocks = mirror_max;
+
+    /* read the FAT sectors a window at a time */
+    while (!error && (mirror_blocks < blocks))  {
+
+        /* get where these sectors go in the mirror */
+#ifdef  PCVERSION
+        p = FAT_mirror + mirror_blocks * IDE_BLOCK_SIZE;
+#else
+        p = (unsigned short int far *) MAKE_FARPTR(FAT_MIRROR_SEG + mirror_blocks *
+                                                   (IDE_BLOCK_SIZE * sizeof(short int) / 16L), 0);
+#endif
+
+        /* read up to a window of sectors */
+        n = ((blocks - mirror_blocks) < FAT_WINDOW_BLOCKS) ? (blocks - mirror_blocks) : FAT_WINDOW_BLOCKS;
+        blk_cnt = get_blocks(first_FAT_sector + first + mirror_blocks, n, p);
+
+        /* update the mirror with the sectors read, checking for errors */
+        mirror_blocks += blk_cnt;
+        error = (blk_cnt < n);
+    }
+
+
+    /* done loading, return the error status */
+    return  error;
+
+}
+
+
+
+
+
+/* local functions to support the directory table */
+
+
+/*
+   build_dir_table
+
+   Description:      This function reads the whole directory described by
+                     dir_info into the directory table in one pass, using
+                     get_next_dir_walk() to get each entry.  Each visible
+                     entry gets a record with its attributes, time, date,
+                     size, and first cluster and its name is saved in
+                     dir_names[].  If the directory has too many entries or
+                     the names don't fit, FALSE is returned and the
+                     directory has to be walked instead.
+
+   Arguments:        None.
+   Return Value:     (char) - TRUE if the whole directory is in the table,
+                     FALSE otherwise.
 
-   Inputs:           Data is read from the disk drive.
-   Outputs:          None.
+   Input:            The directory is read from the hard drive.
+   Output:           None.
 
-   Error Handling:   If there is an error reading the directory, the saved
-                     information is set to reasonable values and TRUE is
+   Error Handling:   If there is an error reading the directory FALSE is
                      returned.
 
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: cur_dir             - accessed and updated to the current
-                                           entry.
-                     cur_info            - set to the FAT information for the
-                                           current directory entry.
-                     dir_info            - accessed to get the starting
-                                           cluster of the current directory.
-                     dir_offset          - accessed and possibly updated to
-                                           the sector offset of the directory
-                                           entries.
-                     dir_sector          - accessed and possibly filled with a
-                                           sector of directory entries.
-                     FAT_cache           - filled with the FAT chain for the
-                                           current directory entry.
-                     filename            - set to the filename of the current
-                                           entry.
-                     first_file_sector   - accessed to compute starting sector
-                                           of an entry.
-                     sectors_per_cluster - accessed to compute starting sector
-                                           of an entry.
-
-   Author:           Glen George
-   Last Modified:    March 24, 2013
+   Shared Variables: cur_attr   - accessed for each entry.
+                     cur_dir    - set to walk the directory.
+                     cur_fdate  - accessed for each entry.
+                     cur_ftime  - accessed for each entry.
+                     cur_info   - accessed for each entry's first cluster.
+                     cur_parent - accessed for each entry.
+                     cur_size   - accessed for each entry.
+                     dir_names  - filled with the entry names.
+                     dir_offset - set to walk the directory.
+                     dir_table  - filled with the entry records.
+                     filename   - accessed for each entry's name.
+                     names_used - set to the characters in dir_names[].
+                     tbl_count  - set to the number of entries.
+
+   Author:           Tim Liu
+   Last Modified:    June 13, 2016
 
 */
 
-char  get_next_dir_entry()
+static  char  build_dir_table()
 {
     /* variables */
-    char  longfilename[MAX_LFN_LEN];    /* long filename of current entry */
-    int   lfn_seq;                      /* sequence number for LFN */
-    int   chksum;                       /* long filename checksum */
+    unsigned long int  old_dir_offset;  /* directory offset before a walk */
+    int                old_cur_dir;     /* directory entry before a walk */
 
-    struct  cache_entry  e;             /* a FAT cache entry */
-    unsigned long int    next;          /* pointer to next FAT cluster */
+    unsigned int       len;             /* length of the entry name */
 
-    unsigned long int  old_dir_offset;  /* previous directory offset */
-    int                old_cur_dir;     /* old file entry in directory */
+    char               error;           /* read error flag */
+    char               done = FALSE;    /* got to the end of the directory */
+    char               full = FALSE;    /* the table is full */
 
-    char  error = FALSE;                /* read error flag */
-    char  done = FALSE;                 /* done reading the directory info */
+    unsigned int       i;               /* general loop index */
 
-    int   i;                            /* general loop indices */
-    int   k;
 
 
+    /* nothing in the table yet */
+    tbl_count = 0;
+    names_used = 0;
 
-    /* reset the filename to setup for this file */
-    longfilename[0] = '\0';
+    /* setup to walk from the "entry" before the first entry */
+    cur_dir = ENTRIES_PER_SECTOR - 1;   /* point at end of previous sector */
+    dir_offset = -1;                    /* will be updated to 0 */
 
-    /* keep track of the old values (in case can't find a next entry */
-    old_dir_offset = dir_offset;
-    old_cur_dir = cur_dir;
+    /* get the first entry */
+    error = get_next_dir_walk();
 
 
-    /* now find the next entry in this directory */
-    while (!error && !done)  {
+    /* add entries until the end of the directory or out of room */
+    while (!error && !done && !full)  {
 
-        /* check if need to read a new sector's worth of entries */
-        if (cur_dir >= (ENTRIES_PER_SECTOR - 1))  {
+        /* get the length of the name */
+        for (len = 0; filename[len] != '\0'; len++);
 
-            /* need to read in a new sector of directory entries */
-            /* update the directory sector number */
-            dir_offset++;
-            /* read a sector of directory entries, watching for an error */
-            error = (get_disk_blocks(&dir_info, dir_offset, 1,
-                               (unsigned short int far *) dir_sector) != 1);
-            /* reset the pointer into the sector of entries */
-            /* set to -1 so will be properly incremented in a couple lines */
-            cur_dir = -1;
-        }
+        /* check if there is room for the entry and its name */
+        if ((tbl_count < DIR_TABLE_ENTRIES) && ((names_used + len) < DIR_NAMES_SIZE))  {
 
+            /* there is room, add the entry */
+            dir_table[tbl_count].name = names_used;
+            dir_table[tbl_count].attr = cur_attr;
+            dir_table[tbl_count].parent = cur_parent;
+            dir_table[tbl_count].time = cur_ftime;
+            dir_table[tbl_count].date = cur_fdate;
+            dir_table[tbl_count].size = cur_size;
+            dir_table[tbl_count].cluster = cur_info.cluster1;
+            tbl_count++;
 
-        /* is this the first entry or the end of the directory */
-        if ((cur_dir == -1) || (FILENAME(dir_sector[cur_dir], 0) != '\0'))
-            /* not end of the directory - update the entry number */
-            cur_dir++;
+            /* and its name (with the <null>) */
+            for (i = 0; i <= len; i++)
+                dir_names[names_used++] = filename[i];
 
 
-        /* try to find the next directory entry */
-        while (!error && !done && (cur_dir < ENTRIES_PER_SECTOR))  {
+            /* get the next entry */
+            old_dir_offset = dir_offset;
+            old_cur_dir = cur_dir;
+            error = get_next_dir_walk();
 
-            /* check if this is a long filename or a normal entry */
-            if (ATTR(dir_sector[cur_dir]) == ATTRIB_LFN)  {
+            /* at the end of the directory the entry doesn't change */
+            done = (dir_offset == old_dir_offset) && (cur_dir == old_cur_dir);
+        }
+        else  {
 
-                /* this is a long filename - collect characters */
-                /* assume ASCII instead of Unicode */
+            /* no room for the entry, have to walk this directory */
+            full = TRUE;
+        }
+    }
 
-                /* get the sequence number for this part of the filename */
-                /* make it zero-based */
-                lfn_seq = (L_SEQ_NUM(dir_sector[cur_dir]) & LFN_SEQ_MASK) - 1;
 
-                /* collect the pieces of the long filename */
-                for (k = 0; k < LFN_CHARS; k++)  {
-                    /* figure out where the LFN characters are */
-                    if (k < LFN1_CHARS)
-                        longfilename[LFN_CHARS * lfn_seq + k] = L_LFN1(dir_sector[cur_dir], 2 * k);
-                    else if (k < (LFN1_CHARS + LFN2_CHARS))
-                        longfilename[LFN_CHARS * lfn_seq + k] = L_LFN2(dir_sector[cur_dir], 2 * (k - LFN1_CHARS));
-                    else
-                        longfilename[LFN_CHARS * lfn_seq + k] = L_LFN3(dir_sector[cur_dir], 2 * (k - LFN1_CHARS - LFN2_CHARS));
-                }
+    /* table is only usable if have the whole directory */
+    return  (done && !error);
 
-                /* check if this is the last entry */
-                if ((L_SEQ_NUM(dir_sector[cur_dir]) & LAST_LFN_ENTRY) != 0)  {
-                    /* last entry so remember the checksum */
-                    chksum = CHECKSUM(dir_sector[cur_dir]);
-                    /* also terminate the filename */
-                    longfilename[LFN_CHARS * (lfn_seq + 1)] = '\0';
-                }
-                
-                /* go to the next directory entry */
-                cur_dir++;
-            }
-            else  {
+}
 
-                /* this is a normal entry */
-                /* first check if this entry really exists */
-                if (FILENAME(dir_sector[cur_dir], 0) == '\xE5')  {
 
-                    /* deleted entry */
-                    /* not a valid file, clear the long filename */
-                    longfilename[0] = '\0';
-                    /* and move to the next entry */
-                    cur_dir++;
-                }
 
-                /* is it the end of directory marker */
-                else if (FILENAME(dir_sector[cur_dir], 0) == '\0')  {
 
-                    /* end of directory marker */
-                    /* not a valid file, clear the filename */
-                    longfilename[0] = '\0';
-                    /* need to restore the old file state (on last file) */
-                    cur_dir = old_cur_dir;
-                    /* check if need to restore the directory sector */
-                    if (dir_offset != old_dir_offset)  {
-                        /* need to restore the old directory sector */
-                        error = (get_disk_blocks(&dir_info, old_dir_offset, 1,
-                                     (unsigned short int far *) dir_sector) != 1);
-                        /* also restore the actual offset */
-                        dir_offset = old_dir_offset;
-                    }
-                    /* restored state, now we're done */
-                    done = TRUE;
-                }
+/*
+   load_table_entry
 
-                /* is it . or .. */
-                else if (FILENAME(dir_sector[cur_dir], 0) == '.')  {
+   Description:      This function makes the passed entry of the directory
+                     table the current file.  The filename, attributes, size,
+                     time, and date are set from the table and the block
+                     information is set up by setup_entry_info().
 
-                    /* is it pointer to this directory or parent directory */
-                    if (FILENAME(dir_sector[cur_dir], 1) == '.')  {
+   Arguments:        n (int) - entry number within the directory table.
+   Return Value:     None.
 
-                        /* pointer to parent directory */
-                        /* so get starting cluster number and parent name */
-                        cur_info.cluster1 = get_dir_tos_sector();
-                        strcpy(filename, get_dir_tos_name());
+   Input:            None.
+   Output:           None.
 
-                        /* also need to fill in the rest of the block info */
-                        /* check whether this is the FAT16 root directory */
-                        if (cur_info.cluster1 == 0)  {
-                            /* FAT16 root directory, handle it specially */
-                            cur_info.sector = root_start_sector;
-                            cur_info.size = root_dir_size;
-                            cur_info.next = CHAIN_END;
-                        }
-                        else  {
-                            /* not FAT16 root, get the directory information */
-                            cur_info.next = get_contig_sectors(cur_info.cluster1, &e);
-                            cur_info.sector = (e.cluster - 2) * sectors_per_cluster + first_file_sector;
-                            cur_info.size = e.size;
-                        }
+   Error Handling:   None.
 
-                        /* always at start of the directory */
-                        cur_info.offset = 0;
-                        /* and never use a cache for directories */
-                        cur_info.cache_idx = -1;
+   Algorithms:       None.
+   Data Structures:  None.
 
-                        /* and we are done */
-                        done = TRUE;
-                    }
-                    else  {
+   Shared Variables: cur_attr   - set from the table.
+                     cur_fdate  - set from the table.
+                     cur_ftime  - set from the table.
+                     cur_info   - set for the entry.
+                     cur_parent - set from the table.
+                     cur_size   - set from the table.
+                     dir_names  - accessed for the entry's name.
+                     dir_table  - accessed for the entry's record.
+                     filename   - set to the entry's name.
 
-                        /* pointer to current directory - skip it */
-                        /* not a valid file, clear the long filename */
-                        longfilename[0] = '\0';
-                        /* and move to the next entry */
-                        cur_dir++;
-                    }
-                }
+   Author:           Tim Liu
+   Last Modified:    June 13, 2016
 
-                /* is it a volume label */
-                else if ((ATTR(dir_sector[cur_dir]) & ATTRIB_VOLUME) != 0)  {
+*/
 
-                    /* it is a volume label, see if already have a directory name */
-                    if (dirname[0] == '\0')  {
+static  void  load_table_entry(int n)
+{
+    /* variables */
+    char  far  *name;           /* the entry's name */
 
-                        /* no directory name currently, use volume label */
-                        /* now check if there is a long filename (shouldn't be) */
-                        /* first compute the checksum for this entry */
-                        /* if checksum OK and there is a filename - keep it */
-                        if (longfilename[0] == '\0')  {
+    int         i;              /* general loop index */
 
-                            /* no long filename, set the directory name from 8.3 name */
-                            /* copy the filename and extension (but no .) */
-                            /* start at first character of filename */
-                            k = 0;
-                            /* copy the full filename */
-                            for (i = 0; (i < DOS_FILENAME_LEN); i++)
-                                dirname[k++] = FILENAME(dir_sector[cur_dir], i);
 
-                            /* now append the extension */
-                            for (i = 0; (i < DOS_EXTENSION_LEN); i++)
-                                dirname[k++] = EXTENSION(dir_sector[cur_dir], i);
 
-                            /* finally, null terminate the string */
-                            dirname[k] = '\0';
-                        }
-                        else  {
+    /* get the entry information from its record */
+    cur_attr = dir_table[n].attr;
+    cur_parent = dir_table[n].parent;
+    cur_ftime = dir_table[n].time;
+    cur_fdate = dir_table[n].date;
+    cur_size = dir_table[n].size;
+    cur_info.cluster1 = dir_table[n].cluster;
 
-                            /* have a long filename - save it as the  directory name */
-                            strcpy(dirname, longfilename);
-                        }
-                    }
-                    else  {
+    /* get the name */
+    name = dir_names + dir_table[n].name;
+    for (i = 0; (filename[i] = name[i]) != '\0'; i++);
 
-                        /* already have a directory name so ignore volume label */
-                        /* means we cursored back up to the directory */
-                        ;
-                    }
+    /* and setup the block information */
+    setup_entry_info();
+
+
+    /* all done, return */
+    return;
+
+}
 
-                    /* in any case, erase any long file name */
-                    longfilename[0] = '\0';
-                    /* and move to the next entry (ignore volume label) */
-                    cur_dir++;
-                }
 
-                /* none of the above, so must actually be a file */
-                else  {
 
-                    /* need to set the file information, FAT cache, and filename */
-                    /* get the starting cluster based on FAT type */
-                    if (fat16)
-                        next = START_CLUSTER(dir_sector[cur_dir]);
-                    else
-                        next = START_CLUSTER32(dir_sector[cur_dir]);
 
-                    /* fill the FAT cache for this file */
-                    for (i = 0;
-                         ((i + 1) < (FAT_CACHE_SIZE / sizeof(struct cache_entry))) && (next != CHAIN_END);
-                         i++)  {
+/*
+   setup_entry_info
 
-                        /* get the contiguous sectors at current position */
-                        next = get_contig_sectors(next, &e);
+   Description:      This function sets up the block information for the
+                     current entry given its first cluster (in cur_info) and
+                     its attributes.  For a directory the block information
+                     is for the start of the directory.  For a file the
+                     extent index is filled and the block information is for
+                     the first extent.
 
-                        /* add this entry to the cache */
-                        FAT_cache[i].cluster = e.cluster;
-                        FAT_cache[i].size = e.size;
-                    }
+   Arguments:        None.
+   Return Value:     None.
 
-                    /* fill in last cache entry with the last next pointer */
-                    /*    but only if there is room in the FAT cache */
-                    if (i < (FAT_CACHE_SIZE / sizeof(struct cache_entry)))  {
-                        FAT_cache[i].cluster = next;
-                        FAT_cache[i].size = 0;
-                    }
+   Input:            None.
+   Output:           None.
 
-                    /* now set up the block information */
-                    /* get the first cluster from the directory information */
-                    if (fat16)
-                        cur_info.cluster1 = START_CLUSTER(dir_sector[cur_dir]);
-                    else
-                        cur_info.cluster1 = START_CLUSTER32(dir_sector[cur_dir]);
-                    /* at start of file */
-                    cur_info.offset = 0;
-
-                    /* get info from first two cache entries if they exist */
-                    if ((FAT_CACHE_SIZE / sizeof(struct cache_entry)) > 1)  {
-
-                        /* the FAT cache exists - get info there */
-                        cur_info.sector = (FAT_cache[0].cluster - 2) * sectors_per_cluster + first_file_sector;
-                        cur_info.size = FAT_cache[0].size;
-                        cur_info.next = FAT_cache[1].cluster;
-                        /* at start of FAT cache */
-                        cur_info.cache_idx = 0;
-                    }
-                    else  {
+   Error Handling:   None.
 
-                        /* no FAT cache, so get information from hard drive */
-                        /* get the contiguous sectors at start of file position */
-                        cur_info.next = get_contig_sectors(cur_info.cluster1, &e);
-                        /* add this information to the file information */
-                        cur_info.sector = (e.cluster - 2) * sectors_per_cluster + first_file_sector;
-                        cur_info.size = e.size;
-                        /* no cache so no index */
-                        cur_info.cache_idx = -1;
-                    }
+   Algorithms:       None.
+   Data Structures:  None.
 
-                    /* now check if there is a long filename */
-                    /* first compute the checksum for this entry */
-                    /* if checksum OK and there is a filename - keep it */
-                    if (longfilename[0] == '\0')  {
+   Shared Variables: cur_attr            - accessed to check for a directory.
+                     cur_info            - updated with the block
+                                           information.
+                     extent_next         - set by build_extent_index().
+                     extents             - filled by build_extent_index().
+                     first_file_sector   - accessed to compute starting sector
+                                           of a directory.
+                     num_extents         - set by build_extent_index().
+                     root_dir_size       - accessed for the FAT16 root
+                                           directory.
+                     root_start_sector   - accessed for the FAT16 root
+                                           directory.
+                     sectors_per_cluster - accessed to compute starting sector
+                                           of a directory.
 
-                        /* no long filename, set the filename from 8.3 name */
-                        /* copy the filename and extension */
-                        /* start at first character of filename */
-                        k = 0;
-                        /* copy the filename without the trailing spaces */
-                        for (i = 0; ((i < DOS_FILENAME_LEN) && (FILENAME(dir_sector[cur_dir], i) != ' ')); i++)
-                            filename[k++] = FILENAME(dir_sector[cur_dir], i);
+   Author:           Tim Liu
+   Last Modified:    June 13, 2016
 
-                        /* add the '.' separating name and extension */
-                        filename[k++] = '.';
+*/
 
-                        /* now add the extension, skipping trailing spaces */
-                        for (i = 0; ((i < DOS_EXTENSION_LEN) && (EXTENSION(dir_sector[cur_dir], i) != ' ')); i++)
-                            filename[k++] = EXTENSION(dir_sector[cur_dir], i);
+static  void  setup_entry_info()
+{
+    /* variables */
+    struct  cache_entry  e;             /* information on clusters */
 
-                        /* finally, null terminate the string */
-                        filename[k] = '\0';
-                    }
-                    else  {
 
-                        /* have a long filename - save it as the filename */
-                        strcpy(filename, longfilename);
-                    }
 
-                    /* got to the next entry so set the done flag */
-                    done = TRUE;
-                }
-            }
+    /* setup a directory or a file */
+    if ((cur_attr & ATTRIB_DIR) != 0)  {
+
+        /* a directory, check whether this is the FAT16 root directory */
+        if (cur_info.cluster1 == 0)  {
+            /* FAT16 root directory, handle it specially */
+            cur_info.sector = root_start_sector;
+            cur_info.size = root_dir_size;
+            cur_info.next = CHAIN_END;
+        }
+        else  {
+            /* not FAT16 root, get the directory information */
+            cur_info.next = get_contig_sectors(cur_info.cluster1, &e);
+            cur_info.sector = (e.cluster - 2) * sectors_per_cluster + first_file_sector;
+            cur_info.size = e.size;
         }
+
+        /* always at start of the directory */
+        cur_info.offset = 0;
+        /* and never use an extent index for directories */
+        cur_info.extent_idx = -1;
     }
+    else  {
 
+        /* a file, fill the extent index for it */
+        build_extent_index(cur_info.cluster1);
 
-    /* check if there was an error */
-    if (error)  {
-        /* had an error - clear out the data */
-        /* clear the filename */
-        filename[0] = '\0';
-        /* set the file info to the first sector */
-        cur_info.sector    = first_file_sector;
-        cur_info.size      = sectors_per_cluster;
-        cur_info.next      = CHAIN_END;
-        cur_info.offset    = 0;
-        cur_info.cluster1  = 2;
-        cur_info.cache_idx = -1;
+        /* now set up the block information from the first extent */
+        cur_info.offset = extents[0].offset;
+        cur_info.sector = extents[0].sector;
+        cur_info.size = extents[0].size;
+        cur_info.next = extent_next;
+        /* at start of extent index */
+        cur_info.extent_idx = 0;
     }
 
 
-    /* finally done, return with the error status */
-    return  error;
+    /* all done, return */
+    return;
 
 }
 
 
 
 
+/* local functions to support the library index file */
+
+
 /*
-   get_previous_dir_entry
+   find_index_file
 
-   Description:      This function gets the previous valid directory entry in
-                     the directory.  As necessary it reads sectors of 
-                     directory entries from the hard drive.  The function
-                     backs up through the directory to the first standard
-                     directory entry prior the current one and then back
-                     before any long filename for that entry.  The long
-                     filename of the previous directory entry is also read and
-                     the filename variable is set to this long filename if it
-                     exists or the 8.3 filename if there is no long filename.
-                     The current sector number and directory entry number are
-                     also updated.  If there is an error reading the directory
-                     entry the filename is set to the empty string, the
-                     starting sector number is set to 0, the directory
-                     information is properly initialized, and TRUE is
-                     returned.
+   Description:      This function looks for the library index file
+                     (\JUKEBOX.IDX) in the root directory and checks its
+                     header.  If the file is found and has the expected
+                     identifier and version the index is marked usable and
+                     the positions of its records are saved.  The current
+                     file must be the root directory.
 
    Arguments:        None.
-   Return Value:     (char) - TRUE if there is an error reading the directory
-                     information, FALSE otherwise.
+   Return Value:     None.
 
-   Inputs:           Data is read from the disk drive.
-   Outputs:          None.
+   Input:            The root directory and index header are read from the
+                     hard drive.
+   Output:           None.
 
-   Error Handling:   If there is an error reading the directory, the saved
-                     information is set to reasonable values and TRUE is
-                     returned.
+   Error Handling:   If the file is not found, can't be read, or has a bad
+                     header the index is not used.
 
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: cur_dir       - accessed and updated to the current
-                                     entry.
-                     cur_info      - set to the block information for the
-                                     current entry.
-                     dir_offset    - accessed and possibly updated to the
-                                     sector offset of the directory entries.
-                     dir_sector    - accessed and possibly filled with a
-                                     sector of directory entries.
-                     filename      - set to the filename of the current entry.
-
-   Author:           Glen George
-   Last Modified:    April 3, 2013
+   Shared Variables: cur_info          - accessed for the root directory.
+                     dir_sector        - filled with root directory sectors.
+                     fat16             - accessed to get the start cluster.
+                     idx_buf           - filled with the index header.
+                     idx_dir_sector    - set from the index header.
+                     idx_entry_sector  - set from the index header.
+                     idx_ext_sector    - set to EMPTY_SECTOR.
+                     idx_extent_sector - set from the index header.
+                     idx_info          - set for the index file.
+                     idx_num_dirs      - set from the index header.
+                     idx_toc_sector    - set from the index header.
+                     idx_valid         - set if the index can be used.
+
+   Author:           Tim Liu
+   Last Modified:    June 12, 2016
 
 */
 
-char  get_previous_dir_entry()
+static  void  find_index_file()
 {
     /* variables */
-    unsigned long int  new_offset;      /* new directory sector offset */
-    int                new_entry;       /* new directory entry */
+    struct  block_info  root;           /* root directory information */
 
-    char  error = FALSE;        /* read error flag */
-    char  done = FALSE;         /* done getting the previous directory info */
-    char  have_entry = FALSE;   /* have the entry (but maybe not the filename) */
+    unsigned long int   size;           /* sectors in the root directory */
+    unsigned long int   s = 0;          /* sector of the root directory */
+    int                 e;              /* entry within the sector */
 
+    char                found = FALSE;  /* found the index file */
+    char                done = FALSE;   /* done looking */
 
+    int                 i;              /* general loop index */
 
-    /* find the previous entry in this directory */
-    /* loop until find the entry or get an error */
-    while (!error && !done)  {
 
-        /* check if need to read a new sector's worth of entries */
-        if (cur_dir == 0)  {
 
-            /* need to read in the previous sector of directory entries */
-            /* check if out of directory entries */
-            if (dir_offset == 0)  {
-                /* out of directory entries - reset to the start */
-                new_offset = 0;
-                new_entry = 0;
-                /* and done */
-                done = TRUE;
-            }
-            else  {
-                /* have a previous directory entry to check, read the */
-                /*    sector of directory entries, watching for an error */
-                error = (get_disk_blocks(&dir_info, --dir_offset, 1,
-                                 (unsigned short int far *) dir_sector) != 1);
-                /* and reset to the last file entry in the directory */
-                cur_dir = ENTRIES_PER_SECTOR - 1;
-            }
-        }
-        else  {
+    /* index isn't usable until it's found and checked */
+    idx_valid = FALSE;
 
-            /* still more files in this directory, just check the previous entry */
-            cur_dir--;
-        }
+    /* search a copy of the root information so cur_info isn't changed */
+    root = cur_info;
+    size = get_dir_size(root.cluster1);
 
+    /* look through the root directory for the index file */
+    while (!found && !done && (s < size))  {
 
-        /* if not an error or done, keep processing */
-        if (!done && !error)  {
+        /* read the next root directory sector, stop on an error */
+        done = (get_disk_blocks(&root, s++, 1, (unsigned short int far *) dir_sector) != 1);
 
-            /* check if have already found a previous entry */
-            if (have_entry)  {
+        /* check the entries in the sector */
+        for (e = 0; !found && !done && (e < ENTRIES_PER_SECTOR); e++)  {
 
-                /* already found a previous entry, but need to skip its */
-                /* potentional long filename too */
-                if (ATTR(dir_sector[cur_dir]) != ATTRIB_LFN)  {
-                    /* not a long filename, must be done */
-                    done = TRUE;
-                }
-                else  {
-                    /* still part of a long filename for the entry */
-                    /* so remember that this is potentially where new entry will start */
-                    new_offset = dir_offset;
-                    new_entry = cur_dir;
+            /* check for the end of the directory */
+            if (FILENAME(dir_sector[e], 0) == '\0')  {
+                /* end of directory - index isn't there */
+                done = TRUE;
+            }
+            /* ignore directories, volume labels, and long filenames */
+            else if ((ATTR(dir_sector[e]) & (ATTRIB_DIR | ATTRIB_VOLUME)) == 0)  {
+
+                /* it's a file, see if it's the index */
+                found = TRUE;
+                for (i = 0; i < DOS_FILENAME_LEN; i++)
+                    found = found && (FILENAME(dir_sector[e], i) == IDX_FILENAME[i]);
+                for (i = 0; i < DOS_EXTENSION_LEN; i++)
+                    found = found && (EXTENSION(dir_sector[e], i) == IDX_EXTENSION[i]);
+
+                /* if found, setup the file information for the index */
+                if (found)  {
+                    if (fat16)
+                        idx_info.cluster1 = START_CLUSTER(dir_sector[e]);
+                    else
+                        idx_info.cluster1 = START_CLUSTER32(dir_sector[e]);
+                    /* point to end of file so will reset to beginning */
+                    idx_info.offset = 0xFFFFFFFF;
+                    idx_info.size = 0;
+                    idx_info.extent_idx = -1;
                 }
             }
             else  {
 
-                /* have not found a previous entry yet, is this one */
-                /* ignore empty entries, deleted entries, long filenames, */
-                /*    volume labels, and '.' directory */
-                if ((FILENAME(dir_sector[cur_dir], 0) != '\0')  &&
-                     (FILENAME(dir_sector[cur_dir], 0) != '\xE5')  &&
-                     (ATTR(dir_sector[cur_dir]) != ATTRIB_LFN) &&
-                     (ATTR(dir_sector[cur_dir]) != ATTRIB_VOLUME) &&
-                     ((FILENAME(dir_sector[cur_dir], 0) != '.')  ||
-                      (FILENAME(dir_sector[cur_dir], 1) == '.')))  {
-
-                    /* have the previous directory entry, remember that */
-                    have_entry = TRUE;
-                    /* and keep track of where the entry starts */
-                    new_offset = dir_offset;
-                    new_entry = cur_dir;
-                }
-                else  {
-
-                    /* not a previous entry, ignore it and keep looking */
-                    ;
-                }
+                /* not a file, keep looking */
+                ;
             }
         }
     }
 
-    /* if no error, update to the new sector, offset, and directory entry */
-    if (!error)  {
 
-        /* first read in the new sector if had moved past it */
-        if (new_offset != dir_offset)
-            error = (get_disk_blocks(&dir_info, new_offset, 1,
-                                 (unsigned short int far *) dir_sector) != 1);
-        /* now update the sector offset and directory entry */
-        dir_offset = new_offset;
-        cur_dir = new_entry - 1;    /* get_next_dir_entry() will inc this */
-    }
+    /* if found the index, read and check its header */
+    if (found)  {
 
+        /* nothing in the index buffers yet */
+        idx_buf_sector = EMPTY_SECTOR;
+        idx_ext_sector = EMPTY_SECTOR;
 
-    /* if finished without an error then get the actual previous filename */
-    if (done & !error)  {
+        /* check the header identifier and version */
+        idx_valid = !read_index_sector(0, idx_buf, &idx_buf_sector) &&
+                    (IDX_WORD(idx_buf, IDX_HDR_MAGIC) == IDX_MAGIC_LO) &&
+                    (IDX_WORD(idx_buf, IDX_HDR_MAGIC + 1) == IDX_MAGIC_HI) &&
+                    (IDX_WORD(idx_buf, IDX_HDR_VERSION) == IDX_VERSION);
 
-        /* get the entry watching for errors */
-        /* since we've backed up past the previous entry, this will now */
-        /*    find the previous entry */
-        error = get_next_dir_entry();
+        /* get the record positions */
+        idx_num_dirs = IDX_LONG(idx_buf, IDX_HDR_NUM_DIRS);
+        idx_dir_sector = IDX_LONG(idx_buf, IDX_HDR_DIR_SECTOR);
+        idx_entry_sector = IDX_LONG(idx_buf, IDX_HDR_ENTRY_SECTOR);
+        idx_extent_sector = IDX_LONG(idx_buf, IDX_HDR_EXTENT_SECTOR);
+        idx_toc_sector = IDX_LONG(idx_buf, IDX_HDR_TOC_SECTOR);
     }
 
 
-    /* check if there was an error */
-    /*    note that this is redundant if error is from get_next_dir_entry() */
-    /*    but it's needed if error is from get_disk_blocks() */
-    if (error)  {
-        /* had an error - clear out the data */
-        /* clear the filename */
-        filename[0] = '\0';
-        /* set the file info to the first sector */
-        cur_info.sector    = first_file_sector;
-        cur_info.size      = sectors_per_cluster;
-        cur_info.next      = CHAIN_END;
-        cur_info.offset    = 0;
-        cur_info.cluster1  = 2;
-        cur_info.cache_idx = 0;
-    }
+    /* all done, return */
+    return;
 
+}
 
-    /* finally done, return with the error status */
-    return  error;
 
-}
 
 
+/*
+   read_index_sector
+
+   Description:      This function reads the passed sector of the library
+                     index file into the passed buffer (idx_buf[] or
+                     idx_ext_buf[]).  If the sector is already in the buffer
+                     it is not read again.
+
+   Arguments:        sector (unsigned long int) - sector of the index file to
+                                                  read.
+                     buf (unsigned short int *) - buffer to read it into.
+                     buf_sector (unsigned long int *) - the sector in the
+                                                  buffer, updated to the one
+                                                  read.
+   Return Value:     (char) - TRUE if there was an error reading the sector,
+                     FALSE otherwise.
+
+   Input:            The sector may be read from the hard drive.
+   Output:           None.
 
+   Error Handling:   On an error the buffer is marked empty and TRUE is
+                     returned.
 
-/* local functions to support FAT16/FAT32 fragmented files */
+   Algorithms:       None.
+   Data Structures:  None.
 
+   Shared Variables: idx_info - used and updated to find the sector.
 
-/*
-   get_disk_blocks
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
 
-   Description:      This function reads blocks from the file whose
-                     information block is passed as the first argument.  The
-                     data "read" is written to the memory pointed to by the
-                     fourth argument.  The number of blocks requested is given
-                     as the third argument.  The starting block number in the
-                     file to read is passed as the second argument.  The
-                     number of sectors (blocks) actually read is returned.
+*/
+
+static  char  read_index_sector(unsigned long int sector, unsigned short int *buf,
+                                unsigned long int *buf_sector)
+{
+    /* variables */
+    char  error = FALSE;        /* error reading the sector */
+
+
+
+    /* only read the sector if it isn't already in the buffer */
+    if (sector != *buf_sector)  {
+
+        /* read the sector, remembering which one is in the buffer */
+        error = (get_disk_blocks(&idx_info, sector, 1, (unsigned short int far *) buf) != 1);
+        if (error)
+            *buf_sector = EMPTY_SECTOR;
+        else
+            *buf_sector = sector;
+    }
+
+
+    /* return the error status */
+    return  error;
+
+}
 
-   Arguments:        info (struct block_info *)      - block information to be
-                                                       used and possibly
-                                                       updated by this
-                                                       function to get file
-                                                       data.
-                     block (unsigned long int)       - sector number (relative
-                                                       to the start of the
-                                                       file) at which to start
-                                                       reading.
-                     length (int)                    - number of blocks to be
-                                                       read.
-                     dest (unsigned short int far *) - pointer to the memory
-                                                       where the read data is
-                                                       to be written.
-   Return Value:     The number of blocks actually read.
 
-   Input:            None.
+
+
+/*
+   find_dir_index
+
+   Description:      This function looks for the current directory in the
+                     library index.  The directory is only used if the index
+                     record still matches the size of the directory and the
+                     time and date of its entry, so an index made before the
+                     directory changed is ignored.
+
+   Arguments:        None.
+   Return Value:     (char) - TRUE if the directory is in the index and can
+                     be used, FALSE otherwise.
+
+   Input:            Directory records are read from the index file.
    Output:           None.
 
-   Error Handling:   None.
+   Error Handling:   If the index can't be read FALSE is returned.
 
-   Algorithms:       None.
+   Algorithms:       Binary search of the directory records (they are sorted
+                     by starting cluster).
    Data Structures:  None.
 
-   Shared Variables: None.
+   Shared Variables: dir_info       - accessed for the directory's cluster.
+                     dir_stamp      - accessed for the directory's time and
+                                      date.
+                     idx_buf        - accessed for the directory records.
+                     idx_count      - set to the number of entries.
+                     idx_dir_sector - accessed to find the records.
+                     idx_first      - set to the first entry record.
+                     idx_num_dirs   - accessed for the number of records.
 
-   Author:           Glen George
-   Last Modified:    March 17, 2013
+   Author:           Tim Liu
+   Last Modified:    June 12, 2016
 
 */
 
-int  get_disk_blocks(struct block_info *info, unsigned long int block,
-                     int length, unsigned short int far *dest)
+static  char  find_dir_index()
 {
     /* variables */
-    int   sectors_read = 0;     /* total number of sectors actually read */
+    unsigned long int  c;               /* cluster of a directory record */
+    unsigned long int  size;            /* size of the directory record */
+    unsigned long int  stamp;           /* time and date of the record */
 
-    int   xfer_cnt;             /* number of blocks to try to read */
-    int   blk_cnt;              /* number of blocks read by get_blocks */
+    long int           lo;              /* binary search range */
+    long int           hi;
+    long int           mid;
 
-    char  error = FALSE;        /* error reading the disk */
+    int                w = 0;           /* word offset of the record */
 
+    char               found = FALSE;   /* found the directory record */
+    char               error = FALSE;   /* error reading the index */
 
 
-    /* read contiguous groups of blocks until error or all are read */
-    while (!error && (sectors_read < length))  {
 
-        /* see if can get sectors from current file block */
-        if ((block < info->offset) || (block >= (info->offset + info->size)))
-            /* the sector isn't in current block, get new block */
-            get_block_info(info, block);
+    /* binary search the directory records for the directory's cluster */
+    lo = 0;
+    hi = (long int) idx_num_dirs - 1;
+    while (!error && !found && (lo <= hi))  {
+
+        /* read the middle record */
+        mid = (lo + hi) / 2;
+        error = read_index_sector(idx_dir_sector + mid / IDX_DIRS_PER_SECTOR,
+                                  idx_buf, &idx_buf_sector);
+        w = (int) (mid % IDX_DIRS_PER_SECTOR) * IDX_DIR_WORDS;
+        c = IDX_LONG(idx_buf, w + IDX_DIR_CLUSTER);
 
-        /* should now be able to find/read the desired sectors */
-        /* see how many sectors are contiguous */
-        if ((info->offset + info->size - block) >= (length - sectors_read))
-            /* all the sectors we need are contiguous in this block */
-            xfer_cnt = length - sectors_read;
+        /* check which half the directory is in */
+        if (c == dir_info.cluster1)
+            found = TRUE;
+        else if (c < dir_info.cluster1)
+            lo = mid + 1;
         else
-            /* can only get contiguous sectors up to the end of the block */
-            xfer_cnt = info->offset + info->size - block;
+            hi = mid - 1;
+    }
 
-        /* now call the get_blocks function to actually read sectors */
-        blk_cnt = get_blocks(info->sector + block - info->offset, xfer_cnt, dest);
 
-        /* update the state of the transfer */
-        block += blk_cnt;                   /* update next block to be read */
-        sectors_read += blk_cnt;            /* update total sectors read */
-        dest += blk_cnt * IDE_BLOCK_SIZE;   /* update buffer position */
+    /* if found it, make sure the directory hasn't changed */
+    if (found && !error)  {
 
-        /* check for an error */
-        if (blk_cnt < xfer_cnt)
-            /* couldn't read all the sectors so an error must have occurred */
-            error = TRUE;
+        /* get the record information */
+        size = IDX_LONG(idx_buf, w + IDX_DIR_SIZE);
+        stamp = ((unsigned long int) IDX_WORD(idx_buf, w + IDX_DIR_DATE) << 16) |
+                IDX_WORD(idx_buf, w + IDX_DIR_TIME);
+        idx_first = IDX_LONG(idx_buf, w + IDX_DIR_FIRST);
+        idx_count = IDX_WORD(idx_buf, w + IDX_DIR_COUNT);
+
+        /* check it against the directory (and that it has entries) */
+        found = (stamp == dir_stamp) && (idx_count > 0) &&
+                (size == get_dir_size(dir_info.cluster1));
     }
 
 
-    /* return the number of sectors actually read */
-    return  sectors_read;
+    /* return whether the directory can be used */
+    return  (found && !error);
 
 }
 
@@ -1610,281 +4568,318 @@ int  get_disk_blocks(struct block_info *info, unsigned long int block,
 
 
 /*
-   get_block_info
+   move_index_entry
 
-   Description:      This function fills in the passed block information
-                     structure with information from the FAT on the hard
-                     drive.  The passed sector within the file along with the
-                     current value of the block information are used to figure
-                     out which block to load the structure with.  The cluster1
-                     element of the structure is not changed.
+   Description:      This function moves the passed number of entries
+                     through the current directory's library index entries
+                     and makes that entry the current file.  The move stops
+                     at the first and last entries of the directory.
 
-   Arguments:        info (struct block_info *) - block information to be used
-                                                  and updated by this
-                                                  function.
-                     sector (unsigned long int) - sector number within a file
-                                                  for which the block
-                                                  information is to be found.
-   Return Value:     None.
+   Arguments:        delta (int) - number of entries to move (negative to
+                                   move backward).
+   Return Value:     (char) - TRUE if there is an error reading the index,
+                     FALSE otherwise.
 
-   Input:            None.
+   Input:            The index entry is read from the hard drive.
    Output:           None.
 
-   Error Handling:   None.
+   Error Handling:   If there is an error reading the index, the saved
+                     information is set to reasonable values and TRUE is
+                     returned.
 
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: FAT_cache - accessed to get block information.
+   Shared Variables: cur_attr  - cleared on an error.
+                     cur_info  - set to reasonable values on an error.
+                     cur_parent - cleared on an error.
+                     cur_size  - cleared on an error.
+                     filename  - cleared on an error.
+                     idx_count - accessed to limit the move.
+                     idx_cur   - updated to the new entry.
 
-   Author:           Glen George
-   Last Modified:    March 17, 2013
+   Author:           Tim Liu
+   Last Modified:    June 12, 2016
 
 */
 
-static  void  get_block_info(struct block_info *info, unsigned long int sector)
+static  char  move_index_entry(int delta)
 {
     /* variables */
-    struct  cache_entry  e;                     /* information on clusters */
+    int   n;                    /* the new entry */
 
-    char                 have_block = FALSE;    /* have the requested block */
+    char  error;                /* error reading the index */
 
 
 
-    /* if don't have the block yet, check if the sector is in a later cache entry */
-    while (!have_block && (info->cache_idx != -1) &&
-           ((info->cache_idx + 1) < (FAT_CACHE_SIZE / sizeof(struct cache_entry))) &&
-           (info->next != CHAIN_END) &&
-           (sector >= (info->offset + info->size)))  {
+    /* find the new entry, staying inside the directory */
+    n = idx_cur + delta;
+    if (n < 0)
+        n = 0;
+    if (n >= idx_count)
+        n = idx_count - 1;
 
-        /* move to the next FAT cache entry (they are in file order) */
-        info->offset += info->size;
-        info->cache_idx++;
-        info->sector = (FAT_cache[info->cache_idx].cluster - 2) * sectors_per_cluster +
-                       first_file_sector;
-        info->size = FAT_cache[info->cache_idx].size;
-        info->next = FAT_cache[info->cache_idx + 1].cluster;
+    /* and make it the current file */
+    error = load_index_entry(n);
+
+
+    /* check if there was an error */
+    if (!error)  {
+        /* no error - now at the new entry */
+        idx_cur = n;
+    }
+    else  {
+        /* had an error - clear out the data */
+        /* clear the filename */
+        filename[0] = '\0';
+        /* set the file info to the first sector */
+        cur_info.sector     = first_file_sector;
+        cur_info.size       = sectors_per_cluster;
+        cur_info.next       = CHAIN_END;
+        cur_info.offset     = 0;
+        cur_info.cluster1   = 2;
+        cur_info.extent_idx = -1;
+        /* and there is no entry information */
+        cur_attr = 0;
+        cur_size = 0;
+        cur_parent = FALSE;
     }
 
-    /* check if have the sector now */
-    if ((sector >= info->offset) && (sector < (info->offset + info->size)))
-        /* have the sector in this new block */
-        have_block = TRUE;
 
+    /* done, return with the error status */
+    return  error;
 
-    /* if don't have the block yet, check if the sector is in an earlier cache entry */
-    while (!have_block && (info->cache_idx > 0) &&
-           (info->next != CHAIN_END) && (sector < info->offset))  {
+}
 
-        /* move to the previous FAT cache entry (they are in file order) */
-        info->cache_idx--;
-        info->offset -= FAT_cache[info->cache_idx].size;
-        info->sector = (FAT_cache[info->cache_idx].cluster - 2) * sectors_per_cluster +
-                       first_file_sector;
-        info->size = FAT_cache[info->cache_idx].size;
-        info->next = FAT_cache[info->cache_idx + 1].cluster;
-    }
 
-    /* check if have the sector now */
-    if ((sector >= info->offset) && (sector < (info->offset + info->size)))
-        /* have the sector in this new block */
-        have_block = TRUE;
 
 
-    /* if still don't have the sector will need to search the FAT on the */
-    /*    hard drive for it - either start at beginning or next cluster */
-    if (!have_block)  {
+/*
+   load_index_entry
+
+   Description:      This function makes the passed library index entry of
+                     the current directory the current file.  The filename,
+                     attributes, size, time, and date are set from the entry
+                     as are the tag title, artist, and time and the probe
+                     results.  For files the extent index is filled from
+                     the entry's extent records (read into idx_ext_buf[] so
+                     the sector of entry records stays in idx_buf[])
+                     and for directories the block information is set up by
+                     setup_entry_info().
+
+   Arguments:        n (int) - entry number within the current directory.
+   Return Value:     (char) - TRUE if there is an error reading the index,
+                     FALSE otherwise.
+
+   Input:            The entry and extent records are read from the hard
+                     drive.
+   Output:           None.
 
-        /* still don't have it, check where to start searching */
-        if (sector < info->offset)  {
-            /* moving backward in file, have to start at beginning */
-            info->next = info->cluster1;
-            /* reset block information to zero sized block at beginning of file */
-            info->size = 0;
-            info->offset = 0;
-        }
-    }
+   Error Handling:   TRUE is returned if the index can't be read.
 
-    /* now search through the hard drive FAT for the sector */
-    while (!have_block && (info->next != CHAIN_END) &&
-           (sector >= (info->offset + info->size)))  {
+   Algorithms:       None.
+   Data Structures:  None.
 
-        /* get information on the contiguous sectors starting at current cluster */
-        info->next = get_contig_sectors(info->next, &e);
+   Shared Variables: cur_attr          - set from the entry.
+                     cur_fdate         - set from the entry.
+                     cur_ftime         - set from the entry.
+                     cur_info          - set for the entry.
+                     cur_parent        - set if the entry is "..".
+                     cur_size          - set from the entry.
+                     extent_next       - set to CHAIN_END.
+                     extents           - filled for a file.
+                     first_file_sector - accessed to convert the extents.
+                     filename          - set to the entry's name.
+                     idx_artist        - set from the entry.
+                     idx_bit_rate      - set from the entry.
+                     idx_buf           - accessed for the entry record.
+                     idx_entry_sector  - accessed to find the entry.
+                     idx_ext_buf       - accessed for the extent records.
+                     idx_extent_sector - accessed to find the extents.
+                     idx_first         - accessed to find the entry.
+                     idx_flags         - set from the entry.
+                     idx_frames        - set from the entry.
+                     idx_probe_time    - set from the entry.
+                     idx_start         - set from the entry.
+                     idx_tag_time      - set from the entry.
+                     idx_title         - set from the entry.
+                     idx_toc           - set from the entry.
+                     num_extents       - set to the number of extents.
+                     sectors_per_cluster - accessed to convert the extents.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
 
-        /* now fill in the block information based on this */
-        /* watch for special case of FAT16 root directory */
-        if (info->cluster1 == 0)
-            /* FAT16 root use FAT16 starting sector, not returned cluster */
-            info->sector = root_start_sector;
-        else
-            /* not FAT16 root, use returned cluster to get sector */
-            info->sector = (e.cluster - 2) * sectors_per_cluster + first_file_sector;
+*/
 
-        /* get the rest of the information */
-        info->offset += info->size;
-        info->size = e.size;
+static  char  load_index_entry(int n)
+{
+    /* variables */
+    unsigned long int    rec;           /* entry or extent record number */
+    int                  w;             /* word offset of the record */
 
-        /* getting information directly from hard drive so no cache index */
-        info->cache_idx = -1;
-    }
+    unsigned long int    ext;           /* first extent record of the file */
+    int                  cnt;           /* number of extent records */
+    unsigned long int    offset = 0;    /* file offset of the next extent */
 
+    char                 error;         /* error reading the index */
 
-    /* we've looked everywhere at this point so we'd better have the sector */
-    /* no way to report errors if we don't, so just return now */
-    return;
+    int                  i;             /* general loop index */
 
-}
 
 
+    /* read the entry record */
+    rec = idx_first + n;
+    error = read_index_sector(idx_entry_sector + rec / IDX_ENTRIES_PER_SECTOR,
+                              idx_buf, &idx_buf_sector);
+    w = (int) (rec % IDX_ENTRIES_PER_SECTOR) * IDX_ENTRY_WORDS;
 
 
-/*
-   get_contig_sectors
+    /* if read the entry, get its information */
+    if (!error)  {
 
-   Description:      This function reads the FAT information on the hard drive
-                     to fill in the passed structure with information for the
-                     passed cluster.  The returned information gives the
-                     number of contiguous sectors starting at the passed
-                     cluster number.  The cluster number of the first
-                     non-contiguous cluster is returned.
+        /* get the directory entry information */
+        cur_attr = IDX_WORD(idx_buf, w + IDX_ENT_ATTR) & 0xFF;
+        cur_ftime = IDX_WORD(idx_buf, w + IDX_ENT_TIME);
+        cur_fdate = IDX_WORD(idx_buf, w + IDX_ENT_DATE);
+        cur_size = IDX_LONG(idx_buf, w + IDX_ENT_SIZE);
+        cur_info.cluster1 = IDX_LONG(idx_buf, w + IDX_ENT_CLUSTER);
+
+        /* get the name (the index always <null> terminates it) */
+        for (i = 0; (i < (IDX_NAME_LEN - 1)) &&
+                    ((filename[i] = IDX_BYTE(idx_buf, w + IDX_ENT_NAME, i)) != '\0'); i++);
+        filename[i] = '\0';
+
+        /* get the tag information */
+        idx_flags = IDX_WORD(idx_buf, w + IDX_ENT_FLAGS);
+        idx_tag_time = IDX_LONG(idx_buf, w + IDX_ENT_TAG_TIME);
+        for (i = 0; i < ID3_TAG_TITLE_SIZE; i++)
+            idx_title[i] = IDX_BYTE(idx_buf, w + IDX_ENT_TITLE, i);
+        for (i = 0; i < ID3_TAG_ARTIST_SIZE; i++)
+            idx_artist[i] = IDX_BYTE(idx_buf, w + IDX_ENT_ARTIST, i);
+
+        /* and the probe results */
+        idx_start = IDX_LONG(idx_buf, w + IDX_ENT_START);
+        idx_frames = IDX_LONG(idx_buf, w + IDX_ENT_FRAMES);
+        idx_bit_rate = IDX_WORD(idx_buf, w + IDX_ENT_BIT_RATE);
+        idx_probe_time = IDX_WORD(idx_buf, w + IDX_ENT_PROBE_TIME);
+        idx_toc = IDX_LONG(idx_buf, w + IDX_ENT_TOC);
+
+        /* and where the extents are */
+        ext = IDX_LONG(idx_buf, w + IDX_ENT_EXTENT);
+        cnt = IDX_WORD(idx_buf, w + IDX_ENT_NUM_EXTENTS);
+
+        /* check if ".." */
+        cur_parent = ((cur_attr & ATTRIB_DIR) != 0) && (filename[0] == '.');
+
+
+        /* the parent directory comes from the stack */
+        if (cur_parent)  {
+            cur_info.cluster1 = get_dir_tos_sector();
+            strcpy(filename, get_dir_tos_name());
+        }
 
-   Operation:        The function first checks for the special cases of
-                     cluster 0 (FAT16 root directory) and END_CHAIN (returns
-                     a zero length entry).  If it is neither special case the
-                     first FAT on the hard drive is read for the passed
-                     cluster number and the information for that entry is
-                     entered in the structure.  The function continues reading
-                     the FAT as long as the clusters are contiguous, updating
-                     the size of the contiguous block as it goes.
 
-   Arguments:        cluster (unsigned long int)  - starting cluster number 
-                                                    at which the number of
-                                                    contiguous sectors is to
-                                                    be found.
-                     entry (struct cache_entry *) - cache entry (general FAT)
-                                                    information to be filled
-                                                    in by this function.
-   Return Value:     (unsigned long int) - cluster number of the first
-                     non-contiguous cluster following the passed cluster
-                     number, CHAIN_END if the end of the file is reached
-                     before a non-contiguous cluster is found.
+        /* now setup the block information */
+        if ((cur_attr & ATTRIB_DIR) != 0)  {
 
-   Input:            None.
-   Output:           None.
+            /* a directory - nothing in the index to help */
+            setup_entry_info();
+        }
+        else  {
 
-   Error Handling:   None.
+            /* a file - get its extents */
+            if ((cnt > 0) && (cnt <= MAX_EXTENTS))  {
 
-   Algorithms:       None.
-   Data Structures:  None.
+                /* fill the extent index from the extent records */
+                for (num_extents = 0; !error && (num_extents < cnt); num_extents++)  {
 
-   Shared Variables: clusters_per_sector - accessed.
-                     fat16               - accessed to determine FAT type.
-                     first_FAT_sector    - accessed.
-                     first_file_sector   - accessed.
-                     root_dir_size       - accessed if cluster is FAT16 root.
-                     root_start_sector   - accessed if cluster is FAT16 root.
-                     sectors_per_cluster - accessed.
+                    /* read the extent record */
+                    rec = ext + num_extents;
+                    error = read_index_sector(idx_extent_sector + rec / IDX_EXTENTS_PER_SECTOR,
+                                              idx_ext_buf, &idx_ext_sector);
+                    w = (int) (rec % IDX_EXTENTS_PER_SECTOR) * IDX_EXTENT_WORDS;
 
-   Author:           Glen George
-   Last Modified:    March 17, 2013
+                    /* and convert it from clusters to sectors */
+                    extents[num_extents].offset = offset;
+                    extents[num_extents].sector = (IDX_LONG(idx_ext_buf, w + IDX_EXT_CLUSTER) - 2) *
+                                                  sectors_per_cluster + first_file_sector;
+                    extents[num_extents].size = IDX_LONG(idx_ext_buf, w + IDX_EXT_COUNT) * sectors_per_cluster;
+                    offset += extents[num_extents].size;
+                }
 
-*/
+                /* whole file is in the index */
+                extent_next = CHAIN_END;
 
-static  unsigned long int  get_contig_sectors(unsigned long int cluster,
-                                              struct cache_entry *entry)
-{
-    /* variables */
-    unsigned long int   s;                      /* sector number of FAT entry */
-    unsigned long int   c;                      /* cluster offset of FAT entry */
+                /* set up the block information from the first extent */
+                cur_info.offset = extents[0].offset;
+                cur_info.sector = extents[0].sector;
+                cur_info.size = extents[0].size;
+                cur_info.next = extent_next;
+                cur_info.extent_idx = 0;
+            }
+            else  {
 
-    unsigned long int   next;                   /* next cluster from FAT */
+                /* no extents or too many, get them from the FAT */
+                setup_entry_info();
+            }
+        }
+    }
 
-    unsigned short int  sector[IDE_BLOCK_SIZE]; /* sector from the hard drive */
 
-    char                contig = TRUE;          /* clusters are contiguous */
-    char                error = FALSE;          /* error flag */
+    /* done, return with the error status */
+    return  error;
 
+}
 
 
-    /* first check for special cluster values */
-    if (cluster == 0)  {
 
-        /* zero cluster is illegal, so this indicates want FAT16 root */
-        entry->cluster = root_start_sector;     /* use root values */
-        entry->size = root_dir_size;
-        next = CHAIN_END;                       /* no next cluster */
-    }
-    else if (cluster == CHAIN_END)  {
 
-        /* end of chain indicator, return a zero length cluster */
-        entry->cluster = 0;
-        entry->size = 0;
-        next = CHAIN_END;                       /* no next cluster */
-    }
-    else  {
+/*
+   get_dir_size
 
-        /* normal cluster number */
-        /* first sector for entry is based on cluster number */
-        entry->cluster = cluster;
-        /* nothing in it yet */
-        entry->size = 0;
+   Description:      This function returns the number of sectors in the
+                     directory starting at the passed cluster.
 
-        /* now try to get info from FAT */
-        /* first get sector number for the cluster entry */
-        s = cluster / clusters_per_sector + first_FAT_sector;
-        /* get cluster entry within the sector */
-        c = cluster % clusters_per_sector;
-        /* and read the sector from the hard drive */
-        error = (get_blocks(s, 1, (unsigned short int far *) sector) != 1);
+   Arguments:        cluster (unsigned long int) - starting cluster of the
+                                                   directory (0 for the
+                                                   FAT16 root directory).
+   Return Value:     (unsigned long int) - number of sectors in the
+                     directory.
 
-        /* while there are contiguous clusters, get the FAT information */
-        while (contig && !error)  {
-
-            /* check if cluster number is still in this sector */
-            if (c >= clusters_per_sector)  {
-                /* finished entries in this sector, move to next */
-                s++;
-                /* at the start of this sector */
-                c = 0;
-                /* and read the sector from the hard drive */
-                error = (get_blocks(s, 1, (unsigned short int far *) sector) != 1);
-            }
+   Input:            None.
+   Output:           None.
 
-            /* get the next cluster number (based on FAT type) */
-            if (fat16)
-                /* FAT16 so each entry is one word */
-                next = sector[c];
-            else
-                /* FAT32, each entry is two words */
-                next = ((unsigned long int *) sector)[c];
+   Error Handling:   None.
 
-            /* check if the cluster contiguous */
-            /* note that end of chain markers will not be contiguous */
-            contig = (next == (cluster + 1));
+   Algorithms:       None.
+   Data Structures:  None.
 
-            /* this cluster was already found to be contiguous, so update size */
-            entry->size += sectors_per_cluster;
+   Shared Variables: None.
 
-            /* can update the cluster number assuming contiguous */
-            cluster++;
-            /* and move to next cluster in this FAT sector */
-            c++;
-        }
+   Author:           Tim Liu
+   Last Modified:    June 12, 2016
 
-        /* set the next cluster pointer in chain to CHAIN_END if there was */
-        /* an error or hit the end of the cluster chain in the FAT */
-        if (error || (fat16 && (next >= FAT16_BAD)) ||
-            (!fat16 && (next >= FAT32_BAD)))  {
-            /* have an error or a bad cluster or end of chain marker */
-            /* next pointer is end of chain */
-            next = CHAIN_END;
-        }
-    }
+*/
+
+static  unsigned long int  get_dir_size(unsigned long int cluster)
+{
+    /* variables */
+    struct  cache_entry  e;             /* information on clusters */
+
+    unsigned long int    size = 0;      /* sectors in the directory */
 
 
-    /* done getting the cluster information, return */
-    return  next;
+
+    /* add up the contiguous runs in the cluster chain */
+    do  {
+        cluster = get_contig_sectors(cluster, &e);
+        size += e.size;
+    } while (cluster != CHAIN_END);
+
+
+    /* return the size of the directory */
+    return  size;
 
 }
 
@@ -1898,6 +4893,7 @@ static  char               dirnames[MAX_PATH_CHARS];            /* names */
 static  unsigned long int  dirclusterstack[MAX_NUM_SUBDIRS];    /* starting clusters */
 static  int                dirnamestack[MAX_NUM_SUBDIRS];       /* name positions in dirnames */
 static  int                dirstack_ptr;                        /* the stack pointer */
+static  unsigned long int  dirstampstack[MAX_NUM_SUBDIRS];      /* times and dates */
 
 
 
@@ -1982,6 +4978,8 @@ static  void  init_dir_stack()
                                        file/directory.
                      dir_info        - accessed for the directory starting
                                        cluster number.
+                     dir_stamp       - accessed to get the current directory
+                                       time and date.
                      dirclusterstack - may be updated to add a directory
                                        starting cluster location.
                      dirname         - accessed to get the current directory
@@ -1992,9 +4990,11 @@ static  void  init_dir_stack()
                                        character number in dirnames[] for this
                                        directory name.
                      dirstack_ptr    - updated to adjust the stack.
+                     dirstampstack   - may be updated to add the directory
+                                       time and date.
 
    Author:           Glen George
-   Last Modified:    March 17, 2013
+   Last Modified:    June 12, 2016
 
 */
 
@@ -2024,8 +5024,9 @@ static  void  new_directory()
 
             /* there is room - update the stack pointer */
             dirstack_ptr++;
-            /* save the starting cluster */
+            /* save the starting cluster and the time and date */
             dirclusterstack[dirstack_ptr] = dir_info.cluster1;
+            dirstampstack[dirstack_ptr] = dir_stamp;
             /* save the name pointer and the name */
             dirnamestack[dirstack_ptr] = strlen(dirnames);
             strcat(dirnames, dirname);
@@ -2158,3 +5159,60 @@ static  unsigned long int  get_dir_tos_sector()
     return  c;
 
 }
+
+
+
+
+/*
+   get_dir_tos_stamp
+
+   Description:      This function returns the time and date (of its entry
+                     in its parent) of the directory on the top of the
+                     directory stack.  If the stack is empty, zero (0) is
+                     returned.
+
+   Arguments:        None.
+   Return Value:     (unsigned long int) - the date (high word) and time (low
+                     word) of the directory on the top of the directory stack
+                     or zero (0) if there is nothing on the stack.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   If nothing is on the stack, zero (0) is returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: dirstampstack - accessed to get the time and date.
+                     dirstack_ptr  - accessed to get the time and date.
+
+   Author:           Tim Liu
+   Last Modified:    June 12, 2016
+
+*/
+
+static  unsigned long int  get_dir_tos_stamp()
+{
+    /* variables */
+    unsigned long int  t;       /* time and date to return */
+
+
+
+    /* check if there is something in the directory stack */
+    if (dirstack_ptr >= 0)  {
+
+        /* there is something on the stack, return the time and date */
+        t = dirstampstack[dirstack_ptr];
+    }
+    else  {
+
+        /* nothing on the stack, return 0 */
+        t = 0;
+    }
+
+
+    /* all done - return with the time and date */
+    return  t;
+
+}
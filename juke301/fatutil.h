@@ -24,6 +24,26 @@
                                  get_ID3_tag() functions and updated
                                  declarations for init_FAT_system() and
                                  get_first_dir_entry().
+      6/7/16   Tim Liu           Added declarations for the asynchronous
+                                 get_file_blocks_start() and
+                                 get_file_blocks_poll() functions.
+      6/9/16   Tim Liu           Added declarations for the sector cache
+                                 counters get_sector_cache_hits() and
+                                 get_sector_cache_misses().
+      6/11/16  Tim Liu           Added the extent structure for the file
+                                 extent index and renamed cache_idx in
+                                 block_info to extent_idx.
+      6/13/16  Tim Liu           Added the dir_record structure for the
+                                 directory table and the declaration for
+                                 move_dir_entry().
+      6/14/16  Tim Liu           Added the tag_record structure for the ID3
+                                 tag cache and the declaration for
+                                 fill_tag_cache().
+      6/16/16  Tim Liu           Added the declaration for get_saved_probe().
+      6/16/16  Tim Liu           Added the declaration for at_dir_end().
+      6/16/16  Tim Liu           Added the probe results to the tag_record
+                                 structure and the declaration for
+                                 save_probe().
 */
 
 
@@ -38,6 +58,7 @@
 
 /* local include files */
 #include  "mp3defs.h"
+#include  "id3info.h"
 
 
 
@@ -51,12 +72,50 @@
 
 /* structures, unions, and typedefs */
 
-/* cache entry structure */
+/* cache entry structure (a run of contiguous clusters) */
 struct  cache_entry  {
                         unsigned long int  cluster; /* starting cluster number of cache entry */
                         unsigned long int  size;    /* number of sectors in cache entry */
                      };
 
+/* extent structure for the file extent index */
+struct  extent  {
+                   unsigned long int  offset;   /* sector offset within file */
+                   unsigned long int  sector;   /* starting sector number on the disk */
+                   unsigned long int  size;     /* number of contiguous sectors */
+               };
+
+/* directory table record (one per visible directory entry) */
+struct  dir_record  {
+                       unsigned int       name;     /* offset of name in name table */
+                       unsigned char      attr;     /* entry attributes */
+                       char               parent;   /* entry is ".." */
+                       unsigned int       time;     /* entry time */
+                       unsigned int       date;     /* entry date */
+                       long int           size;     /* entry size in bytes */
+                       unsigned long int  cluster;  /* first cluster of entry */
+                   };
+
+/* ID3 tag cache record (the displayed parts of a tag and the probe results) */
+/*    if the probe found an ID3v2 title the title and artist are from it */
+struct  tag_record  {
+                       unsigned long int  dir;      /* first cluster of directory */
+                       int                entry;    /* directory table entry, -1 if none */
+                       long int           size;     /* size of the file in bytes */
+                       char               has_tag;  /* file has an ID3 tag */
+                       char               title[ID3_TAG_TITLE_SIZE];    /* tag title */
+                       char               artist[ID3_TAG_ARTIST_SIZE];  /* tag artist */
+                       unsigned long int  time;     /* tag time (our extension) */
+                       char               probed;   /* probe results are saved */
+                       char               id3v2;    /* title and artist are from ID3v2 */
+                       unsigned int       probe_time;   /* probed time */
+                       long int           start;    /* start of audio */
+                       long int           frames;   /* MPEG frames in track */
+                       int                bit_rate; /* average bit rate */
+                       char               has_toc;  /* track has a seek table */
+                       unsigned char      toc[SEEK_TOC_SIZE];   /* the seek table */
+                   };
+
 /* block information structure for holding the current cluster state */
 struct  block_info  {
                        unsigned long int  sector;   /* starting sector number of cluster */
@@ -64,7 +123,7 @@ struct  block_info  {
                        unsigned long int  next;     /* next cluster number in chain */
                        unsigned long int  offset;   /* sector offset within file */
                        unsigned long int  cluster1; /* first cluster in file */
-                       int                cache_idx;/* cache index for this cluster */
+                       int                extent_idx;/* extent index entry, -1 if none */
                    };
 
 
@@ -82,6 +141,8 @@ unsigned char       get_cur_file_attr(void);    /* get current file attributes *
 unsigned int        get_cur_file_time(void);    /* get current file length in seconds */
 long int            get_cur_file_size(void);    /* get current file length in bytes */
 unsigned long int   get_cur_file_sector(void);  /* get current file starting sector */
+unsigned long int   get_sector_cache_hits(void);    /* get sectors found in cache */
+unsigned long int   get_sector_cache_misses(void);  /* get sectors read into cache */
 
 /* status functions */
 char                cur_isDir(void);            /* current file is a directory */
@@ -91,10 +152,19 @@ char                cur_isParentDir(void);      /* current file is ".." */
 char                get_first_dir_entry();      /* get first directory entry */
 char                get_next_dir_entry(void);   /* get next directory entry */
 char                get_previous_dir_entry(void);   /* get previous directory entry */
+char                move_dir_entry(int);        /* move by entries in directory */
+char                at_dir_end(void);           /* last move stopped at the end */
 
 /* file access functions */
 int                 get_file_blocks(unsigned long int, int, unsigned short int far *);   /* get data from a file */
+void                get_file_blocks_start(unsigned long int, int, unsigned short int far *);   /* start getting data from a file */
+int                 get_file_blocks_poll(void); /* check if file data is read */
 void                get_ID3_tag(char *);        /* get ID3 tag data from file */
+char                get_saved_probe(struct track_header *); /* get saved probe results */
+void                save_probe(const struct track_header *, unsigned int);  /* save probe results */
+
+/* background functions */
+void                fill_tag_cache(void);       /* read ahead nearby ID3 tags and probes */
 
 
 #endif
@@ -62,6 +62,13 @@
                                  inc_FFRev_rate along with the shared variable
 				 FFRev_rate to support variable rate fast
 				 forward and reverse.
+      6/16/16  Tim Liu           Changed update_FastFwd() and update_Reverse()
+                                 to move by time using the frame index
+                                 instead of by blocks using the average bit
+                                 rate, and made time_FFRev a long int.
+      6/16/16  Tim Liu           The start of a track is where its audio starts
+                                 (get_track_start()), not the start of the
+                                 file.
 */
 
 
@@ -75,6 +82,7 @@
 #include  "updatfnc.h"
 #include  "trakutil.h"
 #include  "fatutil.h"
+#include  "frameidx.h"
 
 
 
@@ -82,7 +90,7 @@
 
 static int  FFRev_rate;         /* rate at which to increment/decrement fast forward/reverse */
 
-static int  time_FFRev;         /* leftover time (after rounding) for fast forward/reverse */
+static long int  time_FFRev;    /* leftover time (after rounding) for fast forward/reverse */
 
 
 
@@ -190,7 +198,7 @@ enum status  start_Reverse(enum status cur_status)
 
 
     /* check if entry is not a directory and something is left on the track */
-    if (!cur_isDir() && (get_track_remaining_length() != get_track_length()))  {
+    if (!cur_isDir() && (get_track_position() > get_track_start()))  {
 
         /* something is on the track & not a directory, can do reverse */
 
@@ -461,8 +469,10 @@ enum status  stop_FFRev(enum status cur_status)
 
    Description:      This function handles updates when fast forwarding.  The
                      function gets the elapsed time, scales it appropriately,
-                     and updates the track time and buffer pointer for the new
-                     position.  When the end of the track is reached the
+                     and moves the track position to the frame at the new
+                     time (from the frame index).  Any time not moved (the
+                     frame is before the new time) is kept for the next
+                     update.  When the end of the track is reached the
                      status is returned to idle (the time is left at 0).
 
    Arguments:        cur_status (enum status) - the current system status.
@@ -480,7 +490,7 @@ enum status  stop_FFRev(enum status cur_status)
    Shared Variables: time_FFRev - updated.
 
    Author:           Glen George
-   Last Modified:    June 1, 2002
+   Last Modified:    June 16, 2016
 
 */
 
@@ -489,7 +499,9 @@ enum status  update_FastFwd(enum status cur_status)
     /* variables */
     long int  etime;            /* the elapsed time since the last call */
 
-    long int  buffer_fwd;       /* amount to move forward on track */
+    long int  target;           /* time to move forward to */
+    long int  landed;           /* time of the frame moved to */
+    long int  pos;              /* position of the frame moved to */
 
 
 
@@ -504,25 +516,24 @@ enum status  update_FastFwd(enum status cur_status)
         /* has enough time elapsed for fast forwarding */
         if (etime > MIN_FFREV_TIME)  {
 
-            /* can and should move forward - compute how many bytes */
-            buffer_fwd = (get_track_length() * etime) / (100L * get_track_total_time());
-
-            /* truncate it to the nearest number of blocks */
-            buffer_fwd = (buffer_fwd / IDE_BLOCK_SIZE);
-            /* compute the leftover time and save it for next time */
-            time_FFRev = etime - (100L * get_track_total_time() * buffer_fwd * IDE_BLOCK_SIZE) / get_track_length();
-            /* make sure there isn't a minor math error */
-            if (time_FFRev < 0)
-                /* leftover amount shouldn't be negative */
-                time_FFRev = 0;
+            /* can and should move forward - find the frame to move to */
+            target = frame_time(get_track_position()) + etime;
+            landed = target;
+            pos = seek_frame(&landed);
 
-            /* if there are buffers to move forward, do so */
-            if (buffer_fwd > 0)  {
-                update_track_position(buffer_fwd * IDE_BLOCK_SIZE);
+            /* if that frame is forward on the track, move to it */
+            if (pos > get_track_position())  {
+                update_track_position(pos - get_track_position());
+                /* save the time not moved for next time */
+                time_FFRev = target - landed;
 
                 /* also display the new time */
                 display_time(get_track_time());
             }
+            else  {
+                /* no frame to move to yet - keep accumulating time */
+                time_FFRev = etime;
+            }
         }
         else  {
 
@@ -551,8 +562,9 @@ enum status  update_FastFwd(enum status cur_status)
 
    Description:      This function handles updates when reversing.  The
                      function gets the elapsed time, scales it appropriately,
-                     and updates the track time and buffer pointer for the new
-                     position.  When the start of the track is reached the
+                     and moves the track position back to the frame at or
+                     before the new time (from the frame index).  When the
+                     start of the track is reached the
                      status is returned to idle (the time is left at the
                      start).
 
@@ -572,7 +584,7 @@ enum status  update_FastFwd(enum status cur_status)
    Shared Variables: time_FFRev - updated.
 
    Author:           Glen George
-   Last Modified:    June 1, 2002
+   Last Modified:    June 16, 2016
 
 */
 
@@ -581,12 +593,13 @@ enum status  update_Reverse(enum status cur_status)
     /* variables */
     long int  etime;            /* the elapsed time since the last call */
 
-    long int  buffer_rev;       /* amount to move backward on the track */
+    long int  target;           /* time to move back to */
+    long int  pos;              /* position of the frame moved to */
 
 
 
     /* check if already at the start of the track */
-    if (get_track_remaining_length() != get_track_length())  {
+    if (get_track_position() > get_track_start())  {
 
 
         /* something on track - get the elapsed time for reverse operation */
@@ -596,25 +609,23 @@ enum status  update_Reverse(enum status cur_status)
         /* has enough time elapsed for reversing */
         if (etime > MIN_FFREV_TIME)  {
 
-            /* can and should move backward - compute how many bytes */
-            buffer_rev = (get_track_length() * etime) / (100L * get_track_total_time());
+            /* can and should move backward - find the frame to move to */
+            target = frame_time(get_track_position()) - etime;
+            pos = seek_frame(&target);
 
-            /* truncate it to the nearest number of blocks */
-            buffer_rev = (buffer_rev / IDE_BLOCK_SIZE);
-            /* compute the leftover time and save it for next time */
-            time_FFRev = etime - (100L * get_track_total_time() * buffer_rev * IDE_BLOCK_SIZE) / get_track_length();
-            /* make sure there isn't a minor math error */
-            if (time_FFRev < 0)
-                /* leftover amount shouldn't be negative */
+            /* if that frame is back on the track, move to it */
+            if (pos < get_track_position())  {
+                update_track_position(pos - get_track_position());
+                /* the frame is at or before the time, so nothing left over */
                 time_FFRev = 0;
 
-            /* if there are buffers to move back, do so */
-            if (buffer_rev > 0)  {
-                update_track_position(-buffer_rev * IDE_BLOCK_SIZE);
-
                 /* also display the new time */
                 display_time(get_track_time());
             }
+            else  {
+                /* no frame to move to yet - keep accumulating time */
+                time_FFRev = etime;
+            }
         }
         else  {
 
@@ -0,0 +1,1687 @@
+/****************************************************************************/
+/*                                                                          */
+/*                                FRAMEIDX                                  */
+/*                          MP3 Frame Index Functions                       */
+/*                           MP3 Jukebox Project                            */
+/*                                EE/CS 52                                  */
+/*                                                                          */
+/****************************************************************************/
+
+/*
+   This file contains the functions for the MP3 frame index of the current
+   track.  As the track's data is read for playing, the frame headers are
+   followed from frame to frame and the time and byte offset of a frame are
+   saved in a sparse table every so often.  The table is used to find the
+   time at a position on the track and the frame to start playing from for
+   a time, so variable bit rate tracks seek to the right place and their
+   time doesn't drift.  Past the part of the track that has been indexed
+   the rest of the track is assumed to have a constant bit rate, or the
+   track's seek table (from its Xing header) is used if it has one.  When
+   a track is selected its first frame is probed for its length in time and
+   seek table.  The functions included are:
+      frame_header - get the length of a frame from its header
+      frame_time   - get the time at a position on the track
+      index_frames - index the frames in data read from the track
+      probe_track  - get the time and seek table from the first frame
+      seek_frame   - get the position on the track to play a time from
+
+   The local functions included are:
+      check_index_track - start a new index if the track has changed
+      probe_byte        - get a byte of the current file for probing
+      probe_id3v2       - get the title, artist, and length from an ID3v2 tag
+      probe_long        - get a big-endian long int of the current file
+      probe_match       - check for an identifier in the current file
+      probe_syncsafe    - get a syncsafe long int of the current file
+      probe_text        - get an ID3v2 text frame of the current file
+      rest_bytes        - get the bytes played in a time past the index
+      rest_time         - get the time to play bytes past the index
+      scale_long        - compute a * b / c without overflowing
+      toc_pos           - get the position at a time from the seek table
+      toc_time          - get the time at a position from the seek table
+
+   The locally global variable definitions included are:
+      hdr_have     - number of bytes of the next frame header saved
+      index_count  - number of entries in the frame index
+      index_pos    - byte offsets of the frames in the index
+      index_sector - starting sector of the track indexed
+      index_step   - time (in ms) between index entries
+      index_time   - times (in ms) of the frames in the index
+      next_frame   - byte offset of the next frame header to check
+      probe_block  - block of the file in probe_buffer
+      probe_buffer - a block of the file being probed
+      probe_error  - flag indicating an error reading the probed file
+      ref_header   - version, layer, and sample rate bits of the track
+      ref_set      - flag indicating ref_header has been set
+      scan_frac    - leftover time (in ms times the sample rate)
+      scan_hdr     - bytes of the next frame header
+      scan_ms      - time (in ms) at the next frame
+
+
+   Revision History
+      6/16/16  Tim Liu           Initial revision.
+      6/16/16  Tim Liu           Added probe_track() to get the time and seek
+                                 table from the Xing/Info or VBRI header (or
+                                 the bit rate) and use the seek table past
+                                 the index.
+      6/16/16  Tim Liu           probe_track() sets where the audio starts
+                                 and the index starts there (so it no longer
+                                 skips an ID3v2 tag itself).
+      6/16/16  Tim Liu           probe_track() gets the title, artist, and
+                                 length (TIT2, TPE1, and TLEN frames) from an
+                                 ID3v2 tag in the blocks it reads.
+      6/16/16  Tim Liu           Local function declarations are static (gcc
+                                 requires it for the Linux host build).
+      6/16/16  Tim Liu           frame_header() is no longer local (the host
+                                 build's simulated decoder uses it).
+      6/16/16  Tim Liu           toc_time() and toc_pos() scale the seek
+                                 table over the audio (from the track start)
+                                 instead of the whole file.
+*/
+
+
+
+/* library include files */
+#include  <stddef.h>
+
+/* local include files */
+#include  "mp3defs.h"
+#include  "frameidx.h"
+#include  "trakutil.h"
+#include  "fatutil.h"
+
+
+
+
+/* local definitions */
+#define  MAX_LONG_INT       0x7FFFFFFFL /* largest long int */
+
+#define  MPEG_VERSION_1     3           /* version bits for MPEG 1 */
+#define  MPEG_VERSION_2     2           /* version bits for MPEG 2 */
+#define  MPEG_VERSION_BAD   1           /* reserved version bits */
+#define  MPEG_LAYER_3       1           /* layer bits for Layer III */
+#define  BAD_BITRATE        15          /* reserved bit rate index */
+#define  BAD_SAMPLE_RATE    3           /* reserved sample rate index */
+
+#define  MPEG1_SAMPLES      1152        /* samples in an MPEG 1 frame */
+#define  MPEG2_SAMPLES      576         /* samples in an MPEG 2/2.5 frame */
+#define  MPEG1_LEN_SCALE    144000L     /* frame length is this times the */
+#define  MPEG2_LEN_SCALE    72000L      /*    bit rate over the sample rate */
+#define  MONO_MODE          3           /* channel mode bits for mono */
+
+#define  NO_BLOCK           -1L         /* no block in probe_buffer */
+#define  TOC_SCALE          256L        /* seek table entries are 256ths */
+#define  TOC_FRAC           100L        /* fraction of an entry kept */
+
+
+
+
+/* local function declarations */
+static  void      check_index_track(void);                      /* new track index */
+static  unsigned char  probe_byte(long int);                    /* byte of the file */
+static  long int  probe_long(long int);                         /* long int of the file */
+static  int       probe_match(long int, const char *);          /* identifier in file */
+static  long int  probe_id3v2(struct track_header *, long int); /* ID3v2 frames */
+static  long int  probe_syncsafe(long int);                     /* syncsafe long int */
+static  void      probe_text(long int, long int, char *, int);  /* ID3v2 text frame */
+static  long int  rest_bytes(long int, long int, long int);     /* bytes past index */
+static  long int  rest_time(long int, long int, long int);      /* time past index */
+static  long int  scale_long(long int, long int, long int);     /* a * b / c */
+static  long int  toc_pos(const unsigned char *, long int);     /* position from table */
+static  long int  toc_time(const unsigned char *, long int);    /* time from table */
+
+
+
+
+/* locally global variables */
+static unsigned long int  index_sector;             /* track indexed */
+static long int           index_pos[FRAME_INDEX_SIZE];  /* frame offsets */
+static long int           index_time[FRAME_INDEX_SIZE]; /* frame times */
+static int                index_count;              /* entries in the index */
+static long int           index_step;               /* time between entries */
+
+static long int           next_frame;               /* next header to check */
+static unsigned char      scan_hdr[FRAME_HEADER_SIZE];  /* next header */
+static int                hdr_have;                 /* header bytes saved */
+static long int           scan_ms;                  /* time at next_frame */
+static long int           scan_frac;                /* leftover time */
+static unsigned char      ref_header[2];            /* track's header bits */
+static int                ref_set;                  /* ref_header is set */
+
+static long int           probe_block;              /* block in probe_buffer */
+static unsigned char      probe_buffer[2 * IDE_BLOCK_SIZE]; /* file block */
+static int                probe_error;              /* error probing file */
+
+/* Layer III bit rates (in kbps) for MPEG 1 and for MPEG 2/2.5 */
+static const int          bit_rates[2][16] = {
+    {  0,  32,  40,  48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320,   0 },
+    {  0,   8,  16,  24,  32,  40,  48,  56,  64,  80,  96, 112, 128, 144, 160,   0 }
+                                               };
+
+/* MPEG 1 sample rates (halved for MPEG 2, quartered for MPEG 2.5) */
+static const long int     sample_rates[3] = {  44100L,  48000L,  32000L  };
+
+
+
+
+/*
+   probe_track
+
+   Description:      This function probes the start of the current file for
+                     the length of the track in time, its number of frames,
+                     its (average) bit rate, and its seek table.  If there
+                     is an ID3v2 tag, the title, artist, and length are
+                     taken from its first blocks, then it is skipped and
+                     the first frame header is found.  If
+                     the first frame holds a Xing/Info header (written by
+                     LAME and most encoders) or a VBRI header the frame and
+                     byte counts (and the Xing seek table) are taken from
+                     it.  Otherwise the length from the ID3v2 tag is used,
+                     or the track is assumed to have the constant bit rate
+                     of the first frame.  The start of the
+                     audio is set to the first frame (or the end of the tag
+                     if no frame is found).  Usually only the first block of
+                     the file is read (a long ID3v2 tag means the block
+                     after it is read too).
+
+   Arguments:        info (struct track_header *) - track information for
+                                   the current file, its length must be set,
+                                   the start, frames, bit_rate, has_toc,
+                                   and toc elements are set, the title and
+                                   artist elements are set from an ID3v2
+                                   tag (empty if there isn't one).
+   Return Value:     (unsigned int) - the length of the track in tenths of a
+                     second (0 if it can't be determined).
+
+   Input:            The start of the file is read from the hard drive.
+   Output:           None.
+
+   Error Handling:   If the file can't be read or no frame header is found
+                     the time is 0 and nothing is known about the track.
+                     A seek table that isn't in order is not used.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: probe_block - set to the block read (none at first).
+                     probe_error - cleared, then set on an error.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+unsigned int  probe_track(struct track_header *info)
+{
+    /* variables */
+    unsigned char  hdr[FRAME_HEADER_SIZE];  /* header of the first frame */
+
+    long int       pos = 0;         /* position of the first frame */
+    long int       x;               /* position of the Xing or VBRI header */
+
+    int            frame_len = 0;   /* length of the first frame */
+    int            samples;         /* samples in a frame */
+    long int       rate;            /* sample rate */
+    int            bit_rate;        /* bit rate of the first frame */
+
+    long int       flags;           /* Xing header flags */
+    long int       bytes = 0;       /* bytes of frames (0 if not known) */
+    long int       ms = 0;          /* length of the track (in ms) */
+    long int       tag_ms = 0;      /* length from the ID3v2 tag (0 if none) */
+
+    int            n;               /* bytes searched for the first frame */
+    int            i;               /* loop index */
+
+
+
+    /* nothing is known about the track yet (the audio is the whole file) */
+    info->title[0] = '\0';
+    info->artist[0] = '\0';
+    info->start = 0;
+    info->frames = 0;
+    info->bit_rate = 0;
+    info->has_toc = FALSE;
+
+    /* and nothing has been read */
+    probe_block = NO_BLOCK;
+    probe_error = FALSE;
+
+
+    /* check for an ID3v2 tag at the start of the file */
+    if ((probe_byte(0) == 'I') && (probe_byte(1) == 'D') && (probe_byte(2) == '3'))  {
+        /* the size is syncsafe (7 bits a byte) and doesn't include the header */
+        pos = ID3V2_HEADER_SIZE + probe_syncsafe(ID3V2_SIZE);
+        /* get what's wanted from the tag's frames */
+        tag_ms = probe_id3v2(info, pos);
+        /* then skip it, there may also be a footer */
+        if ((probe_byte(ID3V2_FLAGS) & ID3V2_FOOTER) != 0)
+            pos += ID3V2_HEADER_SIZE;
+    }
+    /* an error here just means there's no tag */
+    probe_error = FALSE;
+
+    /* the audio starts after the tag (if it's in the file) */
+    if (pos < info->length)
+        info->start = pos;
+    else
+        pos = 0;
+
+
+    /* look for the first frame header (a little way into the data at most) */
+    for (n = 0; !probe_error && (frame_len == 0) && (n < PROBE_SEARCH); n++)  {
+        /* get the possible header */
+        for (i = 0; i < FRAME_HEADER_SIZE; i++)
+            hdr[i] = probe_byte(pos + i);
+        /* check it, if it isn't a header try the next byte */
+        frame_len = frame_header(hdr, &samples, &rate, &bit_rate);
+        if (frame_len == 0)
+            pos++;
+    }
+
+
+    /* if found the first frame, get the track information from it */
+    if (!probe_error && (frame_len != 0))  {
+
+        /* the audio starts with it */
+        info->start = pos;
+
+        /* a Xing header follows the side information, which depends on */
+        /*    the version and if the track is mono */
+        if (((hdr[1] >> 3) & 0x03) == MPEG_VERSION_1)
+            x = (((hdr[3] >> 6) & 0x03) == MONO_MODE) ? SIDE_MPEG1_MONO : SIDE_MPEG1_STEREO;
+        else
+            x = (((hdr[3] >> 6) & 0x03) == MONO_MODE) ? SIDE_MPEG2_MONO : SIDE_MPEG2_STEREO;
+        x += pos + FRAME_HEADER_SIZE;
+
+        /* check for a Xing/Info or VBRI header */
+        if (probe_match(x, XING_ID) || probe_match(x, INFO_ID))  {
+
+            /* Xing header - the flags say which fields follow */
+            flags = probe_long(x + XING_ID_SIZE);
+            x += XING_ID_SIZE + 4;
+
+            /* get the frame count, byte count, and seek table if there */
+            if ((flags & XING_FRAMES) != 0)  {
+                info->frames = probe_long(x);
+                x += 4;
+            }
+            if ((flags & XING_BYTES) != 0)  {
+                bytes = probe_long(x);
+                x += 4;
+            }
+            if ((flags & XING_TOC) != 0)  {
+                info->has_toc = TRUE;
+                for (i = 0; i < SEEK_TOC_SIZE; i++)  {
+                    info->toc[i] = probe_byte(x + i);
+                    /* the entries can't go backwards */
+                    if ((i > 0) && (info->toc[i] < info->toc[i - 1]))
+                        info->has_toc = FALSE;
+                }
+            }
+        }
+        else if (probe_match(pos + FRAME_HEADER_SIZE + VBRI_OFFSET, VBRI_ID))  {
+
+            /* VBRI header - just get the byte and frame counts */
+            x = pos + FRAME_HEADER_SIZE + VBRI_OFFSET;
+            bytes = probe_long(x + VBRI_BYTES);
+            info->frames = probe_long(x + VBRI_FRAMES);
+        }
+
+
+        /* if the byte count isn't known it's the rest of the file */
+        if (bytes <= 0)
+            bytes = info->length - pos;
+
+        /* now can compute the time */
+        if (info->frames > 0)  {
+            /* have the number of frames, so know the time */
+            ms = scale_long(info->frames * samples, 1000L, rate);
+            /* and the average bit rate (bits per ms is kbps) */
+            if (ms > 0)
+                info->bit_rate = (int) scale_long(bytes, 8L, ms);
+        }
+        else if ((tag_ms > 0) && (bytes > 0))  {
+            /* the ID3v2 tag has the time, get the average bit rate and */
+            /*    (about) the number of frames from it */
+            ms = tag_ms;
+            info->bit_rate = (int) scale_long(bytes, 8L, ms);
+            info->frames = scale_long(ms, rate, samples * 1000L);
+        }
+        else if (bytes > 0)  {
+            /* no header, assume the bit rate of the first frame throughout */
+            info->bit_rate = bit_rate;
+            ms = scale_long(bytes, 8L, bit_rate);
+            info->frames = bytes / frame_len;
+        }
+    }
+
+
+    /* if there was an error, nothing is known about the frames */
+    if (probe_error)  {
+        info->frames = 0;
+        info->bit_rate = 0;
+        info->has_toc = FALSE;
+        /* but the ID3v2 tag may still have had the time */
+        ms = tag_ms;
+    }
+
+    /* make sure the time fits (and isn't TIME_NONE) */
+    if ((ms / TIME_SCALE) >= TIME_NONE)
+        ms = (TIME_NONE - 1) * TIME_SCALE;
+
+
+    /* return the time in tenths of a second */
+    return  (unsigned int) (ms / TIME_SCALE);
+
+}
+
+
+
+
+/*
+   index_frames
+
+   Description:      This function indexes the frames in data read from the
+                     current track for playing.  The frame headers are
+                     followed from the point the last call left off (the
+                     data must include that point, otherwise it can't be
+                     indexed since its time isn't known).  The length and
+                     play time of each frame is taken from its header.  An
+                     index entry is saved for the first frame and then for a
+                     frame every index_step ms.  When the index is full every
+                     other entry is dropped and index_step is doubled.  If
+                     the data doesn't have a valid frame header where one is
+                     expected, the headers are searched for a byte at a time.
+                     After the first frame only headers with the same
+                     version, layer, and sample rate are accepted.  The
+                     scan starts at the start of the track's audio.
+
+   Arguments:        data (const unsigned short int far *) - data read from
+                                                             the track.
+                     words (int)    - number of words of data.
+                     pos (long int) - byte offset of the data in the track.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   Data that isn't frames is skipped over.
+
+   Algorithms:       None.
+   Data Structures:  The index is an array of frame offsets and an array of
+                     the times of those frames, both in order.
+
+   Shared Variables: hdr_have    - updated with the bytes of the next header.
+                     index_count - updated as entries are added.
+                     index_pos   - entries are added.
+                     index_step  - doubled when the index fills up.
+                     index_time  - entries are added.
+                     next_frame  - updated to the next frame header.
+                     ref_header  - set from the first frame.
+                     ref_set     - set once the first frame is found.
+                     scan_frac   - updated with the time of each frame.
+                     scan_hdr    - updated with the next header's bytes.
+                     scan_ms     - updated with the time of each frame.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  index_frames(const unsigned short int far *data, int words, long int pos)
+{
+    /* variables */
+    const unsigned char far  *bytes;    /* data as bytes */
+    unsigned int              len;      /* bytes of data */
+
+    long int                  start;    /* where to look in the data */
+    unsigned int              i;        /* index into the data */
+
+    int                       frame_len;/* bytes in the frame */
+    int                       samples;  /* samples in the frame */
+    long int                  rate;     /* sample rate of the frame */
+    int                       bit_rate; /* bit rate of the frame */
+
+    int                       j;        /* loop index */
+
+
+
+    /* start a new index if this is a new track */
+    check_index_track();
+
+    /* get the data as bytes */
+    bytes = (const unsigned char far *) data;
+    len = 2 * words;
+
+
+
+    /* figure out where the scan left off in this data */
+    start = next_frame + hdr_have - pos;
+
+    /* only continue if that's in this data */
+    if ((start >= 0) && (start < len))  {
+
+        /* look at the data a byte at a time until past the end of it */
+        i = (unsigned int) start;
+        while (i < len)  {
+
+            /* save the next byte of the header */
+            scan_hdr[hdr_have++] = bytes[i++];
+
+            /* check the header once have all of it */
+            if (hdr_have == FRAME_HEADER_SIZE)  {
+
+                /* get the frame length (0 if not a header) */
+                frame_len = frame_header(scan_hdr, &samples, &rate, &bit_rate);
+
+                /* after the first frame the headers must match the track */
+                /*    (so data that looks like a header isn't taken as one) */
+                if ((frame_len != 0) && ref_set &&
+                    (((scan_hdr[1] & FRAME_MATCH_MASK) != ref_header[0]) ||
+                     ((scan_hdr[2] & FRAME_RATE_MASK) != ref_header[1])))
+                    frame_len = 0;
+                /* the first frame sets the track's version, layer, and rate */
+                if ((frame_len != 0) && !ref_set)  {
+                    ref_header[0] = scan_hdr[1] & FRAME_MATCH_MASK;
+                    ref_header[1] = scan_hdr[2] & FRAME_RATE_MASK;
+                    ref_set = TRUE;
+                }
+
+                if (frame_len != 0)  {
+
+                    /* have a frame, check if it should be in the index */
+                    if ((index_count == 0) ||
+                        (scan_ms >= (index_time[index_count - 1] + index_step)))  {
+
+                        /* if the index is full, drop every other entry */
+                        if (index_count == FRAME_INDEX_SIZE)  {
+                            for (j = 0; (2 * j) < FRAME_INDEX_SIZE; j++)  {
+                                index_pos[j] = index_pos[2 * j];
+                                index_time[j] = index_time[2 * j];
+                            }
+                            index_count = FRAME_INDEX_SIZE / 2;
+                            /* and entries are now twice as far apart */
+                            index_step *= 2;
+                        }
+
+                        /* add the frame to the index */
+                        index_pos[index_count] = next_frame;
+                        index_time[index_count] = scan_ms;
+                        index_count++;
+                    }
+
+                    /* add in the time of the frame, keeping the leftover */
+                    scan_ms += (samples * 1000L) / rate;
+                    scan_frac += (samples * 1000L) % rate;
+                    if (scan_frac >= rate)  {
+                        scan_ms++;
+                        scan_frac -= rate;
+                    }
+
+                    /* and move to the next frame header */
+                    next_frame += frame_len;
+                    hdr_have = 0;
+
+                    /* skip to it if it is in this data */
+                    start = next_frame - pos;
+                    if (start < len)
+                        i = (unsigned int) start;
+                    else
+                        i = len;
+                }
+                else  {
+
+                    /* not a frame header, try one byte later */
+                    next_frame++;
+                    for (j = 1; j < FRAME_HEADER_SIZE; j++)
+                        scan_hdr[j - 1] = scan_hdr[j];
+                    hdr_have--;
+                }
+            }
+        }
+    }
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   frame_time
+
+   Description:      This function returns the time (from the start of the
+                     track's audio) at the passed position on the current
+                     track.
+                     Within the indexed part of the track the time is
+                     interpolated between the index entries around the
+                     position.  Past it the rest of the track is assumed to
+                     have a constant bit rate (from the track's total time
+                     if known).
+
+   Arguments:        pos (long int) - byte offset on the track.
+   Return Value:     (long int) - time (in ms) at that position.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       Linear interpolation.
+   Data Structures:  None.
+
+   Shared Variables: index_count - accessed to get the number of entries.
+                     index_pos   - accessed to find the entries.
+                     index_time  - accessed to get the entries' times.
+                     next_frame  - accessed as the last indexed position.
+                     scan_ms     - accessed as the time at next_frame.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+long int  frame_time(long int pos)
+{
+    /* variables */
+    long int  p0;               /* indexed position at or before pos */
+    long int  t0 = 0;           /* time at p0 */
+    long int  time;             /* time at pos */
+
+    int       i;                /* index into the frame index */
+
+
+
+    /* start a new index if this is a new track */
+    check_index_track();
+
+    /* time starts with the audio */
+    p0 = get_track_start();
+    if (pos < p0)
+        pos = p0;
+
+
+    /* find the last index entry at or before the position */
+    for (i = 0; (i < index_count) && (index_pos[i] <= pos); i++)  {
+        p0 = index_pos[i];
+        t0 = index_time[i];
+    }
+
+    /* check if between index entries */
+    if (i < index_count)  {
+        /* interpolate between the entries (i is at least 1 here unless */
+        /*    before the first frame, then interpolate from the start) */
+        time = t0 + scale_long(pos - p0, index_time[i] - t0, index_pos[i] - p0);
+    }
+    else if ((index_count > 0) && (next_frame > pos))  {
+        /* between the last entry and where the index stopped */
+        time = t0 + scale_long(pos - p0, scan_ms - t0, next_frame - p0);
+    }
+    else  {
+        /* past the index, start from where it stopped (if anything) */
+        if (index_count > 0)  {
+            p0 = next_frame;
+            t0 = scan_ms;
+        }
+        /* and assume the rest of the track is constant bit rate */
+        time = t0 + rest_time(pos - p0, p0, t0);
+    }
+
+
+    /* return the time */
+    return  time;
+
+}
+
+
+
+
+/*
+   seek_frame
+
+   Description:      This function returns the position on the current track
+                     to start playing the passed time from.  If there is an
+                     indexed frame after the time, the last indexed frame at
+                     or before the time is used and the passed time is
+                     changed to the time of that frame.  Otherwise the
+                     position is estimated (assuming the rest of the track
+                     after the index has a constant bit rate) and the time
+                     is left alone.  The position is always an even number
+                     of bytes (buffers are words).
+
+   Arguments:        time (long int *) - pointer to the time (in ms from the
+                                         start of the track) to seek to, set
+                                         to the time at the returned
+                                         position.
+   Return Value:     (long int) - byte offset on the track to play from.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   Times before the start of the track are treated as the
+                     start and positions past the end of the track are
+                     limited to the end (which may be an odd byte).
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: index_count - accessed to get the number of entries.
+                     index_pos   - accessed to get the entries' positions.
+                     index_time  - accessed to find the entries.
+                     next_frame  - accessed as the last indexed position.
+                     scan_ms     - accessed as the time at next_frame.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+long int  seek_frame(long int *time)
+{
+    /* variables */
+    long int  p0;               /* indexed position at or before the time */
+    long int  t0 = 0;           /* time at p0 */
+    long int  pos;              /* position to play from */
+
+    int       i;                /* index into the frame index */
+
+
+
+    /* start a new index if this is a new track */
+    check_index_track();
+
+    /* can't seek before the start (where the audio starts) */
+    if (*time < 0)
+        *time = 0;
+    p0 = get_track_start();
+
+
+    /* find the last index entry at or before the time */
+    for (i = 0; (i < index_count) && (index_time[i] <= *time); i++)  {
+        p0 = index_pos[i];
+        t0 = index_time[i];
+    }
+
+    /* where the index stopped can be used too */
+    if ((i == index_count) && (index_count > 0) && (scan_ms <= *time))  {
+        p0 = next_frame;
+        t0 = scan_ms;
+    }
+
+    /* check if there is indexed data after the time */
+    if ((i < index_count) || ((index_count > 0) && (scan_ms > *time)) || (*time == t0))  {
+        /* there is, so play from the indexed frame */
+        pos = p0;
+        *time = t0;
+    }
+    else  {
+        /* past the index, estimate it (on a word boundary) */
+        pos = (p0 + rest_bytes(*time - t0, p0, t0)) & ~1L;
+    }
+
+    /* don't go past the end of the track */
+    if (pos > get_track_length())
+        pos = get_track_length();
+
+
+    /* return the position */
+    return  pos;
+
+}
+
+
+
+
+/*
+   check_index_track
+
+   Description:      This function checks if the current track is the one
+                     that is indexed.  If it isn't, the index is emptied and
+                     the frame scan restarts at the start of the track's
+                     audio.
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: hdr_have     - cleared for a new track.
+                     index_count  - cleared for a new track.
+                     index_sector - set to the current track.
+                     index_step   - reset for a new track.
+                     next_frame   - reset for a new track.
+                     ref_set      - cleared for a new track.
+                     scan_frac    - cleared for a new track.
+                     scan_ms      - cleared for a new track.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  check_index_track()
+{
+    /* variables */
+    unsigned long int  sector;          /* starting sector of current file */
+
+
+
+    /* check if the track has changed */
+    sector = get_cur_file_sector();
+    if (sector != index_sector)  {
+
+        /* it has, start a new index at the start of the track */
+        index_sector = sector;
+        index_count = 0;
+        index_step = FRAME_INDEX_STEP;
+
+        next_frame = get_track_start();
+        hdr_have = 0;
+        scan_ms = 0;
+        scan_frac = 0;
+        ref_set = FALSE;
+    }
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   frame_header
+
+   Description:      This function checks if the passed bytes are the header
+                     of an MPEG Layer III frame and if so returns the length
+                     of the frame and the number of samples in it, its
+                     sample rate, and its bit rate.
+
+   Arguments:        hdr (const unsigned char *) - the four header bytes.
+                     samples (int *)    - pointer to where to store the
+                                          number of samples in the frame.
+                     rate (long int *)  - pointer to where to store the
+                                          sample rate (in Hz).
+                     bit_rate (int *)   - pointer to where to store the bit
+                                          rate (in kbps).
+   Return Value:     (int) - the length of the frame in bytes, 0 if the bytes
+                     aren't a valid frame header.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   Invalid headers return 0.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  frame_header(const unsigned char *hdr, int *samples, long int *rate, int *bit_rate)
+{
+    /* variables */
+    int  version;               /* MPEG version bits */
+    int  bit_rate_idx;          /* bit rate index */
+    int  rate_idx;              /* sample rate index */
+    int  mpeg1;                 /* MPEG 1 (not MPEG 2/2.5) */
+
+    int  len = 0;               /* frame length (0 if not a frame) */
+
+
+
+    /* get the fields of the header */
+    version = (hdr[1] >> 3) & 0x03;
+    bit_rate_idx = (hdr[2] >> 4) & 0x0F;
+    rate_idx = (hdr[2] >> 2) & 0x03;
+
+    /* check for a valid Layer III header */
+    if ((hdr[0] == FRAME_SYNC) && ((hdr[1] & FRAME_SYNC_MASK) == FRAME_SYNC_MASK) &&
+        (version != MPEG_VERSION_BAD) && (((hdr[1] >> 1) & 0x03) == MPEG_LAYER_3) &&
+        (bit_rate_idx != 0) && (bit_rate_idx != BAD_BITRATE) &&
+        (rate_idx != BAD_SAMPLE_RATE))  {
+
+        /* get the sample rate (halved for each lower version) */
+        mpeg1 = (version == MPEG_VERSION_1);
+        *rate = sample_rates[rate_idx];
+        if (!mpeg1)
+            *rate >>= 1;
+        if ((!mpeg1) && (version != MPEG_VERSION_2))
+            *rate >>= 1;
+
+        /* now the bit rate, samples, and length (including the padding byte) */
+        if (mpeg1)  {
+            *bit_rate = bit_rates[0][bit_rate_idx];
+            *samples = MPEG1_SAMPLES;
+            len = (int) ((MPEG1_LEN_SCALE * *bit_rate) / *rate);
+        }
+        else  {
+            *bit_rate = bit_rates[1][bit_rate_idx];
+            *samples = MPEG2_SAMPLES;
+            len = (int) ((MPEG2_LEN_SCALE * *bit_rate) / *rate);
+        }
+        len += (hdr[2] >> 1) & 0x01;
+    }
+
+
+    /* return the frame length */
+    return  len;
+
+}
+
+
+
+
+/*
+   rest_time
+
+   Description:      This function returns the time to play the passed
+                     number of bytes past an indexed point on the track.  If
+                     the track has a seek table the time comes from the
+                     difference of the table's times at the two positions.
+                     Otherwise the rest of the track is assumed to have a
+                     constant bit rate.  The rate comes from the time and
+                     bytes left on the track if its total time is known,
+                     otherwise the indexed part of the track, or if nothing
+                     is indexed a typical rate (DEF_BYTES_PER_MS).
+
+   Arguments:        bytes (long int) - bytes past the indexed point.
+                     p0 (long int)    - position of the indexed point.
+                     t0 (long int)    - time (in ms) at the indexed point.
+   Return Value:     (long int) - time (in ms) to play the bytes.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  long int  rest_time(long int bytes, long int p0, long int t0)
+{
+    /* variables */
+    const unsigned char  *toc;  /* seek table of the track */
+    unsigned int  total;        /* total time of the track */
+    long int      time;         /* time to play the bytes */
+
+
+
+    /* get the seek table and total time of the track */
+    toc = get_track_toc();
+    total = get_track_total_time();
+
+    /* use the seek table if there is one */
+    if (toc != NULL)
+        time = toc_time(toc, p0 + bytes) - toc_time(toc, p0);
+    /* otherwise the time and bytes left on the track if possible */
+    else if ((total != TIME_NONE) && ((total * TIME_SCALE) > t0) && (get_track_length() > p0))
+        time = scale_long(bytes, (total * TIME_SCALE) - t0, get_track_length() - p0);
+    else if ((t0 > 0) && (p0 > 0))
+        /* otherwise the rate of the indexed part */
+        time = scale_long(bytes, t0, p0);
+    else
+        /* nothing to go on, use a typical rate */
+        time = bytes / DEF_BYTES_PER_MS;
+
+
+    /* return the time */
+    return  time;
+
+}
+
+
+
+
+/*
+   rest_bytes
+
+   Description:      This function returns the bytes played in the passed
+                     time past an indexed point on the track.  It is the
+                     inverse of rest_time() (the same seek table or rate is
+                     used).
+
+   Arguments:        time (long int) - time (in ms) past the indexed point.
+                     p0 (long int)   - position of the indexed point.
+                     t0 (long int)   - time (in ms) at the indexed point.
+   Return Value:     (long int) - bytes played in the time.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  long int  rest_bytes(long int time, long int p0, long int t0)
+{
+    /* variables */
+    const unsigned char  *toc;  /* seek table of the track */
+    unsigned int  total;        /* total time of the track */
+    long int      bytes;        /* bytes played in the time */
+
+
+
+    /* get the seek table and total time of the track */
+    toc = get_track_toc();
+    total = get_track_total_time();
+
+    /* use the seek table if there is one (from where it puts p0) */
+    if (toc != NULL)  {
+        bytes = toc_pos(toc, toc_time(toc, p0) + time) - p0;
+        /* the table is coarse, it may put p0 a little later */
+        if (bytes < 0)
+            bytes = 0;
+    }
+    /* otherwise the time and bytes left on the track if possible */
+    else if ((total != TIME_NONE) && ((total * TIME_SCALE) > t0) && (get_track_length() > p0))
+        bytes = scale_long(time, get_track_length() - p0, (total * TIME_SCALE) - t0);
+    else if ((t0 > 0) && (p0 > 0))
+        /* otherwise the rate of the indexed part */
+        bytes = scale_long(time, p0, t0);
+    else
+        /* nothing to go on, use a typical rate */
+        bytes = time * DEF_BYTES_PER_MS;
+
+
+    /* return the bytes */
+    return  bytes;
+
+}
+
+
+
+
+/*
+   scale_long
+
+   Description:      This function computes a * b / c for non-negative long
+                     ints without the product overflowing.  If the product
+                     is too big, the larger of a and b and also c are halved
+                     until it fits (losing a little precision).
+
+   Arguments:        a (long int) - first factor.
+                     b (long int) - second factor.
+                     c (long int) - divisor.
+   Return Value:     (long int) - a * b / c (0 if c isn't positive).
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   A divisor that isn't positive returns 0.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  long int  scale_long(long int a, long int b, long int c)
+{
+    /* variables */
+    long int  result = 0;       /* a * b / c */
+
+
+
+    /* can only divide by a positive number */
+    if (c > 0)  {
+
+        /* scale down until the product fits */
+        while ((b != 0) && (a > (MAX_LONG_INT / b)))  {
+            if (a > b)
+                a >>= 1;
+            else
+                b >>= 1;
+            c >>= 1;
+        }
+
+        /* the divisor may have been scaled away */
+        if (c == 0)
+            c = 1;
+
+        /* now can compute it */
+        result = (a * b) / c;
+    }
+
+
+    /* return the result */
+    return  result;
+
+}
+
+
+
+
+/*
+   probe_byte
+
+   Description:      This function returns the byte at the passed position
+                     in the current file for probe_track().  The block of
+                     the file holding it is read into probe_buffer if it
+                     isn't already there.
+
+   Arguments:        pos (long int) - byte offset in the file.
+   Return Value:     (unsigned char) - the byte at that position.
+
+   Input:            A block of the file may be read from the hard drive.
+   Output:           None.
+
+   Error Handling:   If the position isn't in the file or the block can't be
+                     read probe_error is set (the byte returned is garbage).
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: probe_block  - accessed and set to the block read.
+                     probe_buffer - the block is read into it.
+                     probe_error  - set on an error.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  unsigned char  probe_byte(long int pos)
+{
+    /* variables */
+    long int  block;            /* block of the file holding the byte */
+
+
+
+    /* get the block of the file */
+    block = pos / (2 * IDE_BLOCK_SIZE);
+
+    /* the position has to be in the file */
+    if ((pos < 0) || (pos >= get_cur_file_size()))  {
+        probe_error = TRUE;
+    }
+    else if (block != probe_block)  {
+        /* don't have the block, read it */
+        if (get_file_blocks(block, 1, (unsigned short int far *) probe_buffer) == 1)
+            probe_block = block;
+        else
+            probe_error = TRUE;
+    }
+
+
+    /* return the byte (remember the buffer holds bytes) */
+    return  probe_buffer[(int) (pos % (2 * IDE_BLOCK_SIZE))];
+
+}
+
+
+
+
+/*
+   probe_long
+
+   Description:      This function returns the big-endian (most significant
+                     byte first) long int at the passed position in the
+                     current file for probe_track().
+
+   Arguments:        pos (long int) - byte offset in the file.
+   Return Value:     (long int) - the long int at that position.
+
+   Input:            A block of the file may be read from the hard drive.
+   Output:           None.
+
+   Error Handling:   Errors set probe_error (see probe_byte()).
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  long int  probe_long(long int pos)
+{
+    /* variables */
+    long int  value = 0;        /* the long int */
+
+    int       i;                /* loop index */
+
+
+
+    /* put the bytes together, most significant first */
+    for (i = 0; i < 4; i++)
+        value = (value << 8) | probe_byte(pos + i);
+
+
+    /* return the value */
+    return  value;
+
+}
+
+
+
+
+/*
+   probe_match
+
+   Description:      This function checks if the passed identifier (the
+                     characters of the string) is at the passed position in
+                     the current file for probe_track().
+
+   Arguments:        pos (long int)       - byte offset in the file.
+                     id (const char *)    - the identifier to check for.
+   Return Value:     (int) - TRUE if the identifier is there, FALSE
+                     otherwise.
+
+   Input:            A block of the file may be read from the hard drive.
+   Output:           None.
+
+   Error Handling:   Errors set probe_error (see probe_byte()) and the
+                     identifier doesn't match.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: probe_error - accessed to check for an error.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  probe_match(long int pos, const char *id)
+{
+    /* variables */
+    int  match = TRUE;          /* the identifier matches */
+
+    int  i;                     /* loop index */
+
+
+
+    /* check each character */
+    for (i = 0; match && (id[i] != '\0'); i++)
+        match = (probe_byte(pos + i) == (unsigned char) id[i]);
+
+
+    /* return whether it matched (and could be read) */
+    return  (match && !probe_error);
+
+}
+
+
+
+
+/*
+   probe_syncsafe
+
+   Description:      This function returns the syncsafe long int (7 bits in
+                     each byte, most significant byte first) at the passed
+                     position in the current file for probe_track().
+
+   Arguments:        pos (long int) - byte offset in the file.
+   Return Value:     (long int) - the long int at that position.
+
+   Input:            A block of the file may be read from the hard drive.
+   Output:           None.
+
+   Error Handling:   Errors set probe_error (see probe_byte()).
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  long int  probe_syncsafe(long int pos)
+{
+    /* variables */
+    long int  value = 0;        /* the long int */
+
+    int       i;                /* loop index */
+
+
+
+    /* put the 7 bit pieces together, most significant first */
+    for (i = 0; i < 4; i++)
+        value = (value << 7) | (probe_byte(pos + i) & 0x7F);
+
+
+    /* return the value */
+    return  value;
+
+}
+
+
+
+
+/*
+   probe_id3v2
+
+   Description:      This function gets the title (TIT2), artist (TPE1),
+                     and length (TLEN) from the frames of the ID3v2 tag at
+                     the start of the current file for probe_track().  The
+                     frames are walked from the start of the tag, skipping
+                     the ones that aren't wanted (like cover art) by their
+                     sizes, until all three are found or the end of the
+                     tag, its padding, or the first ID3V2_PROBE_BLOCKS
+                     blocks of the file is reached (so at most those blocks
+                     are read).  Versions 2.2 (TT2, TP1, and TLE), 2.3, and
+                     2.4 are handled.  Unsynchronized tags and compressed or
+                     encrypted frames are not read.
+
+   Arguments:        info (struct track_header *) - track information in
+                                   which to store the title and artist.
+                     tag_end (long int) - where the tag's frames end.
+   Return Value:     (long int) - the length of the track (in ms) from the
+                     tag, 0 if it doesn't have it.
+
+   Input:            The start of the file may be read from the hard drive.
+   Output:           None.
+
+   Error Handling:   A read error or frames that don't fit in the tag stop
+                     the search.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: probe_error - accessed to check for an error.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  long int  probe_id3v2(struct track_header *info, long int tag_end)
+{
+    /* variables */
+    char      length[12];       /* text of the length frame */
+
+    int       version;          /* major version of the tag */
+    int       hdr_size;         /* size of a frame header */
+    int       skip;             /* frame contents can't be read */
+
+    long int  pos;              /* position of the frame */
+    long int  size;             /* size of the frame contents */
+    long int  ms = 0;           /* length from the tag */
+
+    int       found = 0;        /* number of wanted frames found */
+    int       i;                /* loop index */
+
+
+
+    /* get the version and the frame header size for it */
+    version = probe_byte(ID3V2_VERSION);
+    hdr_size = (version == 2) ? ID3V22_FRAME_HEADER : ID3V2_FRAME_HEADER;
+
+    /* frames start after the header (and any extended header) */
+    pos = ID3V2_HEADER_SIZE;
+    if ((probe_byte(ID3V2_FLAGS) & ID3V2_EXTENDED) != 0)  {
+        /* the extended header size doesn't include itself in v2.3 */
+        if (version == 3)
+            pos += 4 + probe_long(pos);
+        else
+            pos += probe_syncsafe(pos);
+    }
+
+    /* only search the start of the file */
+    if (tag_end > (ID3V2_PROBE_BLOCKS * 2L * IDE_BLOCK_SIZE))
+        tag_end = ID3V2_PROBE_BLOCKS * 2L * IDE_BLOCK_SIZE;
+
+    /* can't read unsynchronized tags or versions that aren't known */
+    if (((probe_byte(ID3V2_FLAGS) & ID3V2_UNSYNC) != 0) || (version < 2) || (version > 4))
+        tag_end = 0;
+
+
+    /* walk the frames until find them all or reach the end */
+    while (!probe_error && (found < 3) && ((pos + hdr_size) <= tag_end))  {
+
+        /* get the frame size */
+        if (version == 2)  {
+            /* v2.2 has 3 character identifiers and 3 byte sizes */
+            size = probe_long(pos + 2) & 0x00FFFFFFL;
+            skip = FALSE;
+        }
+        else  {
+            /* v2.3 and v2.4 have 4 character identifiers, the size is */
+            /*    syncsafe in v2.4 */
+            if (version == 4)
+                size = probe_syncsafe(pos + ID3V2_FRAME_SIZE);
+            else
+                size = probe_long(pos + ID3V2_FRAME_SIZE);
+            /* check for frames that can't be read directly */
+            if (version == 4)
+                skip = ((probe_byte(pos + ID3V2_FRAME_FLAGS) & ID3V24_SKIP_FLAGS) != 0);
+            else
+                skip = ((probe_byte(pos + ID3V2_FRAME_FLAGS) & ID3V23_SKIP_FLAGS) != 0);
+        }
+
+        /* padding (no identifier) or a bad size is the end of the frames */
+        if ((probe_byte(pos) == '\0') || (size <= 0) || (size > (tag_end - pos)))  {
+            /* done, stop the search */
+            tag_end = 0;
+        }
+        else  {
+            /* check for the wanted frames */
+            if (!skip && probe_match(pos, (version == 2) ? "TT2" : "TIT2"))  {
+                /* the title */
+                probe_text(pos + hdr_size, size, info->title, MAX_TITLE_LEN);
+                found++;
+            }
+            else if (!skip && probe_match(pos, (version == 2) ? "TP1" : "TPE1"))  {
+                /* the artist */
+                probe_text(pos + hdr_size, size, info->artist, MAX_ARTIST_LEN);
+                found++;
+            }
+            else if (!skip && probe_match(pos, (version == 2) ? "TLE" : "TLEN"))  {
+                /* the length in ms (as text) */
+                probe_text(pos + hdr_size, size, length, sizeof(length));
+                for (i = 0; (length[i] >= '0') && (length[i] <= '9'); i++)
+                    ms = (10 * ms) + (length[i] - '0');
+                found++;
+            }
+
+            /* on to the next frame */
+            pos += hdr_size + size;
+        }
+    }
+
+
+    /* return the length from the tag */
+    return  ms;
+
+}
+
+
+
+
+/*
+   probe_text
+
+   Description:      This function copies the text of an ID3v2 text frame in
+                     the current file into the passed string for
+                     probe_track().  The first byte of the frame is the
+                     text encoding, ISO-8859-1, UTF-16 (with a byte order
+                     mark or big-endian), and UTF-8 are handled.  Characters
+                     that aren't ASCII are replaced by '?'.  The text ends
+                     at the end of the frame or a <null> character and is
+                     cut short if it doesn't fit.
+
+   Arguments:        pos (long int)  - byte offset of the frame contents.
+                     size (long int) - size of the frame contents.
+                     s (char *)      - string in which to store the text.
+                     max (int)       - size of the string (including the
+                                       <null> terminator).
+   Return Value:     None.
+
+   Input:            A block of the file may be read from the hard drive.
+   Output:           None.
+
+   Error Handling:   Errors set probe_error (see probe_byte()).
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  probe_text(long int pos, long int size, char *s, int max)
+{
+    /* variables */
+    int            encoding;        /* text encoding */
+    int            big_endian;      /* UTF-16 is big-endian */
+
+    unsigned int   c;               /* character from the frame */
+    long int       end;             /* end of the frame */
+
+    int            n = 0;           /* characters stored */
+    int            done = FALSE;    /* reached the end of the text */
+
+
+
+    /* get the encoding and the end of the text */
+    encoding = probe_byte(pos++);
+    end = pos + size - 1;
+
+    /* UTF-16 may start with a byte order mark (default big-endian) */
+    big_endian = TRUE;
+    if ((encoding == ID3_ENC_UTF16) && ((pos + 1) < end))  {
+        if ((probe_byte(pos) == 0xFF) && (probe_byte(pos + 1) == 0xFE))  {
+            big_endian = FALSE;
+            pos += 2;
+        }
+        else if ((probe_byte(pos) == 0xFE) && (probe_byte(pos + 1) == 0xFF))  {
+            pos += 2;
+        }
+    }
+
+
+    /* copy characters until the end of the text or the string is full */
+    while (!done && !probe_error && (pos < end) && (n < (max - 1)))  {
+
+        /* get the next character */
+        if ((encoding == ID3_ENC_UTF16) || (encoding == ID3_ENC_UTF16BE))  {
+            /* two bytes a character */
+            if (big_endian)
+                c = (probe_byte(pos) << 8) | probe_byte(pos + 1);
+            else
+                c = probe_byte(pos) | (probe_byte(pos + 1) << 8);
+            pos += 2;
+        }
+        else  {
+            /* one byte a character */
+            c = probe_byte(pos++);
+        }
+
+        /* store the character, the text stops at a <null> */
+        /* (UTF-8 continuation bytes are part of the last character) */
+        if (c == 0)
+            done = TRUE;
+        else if (c < 0x80)
+            s[n++] = (char) c;
+        else if ((encoding != ID3_ENC_UTF8) || ((c & 0xC0) != 0x80))
+            s[n++] = '?';
+    }
+
+    /* terminate the string */
+    s[n] = '\0';
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   toc_time
+
+   Description:      This function returns the time at the passed position
+                     on the current track from the track's seek table.  The
+                     table has the position (in 256ths of the audio, from
+                     the track start to the track length) at each percent
+                     of the track's time, the time is interpolated between
+                     the entries around the position.
+
+   Arguments:        toc (const unsigned char *) - the seek table.
+                     pos (long int)              - byte offset on the track.
+   Return Value:     (long int) - time (in ms) at that position.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       Linear interpolation.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  long int  toc_time(const unsigned char *toc, long int pos)
+{
+    /* variables */
+    unsigned int  total;        /* total time of the track */
+
+    long int      start;        /* start of the audio */
+    long int      x;            /* position in table units (times TOC_FRAC) */
+    long int      a;            /* table position at or before x */
+    long int      b;            /* table position after a */
+    long int      pct;          /* time in percent (times TOC_FRAC) */
+
+    int           i = 0;        /* index into the table */
+
+
+
+    /* get the total time and the position in table units (the table */
+    /*    covers the audio, not any ID3v2 tag before it) */
+    total = get_track_total_time();
+    start = get_track_start();
+    if ((pos > start) && (get_track_length() > start))
+        x = scale_long(pos - start, TOC_SCALE * TOC_FRAC, get_track_length() - start);
+    else
+        x = 0;
+
+    /* find the last entry at or before the position */
+    while ((i < (SEEK_TOC_SIZE - 1)) && ((toc[i + 1] * TOC_FRAC) <= x))
+        i++;
+
+    /* get the positions of the entry and the next one (the end of track) */
+    a = toc[i] * TOC_FRAC;
+    if (i < (SEEK_TOC_SIZE - 1))
+        b = toc[i + 1] * TOC_FRAC;
+    else
+        b = TOC_SCALE * TOC_FRAC;
+
+    /* interpolate the percent between them */
+    pct = i * TOC_FRAC;
+    if ((b > a) && (x > a))
+        pct += scale_long(x - a, TOC_FRAC, b - a);
+    /* can't be past the end */
+    if (pct > (SEEK_TOC_SIZE * TOC_FRAC))
+        pct = SEEK_TOC_SIZE * TOC_FRAC;
+
+
+    /* return the percent of the total time */
+    return  scale_long(pct, total * TIME_SCALE, SEEK_TOC_SIZE * TOC_FRAC);
+
+}
+
+
+
+
+/*
+   toc_pos
+
+   Description:      This function returns the position on the current track
+                     at the passed time from the track's seek table.  It is
+                     the inverse of toc_time(), the position is interpolated
+                     between the entries around the time.
+
+   Arguments:        toc (const unsigned char *) - the seek table.
+                     time (long int)             - time (in ms) on the track.
+   Return Value:     (long int) - byte offset (in the file) at that time.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   Times past the end of the track return the end.
+
+   Algorithms:       Linear interpolation.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  long int  toc_pos(const unsigned char *toc, long int time)
+{
+    /* variables */
+    unsigned int  total;        /* total time of the track */
+
+    long int      pct;          /* time in percent (times TOC_FRAC) */
+    long int      a;            /* table position at the percent */
+    long int      b;            /* table position at the next percent */
+    long int      pos;          /* position at the time */
+
+    int           i;            /* index into the table */
+
+
+
+    /* get the total time and the time in percent */
+    total = get_track_total_time();
+    pct = scale_long(time, SEEK_TOC_SIZE * TOC_FRAC, total * TIME_SCALE);
+
+    /* check if past the end of the table */
+    if (pct >= (SEEK_TOC_SIZE * TOC_FRAC))  {
+        /* it is, that's the end of the track */
+        pos = get_track_length();
+    }
+    else  {
+        /* get the entry and the next one (or the end of the track) */
+        i = (int) (pct / TOC_FRAC);
+        a = toc[i];
+        if (i < (SEEK_TOC_SIZE - 1))
+            b = toc[i + 1];
+        else
+            b = TOC_SCALE;
+
+        /* interpolate between them and scale to the audio (which */
+        /*    starts at the track start) */
+        pos = get_track_start() +
+              scale_long((a * TOC_FRAC) + ((b - a) * (pct % TOC_FRAC)),
+                         get_track_length() - get_track_start(), TOC_SCALE * TOC_FRAC);
+    }
+
+
+    /* return the position */
+    return  pos;
+
+}
@@ -0,0 +1,135 @@
+/****************************************************************************/
+/*                                                                          */
+/*                               FRAMEIDX.H                                 */
+/*                          MP3 Frame Index Functions                       */
+/*                              Include File                                */
+/*                           MP3 Jukebox Project                            */
+/*                                EE/CS 52                                  */
+/*                                                                          */
+/****************************************************************************/
+
+/*
+   This file contains the constants and function prototypes for the MP3
+   frame index functions defined in frameidx.c.  The frame index is a sparse
+   table of the times and byte offsets of frames in the current track, built
+   from the frame headers as the track's data is read for playing.  It is
+   used to convert between track positions and times and to seek to a time.
+   The track's length in time, frame count, bit rate, and seek table are
+   probed from its first frame (Xing/Info, VBRI, or the frame header itself
+   for constant bit rate tracks) when the track is selected, along with the
+   title, artist, and length from an ID3v2 tag at the start of the track.
+
+
+   Revision History
+      6/16/16  Tim Liu           Initial revision.
+      6/16/16  Tim Liu           Added probe_track() and the Xing and VBRI
+                                 header constants.
+      6/16/16  Tim Liu           Added the ID3v2 frame constants.
+      6/16/16  Tim Liu           Added frame_header().
+*/
+
+
+
+
+#ifndef  I__FRAMEIDX_H__
+    #define  I__FRAMEIDX_H__
+
+
+/* library include files */
+  /* none */
+
+/* local include files */
+#include  "mp3defs.h"
+
+
+
+
+/* constants */
+
+/* number of entries in the frame index */
+#define  FRAME_INDEX_SIZE     128
+
+/* starting time (in ms) between frame index entries */
+/*    the time doubles each time the index fills up */
+#define  FRAME_INDEX_STEP     1000L
+
+/* bytes played per ms if there is no other way to tell (128 kbps) */
+#define  DEF_BYTES_PER_MS     16
+
+/* MPEG audio frame header */
+#define  FRAME_HEADER_SIZE    4         /* bytes in a frame header */
+#define  FRAME_SYNC           0xFF      /* first byte of a frame header */
+#define  FRAME_SYNC_MASK      0xE0      /* rest of the sync in the second byte */
+#define  FRAME_MATCH_MASK     0xFE      /* version and layer in the second byte */
+#define  FRAME_RATE_MASK      0x0C      /* sample rate bits in the third byte */
+
+/* ID3v2 tag header (the tag comes before the first frame) */
+#define  ID3V2_HEADER_SIZE    10        /* bytes in the tag header */
+#define  ID3V2_FLAGS          5         /* offset of the tag flags */
+#define  ID3V2_FOOTER         0x10      /* flag for a footer after the tag */
+#define  ID3V2_SIZE           6         /* offset of the (syncsafe) tag size */
+#define  ID3V2_VERSION        3         /* offset of the major version */
+#define  ID3V2_UNSYNC         0x80      /* flag for an unsynchronized tag */
+#define  ID3V2_EXTENDED       0x40      /* flag for an extended header */
+
+/* ID3v2 frames (only the first blocks of a tag are searched for them) */
+#define  ID3V2_PROBE_BLOCKS   2         /* blocks of the tag searched */
+#define  ID3V22_FRAME_HEADER  6         /* bytes in a v2.2 frame header */
+#define  ID3V2_FRAME_HEADER   10        /* bytes in a v2.3/v2.4 frame header */
+#define  ID3V2_FRAME_SIZE     4         /* offset of the v2.3/v2.4 frame size */
+#define  ID3V2_FRAME_FLAGS    9         /* offset of the v2.3/v2.4 format flags */
+#define  ID3V23_SKIP_FLAGS    0xE0      /* v2.3 compressed, encrypted, grouped */
+#define  ID3V24_SKIP_FLAGS    0x0F      /* v2.4 compressed, encrypted, etc. */
+#define  ID3_ENC_UTF16        1         /* UTF-16 text with a byte order mark */
+#define  ID3_ENC_UTF16BE      2         /* UTF-16 text, big-endian */
+#define  ID3_ENC_UTF8         3         /* UTF-8 text */
+
+/* bytes searched for the first frame header when probing a track */
+#define  PROBE_SEARCH         (2 * IDE_BLOCK_SIZE)
+
+/* Xing/Info header (after the side information of the first frame) */
+#define  XING_ID              "Xing"    /* identifier for VBR tracks */
+#define  INFO_ID              "Info"    /* identifier for CBR tracks (LAME) */
+#define  XING_ID_SIZE         4         /* bytes in the identifier */
+#define  XING_FRAMES          0x01      /* flag for the frame count */
+#define  XING_BYTES           0x02      /* flag for the byte count */
+#define  XING_TOC             0x04      /* flag for the seek table */
+
+/* side information sizes (the Xing header follows it) */
+#define  SIDE_MPEG1_STEREO    32        /* MPEG 1 stereo */
+#define  SIDE_MPEG1_MONO      17        /* MPEG 1 mono */
+#define  SIDE_MPEG2_STEREO    17        /* MPEG 2/2.5 stereo */
+#define  SIDE_MPEG2_MONO      9         /* MPEG 2/2.5 mono */
+
+/* VBRI header (always 32 bytes after the first frame header) */
+#define  VBRI_ID              "VBRI"    /* identifier */
+#define  VBRI_OFFSET          32        /* offset after the frame header */
+#define  VBRI_BYTES           10        /* offset of the byte count */
+#define  VBRI_FRAMES          14        /* offset of the frame count */
+
+
+
+
+/* structures, unions, and typedefs */
+    /* none */
+
+
+
+
+/* function declarations */
+
+/* track probing function */
+unsigned int  probe_track(struct track_header *);   /* get time and seek table of the current track */
+
+/* frame header function */
+int       frame_header(const unsigned char *, int *, long int *, int *);    /* get frame length */
+
+/* index building function */
+void      index_frames(const unsigned short int far *, int, long int);  /* index frames in track data */
+
+/* index lookup functions */
+long int  frame_time(long int);         /* get the time (in ms) at a track position */
+long int  seek_frame(long int *);       /* get the track position of a time (in ms) */
+
+
+#endif
@@ -0,0 +1,106 @@
+/****************************************************************************/
+/*                                                                          */
+/*                                  HOST.H                                  */
+/*                        Linux Host Simulation Functions                   */
+/*                              Include File                                */
+/*                           MP3 Jukebox Project                            */
+/*                                EE/CS 52                                  */
+/*                                                                          */
+/****************************************************************************/
+
+/*
+   This file contains the constants and function prototypes for the Linux
+   host build of the MP3 Jukebox (compiled with LINUX defined).  In the host
+   build the hardware functions are simulated: the hard drive is a FAT disk
+   image file (hostide.c), the MP3 decoder takes data as a simulated VS1011
+   plays it at the bit rate of the track (hostaud.c), and the keypad,
+   display, and timer are a key script, lines of output, and a virtual
+   clock (hostsys.c).  Time on the
+   host is virtual, it only moves forward when the simulated hardware says
+   time has passed, so runs are repeatable and don't depend on the speed of
+   the host.
+
+
+   Revision History
+      6/16/16  Tim Liu           Initial revision.
+      6/16/16  Tim Liu           Added the simulated decoder FIFO size and
+                                 host_show() and audio_report().
+      6/16/16  Tim Liu           Added the disk profile functions and
+                                 HOST_POLL_TIME.
+      6/16/16  Tim Liu           Added disk_totals() and audio_started().
+      6/17/16  Tim Liu           Added host_key_time().
+*/
+
+
+
+
+#ifndef  I__HOST_H__
+    #define  I__HOST_H__
+
+
+/* library include files */
+  /* none */
+
+/* local include files */
+  /* none */
+
+
+
+
+/* constants */
+
+/* time (in us) the main loop takes each time around (checking for a key) */
+#define  HOST_LOOP_TIME       100
+
+/* time (in us) each poll of a disk read in progress takes */
+#define  HOST_POLL_TIME       10
+
+/* block a bare FAT volume (no partition table) appears at in the image */
+#define  BARE_VOLUME_START    64
+
+/* simulated MP3 decoder */
+#define  DREQ_BYTES           32        /* bytes sent for each data request */
+#define  DECODER_FIFO_SIZE    2048      /* bytes in the decoder input FIFO */
+#define  DECODER_FRAMES       64        /* most frames that fit in the FIFO */
+#define  HOST_QUEUE_SIZE      16        /* descriptors in the audio queue */
+#define  HOST_LOW_WATER       0         /* queue low at this many descriptors */
+#define  HOST_END_TRACK       1         /* descriptor flag - buffer ends a track */
+
+/* longest line in a key script or disk profile */
+#define  MAX_SCRIPT_LINE      128
+
+
+
+
+/* structures, unions, and typedefs */
+    /* none */
+
+
+
+
+/* function declarations */
+
+/* setup function */
+int   host_init(int, char *[]);         /* setup the simulated hardware */
+
+/* virtual clock functions */
+long long int  host_time(void);         /* get the virtual time (in us) */
+long long int  host_key_time(void);     /* get the time of the last key */
+void  host_advance(long int);           /* move the virtual time forward */
+
+/* disk image functions */
+int   open_image(const char *);         /* open the disk image file */
+int   read_profile(const char *);       /* read the disk profile */
+void  disk_report(void);                /* output the disk totals for the run */
+void  disk_totals(long int *, long int *);  /* get the reads and blocks so far */
+
+/* display function */
+void  host_show(const char *, const char *);    /* output a display line */
+
+/* simulated MP3 decoder functions */
+void  audio_run(long long int);         /* run the decoder to the passed time */
+void  audio_report(void);               /* output the totals for the run */
+int   audio_started(void);              /* audio started since play */
+
+
+#endif
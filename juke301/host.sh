@@ -0,0 +1,14 @@
+cc -c -O2 -DLINUX fatutil.c
+cc -c -O2 -DLINUX ffrev.c
+cc -c -O2 -DLINUX frameidx.c
+cc -c -O2 -DLINUX keyupdat.c
+cc -c -O2 -DLINUX mainloop.c
+cc -c -O2 -DLINUX playmp3.c
+cc -c -O2 -DLINUX trakutil.c
+cc -c -O2 -DLINUX hostaud.c
+cc -c -O2 -DLINUX hostide.c
+cc -c -O2 -DLINUX hostsys.c
+
+cc -o juke fatutil.o ffrev.o frameidx.o keyupdat.o mainloop.o playmp3.o trakutil.o hostaud.o hostide.o hostsys.o
+
+cc -O2 -DLINUX -o mkimage mkimage.c frameidx.o
@@ -0,0 +1,1106 @@
+/****************************************************************************/
+/*                                                                          */
+/*                                 HOSTAUD                                  */
+/*                      Simulated Audio Functions (Host)                    */
+/*                           MP3 Jukebox Project                            */
+/*                                EE/CS 52                                  */
+/*                                                                          */
+/****************************************************************************/
+
+/*
+   This file contains the audio output functions for the Linux host build
+   of the MP3 Jukebox.  The VS1011 MP3 decoder is simulated on the virtual
+   clock.  The decoder has a DECODER_FIFO_SIZE byte input FIFO and asks for
+   data (DREQ) whenever there is room in it for DREQ_BYTES more.  The data
+   requests are handled the same way as the event handler in audio.asm
+   handles them, taking buffers from a queue of buffer descriptors.  The
+   MPEG frame headers are found in the data as it goes into the FIFO and
+   each frame is taken out of the FIFO and played for its real time (its
+   samples over its sample rate), so data is used at the track's bit rate.
+   Data that isn't part of a frame is skipped right away.  If the decoder
+   runs out of frames in the middle of a track it is an underrun (a gap in
+   the audio); each one is output with its time and length.  The time from
+   the key that started play to the first frame of the new data (so it
+   includes the first read of the track) is output too.  The
+   functions included are:
+      audio_done    - get the number of buffers output since the last call
+      audio_halt    - halt the audio output
+      audio_low     - check if the audio queue ran low since the last call
+      audio_play    - start the audio output
+      audio_queue   - queue a buffer for audio output
+      audio_report  - output the totals for the run
+      audio_run     - run the decoder up to the passed time
+      audio_started - check if the audio has started since play
+      update        - queue a buffer for audio output (not ending a track)
+
+   The local functions included are:
+      audio_output   - send one data request's worth of data to the decoder
+      decoder_ready  - check if the decoder is asking for data
+      decoder_take   - put data into the decoder FIFO
+      queue_add      - add a buffer descriptor to the audio queue
+      start_frame    - start playing the frame at the head of the FIFO
+
+   The locally global variable definitions included are:
+      audio_on       - data requests are being handled
+      cur_active     - a buffer is being played
+      cur_buffer     - the data left in the buffer being played
+      cur_flags      - flags of the buffer being played
+      cur_left       - bytes left in the buffer being played
+      dec_time       - virtual time the decoder has been run to
+      decoding       - the decoder is playing a frame
+      done_count     - buffers played since the last audio_done() call
+      fifo_bytes     - bytes of frames in the decoder FIFO
+      first_count    - times play was started
+      first_max      - longest time to the first frame
+      first_total    - total time to the first frame
+      first_wait     - waiting for the first frame of the new data
+      frame_count    - frames in the decoder FIFO
+      frame_end      - virtual time the frame playing ends
+      frame_head     - the next frame to play
+      frame_left     - bytes of the last frame still to come
+      frames         - the frames in the decoder FIFO
+      hdr            - frame header bytes being collected
+      hdr_have       - number of header bytes collected
+      in_track       - playing a track (not stopped)
+      low            - audio queue ran low since the last audio_low() call
+      mark_next      - next frame found is the first of the new data
+      play_start     - virtual time of the key that started play
+      queue          - the queue of buffer descriptors
+      queue_count    - descriptors in the queue
+      queue_head     - the next descriptor to be played
+      queue_tail     - where the next descriptor is added
+      starve_start   - virtual time the decoder ran out of frames
+      track_end      - all of the track has been sent to the decoder
+      underrun_count - number of underruns
+      underrun_max   - longest underrun
+      underrun_total - total time of the underruns
+
+
+   Revision History
+      6/16/16  Tim Liu           Initial revision.
+      6/16/16  Tim Liu           The decoder uses the data at the bit rate of
+                                 the frames in it (instead of a fixed rate)
+                                 through a simulated FIFO, and underruns and
+                                 the time to the first frame are output.
+                                 Added update() and audio_report().
+      6/16/16  Tim Liu           Added audio_started() for benchmarks.
+      6/17/16  Tim Liu           The time to the first frame is from the key
+                                 that started play, not from audio_play()
+                                 (which is after the first read).
+*/
+
+
+
+/* library include files */
+#include  <stdio.h>
+
+/* local include files */
+#include  "mp3defs.h"
+#include  "frameidx.h"
+#include  "host.h"
+
+
+
+
+/* local definitions */
+#define  NO_TIME         (-1LL)         /* no time saved */
+
+
+
+
+/* structures, unions, and typedefs */
+
+/* a buffer descriptor in the audio queue */
+struct  audio_desc  {
+                       unsigned short int  *p;      /* the buffer data */
+                       long int             bytes;  /* bytes in the buffer */
+                       int                  flags;  /* descriptor flags */
+                    };
+
+/* a frame in the decoder FIFO */
+struct  dec_frame  {
+                      long int  bytes;      /* bytes in the frame */
+                      long int  play;       /* time (in us) the frame plays */
+                      int       mark;       /* first frame of the new data */
+                   };
+
+
+
+
+/* local function declarations */
+static  void  audio_output(void);                   /* handle a data request */
+static  int   decoder_ready(void);                  /* decoder wants data */
+static  void  decoder_take(const unsigned short int *, long int);  /* decoder gets data */
+static  int   queue_add(unsigned short int *, int, int);    /* queue a buffer */
+static  void  start_frame(void);                    /* decoder starts a frame */
+
+
+
+
+/* locally global variables */
+
+/* audio queue (the same as audio.asm) */
+static  struct audio_desc    queue[HOST_QUEUE_SIZE];    /* the audio queue */
+static  int                  queue_head;        /* next descriptor to play */
+static  int                  queue_tail;        /* where the next one goes */
+static  int                  queue_count;       /* descriptors in the queue */
+
+static  unsigned short int  *cur_buffer;        /* data left in current buffer */
+static  long int             cur_left;          /* bytes left in current buffer */
+static  int                  cur_flags;         /* flags of current buffer */
+static  int                  cur_active;        /* playing the current buffer */
+
+static  int                  done_count;        /* buffers played */
+static  int                  low;               /* queue ran low */
+static  int                  audio_on;          /* handling data requests */
+
+/* the decoder */
+static  struct dec_frame     frames[DECODER_FRAMES];    /* frames in the FIFO */
+static  int                  frame_head;        /* next frame to play */
+static  int                  frame_count;       /* frames in the FIFO */
+static  long int             fifo_bytes;        /* bytes of frames in the FIFO */
+static  long int             frame_left;        /* bytes of last frame to come */
+static  unsigned char        hdr[FRAME_HEADER_SIZE];    /* header being collected */
+static  int                  hdr_have;          /* header bytes collected */
+
+static  long long int        dec_time;          /* time decoder has run to */
+static  int                  decoding;          /* playing a frame */
+static  long long int        frame_end;         /* time the frame ends */
+
+/* underruns and starting play */
+static  int                  in_track;          /* playing a track */
+static  int                  track_end;         /* all of the track was sent */
+static  long long int        starve_start = NO_TIME;    /* ran out of frames */
+static  long int             underrun_count;    /* number of underruns */
+static  long long int        underrun_total;    /* total underrun time */
+static  long long int        underrun_max;      /* longest underrun */
+
+static  int                  mark_next;         /* mark the next frame found */
+static  int                  first_wait;        /* waiting for the first frame */
+static  long long int        play_start;        /* time of the play key */
+static  long int             first_count;       /* times play was started */
+static  long long int        first_total;       /* total time to first frame */
+static  long long int        first_max;         /* longest time to first frame */
+
+
+
+
+/*
+   audio_play
+
+   Description:      This function starts the audio output with the passed
+                     buffer.  The audio queue is emptied and the done count
+                     and low flag are cleared.  The decoder drops any partial
+                     frame left from the old data (it resyncs on the new
+                     data) but keeps playing the whole frames in its FIFO.
+                     The time to the first frame of the new data is timed
+                     from the key that started play (audio_play() is only
+                     called when a key starts play, after the first read).
+
+   Arguments:        p (unsigned short int far *) - buffer to play.
+                     n (int)                      - length of the buffer in
+                                                    words.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: audio_on     - set.
+                     cur_active   - set.
+                     cur_buffer   - set to the passed buffer.
+                     cur_flags    - cleared (not the end of the track).
+                     cur_left     - set to the bytes in the passed buffer.
+                     done_count   - cleared.
+                     fifo_bytes   - partial frame removed.
+                     first_wait   - set.
+                     frame_count  - partial frame removed.
+                     frame_left   - cleared.
+                     hdr_have     - cleared.
+                     in_track     - set.
+                     low          - cleared.
+                     mark_next    - set.
+                     play_start   - set to the time of the last key.
+                     queue_count  - cleared (queue is empty).
+                     queue_head   - reset to start of queue.
+                     queue_tail   - reset to start of queue.
+                     starve_start - cleared.
+                     track_end    - cleared.
+
+   Author:           Tim Liu
+   Last Modified:    June 17, 2016
+
+*/
+
+void  audio_play(unsigned short int far *p, int n)
+{
+    /* variables */
+    int  last;                  /* last frame in the FIFO */
+
+
+
+    /* play the passed buffer, it isn't the end of the track */
+    cur_buffer = p;
+    cur_left = 2L * n;
+    cur_flags = 0;
+    cur_active = TRUE;
+
+    /* nothing is queued behind it */
+    queue_head = 0;
+    queue_tail = 0;
+    queue_count = 0;
+    done_count = 0;
+    low = FALSE;
+
+
+    /* the decoder drops a partial frame, it can't be finished */
+    if (frame_left > 0)  {
+        last = (frame_head + frame_count - 1) % DECODER_FRAMES;
+        fifo_bytes -= frames[last].bytes - frame_left;
+        frame_count--;
+        frame_left = 0;
+    }
+    hdr_have = 0;
+
+    /* time how long until the new data is heard */
+    in_track = TRUE;
+    track_end = FALSE;
+    starve_start = NO_TIME;
+    mark_next = TRUE;
+    first_wait = TRUE;
+    play_start = host_key_time();
+
+
+    /* and the decoder can ask for data now */
+    audio_on = TRUE;
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   audio_halt
+
+   Description:      This function halts the audio output.  No more data
+                     requests are handled until a buffer is queued or the
+                     audio is started again.  The decoder plays what is in
+                     its FIFO and running out isn't an underrun.
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: audio_on     - cleared.
+                     in_track     - cleared.
+                     starve_start - cleared.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  audio_halt()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* stop handling data requests, no longer playing a track */
+    audio_on = FALSE;
+    in_track = FALSE;
+    starve_start = NO_TIME;
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   update
+
+   Description:      This function adds the passed buffer to the audio queue
+                     if there is room in the queue, the same as Update in
+                     audio.asm.  The buffer is not the end of a track.
+
+   Arguments:        p (unsigned short int far *) - buffer to queue.
+                     n (int)                      - length of the buffer in
+                                                    words.
+   Return Value:     (unsigned char) - TRUE if the buffer was queued, FALSE
+                     if the queue is full.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+unsigned char  update(unsigned short int far *p, int n)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* queue the buffer with no flags */
+    return  queue_add(p, n, 0);
+
+}
+
+
+
+
+/*
+   audio_queue
+
+   Description:      This function adds the passed buffer to the audio queue
+                     if there is room in the queue.  The third argument is
+                     TRUE if the buffer is the last one of a track so running
+                     out of data after it is not an underrun.
+
+   Arguments:        p (unsigned short int far *) - buffer to queue.
+                     n (int)                      - length of the buffer in
+                                                    words.
+                     end (int)                    - TRUE if the buffer ends
+                                                    a track.
+   Return Value:     (unsigned char) - TRUE if the buffer was queued, FALSE
+                     if the queue is full.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+unsigned char  audio_queue(unsigned short int far *p, int n, int end)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* queue the buffer with the end of track flag if it ends the track */
+    return  queue_add(p, n, (end ? HOST_END_TRACK : 0));
+
+}
+
+
+
+
+/*
+   audio_done
+
+   Description:      This function returns the number of queued buffers that
+                     have been completely played since the last call (or
+                     since audio_play() was called).
+
+   Arguments:        None.
+   Return Value:     (int) - number of buffers done.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: done_count - returned and cleared.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  audio_done()
+{
+    /* variables */
+    int  done = done_count;     /* buffers done */
+
+
+
+    /* start counting again */
+    done_count = 0;
+
+
+    /* and return the count */
+    return  done;
+
+}
+
+
+
+
+/*
+   audio_low
+
+   Description:      This function returns TRUE if the audio queue has run
+                     low (HOST_LOW_WATER or fewer buffers queued behind the
+                     one playing) or run out of data since the last call and
+                     FALSE otherwise.
+
+   Arguments:        None.
+   Return Value:     (unsigned char) - TRUE if the queue ran low.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: low - returned and cleared.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+unsigned char  audio_low()
+{
+    /* variables */
+    int  was_low = low;         /* queue ran low */
+
+
+
+    /* clear the flag for next time */
+    low = FALSE;
+
+
+    /* and return whether or not the queue ran low */
+    return  was_low;
+
+}
+
+
+
+
+/*
+   audio_run
+
+   Description:      This function runs the decoder up to the passed virtual
+                     time.  The decoder's data requests are handled, frames
+                     are started as the decoder gets to them, and the
+                     decoder running out of frames in the middle of a track
+                     is noted as the start of an underrun.  It is called
+                     whenever the virtual clock moves forward.
+
+   Arguments:        now (long long int) - the virtual time (in us).
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       The events (data requests, frames starting and ending)
+                     are handled in time order.  Data requests are handled
+                     as soon as there is room in the FIFO and the next frame
+                     starts as soon as the last one ends and it is all in
+                     the FIFO.
+   Data Structures:  None.
+
+   Shared Variables: audio_on     - accessed.
+                     dec_time     - updated.
+                     decoding     - updated.
+                     fifo_bytes   - accessed.
+                     first_wait   - accessed.
+                     frame_count  - accessed.
+                     frame_end    - accessed.
+                     frame_head   - accessed.
+                     frames       - accessed.
+                     in_track     - accessed.
+                     starve_start - set when the decoder runs out of frames.
+                     track_end    - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  audio_run(long long int now)
+{
+    /* variables */
+    int  ready;                 /* the next frame is all in the FIFO */
+
+    int  done = FALSE;          /* run up to the passed time */
+
+
+
+    /* handle the events in order until there aren't any more by now */
+    while (!done)  {
+
+        /* send the decoder data as long as it asks for it */
+        while (audio_on && decoder_ready())
+            audio_output();
+
+        /* check if the next frame can be played */
+        ready = (frame_count > 0) && (fifo_bytes >= frames[frame_head].bytes);
+
+        if (!decoding && ready)  {
+            /* decoder is free and has a frame, start it (makes room) */
+            start_frame();
+        }
+        else if (decoding && (frame_end <= now))  {
+            /* the frame finished playing */
+            dec_time = frame_end;
+            decoding = FALSE;
+            /* out of frames in the middle of a track is an underrun */
+            if (!ready && in_track && !track_end && !first_wait)
+                starve_start = dec_time;
+        }
+        else  {
+            /* nothing more happens by now */
+            done = TRUE;
+        }
+    }
+
+    /* the decoder has been run up to now */
+    dec_time = now;
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   audio_report
+
+   Description:      This function outputs the totals for the run: the
+                     number and length of the underruns and the number of
+                     times play was started and the time to the first frame.
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           The totals (as display lines).
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: first_count    - accessed.
+                     first_max      - accessed.
+                     first_total    - accessed.
+                     underrun_count - accessed.
+                     underrun_max   - accessed.
+                     underrun_total - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  audio_report()
+{
+    /* variables */
+    char  s[MAX_SCRIPT_LINE];   /* the line being output */
+
+
+
+    /* output the underrun totals */
+    sprintf(s, "%ld total %.1f ms longest %.1f ms", underrun_count,
+            underrun_total / 1000.0, underrun_max / 1000.0);
+    host_show("underruns", s);
+
+    /* and the time to the first frame */
+    sprintf(s, "%ld average %.1f ms longest %.1f ms", first_count,
+            (first_count == 0) ? 0.0 : (first_total / 1000.0) / first_count,
+            first_max / 1000.0);
+    host_show("starts", s);
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   audio_started
+
+   Description:      This function returns whether or not the first frame
+                     of the data passed to the last audio_play() call has
+                     started playing (TRUE if play was never started).
+
+   Arguments:        None.
+   Return Value:     (int) - TRUE if the audio has started, FALSE if not.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: first_wait - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  audio_started()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* started if not waiting for the first frame */
+    return  !first_wait;
+
+}
+
+
+
+
+/*
+   audio_output
+
+   Description:      This function handles one data request from the
+                     decoder, sending it up to DREQ_BYTES of data.  If the
+                     current buffer is empty it is done and the next buffer
+                     is taken from the audio queue.  If the queue is empty
+                     the audio is halted.
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           The MP3 data to the simulated decoder.
+
+   Error Handling:   Running out of data in the middle of a track sets the
+                     low flag and halts the audio.
+
+   Algorithms:       The same as AudioOutput in audio.asm.
+   Data Structures:  The audio queue is a circular array of descriptors.
+
+   Shared Variables: audio_on    - cleared when out of data.
+                     cur_active  - updated.
+                     cur_buffer  - updated.
+                     cur_flags   - updated.
+                     cur_left    - updated.
+                     done_count  - incremented when a buffer is done.
+                     low         - set when the queue runs low.
+                     queue       - accessed.
+                     queue_count - decremented when a descriptor is taken.
+                     queue_head  - advanced when a descriptor is taken.
+                     track_end   - set when the end of the track is sent.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  audio_output()
+{
+    /* variables */
+    long int  n;                /* bytes sent */
+
+
+
+    /* check if the current buffer is finished */
+    if (cur_left == 0)  {
+
+        /* if it was being played it is done now */
+        if (cur_active)  {
+            done_count++;
+            cur_active = FALSE;
+        }
+
+        /* get the next buffer if there is one */
+        if (queue_count == 0)  {
+            /* nothing to play - running out in a track is an underrun */
+            if (cur_flags & HOST_END_TRACK)
+                track_end = TRUE;
+            else
+                low = TRUE;
+            /* and stop */
+            audio_on = FALSE;
+        }
+        else  {
+            /* take the descriptor at the head of the queue */
+            cur_buffer = queue[queue_head].p;
+            cur_left = queue[queue_head].bytes;
+            cur_flags = queue[queue_head].flags;
+            cur_active = TRUE;
+            queue_head = (queue_head + 1) % HOST_QUEUE_SIZE;
+            queue_count--;
+            /* check if the queue is running low */
+            if (queue_count <= HOST_LOW_WATER)
+                low = TRUE;
+        }
+    }
+
+
+    /* send the data (if there is any) */
+    n = (cur_left < DREQ_BYTES) ? cur_left : DREQ_BYTES;
+    decoder_take(cur_buffer, n);
+    cur_buffer += n / 2;
+    cur_left -= n;
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   decoder_ready
+
+   Description:      This function checks if the decoder is asking for data
+                     (DREQ is high), that is there is room in its FIFO for
+                     DREQ_BYTES more bytes.
+
+   Arguments:        None.
+   Return Value:     (int) - TRUE if the decoder wants data, FALSE if not.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: fifo_bytes - accessed.
+                     hdr_have   - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  decoder_ready()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* the header bytes being collected are in the FIFO too */
+    return  ((DECODER_FIFO_SIZE - fifo_bytes - hdr_have) >= DREQ_BYTES);
+
+}
+
+
+
+
+/*
+   decoder_take
+
+   Description:      This function puts the passed data into the decoder
+                     FIFO.  The frame headers are found in the data and each
+                     frame is added to the frames in the FIFO along with the
+                     time it plays for.  Data that isn't in a frame is
+                     skipped.
+
+   Arguments:        p (const unsigned short int *) - the data.
+                     n (long int)                   - the number of bytes
+                                                      (even).
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       Until a valid header is found the bytes are shifted
+                     through the header one at a time.  Then the rest of the
+                     frame's bytes just go into the FIFO.  The words are
+                     sent low byte first.
+   Data Structures:  The frames are a circular array.
+
+   Shared Variables: fifo_bytes  - updated.
+                     frame_count - incremented when a frame is found.
+                     frame_head  - accessed.
+                     frame_left  - updated.
+                     frames      - frame added when one is found.
+                     hdr         - updated.
+                     hdr_have    - updated.
+                     mark_next   - cleared when a frame is found.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  decoder_take(const unsigned short int *p, long int n)
+{
+    /* variables */
+    unsigned char  b;           /* byte being put in the FIFO */
+
+    int            samples;     /* samples in a frame */
+    long int       rate;        /* sample rate of a frame */
+    int            bit_rate;    /* bit rate of a frame */
+    int            len;         /* length of a frame */
+
+    int            last;        /* where a frame goes in the frames */
+
+    long int       i;           /* general loop indices */
+    int            j;
+
+
+
+    /* put each byte in the FIFO */
+    for (i = 0; i < n; i++)  {
+
+        /* get the byte (low byte of the word first) */
+        b = (p[i / 2] >> (8 * (i % 2))) & 0xFF;
+
+        if (frame_left > 0)  {
+            /* in a frame, it just goes in the FIFO */
+            fifo_bytes++;
+            frame_left--;
+        }
+        else  {
+            /* looking for a header, add it to the header */
+            hdr[hdr_have++] = b;
+
+            /* check if have all of the header */
+            if (hdr_have == FRAME_HEADER_SIZE)  {
+
+                len = frame_header(hdr, &samples, &rate, &bit_rate);
+
+                if (len >= FRAME_HEADER_SIZE)  {
+                    /* it is a frame, add it to the frames in the FIFO */
+                    last = (frame_head + frame_count) % DECODER_FRAMES;
+                    frames[last].bytes = len;
+                    frames[last].play = (1000000L * samples) / rate;
+                    frames[last].mark = mark_next;
+                    frame_count++;
+                    mark_next = FALSE;
+                    /* the header is in the FIFO, the rest comes next */
+                    fifo_bytes += FRAME_HEADER_SIZE;
+                    frame_left = len - FRAME_HEADER_SIZE;
+                    hdr_have = 0;
+                }
+                else  {
+                    /* not a header, skip the first byte and keep looking */
+                    for (j = 1; j < FRAME_HEADER_SIZE; j++)
+                        hdr[j - 1] = hdr[j];
+                    hdr_have--;
+                }
+            }
+        }
+    }
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   queue_add
+
+   Description:      This function adds a buffer descriptor to the tail of
+                     the audio queue if the queue isn't full and turns on
+                     the data requests (in case the audio ran out of data
+                     and halted).
+
+   Arguments:        p (unsigned short int *) - buffer to queue.
+                     n (int)                  - length of the buffer in
+                                                words.
+                     flags (int)              - descriptor flags.
+   Return Value:     (int) - TRUE if the buffer was queued, FALSE if the
+                     queue was full.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  The audio queue is a circular array of descriptors.
+
+   Shared Variables: audio_on    - set.
+                     queue       - descriptor written.
+                     queue_count - incremented.
+                     queue_tail  - advanced.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  queue_add(unsigned short int *p, int n, int flags)
+{
+    /* variables */
+    int  queued = FALSE;        /* buffer was queued */
+
+
+
+    /* make sure there is room in the queue */
+    if (queue_count < HOST_QUEUE_SIZE)  {
+
+        /* there is, write the descriptor at the tail */
+        queue[queue_tail].p = p;
+        queue[queue_tail].bytes = 2L * n;
+        queue[queue_tail].flags = flags;
+        queue_tail = (queue_tail + 1) % HOST_QUEUE_SIZE;
+        queue_count++;
+
+        /* and make sure the data requests are on */
+        audio_on = TRUE;
+        queued = TRUE;
+    }
+
+
+    /* return whether or not the buffer was queued */
+    return  queued;
+
+}
+
+
+
+
+/*
+   start_frame
+
+   Description:      This function starts the decoder playing the frame at
+                     the head of the FIFO, taking it out of the FIFO.  If it
+                     is the first frame of new data the time since play was
+                     started is output and if it ends an underrun the length
+                     of the underrun is output.
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           The time to the first frame or the underrun (as
+                     display lines).
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  The frames are a circular array.
+
+   Shared Variables: dec_time       - accessed.
+                     decoding       - set.
+                     fifo_bytes     - frame removed.
+                     first_count    - incremented for a first frame.
+                     first_max      - updated for a first frame.
+                     first_total    - updated for a first frame.
+                     first_wait     - cleared for a first frame.
+                     frame_count    - decremented.
+                     frame_end      - set to when the frame ends.
+                     frame_head     - advanced.
+                     frames         - accessed.
+                     play_start     - accessed.
+                     starve_start   - cleared.
+                     underrun_count - incremented for an underrun.
+                     underrun_max   - updated for an underrun.
+                     underrun_total - updated for an underrun.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  start_frame()
+{
+    /* variables */
+    long long int  t;           /* time to the first frame or of an underrun */
+
+    char           s[MAX_SCRIPT_LINE];  /* the line being output */
+
+
+
+    /* take the frame out of the FIFO and play it */
+    fifo_bytes -= frames[frame_head].bytes;
+    decoding = TRUE;
+    frame_end = dec_time + frames[frame_head].play;
+
+
+    /* check if it is the first frame of new data */
+    if (frames[frame_head].mark && first_wait)  {
+        /* it is, output and total the time to get to it */
+        t = dec_time - play_start;
+        first_count++;
+        first_total += t;
+        if (t > first_max)
+            first_max = t;
+        first_wait = FALSE;
+        sprintf(s, "first frame after %.1f ms", t / 1000.0);
+        host_show("audio", s);
+    }
+
+    /* check if it ends an underrun */
+    if (starve_start != NO_TIME)  {
+        /* it does, output and total the underrun */
+        t = dec_time - starve_start;
+        underrun_count++;
+        underrun_total += t;
+        if (t > underrun_max)
+            underrun_max = t;
+        starve_start = NO_TIME;
+        sprintf(s, "%.1f ms gap", t / 1000.0);
+        host_show("underrun", s);
+    }
+
+
+    /* and on to the next frame */
+    frame_head = (frame_head + 1) % DECODER_FRAMES;
+    frame_count--;
+
+
+    /* all done, return */
+    return;
+
+}
@@ -0,0 +1,895 @@
+/****************************************************************************/
+/*                                                                          */
+/*                                 HOSTIDE                                  */
+/*                       Disk Image IDE Functions (Host)                    */
+/*                           MP3 Jukebox Project                            */
+/*                                EE/CS 52                                  */
+/*                                                                          */
+/****************************************************************************/
+
+/*
+   This file contains the IDE hard drive functions for the Linux host build
+   of the MP3 Jukebox.  The hard drive is a raw disk image file which is
+   memory mapped, so the jukebox code can be run against real FAT16 and
+   FAT32 directory trees.  The image can either be a whole disk (with a
+   partition table in the first block) or a bare FAT volume (as made by
+   mkfs.fat), in which case a partition table is faked in block 0 with the
+   volume starting at block BARE_VOLUME_START (as in simide.c).
+
+   Each read takes time on the virtual clock as given by a disk profile:
+   a per-command overhead, a seek (a settle time plus time proportional to
+   the distance moved) and rotational latency when the read doesn't follow
+   on from the last one, a per-block transfer time, and every so often an
+   extra long (slow) read.  Blocking reads move the clock forward by their
+   time, asynchronous reads are busy until the clock gets to their end.
+   Without a profile the reads take no time.  The profile is a file with
+   one parameter on each line (blank lines and lines starting with # are
+   ignored):
+      command <us>     - per-command overhead
+      settle <us>      - minimum seek time (any seek)
+      seek <us>        - seek time across the whole span
+      span <blocks>    - blocks in a full seek (default the image size)
+      rpm <rev/min>    - rotation speed (0 for no rotational latency)
+      transfer <us>    - time to transfer each block
+      slow_rate <n>    - slow reads per 1000 reads
+      slow_time <us>   - extra time for a slow read
+      seed <n>         - seed for the rotational position and slow reads
+   The functions included are:
+      disk_report      - output the disk totals for the run.
+      disk_totals      - get the disk reads and blocks read so far.
+      get_blocks       - retrieve blocks of data from the disk image.
+      get_blocks_poll  - get the result of get_blocks_start().
+      get_blocks_start - start retrieving blocks from the disk image.
+      open_image       - open and map the disk image file.
+      read_profile     - read the disk profile file.
+
+   The local functions included are:
+      disk_random      - get a pseudo-random fraction.
+      disk_time        - get the time a read takes.
+      get_block        - get one block from the disk image.
+      read_blocks      - copy blocks from the disk image.
+
+   The locally global variable definitions included are:
+      bare_type        - partition type of a bare FAT volume
+      blocks_read      - number of blocks read by get_blocks_start()
+      busy_until       - virtual time the disk is busy until
+      head_block       - block after the last one read
+      image            - the mapped disk image
+      image_blocks     - number of blocks in the disk image
+      profile          - the disk profile parameters
+      random_state     - state of the pseudo-random numbers
+      total_blocks     - blocks read
+      total_reads      - read commands
+      total_seeks      - reads that needed a seek
+      total_slow       - slow reads
+      total_time       - time the disk was busy
+      volume_start     - block the disk image starts at
+
+
+   Revision History
+      6/16/16  Tim Liu           Initial revision.
+      6/16/16  Tim Liu           Reads take time on the virtual clock from a
+                                 disk profile (seek, rotation, overhead,
+                                 transfer, and slow reads) and the disk
+                                 totals are output at the end of the run.
+      6/16/16  Tim Liu           Added disk_totals() for benchmark records.
+*/
+
+
+
+/* library include files */
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <fcntl.h>
+#include  <unistd.h>
+#include  <sys/mman.h>
+#include  <sys/stat.h>
+
+/* local include files */
+#include  "mp3defs.h"
+#include  "interfac.h"
+#include  "vfat.h"
+#include  "host.h"
+
+
+
+
+/* local definitions */
+#define  BLOCK_BYTES     (2 * IDE_BLOCK_SIZE)   /* bytes in a block */
+
+/* boot sector offsets used to recognize a bare FAT volume */
+#define  BOOT_SECTOR_SIZE      11       /* offset of bytes per sector */
+#define  BOOT_FAT16_SECTORS    22       /* offset of the FAT16 sectors per FAT */
+#define  BOOT_FAT16_NAME       54       /* offset of the FAT16 FAT name */
+#define  BOOT_FAT32_NAME       82       /* offset of the FAT32 FAT name */
+
+/* word of the partition table signature in the master boot record */
+#define  MBR_SIGNATURE         255
+
+/* disk profile parameters (indices into profile[]) */
+#define  PROF_COMMAND          0        /* per-command overhead (us) */
+#define  PROF_SETTLE           1        /* minimum seek time (us) */
+#define  PROF_SEEK             2        /* seek time across the span (us) */
+#define  PROF_SPAN             3        /* blocks in a full seek */
+#define  PROF_RPM              4        /* rotation speed (rev/min) */
+#define  PROF_TRANSFER         5        /* transfer time per block (us) */
+#define  PROF_SLOW_RATE        6        /* slow reads per 1000 reads */
+#define  PROF_SLOW_TIME        7        /* extra time for a slow read (us) */
+#define  PROF_SEED             8        /* pseudo-random number seed */
+#define  NUM_PROF              9        /* number of parameters */
+
+/* pseudo-random number generator (linear congruential) */
+#define  RANDOM_MULT           1103515245UL
+#define  RANDOM_ADD            12345UL
+#define  RANDOM_MASK           0x7FFFFFFFUL
+
+
+
+
+/* local function declarations */
+static  double    disk_random(void);                          /* random fraction */
+static  long int  disk_time(unsigned long int, int);          /* time of a read */
+static  void      get_block(unsigned long int, unsigned short int *);  /* get one block */
+static  int       read_blocks(unsigned long int, int, unsigned short int *);   /* copy blocks */
+
+
+
+
+/* locally global variables */
+static  const unsigned char  *image;            /* the mapped disk image */
+static  unsigned long int     image_blocks;     /* blocks in the disk image */
+static  unsigned long int     volume_start;     /* block the image starts at */
+static  int                   bare_type;        /* partition type of a bare volume */
+
+static  int                   blocks_read;      /* blocks read by get_blocks_start() */
+static  long long int         busy_until;       /* time the disk is busy until */
+
+/* the disk model */
+static  double                profile[NUM_PROF];    /* disk profile parameters */
+static  unsigned long int     head_block;       /* block after the last read */
+static  unsigned long int     random_state;     /* pseudo-random number state */
+
+/* totals for the run */
+static  long int              total_reads;      /* read commands */
+static  long int              total_blocks;     /* blocks read */
+static  long int              total_seeks;      /* reads that needed a seek */
+static  long int              total_slow;       /* slow reads */
+static  long long int         total_time;       /* time the disk was busy */
+
+
+
+
+/*
+   open_image
+
+   Description:      This function opens the passed disk image file and maps
+                     it into memory to be read by get_blocks().  If the
+                     image starts with a FAT boot sector instead of a master
+                     boot record it is a bare FAT volume and it is made to
+                     appear at block BARE_VOLUME_START with a faked
+                     partition table in block 0.
+
+   Arguments:        name (const char *) - name of the disk image file.
+   Return Value:     (int) - TRUE if the image was opened, FALSE if there was
+                     an error.
+
+   Input:            The disk image file.
+   Output:           Errors are output to stderr.
+
+   Error Handling:   If the file can't be opened or mapped or is less than a
+                     block long an error message is output and FALSE is
+                     returned.
+
+   Algorithms:       A bare FAT volume has 512 bytes per sector and "FAT" at
+                     the start of the FAT name in its boot sector.  It is a
+                     FAT16 volume if it has a FAT16 FAT size.
+   Data Structures:  None.
+
+   Shared Variables: bare_type    - set to the partition type of a bare FAT
+                                    volume.
+                     image        - set to the mapped disk image.
+                     image_blocks - set to the blocks in the disk image.
+                     volume_start - set to the block the image starts at.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  open_image(const char *name)
+{
+    /* variables */
+    struct stat  info;          /* information about the image file */
+
+    int          fd;            /* file descriptor for the image */
+
+    int          ok = TRUE;     /* image was opened */
+
+
+
+    /* open the image and find out how big it is */
+    fd = open(name, O_RDONLY);
+    if ((fd < 0) || (fstat(fd, &info) != 0))  {
+        /* can't open the image */
+        perror(name);
+        ok = FALSE;
+    }
+    else if (info.st_size < BLOCK_BYTES)  {
+        /* too short to have anything in it */
+        fprintf(stderr, "%s: not a disk image\n", name);
+        ok = FALSE;
+    }
+    else  {
+        /* map the whole image, it is only read */
+        image = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        image_blocks = info.st_size / BLOCK_BYTES;
+        if (image == MAP_FAILED)  {
+            /* couldn't map it */
+            perror(name);
+            ok = FALSE;
+        }
+    }
+
+    /* the mapping doesn't need the file to be open */
+    if (fd >= 0)
+        close(fd);
+
+
+    /* check for a bare FAT volume */
+    volume_start = 0;
+    if (ok && (image[BOOT_SECTOR_SIZE] == 0x00) && (image[BOOT_SECTOR_SIZE + 1] == 0x02) &&
+        ((memcmp(image + BOOT_FAT16_NAME, "FAT", 3) == 0) ||
+         (memcmp(image + BOOT_FAT32_NAME, "FAT", 3) == 0)))  {
+
+        /* it is a bare volume, move it up to make room for the partition */
+        /*    table and get the type for the table */
+        volume_start = BARE_VOLUME_START;
+        if ((image[BOOT_FAT16_SECTORS] != 0) || (image[BOOT_FAT16_SECTORS + 1] != 0))
+            bare_type = PARTITION_FAT16;
+        else
+            bare_type = PARTITION_FAT32_1;
+    }
+
+
+    /* done, return whether or not the image was opened */
+    return  ok;
+
+}
+
+
+
+
+/*
+   read_profile
+
+   Description:      This function reads the disk profile from the passed
+                     file.  Parameters that aren't in the file are left as
+                     they were (zero, which takes no time, except a zero span
+                     is the size of the image).
+
+   Arguments:        name (const char *) - name of the disk profile file.
+   Return Value:     (int) - TRUE if the profile was read, FALSE if there was
+                     an error.
+
+   Input:            The disk profile file.
+   Output:           Errors are output to stderr.
+
+   Error Handling:   If the file can't be opened or has a bad line (unknown
+                     parameter, missing or negative value) an error message
+                     is output and FALSE is returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: profile      - set from the file.
+                     random_state - set to the seed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  read_profile(const char *name)
+{
+    /* variables */
+    static const char * const  names[NUM_PROF] =    /* parameter names */
+        {  "command",  "settle",  "seek",  "span",  "rpm",  "transfer",
+           "slow_rate",  "slow_time",  "seed"  };
+
+    FILE    *f;                     /* the profile file */
+
+    char     line[MAX_SCRIPT_LINE]; /* line of the profile */
+    char     param[MAX_SCRIPT_LINE];    /* the parameter name */
+    double   value;                 /* the parameter value */
+    int      n;                     /* number of fields on the line */
+    int      line_no = 0;           /* line number in the file */
+
+    int      ok = TRUE;             /* profile was read */
+
+    int      i;                     /* general loop index */
+
+
+
+    /* open the profile */
+    f = fopen(name, "r");
+    if (f == NULL)  {
+        perror(name);
+        ok = FALSE;
+    }
+
+    /* read the parameters from it */
+    while (ok && (fgets(line, MAX_SCRIPT_LINE, f) != NULL))  {
+
+        /* get the parameter name and value */
+        line_no++;
+        n = sscanf(line, "%s %lf", param, &value);
+
+        /* look for the parameter */
+        for (i = 0; (i < NUM_PROF) && ((n < 1) || (strcmp(param, names[i]) != 0)); i++);
+
+        /* now set it */
+        if ((n < 1) || (param[0] == '#'))  {
+            /* blank line or comment - skip it */
+        }
+        else if ((i < NUM_PROF) && (n == 2) && (value >= 0))  {
+            /* good parameter, set it */
+            profile[i] = value;
+        }
+        else  {
+            /* bad line, the profile can't be used */
+            fprintf(stderr, "%s:%d: bad profile line: %s", name, line_no, line);
+            ok = FALSE;
+        }
+    }
+
+    /* done with the file */
+    if (f != NULL)
+        fclose(f);
+
+
+    /* start the pseudo-random numbers from the seed */
+    random_state = (unsigned long int) profile[PROF_SEED];
+
+
+    /* done, return whether or not the profile was read */
+    return  ok;
+
+}
+
+
+
+
+/*
+   disk_report
+
+   Description:      This function outputs the disk totals for the run: the
+                     number of reads, blocks and bytes read, the time the disk
+                     was busy, and the number of seeks and slow reads.
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           The totals (as display lines).
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: total_blocks - accessed.
+                     total_reads  - accessed.
+                     total_seeks  - accessed.
+                     total_slow   - accessed.
+                     total_time   - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  disk_report()
+{
+    /* variables */
+    char  s[MAX_SCRIPT_LINE];   /* the line being output */
+
+
+
+    /* output the amount read */
+    sprintf(s, "%ld reads %ld blocks %ld bytes", total_reads, total_blocks,
+            total_blocks * BLOCK_BYTES);
+    host_show("disk", s);
+
+    /* and the time it took */
+    sprintf(s, "%.1f ms busy %ld seeks %ld slow", total_time / 1000.0,
+            total_seeks, total_slow);
+    host_show("disk", s);
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   disk_totals
+
+   Description:      This function returns the number of disk reads and the
+                     number of blocks read so far in the run through the
+                     passed pointers.
+
+   Arguments:        reads (long int *)  - where to put the number of reads.
+                     blocks (long int *) - where to put the blocks read.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: total_blocks - accessed.
+                     total_reads  - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  disk_totals(long int *reads, long int *blocks)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* return the totals */
+    *reads = total_reads;
+    *blocks = total_blocks;
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   get_blocks
+
+   Description:      This function reads blocks from the disk image.  The
+                     data read is written to the memory pointed to by the
+                     third argument.  The number of blocks requested is given
+                     as the second argument and the starting block number to
+                     read is passed as the first argument.  The function
+                     returns the number of blocks read, which is less than
+                     the number requested only if the read goes past the end
+                     of the image.  The virtual clock is moved forward by
+                     the time the read takes (after waiting for any
+                     asynchronous read to finish).
+
+   Arguments:        block (unsigned long int)       - block number at which
+                                                       to start the read.
+                     length (int)                    - number of blocks to be
+                                                       read.
+                     dest (unsigned short int far *) - pointer to the memory
+                                                       where the read data is
+                                                       to be written.
+   Return Value:     The number of blocks actually read.
+
+   Input:            Blocks from the disk image.
+   Output:           None.
+
+   Error Handling:   Reads past the end of the image stop at the end.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: busy_until - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  get_blocks(unsigned long int block, int length, unsigned short int far *dest)
+{
+    /* variables */
+    int  cnt;                   /* blocks read */
+
+
+
+    /* the disk does one read at a time, wait for one in progress */
+    if (busy_until > host_time())
+        host_advance((long int) (busy_until - host_time()));
+
+    /* now read the blocks and wait for the read to finish */
+    cnt = read_blocks(block, length, dest);
+    host_advance(disk_time(block, length));
+
+
+    /* all done - return the number of blocks actually read */
+    return  cnt;
+
+}
+
+
+
+
+/*
+   get_blocks_start
+
+   Description:      This function starts an asynchronous read of blocks from
+                     the disk image.  The blocks are copied immediately and
+                     the result is saved for get_blocks_poll(), but the disk
+                     is busy until the read would have finished (it starts
+                     when any read in progress finishes).
+
+   Arguments:        block (unsigned long int)       - block number at which
+                                                       to start the read.
+                     length (int)                    - number of blocks to be
+                                                       read.
+                     dest (unsigned short int far *) - pointer to the memory
+                                                       where the read data is
+                                                       to be written.
+   Return Value:     None.
+
+   Input:            Blocks from the disk image.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: blocks_read - set to the number of blocks read.
+                     busy_until  - set to when the read finishes.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  get_blocks_start(unsigned long int block, int length, unsigned short int far *dest)
+{
+    /* variables */
+    long long int  start;       /* time the read starts */
+
+
+
+    /* the read starts now or when the disk is done with the last one */
+    start = host_time();
+    if (busy_until > start)
+        start = busy_until;
+
+    /* do the read now and remember how much was read and when it is done */
+    blocks_read = read_blocks(block, length, dest);
+    busy_until = start + disk_time(block, length);
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   get_blocks_poll
+
+   Description:      This function returns the number of blocks read by the
+                     last call to get_blocks_start() or IDE_BUSY if the read
+                     hasn't finished yet.  Each poll while busy takes
+                     HOST_POLL_TIME on the virtual clock (so waiting loops
+                     get to the end of the read).
+
+   Arguments:        None.
+   Return Value:     (int) - number of blocks read or IDE_BUSY.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: blocks_read - accessed.
+                     busy_until  - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  get_blocks_poll()
+{
+    /* variables */
+    int  cnt;                   /* blocks read or busy */
+
+
+
+    /* check if the read is done */
+    if (host_time() < busy_until)  {
+        /* not yet, polling takes some time */
+        host_advance(HOST_POLL_TIME);
+        cnt = IDE_BUSY;
+    }
+    else  {
+        /* it's done, return the result */
+        cnt = blocks_read;
+    }
+
+
+    /* return the result of the last read (or busy) */
+    return  cnt;
+
+}
+
+
+
+
+/*
+   disk_random
+
+   Description:      This function returns a pseudo-random fraction, used
+                     for the rotational position and slow reads.  The same
+                     seed always gives the same numbers.
+
+   Arguments:        None.
+   Return Value:     (double) - pseudo-random number from 0 up to (not
+                     including) 1.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       Linear congruential generator.
+   Data Structures:  None.
+
+   Shared Variables: random_state - updated.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  double  disk_random()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* get the next number in the sequence */
+    random_state = (random_state * RANDOM_MULT + RANDOM_ADD) & RANDOM_MASK;
+
+
+    /* and return it as a fraction */
+    return  random_state / (RANDOM_MASK + 1.0);
+
+}
+
+
+
+
+/*
+   disk_time
+
+   Description:      This function returns the time (in us) a read of the
+                     passed blocks takes according to the disk profile and
+                     adds the read to the totals.  Every read has the
+                     command overhead and transfer time.  A read that doesn't
+                     start where the last one ended also seeks (settle time
+                     plus time proportional to the distance) and waits for
+                     the disk to turn to the block.  Some reads are slow.
+
+   Arguments:        block (unsigned long int) - block the read starts at.
+                     length (int)              - number of blocks read.
+   Return Value:     (long int) - time the read takes (in us).
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       The rotational latency is a random part of a
+                     revolution.
+   Data Structures:  None.
+
+   Shared Variables: head_block   - set to the block after the read.
+                     image_blocks - accessed.
+                     profile      - accessed.
+                     total_blocks - updated.
+                     total_reads  - incremented.
+                     total_seeks  - incremented for a seek.
+                     total_slow   - incremented for a slow read.
+                     total_time   - updated.
+                     volume_start - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  long int  disk_time(unsigned long int block, int length)
+{
+    /* variables */
+    double             span;    /* blocks in a full seek */
+    unsigned long int  dist;    /* blocks to seek */
+
+    double             t;       /* time for the read */
+
+
+
+    /* every read has the overhead and the transfer */
+    t = profile[PROF_COMMAND] + length * profile[PROF_TRANSFER];
+
+    /* if the read doesn't follow the last one it has to seek */
+    if (block != head_block)  {
+
+        /* seek time is proportional to the distance (up to a full seek) */
+        span = (profile[PROF_SPAN] > 0) ? profile[PROF_SPAN] : (volume_start + image_blocks);
+        dist = (block > head_block) ? (block - head_block) : (head_block - block);
+        t += profile[PROF_SETTLE] + profile[PROF_SEEK] * ((dist < span) ? dist : span) / span;
+
+        /* and then wait for the block to come around */
+        if (profile[PROF_RPM] > 0)
+            t += disk_random() * 60000000.0 / profile[PROF_RPM];
+
+        total_seeks++;
+    }
+
+    /* some reads are slow (retries, recalibration, etc.) */
+    if ((disk_random() * 1000) < profile[PROF_SLOW_RATE])  {
+        t += profile[PROF_SLOW_TIME];
+        total_slow++;
+    }
+
+    /* the next read follows on from this one */
+    head_block = block + length;
+
+
+    /* total the read and return its time (to the nearest us) */
+    total_reads++;
+    total_blocks += length;
+    total_time += (long int) (t + 0.5);
+
+    return  (long int) (t + 0.5);
+
+}
+
+
+
+
+/*
+   get_block
+
+   Description:      This function gets one block of the disk image and
+                     writes it as words to the passed memory.  Blocks before
+                     a bare FAT volume are zero except for block 0, which is
+                     a master boot record with a partition table for the
+                     volume.
+
+   Arguments:        block (unsigned long int)  - block number to get (must
+                                                  be in the image).
+                     dest (unsigned short int *) - pointer to the memory
+                                                  where the block is to be
+                                                  written.
+   Return Value:     None.
+
+   Input:            A block from the disk image.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       The words are little-endian in the image.
+   Data Structures:  None.
+
+   Shared Variables: bare_type    - accessed.
+                     image        - accessed.
+                     volume_start - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  get_block(unsigned long int block, unsigned short int *dest)
+{
+    /* variables */
+    const unsigned char  *p;    /* block in the image */
+
+    int  i;                     /* general loop index */
+
+
+
+    /* check if the block is in front of the image */
+    if (block < volume_start)  {
+
+        /* it is, these are all zero */
+        for (i = 0; i < IDE_BLOCK_SIZE; i++)
+            dest[i] = 0;
+
+        /* except the master boot record, it has the partition table */
+        if (block == 0)  {
+            dest[PARTITION_TYPE] = bare_type;
+            dest[PARTITION_START_LO] = volume_start & 0xFFFF;
+            dest[PARTITION_START_HI] = volume_start >> 16;
+            dest[MBR_SIGNATURE] = 0xAA55;
+        }
+    }
+    else  {
+
+        /* the block is in the image, copy it a word at a time */
+        p = image + (block - volume_start) * BLOCK_BYTES;
+        for (i = 0; i < IDE_BLOCK_SIZE; i++)
+            dest[i] = p[2 * i] | (p[2 * i + 1] << 8);
+    }
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   read_blocks
+
+   Description:      This function copies blocks from the disk image to the
+                     passed memory.  It stops at the end of the image.
+
+   Arguments:        block (unsigned long int)  - block number at which to
+                                                  start the read.
+                     length (int)               - number of blocks to be
+                                                  read.
+                     dest (unsigned short int *) - pointer to the memory
+                                                  where the blocks are to be
+                                                  written.
+   Return Value:     (int) - the number of blocks actually read.
+
+   Input:            Blocks from the disk image.
+   Output:           None.
+
+   Error Handling:   Reads past the end of the image stop at the end.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: image_blocks - accessed.
+                     volume_start - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  read_blocks(unsigned long int block, int length, unsigned short int *dest)
+{
+    /* variables */
+    int  i;                     /* blocks read */
+
+
+
+    /* read the blocks that are in the image */
+    for (i = 0; (i < length) && ((block + i) < (volume_start + image_blocks)); i++)
+        get_block(block + i, dest + (long int) i * IDE_BLOCK_SIZE);
+
+
+    /* all done - return the number of blocks actually read */
+    return  i;
+
+}
@@ -0,0 +1,1121 @@
+/****************************************************************************/
+/*                                                                          */
+/*                                 HOSTSYS                                  */
+/*                      Simulated System Functions (Host)                   */
+/*                           MP3 Jukebox Project                            */
+/*                                EE/CS 52                                  */
+/*                                                                          */
+/****************************************************************************/
+
+/*
+   This file contains the setup, timing, keypad, and display functions for
+   the Linux host build of the MP3 Jukebox.  Time is kept on a virtual clock
+   that moves forward HOST_LOOP_TIME each time the main loop checks for a
+   key.  Keys come from a key script, a file (or stdin) with one command on
+   each line:
+      up, down, play, rpt, ff, rev, stop - press the key
+      wait <ms>                          - let the jukebox run for a time
+      idle [<ms>]                        - let the jukebox run until it is
+                                           idle (or for at most a time)
+      audio [<ms>]                       - let the jukebox run until the
+                                           audio starts after play (or for
+                                           at most a time)
+      faster, slower                     - change the fast forward/reverse
+                                           rate (after ff or rev)
+      mark <name>                        - output a benchmark record
+      check <manifest>                   - check the current file against
+                                           an mkimage manifest
+      quit                               - end the run (so does the end of
+                                           the script)
+   Blank lines and lines starting with # are ignored.  The display is lines
+   of output to stdout, each starting with the virtual time.  A benchmark
+   record is a mark display line with the name and the virtual time (in us),
+   disk reads, blocks, and bytes since the last mark.  A check reads the
+   current file with get_file_blocks() and compares it byte for byte with
+   the MP3 file the manifest says it came from (the jukebox should be
+   stopped).  The functions included are:
+      display_artist - display the passed track artist
+      display_status - display the passed status
+      display_time   - display the passed track time
+      display_title  - display the passed track title
+      elapsed_time   - get the time since the last call to this function
+      getkey         - get a key
+      host_advance   - move the virtual clock forward
+      host_init      - setup the simulated hardware from the command line
+      host_key_time  - get the virtual time the last key was pressed
+      host_show      - output a line of the display
+      host_time      - get the virtual time
+      key_available  - check if a key is available
+
+   The local functions included are:
+      check_file     - check the current file against a manifest
+      next_command   - get the next key script command
+      show_mark      - output a benchmark record
+
+   The locally global variable definitions included are:
+      clock_us       - the virtual time (in us)
+      elapsed_base   - virtual time of the last elapsed_time() call
+      key            - the key that is available
+      key_time       - virtual time the last key was pressed
+      last_status    - the status last displayed
+      last_time      - the track time last displayed
+      mark_blocks    - disk blocks read at the last mark
+      mark_reads     - disk reads at the last mark
+      mark_time      - virtual time of the last mark
+      script         - the key script
+      show_times     - output every track time
+      wait_audio     - waiting for the audio to start
+      wait_idle      - waiting for the jukebox to be idle
+      wait_until     - virtual time to wait until
+
+
+   Revision History
+      6/16/16  Tim Liu           Initial revision.
+      6/16/16  Tim Liu           show() is now host_show() (the simulated
+                                 decoder outputs lines too) and the decoder
+                                 totals are output at the end of the run.
+      6/16/16  Tim Liu           Added the -d option for a disk profile and
+                                 the disk totals are output at the end.
+      6/16/16  Tim Liu           Added the audio, faster, slower, and mark
+                                 script commands for benchmarks.
+      6/16/16  Tim Liu           Added the check script command.
+      6/17/16  Tim Liu           Added host_key_time() so the simulated
+                                 decoder times starting play from the key.
+*/
+
+
+
+/* library include files */
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+
+/* local include files */
+#include  "mp3defs.h"
+#include  "interfac.h"
+#include  "keyproc.h"
+#include  "fatutil.h"
+#include  "host.h"
+
+
+
+
+/* local definitions */
+
+/* no time limit on waiting for the jukebox to be idle */
+#define  NO_WAIT_LIMIT   0x7FFFFFFFFFFFFFFFLL
+
+/* blocks read at a time when checking a file */
+#define  CHECK_BLOCKS    16
+
+
+
+
+/* local function declarations */
+static  void  check_file(const char *);     /* check the current file */
+static  void  next_command(void);           /* get the next key script command */
+static  void  show_mark(const char *);      /* output a benchmark record */
+
+
+
+
+/* locally global variables */
+static  long long int  clock_us;        /* virtual time (in us) */
+static  long long int  elapsed_base;    /* time of last elapsed_time() call */
+
+static  FILE          *script;          /* the key script */
+static  int            key = KEY_ILLEGAL;   /* the available key */
+static  long long int  key_time;        /* time the last key was pressed */
+static  long long int  wait_until;      /* time to wait until */
+static  int            wait_idle;       /* waiting until the jukebox is idle */
+static  int            wait_audio;      /* waiting until the audio starts */
+
+static  long long int  mark_time;       /* time of the last mark */
+static  long int       mark_reads;      /* disk reads at the last mark */
+static  long int       mark_blocks;     /* disk blocks read at the last mark */
+
+static  unsigned int   last_status = STATUS_ILLEGAL;    /* status displayed */
+static  unsigned int   last_time = TIME_NONE;   /* track time displayed */
+static  int            show_times;      /* output every track time */
+
+
+
+
+/*
+   host_init
+
+   Description:      This function sets up the simulated hardware from the
+                     command line.  The command line is
+                        juke [-t] [-d profile] image [script]
+                     where image is the FAT disk image, script is the key
+                     script (stdin if there isn't one), -t outputs every
+                     change of the track time (otherwise only the time when
+                     the track, title, or status changes is output), and
+                     -d gives the disk profile (otherwise reads take no
+                     time).
+
+   Arguments:        argc (int)     - number of command line arguments.
+                     argv (char *[]) - the command line arguments.
+   Return Value:     (int) - TRUE if the simulated hardware was setup, FALSE
+                     if there was an error.
+
+   Input:            The command line.
+   Output:           Errors are output to stderr.
+
+   Error Handling:   A bad command line outputs the usage, a disk image,
+                     disk profile, or key script that can't be opened (or
+                     read) outputs an error.  In
+                     both cases FALSE is returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: clock_us     - cleared.
+                     elapsed_base - cleared.
+                     script       - set to the key script.
+                     show_times   - set if -t is on the command line.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  host_init(int argc, char *argv[])
+{
+    /* variables */
+    int  arg = 1;               /* the current argument */
+
+    int  usage = FALSE;         /* bad command line */
+
+    int  ok = TRUE;             /* simulated hardware is setup */
+
+
+
+    /* check for the options */
+    show_times = FALSE;
+    while (ok && (arg < argc) && (argv[arg][0] == '-'))  {
+        if (strcmp(argv[arg], "-t") == 0)  {
+            /* output every track time */
+            show_times = TRUE;
+            arg++;
+        }
+        else if ((strcmp(argv[arg], "-d") == 0) && ((arg + 1) < argc))  {
+            /* disk profile */
+            ok = read_profile(argv[arg + 1]);
+            arg += 2;
+        }
+        else  {
+            /* bad option */
+            usage = TRUE;
+            ok = FALSE;
+        }
+    }
+
+    /* need the image and maybe a script */
+    usage = usage || (ok && ((argc - arg) != 1) && ((argc - arg) != 2));
+    if (usage)  {
+        fprintf(stderr, "usage: %s [-t] [-d profile] image [script]\n", argv[0]);
+        ok = FALSE;
+    }
+
+    /* open the image */
+    ok = ok && open_image(argv[arg]);
+
+    /* and the script */
+    if (ok && ((argc - arg) == 2))  {
+        script = fopen(argv[arg + 1], "r");
+        if (script == NULL)  {
+            perror(argv[arg + 1]);
+            ok = FALSE;
+        }
+    }
+    else  {
+        script = stdin;
+    }
+
+
+    /* start the virtual clock */
+    clock_us = 0;
+    elapsed_base = 0;
+
+
+    /* return whether or not everything is setup */
+    return  ok;
+
+}
+
+
+
+
+/*
+   host_time
+
+   Description:      This function returns the virtual time.
+
+   Arguments:        None.
+   Return Value:     (long long int) - the virtual time (in us).
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: clock_us - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+long long int  host_time()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* just return the time */
+    return  clock_us;
+
+}
+
+
+
+
+/*
+   host_key_time
+
+   Description:      This function returns the virtual time (in us) the
+                     last key was pressed (the key script command for it
+                     was read).
+
+   Arguments:        None.
+   Return Value:     (long long int) - the time the last key was pressed.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: key_time - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 17, 2016
+
+*/
+
+long long int  host_key_time()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* just return the time of the key */
+    return  key_time;
+
+}
+
+
+
+
+/*
+   host_advance
+
+   Description:      This function moves the virtual clock forward by the
+                     passed time and lets the simulated decoder catch up to
+                     the new time.
+
+   Arguments:        t (long int) - time (in us) to move forward.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: clock_us - updated.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  host_advance(long int t)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* move the clock and let the decoder use the data it needs */
+    clock_us += t;
+    audio_run(clock_us);
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   elapsed_time
+
+   Description:      This function returns the virtual time (in ms) since
+                     the last time it was called.
+
+   Arguments:        None.
+   Return Value:     (int) - the time since the last call (in ms).
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       Only whole ms are counted, the rest is counted the
+                     next time.
+   Data Structures:  None.
+
+   Shared Variables: clock_us     - accessed.
+                     elapsed_base - updated.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  elapsed_time()
+{
+    /* variables */
+    int  ms;                    /* elapsed time in ms */
+
+
+
+    /* get the whole ms since the last call */
+    ms = (clock_us - elapsed_base) / 1000;
+    elapsed_base += 1000LL * ms;
+
+
+    /* and return it */
+    return  ms;
+
+}
+
+
+
+
+/*
+   key_available
+
+   Description:      This function is called each time around the main loop
+                     so the virtual clock is moved forward by HOST_LOOP_TIME.
+                     Then, unless waiting, the next key script command is
+                     gotten.  It returns TRUE if there is a key available.
+
+   Arguments:        None.
+   Return Value:     (unsigned char) - TRUE if a key is available, FALSE
+                     otherwise.
+
+   Input:            The key script.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: clock_us    - accessed.
+                     key         - accessed.
+                     last_status - accessed.
+                     wait_audio  - cleared when done waiting.
+                     wait_idle   - cleared when done waiting.
+                     wait_until  - set to now when the jukebox is idle (or
+                                   the audio has started).
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+unsigned char  key_available()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* time passes each time around the main loop */
+    host_advance(HOST_LOOP_TIME);
+
+    /* if waiting for the jukebox to be idle, it is done when it is */
+    if (wait_idle && (last_status == STATUS_IDLE))
+        wait_until = clock_us;
+    /* same if waiting for the audio to start */
+    if (wait_audio && audio_started())
+        wait_until = clock_us;
+
+    /* if done waiting and don't have a key, get the next command */
+    if ((clock_us >= wait_until) && (key == KEY_ILLEGAL))  {
+        wait_idle = FALSE;
+        wait_audio = FALSE;
+        next_command();
+    }
+
+
+    /* return whether or not there is a key */
+    return  (key != KEY_ILLEGAL);
+
+}
+
+
+
+
+/*
+   getkey
+
+   Description:      This function returns the available key (KEY_ILLEGAL if
+                     there isn't one).
+
+   Arguments:        None.
+   Return Value:     (int) - the key.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: key - returned and cleared.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  getkey()
+{
+    /* variables */
+    int  k = key;               /* the key */
+
+
+
+    /* the key is used up */
+    key = KEY_ILLEGAL;
+
+
+    /* and return it */
+    return  k;
+
+}
+
+
+
+
+/*
+   display_time
+
+   Description:      This function displays the passed track time.  Unless
+                     every time is being output, it is only output when
+                     something else is.
+
+   Arguments:        t (unsigned int) - track time (in tenths of seconds) or
+                                        TIME_NONE.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           The track time (if every time is being output).
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: last_time  - set to the passed time.
+                     show_times - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  display_time(unsigned int t)
+{
+    /* variables */
+    char  s[16];                /* the time as a string */
+
+
+
+    /* remember the time */
+    last_time = t;
+
+    /* and output it if outputting every time */
+    if (show_times)  {
+        if (t == TIME_NONE)
+            strcpy(s, "-");
+        else
+            sprintf(s, "%u:%02u.%u", t / 600, (t / 10) % 60, t % 10);
+        host_show("time", s);
+    }
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   display_status
+
+   Description:      This function displays the passed status.
+
+   Arguments:        s (unsigned int) - the status.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           The status.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: last_status - set to the passed status.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  display_status(unsigned int s)
+{
+    /* variables */
+
+    /* names of the status values */
+    static const char * const  names[] =
+        {  "play", "fastfwd", "reverse", "idle", "illegal"  };
+
+
+
+    /* remember the status */
+    last_status = s;
+
+    /* and output it */
+    host_show("status", names[(s < STATUS_ILLEGAL) ? s : STATUS_ILLEGAL]);
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   display_title
+
+   Description:      This function displays the passed track title.
+
+   Arguments:        t (const char far *) - the title.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           The title.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  display_title(const char far *t)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* output the title */
+    host_show("title", t);
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   display_artist
+
+   Description:      This function displays the passed track artist.
+
+   Arguments:        a (const char far *) - the artist.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           The artist.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  display_artist(const char far *a)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* output the artist */
+    host_show("artist", a);
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   next_command
+
+   Description:      This function gets the next command from the key
+                     script.  A key command makes the key available, a wait,
+                     idle, or audio command sets up the wait, a faster or
+                     slower command changes the fast forward/reverse rate,
+                     a mark command outputs a benchmark record, a check
+                     command checks the current file, and a quit command or
+                     the end of the script ends the run.
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            The key script.
+   Output:           Bad commands are output to stderr.
+
+   Error Handling:   Bad commands are output and skipped.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: clock_us   - accessed.
+                     key        - set to a key command's key.
+                     key_time   - set to now for a key command.
+                     script     - read.
+                     wait_audio - set for an audio command.
+                     wait_idle  - set for an idle command.
+                     wait_until - set for a wait, idle, or audio command.
+
+   Author:           Tim Liu
+   Last Modified:    June 17, 2016
+
+*/
+
+static  void  next_command()
+{
+    /* variables */
+
+    /* the key commands and their keys */
+    static const struct  {
+                            const char  *name;      /* the command */
+                            int          k;         /* its key */
+                         }  keys[] =
+        {  {  "up",    KEY_TRACKUP    },
+           {  "down",  KEY_TRACKDOWN  },
+           {  "play",  KEY_PLAY       },
+           {  "rpt",   KEY_RPTPLAY    },
+           {  "ff",    KEY_FASTFWD    },
+           {  "rev",   KEY_REVERSE    },
+           {  "stop",  KEY_STOP       }  };
+
+    char    line[MAX_SCRIPT_LINE];  /* line of the script */
+    char    cmd[MAX_SCRIPT_LINE];   /* the command */
+    char    name[MAX_SCRIPT_LINE];  /* name argument */
+    long    ms;                     /* time argument (in ms) */
+    int     n;                      /* number of fields on the line */
+
+    int     done = FALSE;           /* got a command */
+
+    size_t  i;                      /* general loop index */
+
+
+
+    /* read lines until there is a command */
+    while (!done)  {
+
+        /* at the end of the script (or a quit) the run is over */
+        if (fgets(line, MAX_SCRIPT_LINE, script) == NULL)
+            strcpy(line, "quit");
+
+        /* get the command and argument (if there is one) */
+        n = sscanf(line, "%s %ld", cmd, &ms);
+
+        /* look for it in the keys */
+        for (i = 0; (i < (sizeof(keys) / sizeof(keys[0]))) && ((n < 1) || (strcmp(cmd, keys[i].name) != 0)); i++);
+
+        /* now do the command */
+        if ((n < 1) || (cmd[0] == '#'))  {
+            /* blank line or comment - skip it */
+        }
+        else if (i < (sizeof(keys) / sizeof(keys[0])))  {
+            /* it's a key, pressed now */
+            key = keys[i].k;
+            key_time = clock_us;
+            done = TRUE;
+        }
+        else if ((strcmp(cmd, "wait") == 0) && (n == 2))  {
+            /* wait for the time */
+            wait_until = clock_us + 1000LL * ms;
+            done = TRUE;
+        }
+        else if (strcmp(cmd, "idle") == 0)  {
+            /* wait until idle, maybe with a time limit */
+            wait_idle = TRUE;
+            wait_until = (n == 2) ? (clock_us + 1000LL * ms) : NO_WAIT_LIMIT;
+            done = TRUE;
+        }
+        else if (strcmp(cmd, "audio") == 0)  {
+            /* wait until the audio starts, maybe with a time limit */
+            wait_audio = TRUE;
+            wait_until = (n == 2) ? (clock_us + 1000LL * ms) : NO_WAIT_LIMIT;
+            done = TRUE;
+        }
+        else if (strcmp(cmd, "faster") == 0)  {
+            /* speed up fast forward/reverse */
+            inc_FFRev_rate();
+        }
+        else if (strcmp(cmd, "slower") == 0)  {
+            /* slow down fast forward/reverse */
+            dec_FFRev_rate();
+        }
+        else if ((strcmp(cmd, "mark") == 0) && (sscanf(line, "%*s %s", name) == 1))  {
+            /* output a benchmark record */
+            show_mark(name);
+        }
+        else if ((strcmp(cmd, "check") == 0) && (sscanf(line, "%*s %s", name) == 1))  {
+            /* check the current file against the manifest */
+            check_file(name);
+        }
+        else if (strcmp(cmd, "quit") == 0)  {
+            /* the run is over */
+            audio_report();
+            disk_report();
+            host_show("quit", "");
+            exit(0);
+        }
+        else  {
+            /* bad command, skip it */
+            fprintf(stderr, "bad script command: %s", line);
+        }
+    }
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   show_mark
+
+   Description:      This function outputs a benchmark record as a mark
+                     display line.  The record is the passed name and the
+                     virtual time (in us), disk reads, disk blocks, and
+                     bytes read since the last mark (or the start of the
+                     run), separated by spaces.
+
+   Arguments:        name (const char *) - name of the record.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           The record (as a display line).
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: clock_us    - accessed.
+                     mark_blocks - updated.
+                     mark_reads  - updated.
+                     mark_time   - updated.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  show_mark(const char *name)
+{
+    /* variables */
+    char      s[2 * MAX_SCRIPT_LINE];   /* the record */
+
+    long int  reads;            /* disk reads so far */
+    long int  blocks;           /* disk blocks read so far */
+
+
+
+    /* get the disk totals and output the change since the last mark */
+    disk_totals(&reads, &blocks);
+    sprintf(s, "%s %lld %ld %ld %ld", name, clock_us - mark_time,
+            reads - mark_reads, blocks - mark_blocks,
+            (blocks - mark_blocks) * 2L * IDE_BLOCK_SIZE);
+    host_show("mark", s);
+
+    /* the next mark is from now */
+    mark_time = clock_us;
+    mark_reads = reads;
+    mark_blocks = blocks;
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   check_file
+
+   Description:      This function checks the current file against the
+                     passed mkimage manifest.  The manifest line for the
+                     file is the one whose long path (or short path) ends
+                     in the current file name.  The file's starting sector
+                     and size must match the manifest and the data read
+                     with get_file_blocks() must match the start of the MP3
+                     file it was made from.  The result is output as a
+                     check display line: the file name and ok, or what is
+                     wrong.
+
+   Arguments:        manifest (const char *) - the manifest file.
+   Return Value:     None.
+
+   Input:            The manifest, the MP3 file, and the current file.
+   Output:           The result (as a display line).
+
+   Error Handling:   Files that can't be read and files that aren't in the
+                     manifest are output as the result.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  check_file(const char *manifest)
+{
+    /* variables */
+    unsigned short int  buf[CHECK_BLOCKS * IDE_BLOCK_SIZE];     /* file data */
+    unsigned char       src_buf[CHECK_BLOCKS * IDE_BLOCK_SIZE * 2]; /* MP3 data */
+
+    char                s[2 * MAX_SCRIPT_LINE];     /* the result */
+
+    const char         *name;       /* the current file name */
+    size_t              len;        /* length of the name */
+
+    FILE               *m;          /* the manifest */
+    FILE               *src = NULL; /* the MP3 file */
+    char               *line = NULL;    /* line of the manifest */
+    size_t              line_size = 0;  /* size of the line buffer */
+    char               *field[7];   /* fields of the line */
+    char               *p;          /* end of a field */
+
+    long int            bytes = 0;  /* bytes in the file */
+    long int            sector = 0; /* first sector (in the volume) */
+    long int            left;       /* bytes left to check */
+    long int            n;          /* bytes being checked */
+    unsigned long int   block;      /* block of the file */
+    int                 blocks;     /* blocks read */
+
+    int                 found = FALSE;  /* found the file in the manifest */
+    int                 i;              /* general loop index */
+
+
+
+    /* find the current file in the manifest */
+    name = get_cur_file_name();
+    len = strlen(name);
+    m = fopen(manifest, "r");
+    if (m == NULL)
+        sprintf(s, "%s can't open %s", name, manifest);
+    else
+        sprintf(s, "%s not in the manifest", name);
+
+    while (!found && (m != NULL) && (getline(&line, &line_size, m) > 0))  {
+
+        /* split the line into its fields (skip comments) */
+        p = line;
+        for (i = 0; (i < 7) && (p != NULL); i++)  {
+            field[i] = p;
+            p = strpbrk(p, "\t\n");
+            if (p != NULL)
+                *p++ = '\0';
+        }
+
+        /* it's the file if a path ends in the file name */
+        if ((i == 7) && (field[0][0] == 'f') &&
+            (((strlen(field[2]) > len) && (strcmp(field[2] + strlen(field[2]) - len, name) == 0) &&
+              (field[2][strlen(field[2]) - len - 1] == '/')) ||
+             ((strlen(field[1]) > len) && (strcmp(field[1] + strlen(field[1]) - len, name) == 0) &&
+              (field[1][strlen(field[1]) - len - 1] == '/'))))  {
+            found = TRUE;
+            bytes = atol(field[4]);
+            sector = atol(field[6]);
+            src = fopen(field[5], "rb");
+            if (src == NULL)
+                sprintf(s, "%s can't open %s", name, field[5]);
+        }
+    }
+
+    free(line);
+    if (m != NULL)
+        fclose(m);
+
+
+    /* check the file's location and size */
+    if (found && (src != NULL))  {
+        if ((long int) (get_cur_file_sector() - get_partition_start()) != sector)  {
+            sprintf(s, "%s starts at sector %lu, not %ld", name,
+                    get_cur_file_sector() - get_partition_start(), sector);
+            found = FALSE;
+        }
+        else if (get_cur_file_size() != bytes)  {
+            sprintf(s, "%s is %ld bytes, not %ld", name, get_cur_file_size(), bytes);
+            found = FALSE;
+        }
+    }
+
+    /* and its data, a group of blocks at a time */
+    if (found && (src != NULL))  {
+        sprintf(s, "%s ok %ld", name, bytes);
+        left = bytes;
+        block = 0;
+        while (left > 0)  {
+            n = (left < (long int) sizeof(src_buf)) ? left : (long int) sizeof(src_buf);
+            blocks = get_file_blocks(block, CHECK_BLOCKS, buf);
+            if ((blocks * 2L * IDE_BLOCK_SIZE) < n)  {
+                sprintf(s, "%s short read at byte %ld", name, bytes - left);
+                left = 0;
+            }
+            else if (fread(src_buf, 1, n, src) != (size_t) n)  {
+                sprintf(s, "%s can't read the MP3 file at byte %ld", name, bytes - left);
+                left = 0;
+            }
+            else if (memcmp(buf, src_buf, n) != 0)  {
+                for (i = 0; ((unsigned char *) buf)[i] == src_buf[i]; i++);
+                sprintf(s, "%s differs at byte %ld", name, bytes - left + i);
+                left = 0;
+            }
+            else  {
+                left -= n;
+                block += CHECK_BLOCKS;
+            }
+        }
+    }
+
+    if (src != NULL)
+        fclose(src);
+
+
+    /* output the result */
+    host_show("check", s);
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   host_show
+
+   Description:      This function outputs a line of the display: the
+                     virtual time, the track time last displayed, and the
+                     passed item and value.
+
+   Arguments:        item (const char *)  - what is being displayed.
+                     value (const char *) - the value displayed.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           The line to stdout.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: clock_us  - accessed.
+                     last_time - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+void  host_show(const char *item, const char *value)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* output the line */
+    if (last_time == TIME_NONE)
+        printf("%12.3f       -  %-7s %s\n", clock_us / 1000.0, item, value);
+    else
+        printf("%12.3f  %6.1f  %-7s %s\n", clock_us / 1000.0, last_time / 10.0, item, value);
+
+
+    /* all done, return */
+    return;
+
+}
@@ -22,6 +22,7 @@
 	                         PARENT_DIR_CHAR, and SUBDIR_CHAR.
       4/29/06  Glen George       Updated value of IDE_BLOCK_SIZE to be in
 	                         units of words, not bytes.
+      6/7/16   Tim Liu           Added IDE_BUSY for get_blocks_poll().
 */
 
 
@@ -63,5 +64,7 @@
 
 #define  IDE_BLOCK_SIZE  256		/* 256 words/block */
 
+#define  IDE_BUSY        (-1)		/* get_blocks_poll() value while reading */
+
 
 #endif
@@ -0,0 +1,167 @@
+/****************************************************************************/
+/*                                                                          */
+/*                               JUKEIDX.H                                  */
+/*                       Library Index File Format                          */
+/*                              Include File                                */
+/*                           MP3 Jukebox Project                            */
+/*                                EE/CS 52                                  */
+/*                                                                          */
+/****************************************************************************/
+
+/*
+   This file contains the constants and macros for reading the library index
+   file (\JUKEBOX.IDX) in the root directory of the hard drive.  The index
+   holds one record for each directory on the drive and one record for each
+   visible entry in those directories, so the jukebox can browse without
+   parsing directory sectors, long filenames, and ID3 tags or probing the
+   first frames of the files.
+
+   The file is made up of 512 byte sectors, all values are little endian
+   and all offsets below are in words (16 bits).  Sector 0 is the header.
+   The directory records, entry records, extent records, and seek table
+   records each start on a sector boundary at the sector given in the
+   header.
+
+   Directory records are sorted by starting cluster (0 is the FAT16 root
+   directory).  A directory record is only used if the size (in sectors) of
+   the directory's cluster chain and the time and date of the directory's
+   entry in its parent (0 for the root) still match the record.  The entry
+   records of a directory are consecutive and in the same order as the
+   entries in the directory ("." and volume labels are not included, ".."
+   is).  Extent records give the runs of contiguous clusters of a file.
+
+   The entry record of a file also has what probe_track() finds in the file
+   (where the audio starts, the frame count, bit rate, and probed time) so
+   a track can be set up without reading the file.  The title and artist
+   are the ones displayed: from the ID3v2 tag if it has a title
+   (IDX_FLAG_ID3V2), otherwise from the ID3 tag at the end of the file.  A
+   file with a Xing seek table has a seek table record (IDX_FLAG_TOC).
+
+
+   Revision History
+      6/12/16  Tim Liu           Initial revision.
+      6/16/16  Tim Liu           Version 2: the entry records have the
+                                 probe results and the ID3v2 title and
+                                 artist, and added the seek table records.
+*/
+
+
+
+#ifndef  I__JUKEIDX_H__
+    #define  I__JUKEIDX_H__
+
+
+/* library include files */
+  /* none */
+
+/* local include files */
+#include  "interfac.h"
+#include  "id3info.h"
+
+
+
+
+/* constants */
+
+/* name of the index file (8.3, padded as in a directory entry) */
+#define  IDX_FILENAME           "JUKEBOX "
+#define  IDX_EXTENSION          "IDX"
+
+/* identifier ("JBIX") and version in the header */
+#define  IDX_MAGIC_LO           0x424A
+#define  IDX_MAGIC_HI           0x5849
+#define  IDX_VERSION            2
+
+
+/* header word offsets */
+#define  IDX_HDR_MAGIC          0       /* identifier (2 words) */
+#define  IDX_HDR_VERSION        2       /* format version */
+#define  IDX_HDR_NUM_DIRS       4       /* number of directory records (2 words) */
+#define  IDX_HDR_DIR_SECTOR     6       /* sector of first directory record (2 words) */
+#define  IDX_HDR_ENTRY_SECTOR   8       /* sector of first entry record (2 words) */
+#define  IDX_HDR_EXTENT_SECTOR  10      /* sector of first extent record (2 words) */
+#define  IDX_HDR_TOC_SECTOR     12      /* sector of first seek table record (2 words) */
+
+
+/* directory record size and word offsets */
+#define  IDX_DIR_WORDS          16
+#define  IDX_DIRS_PER_SECTOR    (IDE_BLOCK_SIZE / IDX_DIR_WORDS)
+
+#define  IDX_DIR_CLUSTER        0       /* starting cluster (2 words) */
+#define  IDX_DIR_SIZE           2       /* sectors in the directory (2 words) */
+#define  IDX_DIR_TIME           4       /* time of the entry in the parent */
+#define  IDX_DIR_DATE           5       /* date of the entry in the parent */
+#define  IDX_DIR_FIRST          6       /* first entry record number (2 words) */
+#define  IDX_DIR_COUNT          8       /* number of entry records */
+
+
+/* entry record size and word offsets */
+#define  IDX_ENTRY_WORDS        128
+#define  IDX_ENTRIES_PER_SECTOR (IDE_BLOCK_SIZE / IDX_ENTRY_WORDS)
+
+#define  IDX_ENT_NAME           0       /* long filename (IDX_NAME_LEN bytes) */
+#define  IDX_ENT_ATTR           64      /* attributes (low byte) */
+#define  IDX_ENT_TIME           65      /* file time */
+#define  IDX_ENT_DATE           66      /* file date */
+#define  IDX_ENT_SIZE           67      /* file size in bytes (2 words) */
+#define  IDX_ENT_CLUSTER        69      /* starting cluster (2 words) */
+#define  IDX_ENT_TAG_TIME       71      /* ID3 tag time field (2 words) */
+#define  IDX_ENT_EXTENT         73      /* first extent record number (2 words) */
+#define  IDX_ENT_NUM_EXTENTS    75      /* number of extent records */
+#define  IDX_ENT_FLAGS          76      /* entry flags */
+#define  IDX_ENT_TITLE          77      /* displayed title (ID3_TAG_TITLE_SIZE bytes) */
+#define  IDX_ENT_ARTIST         92      /* displayed artist (ID3_TAG_ARTIST_SIZE bytes) */
+#define  IDX_ENT_START          107     /* where the audio starts (2 words) */
+#define  IDX_ENT_FRAMES         109     /* number of frames (2 words) */
+#define  IDX_ENT_BIT_RATE       111     /* (average) bit rate */
+#define  IDX_ENT_PROBE_TIME     112     /* probed time in tenths of a second */
+#define  IDX_ENT_TOC            113     /* seek table record number (2 words) */
+
+/* longest name in an entry record (including the <null>) */
+#define  IDX_NAME_LEN           128
+
+/* entry flags */
+#define  IDX_FLAG_ID3           0x0001  /* file has an ID3 tag */
+#define  IDX_FLAG_ID3V2         0x0002  /* title and artist are from an ID3v2 tag */
+#define  IDX_FLAG_TOC           0x0004  /* file has a seek table record */
+
+
+/* extent record size and word offsets */
+#define  IDX_EXTENT_WORDS       4
+#define  IDX_EXTENTS_PER_SECTOR (IDE_BLOCK_SIZE / IDX_EXTENT_WORDS)
+
+#define  IDX_EXT_CLUSTER        0       /* starting cluster of the run (2 words) */
+#define  IDX_EXT_COUNT          2       /* number of clusters in the run (2 words) */
+
+
+/* seek table record size (SEEK_TOC_SIZE bytes) and word offsets */
+#define  IDX_TOC_WORDS          50
+#define  IDX_TOCS_PER_SECTOR    (IDE_BLOCK_SIZE / IDX_TOC_WORDS)
+
+#define  IDX_TOC_TABLE          0       /* the seek table (SEEK_TOC_SIZE bytes) */
+
+
+
+
+/* macros */
+
+/* get a word, long, or byte from a sector of the index (array of words) */
+#define  IDX_WORD(b, w)         ((unsigned int) ((b)[w] & 0xFFFF))
+#define  IDX_LONG(b, w)         (((unsigned long int) ((b)[w] & 0xFFFF)) | \
+                                 (((unsigned long int) ((b)[(w) + 1] & 0xFFFF)) << 16))
+#define  IDX_BYTE(b, w, i)      (((b)[(w) + ((i) / 2)] >> (8 * ((i) % 2))) & 0xFF)
+
+
+
+
+/* structures, unions, and typedefs */
+    /* none */
+
+
+
+
+/* function declarations */
+    /* none */
+
+
+#endif
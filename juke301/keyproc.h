@@ -19,6 +19,8 @@
                                  Project).
       6/5/08   Glen George       Added declarations for dec_FFRev_rate() and
                                  inc_FFRev_rate() functions.
+      6/13/16  Tim Liu           Added declaration for init_track_keys().
+      6/15/16  Tim Liu           Added declaration for cont_PlayAll().
 */
 
 
@@ -53,12 +55,14 @@
 enum status  no_action(enum status);      /* nothing to do */
 enum status  stop_idle(enum status);      /* <Stop> when doing nothing */
 
+void         init_track_keys(void);       /* initialize track key repeating */
 enum status  do_TrackUp(enum status);     /* go to the next track */
 enum status  do_TrackDown(enum status);   /* go to the previous track */
 
 enum status  start_Play(enum status);     /* begin playing the current track */
 enum status  begin_Play(enum status);     /* start playing from fast forward or reverse */
 enum status  stop_Play(enum status);      /* stop playing */
+enum status  cont_PlayAll(enum status);   /* switch to playing all tracks from play */
 
 enum status  start_RptPlay(enum status);  /* begin repeatedly playing the current track */
 enum status  cont_RptPlay(enum status);   /* switch to repeat play from standard play */
@@ -14,15 +14,17 @@
    The functions included are:
       do_TrackUp      - go to the next track (key processing function)
       do_TrackDown    - go to the previous track (key processing function)
+      init_track_keys - initialize the track key repeat counting
       no_action       - nothing to do (key processing function)
       no_update       - nothing to do (update function)
       stop_idle       - stop when doing nothing (key processing function)
 
    The local functions included are:
-      none
+      track_step      - get the number of entries to move for a track key
 
-   The global variable definitions included are:
-      none
+   The locally global variable definitions included are:
+      last_track_key  - the last track key pressed
+      track_repeats   - number of times the track key has repeated
 
 
    Revision History
@@ -37,6 +39,16 @@
       6/5/03   Glen George       Added #include of fatutil.h for function
                                  declarations needed by above change.
       6/5/03   Glen George       Updated function headers.
+      6/13/16  Tim Liu           Changed do_TrackUp and do_TrackDown to jump
+                                 by TRACK_JUMP_SIZE entries when the key is
+                                 held down (auto-repeating), added
+                                 init_track_keys() and track_step().
+      6/14/16  Tim Liu           Changed no_update to read ahead the ID3 tags
+                                 of nearby tracks.
+      6/16/16  Tim Liu           Local function declarations are static (gcc
+                                 requires it for the Linux host build).
+      6/16/16  Tim Liu           no_update also reads ahead the probe results
+                                 of nearby tracks (in fill_tag_cache()).
 */
 
 
@@ -55,6 +67,20 @@
 
 
 
+/* local function declarations */
+static  int  track_step(int);           /* entries to move for a track key */
+
+
+
+
+/* locally global variables */
+
+static  int  last_track_key;    /* last track key pressed */
+static  int  track_repeats;     /* times the track key has repeated */
+
+
+
+
 /*
    no_action
 
@@ -99,8 +125,9 @@ enum status  no_action(enum status cur_status)
 
    Description:      This function handles the <Track Up> key when nothing is
                      happening in the system.  It moves to the previous entry
-                     in the directory and resets the track time and loads the
-                     track information for the new track.
+                     in the directory (or jumps back several entries if the
+                     key is being held down) and resets the track time and
+                     loads the track information for the new track.
 
    Arguments:        cur_status (enum status) - the current system status.
    Return Value:     (enum status) - the new status (same as current status).
@@ -116,7 +143,7 @@ enum status  no_action(enum status cur_status)
    Shared Variables: None.
 
    Author:           Glen George
-   Last Modified:    June 5, 2003
+   Last Modified:    June 13, 2016
 
 */
 
@@ -127,8 +154,8 @@ enum status  do_TrackUp(enum status cur_status)
 
 
 
-    /* move to the previous directory entry, watching for errors */
-    if (!get_previous_dir_entry())
+    /* move to the previous directory entry(s), watching for errors */
+    if (!move_dir_entry(-track_step(KEY_TRACKUP)))
         /* successfully got the new entry, load its data */
         setup_cur_track_info();
     else
@@ -155,8 +182,9 @@ enum status  do_TrackUp(enum status cur_status)
 
    Description:      This function handles the <Track Down> key when nothing
                      is happening in the system.  It moves to the next entry
-                     in the directory and resets the track time and loads the
-                     track information for the new track.
+                     in the directory (or jumps ahead several entries if the
+                     key is being held down) and resets the track time and
+                     loads the track information for the new track.
 
    Arguments:        cur_status (enum status) - the current system status.
    Return Value:     (enum status) - the new status (same as current status).
@@ -172,7 +200,7 @@ enum status  do_TrackUp(enum status cur_status)
    Shared Variables: None.
 
    Author:           Glen George
-   Last Modified:    June 5, 2003
+   Last Modified:    June 13, 2016
 
 */
 
@@ -183,8 +211,8 @@ enum status  do_TrackDown(enum status cur_status)
 
 
 
-    /* move to the next directory entry, watching for errors */
-    if (!get_next_dir_entry())
+    /* move to the next directory entry(s), watching for errors */
+    if (!move_dir_entry(track_step(KEY_TRACKDOWN)))
         /* successfully got the new entry, load its data */
         setup_cur_track_info();
     else
@@ -257,7 +285,9 @@ enum status  stop_idle(enum status cur_status)
    no_update
 
    Description:      This function handles updates when there is nothing to
-                     do.  It just returns with the status unchanged.
+                     do.  It reads ahead the ID3 tag or probe results of
+                     a nearby track (so browsing doesn't wait for the hard
+                     drive) and returns with the status unchanged.
 
    Arguments:        cur_status (enum status) - the current system status.
    Return Value:     (enum status) - the new status (same as current status).
@@ -273,7 +303,7 @@ enum status  stop_idle(enum status cur_status)
    Shared Variables: None.
 
    Author:           Glen George
-   Last Modified:    Mar. 5, 1994
+   Last Modified:    June 16, 2016
 
 */
 
@@ -284,7 +314,122 @@ enum status  no_update(enum status cur_status)
 
 
 
-    /* nothing to do - return with the status unchanged */
+    /* use the time to read ahead track information */
+    fill_tag_cache();
+
+
+    /* nothing else to do - return with the status unchanged */
     return  cur_status;
 
 }
+
+
+
+
+/*
+   init_track_keys
+
+   Description:      This function initializes the counting of repeated
+                     track keys so the first track key only moves one entry.
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: last_track_key - set to KEY_ILLEGAL (no track key).
+                     track_repeats  - set to zero (0).
+
+   Author:           Tim Liu
+   Last Modified:    June 13, 2016
+
+*/
+
+void  init_track_keys()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* no track key has been pressed yet */
+    last_track_key = KEY_ILLEGAL;
+    track_repeats = 0;
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   track_step
+
+   Description:      This function returns the number of directory entries
+                     a track key should move.  If the same track key comes
+                     again within TRACK_REPEAT_TIME (the key is held down and
+                     auto-repeating) TRACK_JUMP_REPEATS times in a row, the
+                     key moves TRACK_JUMP_SIZE entries, otherwise it moves
+                     one entry.
+
+   Arguments:        key (int) - the track key (KEY_TRACKUP or
+                                 KEY_TRACKDOWN).
+   Return Value:     (int) - the number of entries to move.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: last_track_key - accessed and set to the passed key.
+                     track_repeats  - updated with the times the key has
+                                      repeated.
+
+   Author:           Tim Liu
+   Last Modified:    June 13, 2016
+
+*/
+
+static  int  track_step(int key)
+{
+    /* variables */
+    int  step = 1;              /* entries to move */
+
+
+
+    /* check if the key is repeating (only counting up to the jump) */
+    if ((key == last_track_key) && (elapsed_time() < TRACK_REPEAT_TIME))  {
+        /* it is repeating, count it */
+        if (track_repeats < TRACK_JUMP_REPEATS)
+            track_repeats++;
+    }
+    else  {
+        /* not repeating, start counting again */
+        track_repeats = 0;
+    }
+
+    /* remember the key for next time */
+    last_track_key = key;
+
+
+    /* if repeated enough times, jump */
+    if (track_repeats >= TRACK_JUMP_REPEATS)
+        step = TRACK_JUMP_SIZE;
+
+
+    /* return the number of entries to move */
+    return  step;
+
+}
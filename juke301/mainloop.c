@@ -37,6 +37,14 @@
       6/5/03   Glen George       Updated function headers.
       3/14/13  Glen George       Changed code to match new interfaces for
                                  init_FAT_system() and get_first_dir_entry().
+      6/13/16  Tim Liu           Added initialization of the track keys.
+      6/15/16  Tim Liu           <Play> while playing switches to play all
+                                 (cont_PlayAll).
+      6/16/16  Tim Liu           Added configuration of the play buffer ring.
+      6/16/16  Tim Liu           In the Linux host build (LINUX) main() takes
+                                 the command line and sets up the simulated
+                                 hardware first.  Local function
+                                 declarations are static (gcc requires it).
 */
 
 
@@ -51,12 +59,15 @@
 #include  "updatfnc.h"
 #include  "trakutil.h"
 #include  "fatutil.h"
+#ifdef  LINUX
+#include  "host.h"
+#endif
 
 
 
 
 /* local function declarations */
-enum keycode  key_lookup(void);      /* translate key values into keycodes */
+static  enum keycode  key_lookup(void);      /* translate key values into keycodes */
 
 
 
@@ -68,10 +79,13 @@ enum keycode  key_lookup(void);      /* translate key values into keycodes */
                      Jukebox.  It loops getting keys from the keypad,
                      processing those keys as is appropriate.  It also handles
                      updating the display and setting up the buffers for MP3
-                     playback.
+                     playback.  In the Linux host build the simulated
+                     hardware is set up from the command line first.
 
-   Arguments:        None.
-   Return Value:     (int) - return code, always 0 (never returns).
+   Arguments:        None (argc and argv in the Linux host build).
+   Return Value:     (int) - return code, always 0 (never returns), except
+                     in the Linux host build if the simulated hardware
+                     can't be set up (then it is 1).
 
    Input:            Keys from the keypad.
    Output:           Status information to the display.
@@ -87,11 +101,15 @@ enum keycode  key_lookup(void);      /* translate key values into keycodes */
    Shared Variables: None.
 
    Author:           Glen George
-   Last Modified:    March 14, 2013
+   Last Modified:    June 16, 2016
 
 */
 
+#ifdef  LINUX
+int  main(int argc, char *argv[])
+#else
 int  main()
+#endif
 {
     /* variables */
     enum keycode  key;                      /* an input key */
@@ -122,7 +140,7 @@ int  main()
         /* idle           play            fast forward   reverse                  key         */
       { {  do_TrackUp,    no_action,      no_action,     no_action     },   /* <Track Up>     */
         {  do_TrackDown,  no_action,      no_action,     no_action     },   /* <Track Down>   */
-        {  start_Play,    no_action,      begin_Play,    begin_Play    },   /* <Play>         */
+        {  start_Play,    cont_PlayAll,   begin_Play,    begin_Play    },   /* <Play>         */
         {  start_RptPlay, cont_RptPlay,   begin_RptPlay, begin_RptPlay },   /* <Repeat Play>  */
         {  start_FastFwd, switch_FastFwd, stop_FFRev,    begin_FastFwd },   /* <Fast Forward> */
         {  start_Reverse, switch_Reverse, begin_Reverse, stop_FFRev    },   /* <Reverse>      */
@@ -132,8 +150,17 @@ int  main()
 
 
     /* first initialize everything */
+#ifdef  LINUX
+    /* on the host, setup the simulated hardware (disk image and keys) */
+    if (!host_init(argc, argv))
+        return  1;
+#endif
     /* initialize FAT directory functions */
     error = init_FAT_system();
+    /* and the track keys */
+    init_track_keys();
+    /* and the play buffer ring */
+    (void) set_play_buffers(DEF_BUFFERS, DEF_BUFFER_BLOCKS);
 
     /* get the first directory entry (file/song) */
     if (!error)  {
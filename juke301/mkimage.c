@@ -0,0 +1,2850 @@
+/****************************************************************************/
+/*                                                                          */
+/*                                 MKIMAGE                                  */
+/*                     Synthetic FAT Disk Image Generator                   */
+/*                           MP3 Jukebox Project                            */
+/*                                EE/CS 52                                  */
+/*                                                                          */
+/****************************************************************************/
+
+/*
+   This file contains a host tool (built by host.sh) that builds a bare
+   FAT16 or FAT32 volume from a directory of MP3 files for the Linux host
+   build of the MP3 Jukebox (juke) and its benchmarks (bench.sh).  The layout
+   of the volume is controlled so the FAT code can be tested with large
+   directories, deep trees, and fragmented files.  The command line is
+      mkimage [options] image mp3dir
+   and the options are:
+      -f 16|32      FAT type (default 16)
+      -c sectors    sectors per cluster (power of 2, default 8)
+      -n files      number of files (the MP3 files are used over as needed,
+                    default the number of MP3 files)
+      -t bytes      most bytes of audio (after any ID3v2 tag) of each MP3
+                    file to use (default all)
+      -o order      directory order: name, size, random, or reverse (default
+                    name)
+      -a order      order of the files on the disk: dir (the directory
+                    order), reverse, or random (default dir)
+      -r clusters   fragment run length (default 0, not fragmented)
+      -i files      files interleaved on the disk (default 1)
+      -g clusters   free clusters left after each run (default 0)
+      -l length     pad long filenames to at least this length
+      -8            only 8.3 filenames (no long filename entries)
+      -j            write the library index (\JUKEBOX.IDX, see jukeidx.h)
+      -x entries    deleted (0xE5) entries before each directory entry
+      -p files      most files in each directory (default 0, no limit)
+      -d depth      most levels of subdirectories (default 0)
+      -b dirs       subdirectories in each directory (default 1)
+      -s seed       seed for the random orders (default 1)
+      -m manifest   manifest file (default the image name with .man added)
+   The files fill the directories depth first.  Each directory holds up to
+   the -p number of files and directories less than -d levels down have up
+   to -b subdirectories.  The short names are Tnnnnnnn.MP3 and Dnnnnnnn and
+   the long names are the MP3 file name with the file number added (the
+   folders are "Folder nnnn").  With fragmenting, the files are allocated in
+   groups of -i files taking turns allocating -r clusters at a time.
+
+   With -j the library index is the last entry in the root directory and
+   its data is after all of the other files.  It has a record for every
+   directory and every entry the jukebox would show in them, with the ID3
+   tag title, artist, and time taken from the end of each file's data and
+   what probe_track() finds at the start of it (frameidx.c is linked in to
+   probe the files the same way the jukebox does).  The jukebox itself can't
+   make the index: its FAT and IDE code only read the drive, and walking
+   every directory and reading every tag is the work the index is there to
+   save.
+
+   The manifest has a line for each directory and file (tab separated):
+      type (d, f, or i for the index), short path, long path, first
+      cluster, bytes, source file, extents
+   where the extents are the sectors the data is in (from the start of the
+   volume) as sector+count separated by spaces.  They can be checked
+   against get_file_blocks() and the source files byte for byte (check.sh
+   does this by browsing to every file).
+
+   The functions included are:
+      main          - build the image and manifest
+   and for probe_track() (the rest of frameidx.c isn't used, they are only
+   there so it links):
+      get_cur_file_sector  - get the starting sector of the file (0)
+      get_cur_file_size    - get the size of the file being probed
+      get_file_blocks      - get data blocks from the file being probed
+      get_track_length     - get the length of the track (not used)
+      get_track_start      - get where the audio starts (not used)
+      get_track_toc        - get the seek table of the track (not used)
+      get_track_total_time - get the time of the track (not used)
+
+   The local functions included are:
+      alloc_index   - size and allocate the library index
+      alloc_run     - allocate clusters to a chain
+      alloc_volume  - allocate the directories and files
+      build_tree    - put the files into directories
+      chain_runs    - get the runs of consecutive clusters in a chain
+      dir_entries   - get the number of entries in a directory
+      fat_geometry  - get the layout of the volume
+      lfn_count     - get the number of long filename entries for a name
+      make_entry    - build the directory entries for a file or directory
+      make_names    - make the short and long names
+      make_record   - build a library index entry record
+      new_dir       - add a directory to the tree
+      next_random   - get the next pseudo-random number
+      order_files   - put the files in directory and disk order
+      probe_file    - probe the start of a file's data
+      put_long      - store a little-endian long
+      put_word      - store a little-endian word
+      read_sources  - get the MP3 files in the source directory
+      write_chain   - write data to the clusters of a chain
+      write_dir     - write a directory
+      write_file    - write a file
+      write_image   - write the volume
+      write_index   - write the library index
+      write_manifest - write the manifest
+
+   The locally global variable definitions included are:
+      alloc_order   - order of the files on the disk
+      branch        - subdirectories in each directory
+      clus_sectors  - sectors per cluster
+      data_clusters - clusters in the data area
+      data_start    - first sector of the data area
+      deleted       - deleted entries before each entry
+      depth         - most levels of subdirectories
+      dirs          - the directories
+      disk_list     - the files in disk order
+      fat           - the FAT (as next clusters)
+      fat_sectors   - sectors in each FAT
+      fat_size      - entries allocated in fat
+      fat_type      - 16 or 32
+      files         - the files (in directory order)
+      frag_gap      - free clusters after each run
+      frag_run      - fragment run length
+      idx_bytes     - bytes in the library index
+      idx_entries   - entry records in the library index
+      idx_extents   - extent records in the library index
+      idx_first     - first cluster of the library index
+      idx_last      - last cluster of the library index
+      idx_tocs      - seek table records in the library index
+      img           - the image file
+      interleave    - files interleaved on the disk
+      lfn_len       - length to pad long filenames to
+      make_index    - write the library index
+      max_bytes     - most bytes of each MP3 file to use
+      n_dirs        - number of directories
+      n_files       - number of files
+      n_sources     - number of MP3 files
+      next_free     - next cluster to allocate
+      per_dir       - most files in each directory
+      probe_bytes   - bytes in the file being probed
+      probe_src     - MP3 file of the file being probed
+      random_state  - state of the pseudo-random numbers
+      reserved      - reserved sectors
+      root_entries  - entries in a FAT16 root directory
+      root_sectors  - sectors in a FAT16 root directory
+      short_only    - only 8.3 filenames
+      sources       - the MP3 files (and their ID3v2 tag sizes)
+      total_sectors - sectors in the volume
+
+
+   Revision History
+      6/16/16  Tim Liu           Initial revision.
+      6/16/16  Tim Liu           Added the -j option to write the library
+                                 index.
+      6/16/16  Tim Liu           The library index (version 2) has the probe
+                                 results of the files (probe_track() from
+                                 frameidx.c) and their seek tables.
+*/
+
+
+
+/* library include files */
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <strings.h>
+#include  <dirent.h>
+#include  <unistd.h>
+#include  <sys/stat.h>
+#include  <sys/types.h>
+
+/* local include files */
+#include  "mp3defs.h"
+#include  "vfat.h"
+#include  "frameidx.h"
+#include  "fatutil.h"
+#include  "trakutil.h"
+#include  "jukeidx.h"
+
+
+
+
+/* local definitions */
+
+#define  SECTOR_BYTES        (2 * IDE_BLOCK_SIZE)   /* bytes in a sector */
+#define  ENTRY_BYTES         (2 * DIR_ENTRY_SIZE)   /* bytes in an entry */
+#define  SHORT_NAME_LEN      (DOS_FILENAME_LEN + DOS_EXTENSION_LEN)
+#define  MAX_NAME            (MAX_LFN_LEN - 1)      /* longest long name */
+#define  MAX_FILES           9999999L   /* most files (short names) */
+
+/* FAT layout */
+#define  FAT16_RESERVED      1          /* reserved sectors for FAT16 */
+#define  FAT32_RESERVED      32         /* reserved sectors for FAT32 */
+#define  MIN_ROOT_ENTRIES    512        /* smallest FAT16 root directory */
+#define  MIN_FAT16_CLUSTERS  4085       /* cluster counts for each type */
+#define  MAX_FAT16_CLUSTERS  65524L
+#define  MIN_FAT32_CLUSTERS  65525L
+#define  MAX_FAT32_CLUSTERS  0x0FFFFFF5L
+#define  FIRST_CLUSTER       2          /* first data cluster */
+#define  END_CHAIN           0xFFFFFFFFUL   /* end of a chain in fat[] */
+
+/* boot sector offsets */
+#define  BOOT_FSINFO         1          /* FAT32 FSInfo sector */
+#define  BOOT_BACKUP         6          /* FAT32 backup boot sector */
+
+/* directory entry fields (byte offsets) */
+#define  ENTRY_ATTRIB        11
+#define  ENTRY_CLUSTER_HI    20
+#define  ENTRY_TIME          22
+#define  ENTRY_DATE          24
+#define  ENTRY_CLUSTER_LO    26
+#define  ENTRY_SIZE          28
+#define  LFN_CHECKSUM        13
+
+/* time stamp of everything (12:00:00 June 16, 2016) */
+#define  STAMP_TIME          (12 << 11)
+#define  STAMP_DATE          (((2016 - 1980) << 9) | (6 << 5) | 16)
+
+/* directory and disk orders */
+#define  ORDER_NAME          0          /* directory orders */
+#define  ORDER_SIZE          1
+#define  ORDER_RANDOM        2
+#define  ORDER_REVERSE       3
+#define  ORDER_DIR           4          /* disk order is directory order */
+
+#define  NO_DIR              (-1)       /* no directory */
+
+/* library index record sizes (in bytes) */
+#define  IDX_DIR_BYTES       (2 * IDX_DIR_WORDS)
+#define  IDX_ENTRY_BYTES     (2 * IDX_ENTRY_WORDS)
+#define  IDX_EXTENT_BYTES    (2 * IDX_EXTENT_WORDS)
+#define  IDX_TOC_BYTES       (2 * IDX_TOC_WORDS)
+
+/* pseudo-random number generator (linear congruential, as in hostide.c) */
+#define  RANDOM_MULT         1103515245UL
+#define  RANDOM_ADD          12345UL
+#define  RANDOM_MASK         0x7FFFFFFFUL
+
+
+
+
+/* structures, unions, and typedefs */
+
+/* an MP3 source file */
+struct  source  {
+                   char      *path;             /* path of the file */
+                   char      *name;             /* name without the path */
+                   long int   bytes;            /* size of the file */
+                   long int   tag;              /* size of its ID3v2 tag */
+                };
+
+/* a file in the image */
+struct  img_file  {
+                     int                src;    /* the source file */
+                     long int           bytes;  /* bytes in the file */
+                     long int           left;   /* clusters to allocate */
+                     int                dir;    /* directory it's in */
+                     char               short_name[SHORT_NAME_LEN + 1];
+                     char               long_name[MAX_LFN_LEN];
+                     unsigned long int  first;  /* first cluster */
+                     unsigned long int  last;   /* last cluster */
+                     struct track_header  probe;    /* what probing finds */
+                  };
+
+/* a directory in the image */
+struct  img_dir  {
+                    int                parent;  /* parent directory */
+                    int                level;   /* levels down */
+                    int                n_files; /* files in it */
+                    int                n_subs;  /* subdirectories in it */
+                    char               short_name[SHORT_NAME_LEN + 1];
+                    char               long_name[MAX_LFN_LEN];
+                    unsigned long int  first;   /* first cluster */
+                    unsigned long int  last;    /* last cluster */
+                 };
+
+
+
+
+/* local function declarations */
+static  int   alloc_index(void);                    /* allocate the index */
+static  int   alloc_run(unsigned long int *, unsigned long int *, long int);
+static  int   alloc_volume(void);                   /* allocate everything */
+static  int   build_tree(void);                     /* files to directories */
+static  long int  chain_runs(unsigned long int, unsigned char *);   /* runs */
+static  long int  dir_entries(int);                 /* entries in a directory */
+static  int   fat_geometry(void);                   /* layout of the volume */
+static  int   lfn_count(const char *);              /* long filename entries */
+static  int   make_entry(unsigned char *, const char *, const char *, int,
+                         unsigned long int, long int);  /* directory entries */
+static  void  make_names(void);                     /* short and long names */
+static  long int  make_record(unsigned char *, unsigned char *, long int,
+                              const char *, const char *, int, unsigned long int,
+                              long int, const unsigned char *,
+                              const struct track_header *, long int);   /* index */
+static  int   new_dir(int);                         /* add a directory */
+static  unsigned long int  next_random(void);       /* pseudo-random number */
+static  int   order_files(int);                     /* directory/disk order */
+static  int   probe_file(int);                      /* probe a file */
+static  void  put_long(unsigned char *, unsigned long int);
+static  void  put_word(unsigned char *, unsigned int);
+static  int   read_sources(const char *);           /* get the MP3 files */
+static  int   write_chain(unsigned long int, const unsigned char *, long int);
+static  int   write_dir(int);                       /* write a directory */
+static  int   write_file(int);                      /* write a file */
+static  int   write_image(void);                    /* write the volume */
+static  int   write_index(void);                    /* write the index */
+static  int   write_manifest(const char *);         /* write the manifest */
+
+
+
+
+/* locally global variables */
+
+/* options */
+static  int                 fat_type = 16;      /* FAT16 or FAT32 */
+static  int                 clus_sectors = 8;   /* sectors per cluster */
+static  long int            max_bytes;          /* most bytes per file */
+static  int                 alloc_order = ORDER_DIR;    /* disk order */
+static  long int            frag_run;           /* fragment run length */
+static  int                 interleave = 1;     /* files interleaved */
+static  long int            frag_gap;           /* free clusters after runs */
+static  int                 lfn_len;            /* long name length */
+static  int                 short_only;         /* only 8.3 names */
+static  int                 deleted;            /* deleted entries */
+static  int                 make_index;         /* write the library index */
+static  int                 per_dir;            /* files per directory */
+static  int                 depth;              /* levels of directories */
+static  int                 branch = 1;         /* subdirectories per dir */
+static  unsigned long int   random_state = 1;   /* random number state */
+
+/* the files and directories */
+static  struct source      *sources;            /* the MP3 files */
+static  int                 n_sources;          /* number of MP3 files */
+static  struct img_file    *files;              /* files (directory order) */
+static  int                *disk_list;          /* files (disk order) */
+static  int                 n_files;            /* number of files */
+static  struct img_dir     *dirs;               /* the directories */
+static  int                 n_dirs;             /* number of directories */
+
+/* the volume */
+static  unsigned long int  *fat;                /* next cluster of each */
+static  unsigned long int   fat_size;           /* entries in fat[] */
+static  unsigned long int   next_free = FIRST_CLUSTER;  /* next to allocate */
+static  unsigned long int   data_clusters;      /* clusters in the volume */
+static  long int            reserved;           /* reserved sectors */
+static  long int            fat_sectors;        /* sectors in each FAT */
+static  long int            root_entries;       /* FAT16 root entries */
+static  long int            root_sectors;       /* FAT16 root sectors */
+static  long int            data_start;         /* first data sector */
+static  long int            total_sectors;      /* sectors in the volume */
+
+/* the library index */
+static  long int            idx_entries;        /* entry records */
+static  long int            idx_extents;        /* extent records */
+static  long int            idx_bytes;          /* bytes in the index */
+static  unsigned long int   idx_first;          /* first cluster */
+static  unsigned long int   idx_last;           /* last cluster */
+static  long int            idx_tocs;           /* seek table records */
+
+/* the file being probed */
+static  FILE               *probe_src;          /* its MP3 file */
+static  long int            probe_bytes;        /* bytes in it */
+static  FILE               *img;                /* the image file */
+
+
+
+
+/*
+   main
+
+   Description:      This function builds the image and manifest from the
+                     command line (see the top of the file).
+
+   Arguments:        argc (int)      - number of command line arguments.
+                     argv (char *[]) - the command line arguments.
+   Return Value:     (int) - 0 if the image was built, 1 if there was an
+                     error.
+
+   Input:            The MP3 files.
+   Output:           The image and manifest files, errors to stderr.
+
+   Error Handling:   A bad command line outputs the usage and any other
+                     error outputs a message, in both cases 1 is returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: All of the options are set from the command line.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  main(int argc, char *argv[])
+{
+    /* variables */
+    static const char * const  orders[] =   /* names of the orders */
+        {  "name",  "size",  "random",  "reverse",  "dir"  };
+
+    char  manifest[MAX_PATH_CHARS];     /* manifest file name */
+
+    int   dir_order = ORDER_NAME;       /* directory order */
+    int   opt;                          /* the option */
+    int   i;                            /* order index */
+
+    int   ok = TRUE;                    /* image is being built */
+
+
+
+    /* get the options */
+    n_files = 0;
+    manifest[0] = '\0';
+    while (ok && ((opt = getopt(argc, argv, "f:c:n:t:o:a:r:i:g:l:8jx:p:d:b:s:m:")) != -1))  {
+
+        switch (opt)  {
+            case 'f':   fat_type = atoi(optarg);
+                        ok = (fat_type == 16) || (fat_type == 32);
+                        break;
+            case 'c':   clus_sectors = atoi(optarg);
+                        ok = (clus_sectors > 0) && (clus_sectors <= 128) &&
+                             ((clus_sectors & (clus_sectors - 1)) == 0);
+                        break;
+            case 'n':   n_files = atoi(optarg);
+                        ok = (n_files > 0) && (n_files <= MAX_FILES);
+                        break;
+            case 't':   max_bytes = atol(optarg);
+                        ok = (max_bytes >= 0);
+                        break;
+            case 'o':
+            case 'a':   /* find the order */
+                        for (i = 0; (i <= ORDER_DIR) && (strcmp(optarg, orders[i]) != 0); i++);
+                        /* and check that it is allowed */
+                        if (opt == 'o')  {
+                            dir_order = i;
+                            ok = (i < ORDER_DIR);
+                        }
+                        else  {
+                            alloc_order = i;
+                            ok = (i == ORDER_DIR) || (i == ORDER_RANDOM) || (i == ORDER_REVERSE);
+                        }
+                        break;
+            case 'r':   frag_run = atol(optarg);
+                        ok = (frag_run >= 0);
+                        break;
+            case 'i':   interleave = atoi(optarg);
+                        ok = (interleave > 0);
+                        break;
+            case 'g':   frag_gap = atol(optarg);
+                        ok = (frag_gap >= 0);
+                        break;
+            case 'l':   lfn_len = atoi(optarg);
+                        ok = (lfn_len >= 0) && (lfn_len <= MAX_NAME);
+                        break;
+            case '8':   short_only = TRUE;
+                        break;
+            case 'j':   make_index = TRUE;
+                        break;
+            case 'x':   deleted = atoi(optarg);
+                        ok = (deleted >= 0);
+                        break;
+            case 'p':   per_dir = atoi(optarg);
+                        ok = (per_dir >= 0);
+                        break;
+            case 'd':   depth = atoi(optarg);
+                        ok = (depth >= 0) && (depth < MAX_NUM_SUBDIRS);
+                        break;
+            case 'b':   branch = atoi(optarg);
+                        ok = (branch > 0);
+                        break;
+            case 's':   random_state = strtoul(optarg, NULL, 0);
+                        break;
+            case 'm':   ok = (strlen(optarg) < MAX_PATH_CHARS);
+                        if (ok)
+                            strcpy(manifest, optarg);
+                        break;
+            default:    ok = FALSE;
+                        break;
+        }
+    }
+
+    /* need the image and the source directory */
+    if (!ok || ((argc - optind) != 2) || (strlen(argv[optind]) >= (MAX_PATH_CHARS - 4)))  {
+        fprintf(stderr, "usage: %s [-f 16|32] [-c sectors] [-n files] [-t bytes]\n"
+                        "       [-o name|size|random|reverse] [-a dir|reverse|random]\n"
+                        "       [-r clusters] [-i files] [-g clusters] [-l length] [-8] [-j]\n"
+                        "       [-x entries] [-p files] [-d depth] [-b dirs] [-s seed]\n"
+                        "       [-m manifest] image mp3dir\n", argv[0]);
+        ok = FALSE;
+    }
+    else if (manifest[0] == '\0')  {
+        /* default manifest name */
+        sprintf(manifest, "%s.man", argv[optind]);
+    }
+
+
+    /* build it */
+    ok = ok && read_sources(argv[optind + 1]);
+    ok = ok && order_files(dir_order);
+    ok = ok && build_tree();
+    if (ok)
+        make_names();
+    ok = ok && alloc_volume();
+    ok = ok && alloc_index();
+    ok = ok && fat_geometry();
+
+    /* and write it */
+    if (ok)  {
+        img = fopen(argv[optind], "wb");
+        if (img == NULL)  {
+            perror(argv[optind]);
+            ok = FALSE;
+        }
+    }
+    ok = ok && write_image();
+    if ((img != NULL) && (fclose(img) != 0))  {
+        perror(argv[optind]);
+        ok = FALSE;
+    }
+    ok = ok && write_manifest(manifest);
+
+
+    /* return 0 if built, 1 if not */
+    return  !ok;
+
+}
+
+
+
+
+/*
+   get_cur_file_sector
+
+   Description:      This function stands in for the jukebox function
+                     (fatutil.c) so frameidx.c links.  It is only used by
+                     the frame index, not by probe_track().
+
+   Arguments:        None.
+   Return Value:     (unsigned long int) - always 0.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+unsigned long int  get_cur_file_sector()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* there is no disk */
+    return  0;
+
+}
+
+
+
+
+/*
+   get_cur_file_size
+
+   Description:      This function returns the size of the file being
+                     probed for probe_track() (the bytes of the MP3 file
+                     put in the image).
+
+   Arguments:        None.
+   Return Value:     (long int) - the size of the file in bytes.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: probe_bytes - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+long int  get_cur_file_size()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* return the size */
+    return  probe_bytes;
+
+}
+
+
+
+
+/*
+   get_file_blocks
+
+   Description:      This function reads blocks of the file being probed
+                     for probe_track() from its MP3 file.  Blocks past the
+                     end of the file aren't read and the end of the last
+                     block is filled with zeros.
+
+   Arguments:        block (unsigned long int) - first block of the file to
+                                                 read.
+                     length (int)              - number of blocks to read.
+                     buffer (unsigned short int far *) - where to put the
+                                                 data.
+   Return Value:     (int) - the number of blocks read.
+
+   Input:            The MP3 file.
+   Output:           None.
+
+   Error Handling:   A read error stops the read (fewer blocks are
+                     returned).
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: probe_bytes - accessed.
+                     probe_src   - read.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  get_file_blocks(unsigned long int block, int length, unsigned short int far *buffer)
+{
+    /* variables */
+    unsigned char  *p = (unsigned char *) buffer;   /* where the next block goes */
+
+    off_t           pos;            /* position of the next block */
+    long int        n;              /* bytes of the file in the block */
+
+    int             blocks = 0;     /* blocks read */
+    int             ok = TRUE;      /* no read error */
+
+
+
+    /* read a block at a time while in the file */
+    pos = (off_t) block * SECTOR_BYTES;
+    while (ok && (blocks < length) && (pos < probe_bytes))  {
+        n = ((probe_bytes - pos) < SECTOR_BYTES) ? (probe_bytes - pos) : SECTOR_BYTES;
+        memset(p, 0, SECTOR_BYTES);
+        ok = (fseeko(probe_src, pos, SEEK_SET) == 0) && (fread(p, n, 1, probe_src) == 1);
+        if (ok)
+            blocks++;
+        p += SECTOR_BYTES;
+        pos += SECTOR_BYTES;
+    }
+
+
+    /* return the blocks read */
+    return  blocks;
+
+}
+
+
+
+
+/*
+   get_track_length
+
+   Description:      This function stands in for the jukebox function
+                     (trakutil.c) so frameidx.c links.  It is only used by
+                     the frame index, not by probe_track().
+
+   Arguments:        None.
+   Return Value:     (long int) - the size of the file being probed.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: probe_bytes - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+long int  get_track_length()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* the whole file */
+    return  probe_bytes;
+
+}
+
+
+
+
+/*
+   get_track_start
+
+   Description:      This function stands in for the jukebox function
+                     (trakutil.c) so frameidx.c links.  It is only used by
+                     the frame index, not by probe_track().
+
+   Arguments:        None.
+   Return Value:     (long int) - always 0.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+long int  get_track_start()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* the start of the file */
+    return  0;
+
+}
+
+
+
+
+/*
+   get_track_toc
+
+   Description:      This function stands in for the jukebox function
+                     (trakutil.c) so frameidx.c links.  It is only used by
+                     the frame index, not by probe_track().
+
+   Arguments:        None.
+   Return Value:     (const unsigned char *) - always NULL (no seek table).
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+const unsigned char  *get_track_toc()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* no seek table */
+    return  NULL;
+
+}
+
+
+
+
+/*
+   get_track_total_time
+
+   Description:      This function stands in for the jukebox function
+                     (trakutil.c) so frameidx.c links.  It is only used by
+                     the frame index, not by probe_track().
+
+   Arguments:        None.
+   Return Value:     (int) - always 0 (time not known).
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+int  get_track_total_time()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* the time isn't known */
+    return  0;
+
+}
+
+
+
+
+/*
+   read_sources
+
+   Description:      This function gets the MP3 files (names ending in .mp3)
+                     in the passed directory, sorted by name, along with
+                     their sizes and the sizes of their ID3v2 tags.
+
+   Arguments:        dir_name (const char *) - the source directory.
+   Return Value:     (int) - TRUE if there are MP3 files, FALSE if not.
+
+   Input:            The source directory.
+   Output:           Errors to stderr.
+
+   Error Handling:   If the directory can't be read or has no MP3 files an
+                     error is output and FALSE is returned.
+
+   Algorithms:       The ID3v2 tag size is 7 bits in each of 4 bytes (sync
+                     safe) and doesn't include the header (or footer).
+   Data Structures:  None.
+
+   Shared Variables: n_files   - set to n_sources if it wasn't set.
+                     n_sources - set to the number of MP3 files.
+                     sources   - set to the MP3 files.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  read_sources(const char *dir_name)
+{
+    /* variables */
+    DIR            *d;          /* the source directory */
+    struct dirent  *e;          /* a directory entry */
+    struct stat     info;       /* information about a file */
+    FILE           *f;          /* an MP3 file */
+    unsigned char   hdr[ID3V2_HEADER_SIZE];    /* its ID3v2 tag header */
+    struct source   tmp;        /* for sorting */
+
+    size_t          len;        /* length of a name */
+
+    int             i;          /* general loop indices */
+    int             j;
+
+
+
+    /* read the directory */
+    d = opendir(dir_name);
+    if (d == NULL)
+        perror(dir_name);
+
+    while ((d != NULL) && ((e = readdir(d)) != NULL))  {
+
+        /* check for an MP3 file */
+        len = strlen(e->d_name);
+        if ((len > 4) && (strcasecmp(e->d_name + len - 4, ".mp3") == 0))  {
+
+            /* get the path and size */
+            sources = realloc(sources, (n_sources + 1) * sizeof(struct source));
+            sources[n_sources].path = malloc(strlen(dir_name) + len + 2);
+            sprintf(sources[n_sources].path, "%s/%s", dir_name, e->d_name);
+            sources[n_sources].name = sources[n_sources].path + strlen(dir_name) + 1;
+            if (stat(sources[n_sources].path, &info) == 0)  {
+                sources[n_sources].bytes = info.st_size;
+                /* get the size of the ID3v2 tag (if there is one) */
+                sources[n_sources].tag = 0;
+                f = fopen(sources[n_sources].path, "rb");
+                if ((f != NULL) && (fread(hdr, ID3V2_HEADER_SIZE, 1, f) == 1) && (memcmp(hdr, "ID3", 3) == 0))
+                    sources[n_sources].tag = ID3V2_HEADER_SIZE +
+                        (((long int) (hdr[ID3V2_SIZE] & 0x7F) << 21) |
+                         ((long int) (hdr[ID3V2_SIZE + 1] & 0x7F) << 14) |
+                         ((hdr[ID3V2_SIZE + 2] & 0x7F) << 7) | (hdr[ID3V2_SIZE + 3] & 0x7F)) +
+                        ((hdr[ID3V2_FLAGS] & ID3V2_FOOTER) ? ID3V2_HEADER_SIZE : 0);
+                if (f != NULL)
+                    fclose(f);
+                n_sources++;
+            }
+        }
+    }
+
+    if (d != NULL)
+        closedir(d);
+
+
+    /* sort them by name (so the image doesn't depend on the directory) */
+    for (i = 1; i < n_sources; i++)  {
+        tmp = sources[i];
+        for (j = i; (j > 0) && (strcmp(sources[j - 1].name, tmp.name) > 0); j--)
+            sources[j] = sources[j - 1];
+        sources[j] = tmp;
+    }
+
+
+    /* the default is one file for each MP3 file */
+    if (n_files == 0)
+        n_files = n_sources;
+
+    if ((d != NULL) && (n_sources == 0))
+        fprintf(stderr, "%s: no MP3 files\n", dir_name);
+
+
+    /* return whether there were MP3 files */
+    return  (n_sources > 0);
+
+}
+
+
+
+
+/*
+   order_files
+
+   Description:      This function makes the files (using the MP3 files
+                     over as needed) and puts them in the passed directory
+                     order.  Then the disk order is made from the directory
+                     order.
+
+   Arguments:        dir_order (int) - the directory order.
+   Return Value:     (int) - TRUE (the files are always ordered).
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       The files are insertion sorted by name (then by their
+                     number) or by size.  A random order is a Fisher-Yates
+                     shuffle.
+   Data Structures:  None.
+
+   Shared Variables: alloc_order - accessed.
+                     disk_list   - set to the disk order.
+                     files       - set to the files in directory order.
+                     max_bytes   - accessed.
+                     n_files     - accessed.
+                     sources     - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  order_files(int dir_order)
+{
+    /* variables */
+    struct img_file  tmp;       /* for sorting and shuffling */
+    int              t;
+
+    int              before;    /* a file goes before another */
+
+    int              i;         /* general loop indices */
+    int              j;
+
+
+
+    /* make the files, in source order */
+    files = calloc(n_files, sizeof(struct img_file));
+    disk_list = calloc(n_files, sizeof(int));
+    for (i = 0; i < n_files; i++)  {
+        files[i].src = i % n_sources;
+        files[i].bytes = sources[files[i].src].bytes;
+        if ((max_bytes > 0) && (files[i].bytes > (sources[files[i].src].tag + max_bytes)))
+            files[i].bytes = sources[files[i].src].tag + max_bytes;
+    }
+
+
+    /* put them in directory order */
+    if (dir_order == ORDER_RANDOM)  {
+        /* shuffle them */
+        for (i = n_files - 1; i > 0; i--)  {
+            j = next_random() % (i + 1);
+            tmp = files[i];
+            files[i] = files[j];
+            files[j] = tmp;
+        }
+    }
+    else  {
+        /* sort them (insertion sort, it is stable) */
+        for (i = 1; i < n_files; i++)  {
+            tmp = files[i];
+            j = i;
+            before = TRUE;
+            while ((j > 0) && before)  {
+                /* check if it goes before the previous file */
+                if (dir_order == ORDER_SIZE)
+                    before = (tmp.bytes < files[j - 1].bytes);
+                else if (dir_order == ORDER_REVERSE)
+                    before = (strcmp(sources[tmp.src].name, sources[files[j - 1].src].name) > 0);
+                else
+                    before = (strcmp(sources[tmp.src].name, sources[files[j - 1].src].name) < 0);
+                /* if it does, move the previous file up */
+                if (before)  {
+                    files[j] = files[j - 1];
+                    j--;
+                }
+            }
+            files[j] = tmp;
+        }
+    }
+
+
+    /* now the disk order */
+    for (i = 0; i < n_files; i++)
+        disk_list[i] = (alloc_order == ORDER_REVERSE) ? (n_files - 1 - i) : i;
+    if (alloc_order == ORDER_RANDOM)  {
+        for (i = n_files - 1; i > 0; i--)  {
+            j = next_random() % (i + 1);
+            t = disk_list[i];
+            disk_list[i] = disk_list[j];
+            disk_list[j] = t;
+        }
+    }
+
+
+    /* the files are ordered */
+    return  TRUE;
+
+}
+
+
+
+
+/*
+   build_tree
+
+   Description:      This function puts the files (in directory order) into
+                     directories.  Each directory gets up to per_dir files
+                     (all of them if per_dir is 0) and then the next
+                     directory is made, depth first.
+
+   Arguments:        None.
+   Return Value:     (int) - TRUE if the files fit in the tree, FALSE if
+                     not.
+
+   Input:            None.
+   Output:           Errors to stderr.
+
+   Error Handling:   If the tree runs out of directories an error is output
+                     and FALSE is returned.
+
+   Algorithms:       A directory less than depth levels down with less than
+                     branch subdirectories gets a new subdirectory, otherwise
+                     its parent is tried, and so on up to the root.
+   Data Structures:  None.
+
+   Shared Variables: branch  - accessed.
+                     depth   - accessed.
+                     dirs    - directories added.
+                     files   - directory of each file set.
+                     n_dirs  - updated.
+                     n_files - accessed.
+                     per_dir - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  build_tree()
+{
+    /* variables */
+    int  cur;                   /* directory being filled */
+    int  p;                     /* directory getting a subdirectory */
+
+    int  i;                     /* general loop index */
+
+
+
+    /* there can't be more directories than files (plus the root) */
+    dirs = calloc(n_files + 1, sizeof(struct img_dir));
+    cur = new_dir(NO_DIR);
+
+
+    /* put each file in a directory */
+    for (i = 0; (i < n_files) && (cur != NO_DIR); i++)  {
+
+        /* if the directory is full move on to the next one */
+        if ((per_dir > 0) && (dirs[cur].n_files >= per_dir))  {
+            /* find the closest directory that can have a subdirectory */
+            for (p = cur; (p != NO_DIR) && ((dirs[p].level >= depth) || (dirs[p].n_subs >= branch)); p = dirs[p].parent);
+            cur = (p == NO_DIR) ? NO_DIR : new_dir(p);
+        }
+
+        /* add the file to the directory */
+        if (cur != NO_DIR)  {
+            files[i].dir = cur;
+            dirs[cur].n_files++;
+        }
+    }
+
+    if (cur == NO_DIR)
+        fprintf(stderr, "the files don't fit in the directory tree (-p, -d, -b)\n");
+
+
+    /* return whether or not the files fit */
+    return  (cur != NO_DIR);
+
+}
+
+
+
+
+/*
+   new_dir
+
+   Description:      This function adds a directory to the tree as a
+                     subdirectory of the passed directory (or as the root).
+
+   Arguments:        parent (int) - the parent directory (NO_DIR for the
+                                    root).
+   Return Value:     (int) - the new directory.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: dirs   - directory added.
+                     n_dirs - incremented.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  new_dir(int parent)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* add the directory to its parent */
+    dirs[n_dirs].parent = parent;
+    if (parent == NO_DIR)  {
+        dirs[n_dirs].level = 0;
+    }
+    else  {
+        dirs[n_dirs].level = dirs[parent].level + 1;
+        dirs[parent].n_subs++;
+    }
+
+
+    /* return the new directory */
+    return  n_dirs++;
+
+}
+
+
+
+
+/*
+   make_names
+
+   Description:      This function makes the short and long names of the
+                     files and directories.  The short names are numbered
+                     (Tnnnnnnn.MP3 and Dnnnnnnn) and the long names are the
+                     MP3 file name with the file number added (or "Folder
+                     nnnn"), padded to lfn_len characters.  With only 8.3
+                     names the long names are the short names.
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: dirs       - names set.
+                     files      - names set.
+                     lfn_len    - accessed.
+                     n_dirs     - accessed.
+                     n_files    - accessed.
+                     short_only - accessed.
+                     sources    - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  make_names()
+{
+    /* variables */
+    char        stem[MAX_LFN_LEN];  /* long name without the extension */
+    const char *name;               /* name of the MP3 file */
+    const char *ext;                /* its extension (.mp3) */
+    int         len;                /* length of its name without .mp3 */
+
+    int         i;                  /* general loop index */
+
+
+
+    /* the files */
+    for (i = 0; i < n_files; i++)  {
+
+        sprintf(files[i].short_name, "T%07dMP3", (int) ((i + 1) % (MAX_FILES + 1)));
+
+        /* long name is the MP3 file name with the number added */
+        name = sources[files[i].src].name;
+        ext = strrchr(name, '.');
+        len = ((ext - name) < (MAX_NAME - 20)) ? (ext - name) : (MAX_NAME - 20);
+        sprintf(stem, "%.*s %04d", len, name, i + 1);
+        /* pad it out */
+        while ((int) (strlen(stem) + strlen(ext)) < lfn_len)
+            strcat(stem, "_");
+        sprintf(files[i].long_name, "%s%s", stem, ext);
+
+        /* with only 8.3 names the "long" name is the short one */
+        if (short_only)
+            sprintf(files[i].long_name, "%.8s.%.3s", files[i].short_name, files[i].short_name + DOS_FILENAME_LEN);
+    }
+
+    /* the directories (the root doesn't have a name) */
+    for (i = 1; i < n_dirs; i++)  {
+        sprintf(dirs[i].short_name, "D%07d   ", (int) (i % (MAX_FILES + 1)));
+        sprintf(dirs[i].long_name, "Folder %04d", i);
+        while ((int) strlen(dirs[i].long_name) < lfn_len)
+            strcat(dirs[i].long_name, "_");
+        if (short_only)
+            sprintf(dirs[i].long_name, "%.8s", dirs[i].short_name);
+    }
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   lfn_count
+
+   Description:      This function returns the number of long filename
+                     entries needed for the passed name (none if only 8.3
+                     names are used).
+
+   Arguments:        name (const char *) - the long name.
+   Return Value:     (int) - number of long filename entries.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: short_only - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  lfn_count(const char *name)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* LFN_CHARS characters in each entry */
+    return  short_only ? 0 : ((strlen(name) + LFN_CHARS - 1) / LFN_CHARS);
+
+}
+
+
+
+
+/*
+   dir_entries
+
+   Description:      This function returns the number of entries in the
+                     passed directory: the . and .. entries (except in the
+                     root) and for each file and subdirectory its deleted
+                     entries, long filename entries, and short entry.  With
+                     -j the root also has the library index's deleted and
+                     short entries.
+
+   Arguments:        d (int) - the directory.
+   Return Value:     (long int) - number of entries.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: deleted    - accessed.
+                     dirs       - accessed.
+                     files      - accessed.
+                     make_index - accessed.
+                     n_dirs     - accessed.
+                     n_files    - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  long int  dir_entries(int d)
+{
+    /* variables */
+    long int  n;                /* number of entries */
+
+    int       i;                /* general loop index */
+
+
+
+    /* subdirectories start with . and .. */
+    n = (d == 0) ? 0 : 2;
+
+    /* add the files and subdirectories */
+    for (i = 0; i < n_files; i++)
+        if (files[i].dir == d)
+            n += deleted + lfn_count(files[i].long_name) + 1;
+    for (i = 1; i < n_dirs; i++)
+        if (dirs[i].parent == d)
+            n += deleted + lfn_count(dirs[i].long_name) + 1;
+
+    /* and the library index goes at the end of the root */
+    if ((d == 0) && make_index)
+        n += deleted + 1;
+
+
+    /* return the number of entries */
+    return  n;
+
+}
+
+
+
+
+/*
+   alloc_volume
+
+   Description:      This function allocates the clusters for the
+                     directories (contiguous, the root first for FAT32) and
+                     then the files in disk order.  The files are taken in
+                     groups of interleave files that take turns allocating
+                     frag_run clusters (the whole file if frag_run is 0),
+                     leaving frag_gap free clusters after each run.
+
+   Arguments:        None.
+   Return Value:     (int) - TRUE if allocated, FALSE if there are too many
+                     clusters.
+
+   Input:            None.
+   Output:           Errors to stderr.
+
+   Error Handling:   If the volume is too big an error is output and FALSE
+                     is returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: clus_sectors - accessed.
+                     dirs         - clusters set.
+                     disk_list    - accessed.
+                     fat_type     - accessed.
+                     files        - clusters set.
+                     frag_gap     - accessed.
+                     frag_run     - accessed.
+                     interleave   - accessed.
+                     n_dirs       - accessed.
+                     n_files      - accessed.
+                     next_free    - updated.
+                     root_entries - set for FAT16.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  alloc_volume()
+{
+    /* variables */
+    long int           clus_bytes = (long int) clus_sectors * SECTOR_BYTES;
+    long int           n;       /* clusters to allocate */
+    int                more;    /* files in a group have clusters left */
+    int                g_end;   /* end of a group of files */
+    struct img_file   *f;       /* a file */
+
+    int                ok = TRUE;   /* volume was allocated */
+
+    int                g;       /* general loop indices */
+    int                i;
+
+
+
+    /* the directories first */
+    for (i = 0; i < n_dirs; i++)  {
+        n = (dir_entries(i) * ENTRY_BYTES + clus_bytes - 1) / clus_bytes;
+        if ((i == 0) && (fat_type == 16))  {
+            /* FAT16 root is outside of the data area */
+            root_entries = dir_entries(0);
+            root_entries = (root_entries + ENTRIES_PER_SECTOR - 1) / ENTRIES_PER_SECTOR * ENTRIES_PER_SECTOR;
+            if (root_entries < MIN_ROOT_ENTRIES)
+                root_entries = MIN_ROOT_ENTRIES;
+            ok = (root_entries <= 0xFFFF);
+        }
+        else  {
+            ok = ok && alloc_run(&dirs[i].first, &dirs[i].last, (n > 0) ? n : 1);
+        }
+    }
+
+    /* now the files in disk order */
+    for (i = 0; i < n_files; i++)
+        files[i].left = (files[i].bytes + clus_bytes - 1) / clus_bytes;
+
+    for (g = 0; ok && (g < n_files); g += interleave)  {
+
+        /* take turns in the group */
+        g_end = ((g + interleave) < n_files) ? (g + interleave) : n_files;
+        more = TRUE;
+        while (ok && more)  {
+            more = FALSE;
+            for (i = g; ok && (i < g_end); i++)  {
+                f = &files[disk_list[i]];
+                if (f->left > 0)  {
+                    n = ((frag_run > 0) && (frag_run < f->left)) ? frag_run : f->left;
+                    ok = alloc_run(&f->first, &f->last, n);
+                    f->left -= n;
+                    next_free += frag_gap;
+                    more = more || (f->left > 0);
+                }
+            }
+        }
+    }
+
+    if (!ok)
+        fprintf(stderr, "the volume is too big (use larger clusters or -t)\n");
+
+
+    /* return whether or not it was allocated */
+    return  ok;
+
+}
+
+
+
+
+/*
+   alloc_index
+
+   Description:      This function works out the size of the library index
+                     (with -j) and allocates its clusters, contiguous and
+                     after all of the files.  The index is a header sector
+                     then the directory, entry, extent, and seek table
+                     records, each starting on a sector boundary.  The files
+                     are probed here to find out which have seek tables.
+
+   Arguments:        None.
+   Return Value:     (int) - TRUE if allocated (or there is no index), FALSE
+                     if there are too many clusters or a file can't be
+                     probed.
+
+   Input:            The start of each file's data from the MP3 files.
+   Output:           Errors to stderr.
+
+   Error Handling:   If the volume is too big or an MP3 file can't be read
+                     an error is output and FALSE is returned.
+
+   Algorithms:       Every directory but the root has a .. entry record and
+                     the root has one for the index itself.  Each run of
+                     consecutive clusters of a file is an extent record.
+   Data Structures:  None.
+
+   Shared Variables: clus_sectors - accessed.
+                     files        - accessed and the probe results set.
+                     idx_bytes    - set.
+                     idx_entries  - set.
+                     idx_extents  - set.
+                     idx_first    - set.
+                     idx_last     - set.
+                     idx_tocs     - set.
+                     make_index   - accessed.
+                     n_dirs       - accessed.
+                     n_files      - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  alloc_index()
+{
+    /* variables */
+    long int  sectors;          /* sectors in the index */
+
+    int       ok = TRUE;        /* index was allocated */
+
+    int       i;                /* general loop index */
+
+
+
+    /* only need to do anything if making the index */
+    if (make_index)  {
+
+        /* .. in each subdirectory, the files, the subdirectories, and */
+        /*    the index itself */
+        idx_entries = (n_dirs - 1) + n_files + (n_dirs - 1) + 1;
+
+        /* the index is one run, the files have as many as they have */
+        idx_extents = 1;
+        for (i = 0; i < n_files; i++)
+            idx_extents += chain_runs(files[i].first, NULL);
+
+        /* probe the files, the ones with seek tables have a record */
+        idx_tocs = 0;
+        for (i = 0; ok && (i < n_files); i++)  {
+            ok = probe_file(i);
+            if (ok && files[i].probe.has_toc)
+                idx_tocs++;
+        }
+
+        /* the header and then each kind of record */
+        sectors = 1 + (n_dirs + IDX_DIRS_PER_SECTOR - 1) / IDX_DIRS_PER_SECTOR +
+                  (idx_entries + IDX_ENTRIES_PER_SECTOR - 1) / IDX_ENTRIES_PER_SECTOR +
+                  (idx_extents + IDX_EXTENTS_PER_SECTOR - 1) / IDX_EXTENTS_PER_SECTOR +
+                  (idx_tocs + IDX_TOCS_PER_SECTOR - 1) / IDX_TOCS_PER_SECTOR;
+        idx_bytes = sectors * SECTOR_BYTES;
+
+        /* and allocate it in one run */
+        ok = ok && alloc_run(&idx_first, &idx_last, (sectors + clus_sectors - 1) / clus_sectors);
+        if (!ok && (i == n_files))
+            fprintf(stderr, "the volume is too big for the index (use larger clusters or -t)\n");
+    }
+
+
+    /* return whether or not it was allocated */
+    return  ok;
+
+}
+
+
+
+
+/*
+   alloc_run
+
+   Description:      This function allocates the passed number of clusters
+                     starting at the next free cluster and adds them to the
+                     end of the passed chain.
+
+   Arguments:        first (unsigned long int *) - first cluster of the
+                                                   chain (0 if none yet).
+                     last (unsigned long int *)  - last cluster of the
+                                                   chain.
+                     n (long int)                - clusters to allocate.
+   Return Value:     (int) - TRUE if allocated, FALSE if out of clusters.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   FALSE is returned if the volume would be too big.
+
+   Algorithms:       None.
+   Data Structures:  fat[] is grown as needed.
+
+   Shared Variables: fat       - chain added.
+                     fat_size  - updated.
+                     fat_type  - accessed.
+                     next_free - updated.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  alloc_run(unsigned long int *first, unsigned long int *last, long int n)
+{
+    /* variables */
+    unsigned long int  c;       /* cluster being allocated */
+    unsigned long int  old;     /* old size of fat[] */
+
+    int                ok;      /* there are enough clusters */
+
+    long int           i;       /* general loop index */
+
+
+
+    /* make sure there are enough clusters */
+    ok = ((next_free + n + frag_gap) <= (FIRST_CLUSTER + ((fat_type == 16) ? MAX_FAT16_CLUSTERS : MAX_FAT32_CLUSTERS)));
+
+    /* make sure the fat is big enough */
+    if (ok && ((next_free + n + frag_gap) > fat_size))  {
+        old = fat_size;
+        fat_size = 2 * (next_free + n + frag_gap);
+        fat = realloc(fat, fat_size * sizeof(unsigned long int));
+        for (c = old; c < fat_size; c++)
+            fat[c] = 0;
+    }
+
+    /* allocate and link the clusters */
+    for (i = 0; ok && (i < n); i++)  {
+        c = next_free++;
+        if (*first == 0)
+            *first = c;
+        else
+            fat[*last] = c;
+        *last = c;
+        fat[c] = END_CHAIN;
+    }
+
+
+    /* return whether or not they were allocated */
+    return  ok;
+
+}
+
+
+
+
+/*
+   fat_geometry
+
+   Description:      This function works out the layout of the volume from
+                     the clusters allocated.  The number of clusters is
+                     padded up to the least allowed for the FAT type.
+
+   Arguments:        None.
+   Return Value:     (int) - TRUE (the layout always works).
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: clus_sectors  - accessed.
+                     data_clusters - set.
+                     data_start    - set.
+                     fat_sectors   - set.
+                     fat_type      - accessed.
+                     next_free     - accessed.
+                     reserved      - set.
+                     root_entries  - accessed.
+                     root_sectors  - set.
+                     total_sectors - set.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  fat_geometry()
+{
+    /* variables */
+    unsigned long int  least;   /* least clusters for the type */
+
+
+
+    /* the clusters (there must be enough for the FAT type) */
+    least = (fat_type == 16) ? MIN_FAT16_CLUSTERS : MIN_FAT32_CLUSTERS;
+    data_clusters = next_free - FIRST_CLUSTER;
+    if (data_clusters < least)
+        data_clusters = least;
+
+    /* lay it out */
+    reserved = (fat_type == 16) ? FAT16_RESERVED : FAT32_RESERVED;
+    fat_sectors = ((data_clusters + FIRST_CLUSTER) * (fat_type / 8) + SECTOR_BYTES - 1) / SECTOR_BYTES;
+    root_sectors = (fat_type == 16) ? (root_entries / ENTRIES_PER_SECTOR) : 0;
+    data_start = reserved + 2 * fat_sectors + root_sectors;
+    total_sectors = data_start + data_clusters * clus_sectors;
+
+
+    /* done */
+    return  TRUE;
+
+}
+
+
+
+
+/*
+   write_image
+
+   Description:      This function writes the volume: the boot sector (and
+                     FSInfo and backup boot sector for FAT32), both FATs,
+                     the directories, the files, and the library index (with
+                     -j).
+
+   Arguments:        None.
+   Return Value:     (int) - TRUE if written, FALSE if there was an error.
+
+   Input:            The MP3 files.
+   Output:           The image file, errors to stderr.
+
+   Error Handling:   Write errors output a message and return FALSE.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: All of the layout variables are accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  write_image()
+{
+    /* variables */
+    unsigned char      s[SECTOR_BYTES];     /* a sector */
+    unsigned long int  e;       /* a FAT entry */
+    unsigned long int  c;       /* a cluster */
+
+    int                ok = TRUE;   /* written */
+
+    long int           i;       /* general loop indices */
+    int                j;
+
+
+
+    /* boot sector */
+    memset(s, 0, SECTOR_BYTES);
+    memcpy(s, "\xEB\x58\x90" "MKIMAGE ", 11);
+    put_word(s + 11, SECTOR_BYTES);
+    s[13] = clus_sectors;
+    put_word(s + 14, reserved);
+    s[16] = 2;                                  /* number of FATs */
+    put_word(s + 17, root_entries);
+    put_word(s + 19, (total_sectors < 0x10000) ? total_sectors : 0);
+    s[21] = 0xF8;                               /* hard disk */
+    put_word(s + 24, 63);                       /* sectors per track */
+    put_word(s + 26, 255);                      /* heads */
+    put_long(s + 32, (total_sectors < 0x10000) ? 0 : total_sectors);
+    if (fat_type == 16)  {
+        put_word(s + 22, fat_sectors);
+        s[36] = 0x80;                           /* drive */
+        s[38] = 0x29;                           /* extended signature */
+        put_long(s + 39, random_state);         /* volume ID */
+        memcpy(s + 43, "NO NAME    FAT16   ", VOL_LABEL_LEN + 8);
+    }
+    else  {
+        put_long(s + 36, fat_sectors);
+        put_long(s + 44, FIRST_CLUSTER);        /* root directory */
+        put_word(s + 48, BOOT_FSINFO);
+        put_word(s + 50, BOOT_BACKUP);
+        s[64] = 0x80;
+        s[66] = 0x29;
+        put_long(s + 67, random_state);
+        memcpy(s + 71, "NO NAME    FAT32   ", VOL_LABEL_LEN + 8);
+    }
+    s[510] = 0x55;
+    s[511] = 0xAA;
+    ok = (fseeko(img, 0, SEEK_SET) == 0) && (fwrite(s, SECTOR_BYTES, 1, img) == 1);
+
+    if (fat_type == 32)  {
+        /* backup boot sector */
+        ok = ok && (fseeko(img, (off_t) BOOT_BACKUP * SECTOR_BYTES, SEEK_SET) == 0) &&
+             (fwrite(s, SECTOR_BYTES, 1, img) == 1);
+        /* and the FSInfo sector */
+        memset(s, 0, SECTOR_BYTES);
+        put_long(s, 0x41615252UL);
+        put_long(s + 484, 0x61417272UL);
+        put_long(s + 488, 0xFFFFFFFFUL);        /* free count unknown */
+        put_long(s + 492, 0xFFFFFFFFUL);        /* next free unknown */
+        put_long(s + 508, 0xAA550000UL);
+        ok = ok && (fseeko(img, (off_t) BOOT_FSINFO * SECTOR_BYTES, SEEK_SET) == 0) &&
+             (fwrite(s, SECTOR_BYTES, 1, img) == 1);
+    }
+
+
+    /* the FATs, a sector at a time */
+    for (i = 0; ok && (i < fat_sectors); i++)  {
+        memset(s, 0, SECTOR_BYTES);
+        for (j = 0; j < (SECTOR_BYTES * 8 / fat_type); j++)  {
+            c = i * (SECTOR_BYTES * 8 / fat_type) + j;
+            if (c == 0)
+                e = 0x0FFFFFF8UL;               /* media type */
+            else if (c == 1)
+                e = 0x0FFFFFFFUL;
+            else if (c < fat_size)
+                e = (fat[c] == END_CHAIN) ? 0x0FFFFFFFUL : fat[c];
+            else
+                e = 0;
+            if (fat_type == 16)
+                put_word(s + 2 * j, e & 0xFFFF);
+            else
+                put_long(s + 4 * j, e);
+        }
+        ok = (fseeko(img, (off_t) (reserved + i) * SECTOR_BYTES, SEEK_SET) == 0) &&
+             (fwrite(s, SECTOR_BYTES, 1, img) == 1) &&
+             (fseeko(img, (off_t) (reserved + fat_sectors + i) * SECTOR_BYTES, SEEK_SET) == 0) &&
+             (fwrite(s, SECTOR_BYTES, 1, img) == 1);
+    }
+
+
+    /* the directories and files */
+    for (i = 0; ok && (i < n_dirs); i++)
+        ok = write_dir(i);
+    for (i = 0; ok && (i < n_files); i++)
+        ok = write_file(i);
+    if (make_index)
+        ok = ok && write_index();
+
+    /* and make the image the whole size of the volume */
+    ok = ok && (fflush(img) == 0) && (ftruncate(fileno(img), (off_t) total_sectors * SECTOR_BYTES) == 0);
+
+    if (!ok)
+        perror("writing the image");
+
+
+    /* return whether or not the image was written */
+    return  ok;
+
+}
+
+
+
+
+/*
+   write_dir
+
+   Description:      This function builds and writes the passed directory.
+                     With -j the library index is the last entry in the
+                     root.
+
+   Arguments:        d (int) - the directory.
+   Return Value:     (int) - TRUE if written, FALSE if there was an error.
+
+   Input:            None.
+   Output:           The directory to the image.
+
+   Error Handling:   FALSE is returned on a write error.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: dirs       - accessed.
+                     files      - accessed.
+                     idx_bytes  - accessed.
+                     idx_first  - accessed.
+                     make_index - accessed.
+                     n_dirs     - accessed.
+                     n_files    - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  write_dir(int d)
+{
+    /* variables */
+    unsigned char  *buf;        /* the directory */
+    unsigned char  *p;          /* next entry in it */
+    long int        bytes;      /* bytes in the directory */
+
+    int             ok;         /* written */
+
+    int             i;          /* general loop index */
+
+
+
+    /* get a buffer for the whole directory */
+    if ((d == 0) && (fat_type == 16))
+        bytes = root_sectors * SECTOR_BYTES;
+    else
+        bytes = (long int) clus_sectors * SECTOR_BYTES * ((dir_entries(d) * ENTRY_BYTES + (long int) clus_sectors * SECTOR_BYTES - 1) / ((long int) clus_sectors * SECTOR_BYTES));
+    if (bytes == 0)
+        bytes = (long int) clus_sectors * SECTOR_BYTES;
+    buf = calloc(bytes, 1);
+    p = buf;
+
+
+    /* subdirectories start with . and .. */
+    if (d != 0)  {
+        p += make_entry(p, ".          ", NULL, ATTRIB_DIR, dirs[d].first, 0);
+        p += make_entry(p, "..         ", NULL, ATTRIB_DIR,
+                        (dirs[d].parent == 0) ? 0 : dirs[dirs[d].parent].first, 0);
+    }
+
+    /* then the files and subdirectories */
+    for (i = 0; i < n_files; i++)
+        if (files[i].dir == d)
+            p += make_entry(p, files[i].short_name, files[i].long_name,
+                            ATTRIB_ARCHIVE, files[i].first, files[i].bytes);
+    for (i = 1; i < n_dirs; i++)
+        if (dirs[i].parent == d)
+            p += make_entry(p, dirs[i].short_name, dirs[i].long_name,
+                            ATTRIB_DIR, dirs[i].first, 0);
+
+    /* and the library index at the end of the root */
+    if ((d == 0) && make_index)
+        p += make_entry(p, IDX_FILENAME IDX_EXTENSION, NULL, ATTRIB_ARCHIVE, idx_first, idx_bytes);
+
+
+    /* write it */
+    if ((d == 0) && (fat_type == 16))
+        ok = (fseeko(img, (off_t) (reserved + 2 * fat_sectors) * SECTOR_BYTES, SEEK_SET) == 0) &&
+             (fwrite(buf, bytes, 1, img) == 1);
+    else
+        ok = write_chain(dirs[d].first, buf, bytes);
+
+    free(buf);
+
+
+    /* return whether or not it was written */
+    return  ok;
+
+}
+
+
+
+
+/*
+   make_entry
+
+   Description:      This function builds the directory entries for a file
+                     or directory: the deleted entries, the long filename
+                     entries (if there is a long name), and the short entry.
+
+   Arguments:        p (unsigned char *)          - where to put the entries.
+                     short_name (const char *)    - the 8.3 name (11
+                                                    characters, space
+                                                    padded).
+                     long_name (const char *)     - the long name (NULL for
+                                                    none).
+                     attrib (int)                 - the attributes.
+                     cluster (unsigned long int)  - the first cluster.
+                     bytes (long int)             - the size.
+   Return Value:     (int) - the number of bytes of entries built.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       The long filename entries are in reverse order (last
+                     part first) with the checksum of the short name.  The
+                     deleted entries alternate between long filename and
+                     short entries.
+   Data Structures:  None.
+
+   Shared Variables: deleted  - accessed.
+                     fat_type - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  make_entry(unsigned char *p, const char *short_name, const char *long_name,
+                        int attrib, unsigned long int cluster, long int bytes)
+{
+    /* variables */
+    static const int  pos[LFN_CHARS] =  /* where each character goes */
+        {  1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30  };
+
+    unsigned char  *start = p;  /* where the entries start */
+    unsigned char   sum = 0;    /* checksum of the short name */
+    int             n;          /* number of long filename entries */
+    int             len;        /* length of the long name */
+    int             k;          /* character in the long name */
+    unsigned int    ch;         /* a long name character */
+
+    int             i;          /* general loop indices */
+    int             j;
+
+
+
+    /* deleted entries first (in directories with . and .. they follow) */
+    for (i = 0; (i < deleted) && (short_name[0] != '.'); i++)  {
+        memcpy(p, short_name, SHORT_NAME_LEN);
+        p[0] = 0xE5;
+        p[ENTRY_ATTRIB] = (i % 2) ? ATTRIB_ARCHIVE : ATTRIB_LFN;
+        p += ENTRY_BYTES;
+    }
+
+    /* the long filename entries */
+    n = (long_name == NULL) ? 0 : lfn_count(long_name);
+    for (i = 0; i < SHORT_NAME_LEN; i++)
+        sum = ((sum & 1) << 7) + (sum >> 1) + (unsigned char) short_name[i];
+    len = (long_name == NULL) ? 0 : strlen(long_name);
+    for (i = n; i > 0; i--)  {
+        p[0] = i | ((i == n) ? LAST_LFN_ENTRY : 0);
+        p[ENTRY_ATTRIB] = ATTRIB_LFN;
+        p[LFN_CHECKSUM] = sum;
+        for (j = 0; j < LFN_CHARS; j++)  {
+            k = (i - 1) * LFN_CHARS + j;
+            ch = (k < len) ? (unsigned char) long_name[k] : ((k == len) ? 0 : 0xFFFF);
+            put_word(p + pos[j], ch);
+        }
+        p += ENTRY_BYTES;
+    }
+
+    /* and the short entry */
+    memcpy(p, short_name, SHORT_NAME_LEN);
+    p[ENTRY_ATTRIB] = attrib;
+    put_word(p + ENTRY_CLUSTER_HI, (fat_type == 32) ? (cluster >> 16) : 0);
+    put_word(p + ENTRY_TIME, STAMP_TIME);
+    put_word(p + ENTRY_DATE, STAMP_DATE);
+    put_word(p + ENTRY_CLUSTER_LO, cluster & 0xFFFF);
+    put_long(p + ENTRY_SIZE, bytes);
+    p += ENTRY_BYTES;
+
+
+    /* return the size of the entries */
+    return  p - start;
+
+}
+
+
+
+
+/*
+   write_file
+
+   Description:      This function copies the passed file's data from its
+                     MP3 file to its clusters.
+
+   Arguments:        f (int) - the file.
+   Return Value:     (int) - TRUE if written, FALSE if there was an error.
+
+   Input:            The MP3 file.
+   Output:           The file to the image, errors to stderr.
+
+   Error Handling:   If the MP3 file can't be read a message is output and
+                     FALSE is returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: files   - accessed.
+                     sources - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  write_file(int f)
+{
+    /* variables */
+    unsigned char  *buf;        /* the file data */
+    FILE           *src;        /* the MP3 file */
+
+    int             ok;         /* written */
+
+
+
+    /* read the data */
+    buf = malloc(files[f].bytes + 1);
+    src = fopen(sources[files[f].src].path, "rb");
+    ok = (src != NULL) && (fread(buf, 1, files[f].bytes, src) == (size_t) files[f].bytes);
+    if (!ok)
+        perror(sources[files[f].src].path);
+    if (src != NULL)
+        fclose(src);
+
+    /* and write it */
+    ok = ok && write_chain(files[f].first, buf, files[f].bytes);
+
+    free(buf);
+
+
+    /* return whether or not it was written */
+    return  ok;
+
+}
+
+
+
+
+/*
+   write_chain
+
+   Description:      This function writes the passed data to the clusters
+                     of the chain starting at the passed cluster.
+
+   Arguments:        c (unsigned long int)      - first cluster of the chain.
+                     buf (const unsigned char *) - the data.
+                     bytes (long int)           - bytes of data.
+   Return Value:     (int) - TRUE if written, FALSE if there was an error.
+
+   Input:            None.
+   Output:           The data to the image.
+
+   Error Handling:   FALSE is returned on a write error.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: clus_sectors - accessed.
+                     data_start   - accessed.
+                     fat          - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  write_chain(unsigned long int c, const unsigned char *buf, long int bytes)
+{
+    /* variables */
+    long int  clus_bytes = (long int) clus_sectors * SECTOR_BYTES;
+    long int  n;                /* bytes in this cluster */
+
+    int       ok = TRUE;        /* written */
+
+
+
+    /* write a cluster at a time */
+    while (ok && (bytes > 0) && (c != END_CHAIN))  {
+        n = (bytes < clus_bytes) ? bytes : clus_bytes;
+        ok = (fseeko(img, ((off_t) data_start + (off_t) (c - FIRST_CLUSTER) * clus_sectors) * SECTOR_BYTES, SEEK_SET) == 0) &&
+             (fwrite(buf, n, 1, img) == 1);
+        buf += n;
+        bytes -= n;
+        c = fat[c];
+    }
+
+
+    /* return whether or not it was written */
+    return  ok;
+
+}
+
+
+
+
+/*
+   write_index
+
+   Description:      This function builds and writes the library index:
+                     the header, a directory record for each directory (in
+                     cluster order), and for each directory an entry record
+                     for each entry the jukebox shows in it (.., the files,
+                     the subdirectories, and in the root the index itself)
+                     along with the extent and seek table records of the
+                     files.
+
+   Arguments:        None.
+   Return Value:     (int) - TRUE if written, FALSE if there was an error.
+
+   Input:            The ID3 tags at the end of the files' data are read
+                     from the MP3 files.
+   Output:           The index to the image, errors to stderr.
+
+   Error Handling:   If an MP3 file can't be read a message is output and
+                     FALSE is returned.
+
+   Algorithms:       The directories are allocated in order, so they are
+                     already sorted by cluster (the FAT16 root is cluster
+                     0).  The directory records have the size of the
+                     directory in sectors and the time and date of its
+                     entry in its parent (0 for the root), the same things
+                     the jukebox checks them against.
+   Data Structures:  None.
+
+   Shared Variables: All of the layout and index variables are accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  write_index()
+{
+    /* variables */
+    unsigned char  *buf;        /* the index */
+    unsigned char  *rec;        /* a directory record */
+    unsigned char  *entry;      /* first entry record */
+    unsigned char  *ext;        /* first extent record */
+    unsigned char  *toc;        /* first seek table record */
+    unsigned char   tag[ID3_TAG_SIZE];  /* ID3 tag of a file */
+    FILE           *src;        /* an MP3 file */
+
+    long int        n_ent = 0;  /* entry records made */
+    long int        n_ext = 0;  /* extent records made */
+    long int        n_toc = 0;  /* seek table records made */
+    long int        first;      /* first entry record of a directory */
+
+    int             ok = TRUE;  /* written */
+
+    int             d;          /* general loop indices */
+    int             i;
+
+
+
+    /* get a buffer for the whole index and find where the records go */
+    buf = calloc(idx_bytes, 1);
+    entry = buf + SECTOR_BYTES * (1 + (n_dirs + IDX_DIRS_PER_SECTOR - 1) / IDX_DIRS_PER_SECTOR);
+    ext = entry + SECTOR_BYTES * ((idx_entries + IDX_ENTRIES_PER_SECTOR - 1) / IDX_ENTRIES_PER_SECTOR);
+    toc = ext + SECTOR_BYTES * ((idx_extents + IDX_EXTENTS_PER_SECTOR - 1) / IDX_EXTENTS_PER_SECTOR);
+
+    /* the header */
+    put_word(buf + 2 * IDX_HDR_MAGIC, IDX_MAGIC_LO);
+    put_word(buf + 2 * (IDX_HDR_MAGIC + 1), IDX_MAGIC_HI);
+    put_word(buf + 2 * IDX_HDR_VERSION, IDX_VERSION);
+    put_long(buf + 2 * IDX_HDR_NUM_DIRS, n_dirs);
+    put_long(buf + 2 * IDX_HDR_DIR_SECTOR, 1);
+    put_long(buf + 2 * IDX_HDR_ENTRY_SECTOR, (entry - buf) / SECTOR_BYTES);
+    put_long(buf + 2 * IDX_HDR_EXTENT_SECTOR, (ext - buf) / SECTOR_BYTES);
+    put_long(buf + 2 * IDX_HDR_TOC_SECTOR, (toc - buf) / SECTOR_BYTES);
+
+
+    /* now each directory */
+    for (d = 0; ok && (d < n_dirs); d++)  {
+
+        first = n_ent;
+
+        /* subdirectories start with .. */
+        if (d != 0)  {
+            n_ext += make_record(entry + n_ent++ * IDX_ENTRY_BYTES, ext, n_ext, NULL, "..",
+                                 ATTRIB_DIR, (dirs[d].parent == 0) ? 0 : dirs[dirs[d].parent].first, 0,
+                                 NULL, NULL, 0);
+        }
+
+        /* then the files, with their tags, probe results, and seek tables */
+        for (i = 0; ok && (i < n_files); i++)  {
+            if (files[i].dir == d)  {
+                /* the tag is at the end of the file's data */
+                memset(tag, 0, ID3_TAG_SIZE);
+                src = fopen(sources[files[i].src].path, "rb");
+                ok = (src != NULL);
+                if (ok && (files[i].bytes >= ID3_TAG_SIZE))
+                    ok = (fseeko(src, (off_t) (files[i].bytes - ID3_TAG_SIZE), SEEK_SET) == 0) &&
+                         (fread(tag, ID3_TAG_SIZE, 1, src) == 1);
+                if (!ok)
+                    perror(sources[files[i].src].path);
+                if (src != NULL)
+                    fclose(src);
+
+                n_ext += make_record(entry + n_ent++ * IDX_ENTRY_BYTES, ext, n_ext,
+                                     files[i].short_name, short_only ? NULL : files[i].long_name,
+                                     ATTRIB_ARCHIVE, files[i].first, files[i].bytes, tag,
+                                     &files[i].probe, n_toc);
+                if (files[i].probe.has_toc)
+                    memcpy(toc + n_toc++ * IDX_TOC_BYTES + 2 * IDX_TOC_TABLE,
+                           files[i].probe.toc, SEEK_TOC_SIZE);
+            }
+        }
+
+        /* the subdirectories */
+        for (i = 1; i < n_dirs; i++)
+            if (dirs[i].parent == d)
+                n_ext += make_record(entry + n_ent++ * IDX_ENTRY_BYTES, ext, n_ext,
+                                     dirs[i].short_name, short_only ? NULL : dirs[i].long_name,
+                                     ATTRIB_DIR, dirs[i].first, 0, NULL, NULL, 0);
+
+        /* and the index at the end of the root */
+        if (d == 0)
+            n_ext += make_record(entry + n_ent++ * IDX_ENTRY_BYTES, ext, n_ext,
+                                 IDX_FILENAME IDX_EXTENSION, NULL, ATTRIB_ARCHIVE,
+                                 idx_first, idx_bytes, NULL, NULL, 0);
+
+
+        /* now the directory's record */
+        rec = buf + SECTOR_BYTES + d * IDX_DIR_BYTES;
+        if ((d == 0) && (fat_type == 16))  {
+            /* the FAT16 root is cluster 0 and outside the data area */
+            put_long(rec + 2 * IDX_DIR_CLUSTER, 0);
+            put_long(rec + 2 * IDX_DIR_SIZE, root_sectors);
+        }
+        else  {
+            put_long(rec + 2 * IDX_DIR_CLUSTER, dirs[d].first);
+            put_long(rec + 2 * IDX_DIR_SIZE, (dirs[d].last - dirs[d].first + 1) * clus_sectors);
+        }
+        /* only subdirectories have an entry with a time and date */
+        put_word(rec + 2 * IDX_DIR_TIME, (d == 0) ? 0 : STAMP_TIME);
+        put_word(rec + 2 * IDX_DIR_DATE, (d == 0) ? 0 : STAMP_DATE);
+        put_long(rec + 2 * IDX_DIR_FIRST, first);
+        put_word(rec + 2 * IDX_DIR_COUNT, n_ent - first);
+    }
+
+
+    /* write it */
+    ok = ok && write_chain(idx_first, buf, idx_bytes);
+
+    free(buf);
+
+
+    /* return whether or not it was written */
+    return  ok;
+
+}
+
+
+
+
+/*
+   make_record
+
+   Description:      This function builds a library index entry record for
+                     a file or directory along with the extent records for
+                     a file's clusters.  The name is the one the jukebox
+                     shows: the long name if there is one, otherwise the
+                     8.3 name without the padding.  A file's record also has
+                     what probing it found, and if it has an ID3v2 tag with
+                     a title the title and artist are from it (they are
+                     what the jukebox displays) instead of the ID3 tag.
+
+   Arguments:        rec (unsigned char *)        - the entry record.
+                     ext (unsigned char *)        - the first extent
+                                                    record.
+                     n_ext (long int)             - extent record number
+                                                    for the file's extents.
+                     short_name (const char *)    - the 8.3 name (11
+                                                    characters, space
+                                                    padded, NULL if the
+                                                    long name is always
+                                                    used).
+                     long_name (const char *)     - the long name (NULL for
+                                                    none).
+                     attrib (int)                 - the attributes.
+                     cluster (unsigned long int)  - the first cluster.
+                     bytes (long int)             - the size.
+                     tag (const unsigned char *)  - the last ID3_TAG_SIZE
+                                                    bytes of the file (NULL
+                                                    for no tag).
+                     probe (const struct track_header *) - what probing the
+                                                    file found (NULL if not
+                                                    a file).
+                     n_toc (long int)             - seek table record
+                                                    number if the file has
+                                                    a seek table.
+   Return Value:     (long int) - the number of extent records built.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       The tag's time bytes are stored in order, so the first
+                     one is in the low byte.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  long int  make_record(unsigned char *rec, unsigned char *ext, long int n_ext,
+                              const char *short_name, const char *long_name, int attrib,
+                              unsigned long int cluster, long int bytes, const unsigned char *tag,
+                              const struct track_header *probe, long int n_toc)
+{
+    /* variables */
+    unsigned int  flags = 0;    /* entry flags */
+
+    long int  n = 0;            /* extent records built */
+    int       len;              /* length of the name part of an 8.3 name */
+    int       ext_len;          /* length of its extension */
+
+
+
+    /* the name (always <null> terminated) */
+    if (long_name != NULL)  {
+        strncpy((char *) rec + 2 * IDX_ENT_NAME, long_name, IDX_NAME_LEN - 1);
+    }
+    else  {
+        for (len = 0; (len < DOS_FILENAME_LEN) && (short_name[len] != ' '); len++);
+        for (ext_len = 0; (ext_len < DOS_EXTENSION_LEN) && (short_name[DOS_FILENAME_LEN + ext_len] != ' '); ext_len++);
+        sprintf((char *) rec + 2 * IDX_ENT_NAME, "%.*s.%.*s", len, short_name,
+                ext_len, short_name + DOS_FILENAME_LEN);
+    }
+
+    /* the directory entry information */
+    put_word(rec + 2 * IDX_ENT_ATTR, attrib);
+    put_word(rec + 2 * IDX_ENT_TIME, STAMP_TIME);
+    put_word(rec + 2 * IDX_ENT_DATE, STAMP_DATE);
+    put_long(rec + 2 * IDX_ENT_SIZE, bytes);
+    put_long(rec + 2 * IDX_ENT_CLUSTER, cluster);
+
+    /* the tag information, if there is a tag */
+    if ((tag != NULL) && (memcmp(tag, ID3_TAG_ID, ID3_TAG_ID_SIZE) == 0))  {
+        flags |= IDX_FLAG_ID3;
+        memcpy(rec + 2 * IDX_ENT_TAG_TIME, tag + ID3_TAG_TIME_OFFSET, ID3_TAG_TIME_SIZE);
+        memcpy(rec + 2 * IDX_ENT_TITLE, tag + ID3_TAG_TITLE_OFFSET, ID3_TAG_TITLE_SIZE);
+        memcpy(rec + 2 * IDX_ENT_ARTIST, tag + ID3_TAG_ARTIST_OFFSET, ID3_TAG_ARTIST_SIZE);
+    }
+
+    /* what probing a file found (the probed time is in the time element) */
+    if (probe != NULL)  {
+        put_long(rec + 2 * IDX_ENT_START, probe->start);
+        put_long(rec + 2 * IDX_ENT_FRAMES, probe->frames);
+        put_word(rec + 2 * IDX_ENT_BIT_RATE, probe->bit_rate);
+        put_word(rec + 2 * IDX_ENT_PROBE_TIME, probe->time);
+        /* an ID3v2 title (and artist) is what is displayed */
+        if (probe->title[0] != '\0')  {
+            flags |= IDX_FLAG_ID3V2;
+            memset(rec + 2 * IDX_ENT_TITLE, 0, ID3_TAG_TITLE_SIZE);
+            memcpy(rec + 2 * IDX_ENT_TITLE, probe->title, strlen(probe->title));
+            memset(rec + 2 * IDX_ENT_ARTIST, 0, ID3_TAG_ARTIST_SIZE);
+            memcpy(rec + 2 * IDX_ENT_ARTIST, probe->artist, strlen(probe->artist));
+        }
+        if (probe->has_toc)  {
+            flags |= IDX_FLAG_TOC;
+            put_long(rec + 2 * IDX_ENT_TOC, n_toc);
+        }
+    }
+    put_word(rec + 2 * IDX_ENT_FLAGS, flags);
+
+    /* and the extents of a file */
+    if ((attrib & ATTRIB_DIR) == 0)  {
+        n = chain_runs(cluster, ext + n_ext * IDX_EXTENT_BYTES);
+        put_long(rec + 2 * IDX_ENT_EXTENT, n_ext);
+        put_word(rec + 2 * IDX_ENT_NUM_EXTENTS, n);
+    }
+
+
+    /* return the number of extent records */
+    return  n;
+
+}
+
+
+
+
+/*
+   chain_runs
+
+   Description:      This function finds the runs of consecutive clusters
+                     in the chain starting at the passed cluster and, if
+                     passed somewhere to put them, builds a library index
+                     extent record for each.
+
+   Arguments:        c (unsigned long int) - first cluster of the chain (0
+                                             for none).
+                     ext (unsigned char *) - where to put the extent
+                                             records (NULL to only count
+                                             them).
+   Return Value:     (long int) - the number of runs.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: fat - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  long int  chain_runs(unsigned long int c, unsigned char *ext)
+{
+    /* variables */
+    unsigned long int  start;   /* first cluster of a run */
+    unsigned long int  count;   /* clusters in the run */
+
+    long int           n = 0;   /* number of runs */
+
+
+
+    /* follow the chain a run at a time */
+    while ((c != 0) && (c != END_CHAIN))  {
+        start = c;
+        for (count = 1; fat[c] == (c + 1); count++)
+            c++;
+        if (ext != NULL)  {
+            put_long(ext + n * IDX_EXTENT_BYTES + 2 * IDX_EXT_CLUSTER, start);
+            put_long(ext + n * IDX_EXTENT_BYTES + 2 * IDX_EXT_COUNT, count);
+        }
+        n++;
+        c = fat[c];
+    }
+
+
+    /* return the number of runs */
+    return  n;
+
+}
+
+
+
+
+/*
+   probe_file
+
+   Description:      This function probes the start of the passed file's
+                     data with probe_track() (the same way the jukebox
+                     does) and saves what it finds with the file.
+
+   Arguments:        f (int) - the file.
+   Return Value:     (int) - TRUE if probed, FALSE if there was an error.
+
+   Input:            The start of the MP3 file.
+   Output:           Errors to stderr.
+
+   Error Handling:   If the MP3 file can't be opened a message is output and
+                     FALSE is returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: files       - the probe results are set.
+                     probe_bytes - set to the bytes in the file.
+                     probe_src   - set to the MP3 file (while probing).
+                     sources     - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  probe_file(int f)
+{
+    /* variables */
+    int  ok;                    /* probed */
+
+
+
+    /* open the MP3 file, only its bytes in the image are probed */
+    probe_src = fopen(sources[files[f].src].path, "rb");
+    probe_bytes = files[f].bytes;
+    ok = (probe_src != NULL);
+
+    /* probe it (the length has to be set), keeping the time with the rest */
+    if (ok)  {
+        files[f].probe.length = files[f].bytes;
+        files[f].probe.time = probe_track(&files[f].probe);
+        fclose(probe_src);
+    }
+    else  {
+        perror(sources[files[f].src].path);
+    }
+
+
+    /* return whether or not it was probed */
+    return  ok;
+
+}
+
+
+
+
+/*
+   write_manifest
+
+   Description:      This function writes the manifest: a line for each
+                     directory and file with its short and long paths,
+                     first cluster, size, MP3 file, and the extents (the
+                     sectors of the volume its data is in).  The library
+                     index (with -j) has a line of its own.
+
+   Arguments:        name (const char *) - the manifest file name.
+   Return Value:     (int) - TRUE if written, FALSE if there was an error.
+
+   Input:            None.
+   Output:           The manifest file, errors to stderr.
+
+   Error Handling:   If the manifest can't be written a message is output
+                     and FALSE is returned.
+
+   Algorithms:       Runs of consecutive clusters are combined into one
+                     extent.  The last extent only counts the sectors with
+                     file data in them.
+   Data Structures:  None.
+
+   Shared Variables: All of the layout variables are accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  int  write_manifest(const char *name)
+{
+    /* variables */
+    FILE               *m;      /* the manifest */
+
+    char              **spath;  /* short directory paths */
+    char              **lpath;  /* long directory paths */
+    char                sname[SHORT_NAME_LEN + 2];  /* short name (with .) */
+    const char         *sep;    /* separator before an extent */
+
+    unsigned long int   c;      /* cluster in the chain */
+    long int            start;  /* first sector of an extent */
+    long int            count;  /* sectors in an extent */
+    long int            left;   /* sectors of data left */
+
+    int                 ok;     /* written */
+
+    int                 i;      /* general loop indices */
+    int                 j;
+
+
+
+    /* make the directory paths (parents come before their subdirectories) */
+    spath = calloc(n_dirs, sizeof(char *));
+    lpath = calloc(n_dirs, sizeof(char *));
+    spath[0] = "";
+    lpath[0] = "";
+    for (i = 1; i < n_dirs; i++)  {
+        for (j = 0; (j < DOS_FILENAME_LEN) && (dirs[i].short_name[j] != ' '); j++);
+        spath[i] = malloc(strlen(spath[dirs[i].parent]) + j + 2);
+        sprintf(spath[i], "%s/%.*s", spath[dirs[i].parent], j, dirs[i].short_name);
+        lpath[i] = malloc(strlen(lpath[dirs[i].parent]) + strlen(dirs[i].long_name) + 2);
+        sprintf(lpath[i], "%s/%s", lpath[dirs[i].parent], dirs[i].long_name);
+    }
+
+
+    m = fopen(name, "w");
+    ok = (m != NULL);
+
+    if (ok)  {
+        fprintf(m, "# mkimage manifest: FAT%d, %d sectors per cluster, data at sector %ld, %ld sectors\n",
+                fat_type, clus_sectors, data_start, total_sectors);
+        fprintf(m, "# type\tshort path\tlong path\tfirst cluster\tbytes\tsource\textents (sector+count)\n");
+
+        for (i = 1; i < n_dirs; i++)
+            fprintf(m, "d\t%s\t%s\t%lu\t0\t-\t%ld+%ld\n", spath[i], lpath[i], dirs[i].first,
+                    data_start + (long int) (dirs[i].first - FIRST_CLUSTER) * clus_sectors,
+                    (dirs[i].last - dirs[i].first + 1) * clus_sectors);
+
+        for (i = 0; i < n_files; i++)  {
+
+            /* the paths */
+            sprintf(sname, "%.8s.%.3s", files[i].short_name, files[i].short_name + DOS_FILENAME_LEN);
+            fprintf(m, "f\t%s/%s\t%s/%s\t%lu\t%ld\t%s\t", spath[files[i].dir], sname,
+                    lpath[files[i].dir], files[i].long_name, files[i].first, files[i].bytes,
+                    sources[files[i].src].path);
+
+            /* and the extents */
+            left = (files[i].bytes + SECTOR_BYTES - 1) / SECTOR_BYTES;
+            c = files[i].first;
+            sep = "";
+            while (left > 0)  {
+                /* a run of consecutive clusters */
+                start = data_start + (long int) (c - FIRST_CLUSTER) * clus_sectors;
+                count = clus_sectors;
+                while ((fat[c] == (c + 1)) && (count < left))  {
+                    c++;
+                    count += clus_sectors;
+                }
+                if (count > left)
+                    count = left;
+                fprintf(m, "%s%ld+%ld", sep, start, count);
+                sep = " ";
+                left -= count;
+                c = fat[c];
+            }
+            fprintf(m, "\n");
+        }
+
+        /* the library index is contiguous, so has one extent */
+        if (make_index)  {
+            for (j = 0; (j < DOS_FILENAME_LEN) && (IDX_FILENAME[j] != ' '); j++);
+            sprintf(sname, "%.*s.%s", j, IDX_FILENAME, IDX_EXTENSION);
+            fprintf(m, "i\t/%s\t/%s\t%lu\t%ld\t-\t%ld+%ld\n", sname, sname, idx_first, idx_bytes,
+                    data_start + (long int) (idx_first - FIRST_CLUSTER) * clus_sectors,
+                    idx_bytes / SECTOR_BYTES);
+        }
+
+        ok = (fclose(m) == 0);
+    }
+
+    if (!ok)
+        perror(name);
+
+    for (i = 1; i < n_dirs; i++)  {
+        free(spath[i]);
+        free(lpath[i]);
+    }
+    free(spath);
+    free(lpath);
+
+
+    /* return whether or not it was written */
+    return  ok;
+
+}
+
+
+
+
+/*
+   next_random
+
+   Description:      This function returns the next pseudo-random number.
+
+   Arguments:        None.
+   Return Value:     (unsigned long int) - the number.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       Linear congruential generator.
+   Data Structures:  None.
+
+   Shared Variables: random_state - updated.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  unsigned long int  next_random()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* get the next number in the sequence */
+    random_state = (random_state * RANDOM_MULT + RANDOM_ADD) & RANDOM_MASK;
+
+
+    /* and return the high bits (the low ones aren't very random) */
+    return  random_state >> 8;
+
+}
+
+
+
+
+/*
+   put_word
+
+   Description:      This function stores a 16-bit value little-endian.
+
+   Arguments:        p (unsigned char *) - where to store it.
+                     w (unsigned int)    - the value.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  put_word(unsigned char *p, unsigned int w)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* low byte first */
+    p[0] = w & 0xFF;
+    p[1] = (w >> 8) & 0xFF;
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   put_long
+
+   Description:      This function stores a 32-bit value little-endian.
+
+   Arguments:        p (unsigned char *)     - where to store it.
+                     l (unsigned long int)   - the value.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  put_long(unsigned char *p, unsigned long int l)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* low word first */
+    put_word(p, l & 0xFFFF);
+    put_word(p + 2, (l >> 16) & 0xFFFF);
+
+
+    /* all done, return */
+    return;
+
+}
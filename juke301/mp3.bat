@@ -1,5 +1,6 @@
 ic86 fatutil.c debug mod186 extend code small rom noalign
 ic86 ffrev.c debug mod186 extend code small rom noalign
+ic86 frameidx.c debug mod186 extend code small rom noalign
 ic86 keyupdat.c debug mod186 extend code small rom noalign
 ic86 mainloop.c debug mod186 extend code small rom noalign
 ic86 playmp3.c debug mod186 extend code small rom noalign
@@ -72,6 +72,49 @@
                                  pointers to them and added constants to set
                                  the size of those strings.  It also no longer
                                  needs to keep track of the starting position.
+      6/7/16   Tim Liu           Added declarations for get_blocks_start() and
+                                 get_blocks_poll() (asynchronous reads).
+      6/9/16   Tim Liu           Added SECTOR_CACHE_BLOCKS and
+                                 SECTOR_CACHE_MAX_READ for the sector cache.
+      6/10/16  Tim Liu           Added FAT_MIRROR_BLOCKS and FAT_WINDOW_BLOCKS
+                                 for the FAT mirror.
+      6/11/16  Tim Liu           Replaced FAT_CACHE_BLOCKS and FAT_CACHE_SIZE
+                                 with EXTENT_INDEX_BLOCKS and
+                                 EXTENT_INDEX_SIZE.
+      6/13/16  Tim Liu           Added DIR_TABLE_BLOCKS and DIR_TABLE_ENTRIES
+                                 for the directory table and halved the
+                                 extent index and sector cache to make room
+                                 for it.
+      6/13/16  Tim Liu           Added TRACK_REPEAT_TIME, TRACK_JUMP_REPEATS,
+                                 and TRACK_JUMP_SIZE for moving quickly
+                                 through large directories.
+      6/14/16  Tim Liu           Added TAG_CACHE_ENTRIES and TAG_CACHE_SPAN
+                                 for the ID3 tag cache.
+      6/16/16  Tim Liu           Added AUDIO_BUFFER_SIZE and the buffer ring
+                                 parameters (MIN_BUFFERS, MAX_BUFFERS,
+                                 DEF_BUFFERS, MIN_BUFFER_BLOCKS,
+                                 DEF_BUFFER_BLOCKS, RING_GROW_PERCENT, and
+                                 DEF_BLOCK_TIME).
+      6/16/16  Tim Liu           Added declarations for audio_queue(),
+                                 audio_done(), and audio_low() (audio
+                                 descriptor queue).
+      6/16/16  Tim Liu           Added PRIME_BLOCKS (slow start of buffer
+                                 fills).
+      6/16/16  Tim Liu           Added SEEK_TOC_SIZE and the frames, bit_rate,
+                                 has_toc, and toc elements of track_header
+                                 (from the track's Xing/VBRI header).
+      6/16/16  Tim Liu           Added the start element to track_header and
+                                 the length element is now where the audio
+                                 ends (before any ID3 tag).
+      6/16/16  Tim Liu           Added metamacro for LINUX (host build) and
+                                 definitions of farmalloc() and farfree()
+                                 for it.
+      6/16/16  Tim Liu           Added TRACK_IMAGE_BLOCKS for a track image
+                                 of its own (after the directory table) and
+                                 halved the FAT mirror to make room for it.
+      6/16/16  Tim Liu           Removed TRACK_IMAGE_BLOCKS and the FAT mirror
+                                 again holds the largest FAT16 FAT (there is
+                                 no DRAM free for a track image).
 */
 
 
@@ -97,9 +140,32 @@
 #define  TRUE        !FALSE
 
 
-/* number of words and blocks in the FAT cache */
-#define  FAT_CACHE_BLOCKS     64
-#define  FAT_CACHE_SIZE       (FAT_CACHE_BLOCKS * IDE_BLOCK_SIZE)
+/* number of words and blocks in the file extent index */
+#define  EXTENT_INDEX_BLOCKS  32
+#define  EXTENT_INDEX_SIZE    (EXTENT_INDEX_BLOCKS * IDE_BLOCK_SIZE)
+
+/* number of blocks in the sector cache (follows the extent index in DRAM) */
+#define  SECTOR_CACHE_BLOCKS  32
+/* longest read (in blocks) that goes through the sector cache */
+/*    longer reads are streaming MP3 data and bypass it */
+#define  SECTOR_CACHE_MAX_READ  2
+
+/* number of blocks in the FAT mirror (follows the sector cache in DRAM) */
+/*    this holds the largest FAT16 FAT (65536 entries) */
+#define  FAT_MIRROR_BLOCKS    256
+/* number of FAT blocks loaded at a time when the FAT doesn't fit */
+#define  FAT_WINDOW_BLOCKS    16
+
+/* number of blocks in the directory table (follows the FAT mirror in DRAM) */
+#define  DIR_TABLE_BLOCKS     64
+/* most entries in the directory table, the rest of it holds the names */
+#define  DIR_TABLE_ENTRIES    1024
+
+/* number of ID3 tags cached for the directory table entries */
+#define  TAG_CACHE_ENTRIES    32
+/* entries on each side of the current one whose tags are read ahead */
+/*    (must be less than TAG_CACHE_ENTRIES / 2) */
+#define  TAG_CACHE_SPAN       15
 
 
 /* song information parameters */
@@ -110,19 +176,44 @@
 /* maximum length of an artist name (based on ID3 length) */
 #define  MAX_ARTIST_LEN       (ID3_TAG_ARTIST_SIZE + 1)
 
+/* entries in a track's seek table (one per percent of the time, as in a */
+/*    Xing header) */
+#define  SEEK_TOC_SIZE        100
+
 
 /* audio parameters */
 
 /* value to use when there is no MP3 data */
 #define  NO_MP3_DATA          0
 
-/* number of buffers to use for buffering MP3 data */
+/* number of largest buffers the DRAM for buffering MP3 data holds */
+/*    (not counting the empty buffer) */
 #define  NO_BUFFERS           3
 
-/* number of words and blocks in an MP3 buffer */
+/* number of words and blocks in the largest MP3 buffer */
 #define  BUFFER_BLOCKS        32
 #define  BUFFER_SIZE          (BUFFER_BLOCKS * IDE_BLOCK_SIZE)
 
+/* number of words of DRAM for the buffer ring and the empty buffer */
+#define  AUDIO_BUFFER_SIZE    ((NO_BUFFERS + 1L) * BUFFER_SIZE)
+
+/* buffer ring parameters (the ring depth grows as needed while playing) */
+#define  MIN_BUFFERS           3    /* fewest buffers in the ring */
+#define  MAX_BUFFERS          15    /* most buffers in the ring */
+#define  DEF_BUFFERS           3    /* default starting ring depth */
+#define  MIN_BUFFER_BLOCKS     8    /* smallest buffer (in blocks) */
+#define  DEF_BUFFER_BLOCKS    16    /* default buffer size (in blocks) */
+
+/* blocks read before starting the audio, later reads double in size until */
+/*    they fill a buffer (must not be more than MIN_BUFFER_BLOCKS) */
+#define  PRIME_BLOCKS          4
+
+/* grow the ring if a fill takes this percent of the play time of the data */
+#define  RING_GROW_PERCENT    50
+
+/* time (in ms) a block plays for if the track time is unknown (128 kbps) */
+#define  DEF_BLOCK_TIME       32
+
 /* rates at which fast forward and reverse are to run */
 #define  MIN_FFREV_RATE        3    /* minimum fast forward/reverse rate */
 #define  MAX_FFREV_RATE       10    /* maximum fast forward/reverse rate */
@@ -131,6 +222,11 @@
 /* minimum amount of time (in ms) to move by when in fast forward or reverse */
 #define  MIN_FFREV_TIME       500
 
+/* track key parameters for moving through large directories */
+#define  TRACK_REPEAT_TIME    500   /* most time (in ms) between repeated keys */
+#define  TRACK_JUMP_REPEATS     4   /* repeated keys before jumping */
+#define  TRACK_JUMP_SIZE       10   /* entries to move by when jumping */
+
 
 /* timing parameters */
 
@@ -162,6 +258,14 @@
   #define  USE_LIBRARY          /* use the standard library functions */
 #endif
 
+/* add the definitions necessary for a Linux host (simulation of the system) */
+#ifdef  LINUX
+  #define  FLAT_MEMORY          /* use the flat memory model */
+  #define  USE_LIBRARY          /* use the standard library functions */
+  #define  USE_ARRAY            /* use arrays to access disk data, not structures */
+  #define  PCVERSION            /* allocate memory instead of using the DRAM */
+#endif
+
 
 /* macro to make a far pointer given a segment and offset */
 #ifdef  FLAT_MEMORY
@@ -193,6 +297,13 @@
 #endif
 
 
+/* on a Linux host the PC version's memory allocation is the standard one */
+#ifdef  LINUX
+  #define  farmalloc(n)         malloc(n)
+  #define  farfree(p)           free(p)
+#endif
+
+
 
 /* structures, unions, and typedefs */
 
@@ -208,8 +319,14 @@ struct  track_header  {
                          char          title[MAX_TITLE_LEN];    /* title of the track */
                          char          artist[MAX_ARTIST_LEN];  /* track artist */
                          unsigned int  time;                    /* time length of track */
-                         long int      length;                  /* length in bytes */
+                         long int      start;                   /* start of audio (offset in bytes) */
+                         long int      length;                  /* end of audio (offset in bytes) */
                          long int      curpos;                  /* current position (offset in bytes) */
+                         long int      frames;                  /* MPEG frames in track (0 if unknown) */
+                         int           bit_rate;                /* average bit rate (kbps, 0 if unknown) */
+                         char          has_toc;                 /* track has a seek table */
+                         unsigned char toc[SEEK_TOC_SIZE];      /* seek table (position in 256ths of */
+                                                                /*    length at each percent of time) */
                       };
 
 /* status types */
@@ -254,11 +371,16 @@ void  display_title(const char far *);  /* display the track title */
 void  display_artist(const char far *); /* display the track artist */
 
 /* IDE interface functions */
-int  get_blocks(unsigned long int, int, unsigned short int far *);   /* get data */
+int   get_blocks(unsigned long int, int, unsigned short int far *);        /* get data */
+void  get_blocks_start(unsigned long int, int, unsigned short int far *);  /* start getting data */
+int   get_blocks_poll(void);                                               /* check if data is read */
 
 /* audio functions */
 void  audio_play(unsigned short int far *, int);  /* start playing */
 void  audio_halt(void);                           /* halt play or record */
+unsigned char  audio_queue(unsigned short int far *, int, int);  /* queue a buffer to play */
+int            audio_done(void);                  /* buffers played since last call */
+unsigned char  audio_low(void);                   /* audio queue ran low */
 
 
 #endif
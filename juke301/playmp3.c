@@ -17,8 +17,11 @@
                            processing function)
       begin_RptPlay      - start repeatedly playing from fast forward or
                            reverse (key processing function)
+      cont_PlayAll       - switch to playing all tracks from play or repeat
+                           play (key processing function)
       cont_RptPlay       - switch to repeat play from standard play (key
                            processing function)
+      set_play_buffers   - set the depth and buffer size of the buffer ring
       start_Play         - begin playing the current track (key processing
                            function)
       start_RptPlay      - begin repeatedly playing the current track (key
@@ -28,14 +31,45 @@
                            function)
 
    The local functions included are:
+      audio_dram         - get a pointer into the audio buffer DRAM
+      check_fill         - check if the buffer being filled has been read
+      fill_done          - finish filling a buffer and move to the next one
+      fill_setup         - get ready to fill the next buffer
+      fill_start         - start filling at the current track position
       init_Play          - actually start playing a track
+      next_track         - move to the next track for playing all tracks
+      set_block_time     - compute the play time of a block of the track
 
    The locally global variable definitions included are:
-      buffers        - buffers for playing
+      base_depth     - configured number of buffers in the ring
+      block_time     - time (in ms) a block of the track plays for
+      buffer_blocks  - number of blocks in each buffer
+      buffer_mem     - memory allocated for the buffers (PC version only)
+      buffers        - ring of buffers for playing
+      current_buffer - which buffer was last queued to the audio output
       empty_buffer   - buffer used for audio I/O when have no data available
-      current_buffer - which buffer is currently being played
+      end_play       - flag indicating the end of play is in the ring
+      fill_block     - block of the track to read next
+      fill_buffer    - which buffer is filled next from the disk
+      fill_bytes     - bytes left in the track at fill_block
+      fill_count     - number of filled buffers waiting to be played
+      fill_limit     - most blocks to read in the next buffer fill
+      fill_pending   - flag indicating a buffer fill is in progress
+      fill_skip      - words to skip at the start of the next buffer filled
+      fill_time      - time (in ms) the buffer fill in progress has taken
+      grow_ring      - flag indicating the ring should grow by a buffer
+      max_depth      - deepest ring that fits in the audio buffer DRAM
+      new_blocks     - configured number of blocks in each buffer
+      new_track      - flag indicating the next track has been started
+      old_data       - flag indicating buffers from before a repeat or the
+                       last track are still playing
+      play_all       - flag indicating playing all tracks in the directory
       play_time      - current time of play operation
+      queued         - number of buffers queued to the audio output
+      reset_ring     - flag indicating the ring configuration was changed
+      ring_depth     - number of buffers in the ring
       rpt_play       - flag indicating doing repeat play instead of play
+      slow_fill      - flag indicating a buffer fill was slow this track
 
 
    Revision History
@@ -100,14 +134,75 @@
                                  drive.
       3/15/13  Glen George       Changed to using get_file_blocks() instead of
                                  get_blocks() to support fragmented files.
+      6/7/16   Tim Liu           Buffers are filled with asynchronous reads
+                                 (get_file_blocks_start()) so update_Play()
+                                 no longer waits on the disk.
+      6/15/16  Tim Liu           Added play all mode (cont_PlayAll()): at the
+                                 end of a track update_Play() moves to the
+                                 next file in the directory and keeps
+                                 filling buffers from it without halting the
+                                 audio, like repeat play does.
+      6/16/16  Tim Liu           The buffers are now a ring whose depth and
+                                 buffer size are set at run time with
+                                 set_play_buffers() (within the audio buffer
+                                 DRAM) and the ring is kept full instead of
+                                 filling one buffer per update.  The ring
+                                 grows when buffer fills take too long
+                                 compared to the play time of the data.
+      6/16/16  Tim Liu           Buffers are queued to the audio output with
+                                 audio_queue() as soon as they are filled and
+                                 freed as audio_done() reports them played.
+                                 The ring also grows if the audio queue runs
+                                 low while the disk is still reading.
+      6/16/16  Tim Liu           Slow start: init_Play() only reads a small
+                                 priming buffer (PRIME_BLOCKS) before
+                                 starting the audio and the following reads
+                                 double in size up to a full buffer.
+      6/16/16  Tim Liu           Tracks that fit in the audio buffer DRAM are
+                                 kept there as a whole track image when
+                                 repeat playing.  The buffers point into the
+                                 image and blocks already in it are not read
+                                 again (later iterations and restarts after
+                                 fast forward or reverse use no disk reads).
+      6/16/16  Tim Liu           The frames in each buffer filled are added
+                                 to the frame index (index_frames()).  Play
+                                 can start in the middle of a block (at a
+                                 frame found by fast forward or reverse), the
+                                 first buffer skips the words before it.
+      6/16/16  Tim Liu           Only the track's audio is read and played
+                                 (from after any ID3v2 tag to before any
+                                 ID3v1 tag), restarting a track also skips
+                                 the words before its start.  Added
+                                 fill_start().
+      6/16/16  Tim Liu           Don't include alloc.h in the Linux host
+                                 build (LINUX) and local function
+                                 declarations are static (gcc requires it).
+      6/16/16  Tim Liu           The track image has its own DRAM (after the
+                                 directory table, TRACK_IMAGE_BLOCKS) instead
+                                 of sharing the ring's, so the ring no longer
+                                 overwrites it, its size doesn't depend on
+                                 the ring configuration, and it is kept in
+                                 the PC version too.  Added image_dram().
+      6/16/16  Tim Liu           When playing all tracks next_track() skips
+                                 directories and empty files up to the next
+                                 track, and a track played from the track
+                                 image is followed by the next track
+                                 through the ring without halting the audio.
+      6/16/16  Tim Liu           Removed the track image, the FAT mirror
+                                 needs all of the DRAM it used.
+      6/16/16  Tim Liu           next_track() finds the end of the directory
+                                 with at_dir_end() instead of comparing the
+                                 entry names.
 */
 
 
 
 /* library include files */
 #ifdef  PCVERSION
+#ifndef  LINUX
     #include  <alloc.h>
 #endif
+#endif
 
 /* local include files */
 #include  "mp3defs.h"
@@ -115,6 +210,8 @@
 #include  "updatfnc.h"
 #include  "trakutil.h"
 #include  "fatutil.h"
+#include  "frameidx.h"
+#include  "vfat.h"
 
 
 
@@ -126,18 +223,52 @@
 
 
 /* local function declarations */
-enum status  init_Play(enum status);            /* initialize playing */
+static  enum status  init_Play(enum status);            /* initialize playing */
+static  void         check_fill(void);                  /* check if buffer fill is done */
+static  char         fill_setup(int *);                 /* get ready to fill a buffer */
+static  void         fill_start(void);                  /* start filling at position */
+static  void         fill_done(int);                    /* finish filling a buffer */
+static  char         next_track(void);                  /* move to the next track */
+static  void         set_block_time(void);              /* get play time of a block */
+static  unsigned short int far  *audio_dram(unsigned long int); /* pointer into DRAM */
 
 
 
 
 /* locally global variables */
-static struct audio_buf          buffers[NO_BUFFERS];/* buffers to play */
+static struct audio_buf          buffers[MAX_BUFFERS];/* ring of buffers to play */
 static unsigned short int  far  *empty_buffer;       /* empty (no data) buffer */
-static int                       current_buffer;     /* buffer currently playing */
+#ifdef  PCVERSION
+static unsigned short int  far  *buffer_mem;         /* allocated buffer memory */
+#endif
+static int                       current_buffer;     /* last buffer queued */
+static int                       queued;             /* buffers queued to audio */
+
+static int                       ring_depth;         /* buffers in the ring */
+static int                       max_depth;          /* deepest ring that fits */
+static int                       buffer_blocks;      /* blocks in a buffer */
+static int                       base_depth;         /* configured ring depth */
+static int                       new_blocks;         /* configured blocks in a buffer */
+static int                       reset_ring;         /* configuration changed */
+static int                       grow_ring;          /* add a buffer to the ring */
+static int                       slow_fill;          /* a buffer fill was slow */
+static int                       block_time;         /* play time of a block (ms) */
 
 static long int                  play_time;          /* time for play operation */
 static int                       rpt_play;           /* doing repeat play */
+static int                       play_all;           /* playing all tracks */
+static int                       new_track;          /* next track started, not playing yet */
+
+static int                       fill_buffer;        /* next buffer to fill */
+static int                       fill_count;         /* filled buffers waiting */
+static int                       fill_limit;         /* most blocks in next fill */
+static long int                  fill_block;         /* next block of track to read */
+static long int                  fill_bytes;         /* bytes left at fill_block */
+static int                       fill_pending;       /* buffer fill in progress */
+static int                       fill_skip;          /* words to skip in next fill */
+static long int                  fill_time;          /* time fill has taken */
+static int                       end_play;           /* end of play in the ring */
+static int                       old_data;           /* old data still playing */
 
 
 
@@ -167,10 +298,11 @@ static int                       rpt_play;           /* doing repeat play */
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: rpt_play - set to FALSE.
+   Shared Variables: play_all - set to FALSE.
+                     rpt_play - set to FALSE.
 
    Author:           Glen George
-   Last Modified:    March 15, 2013
+   Last Modified:    June 15, 2016
 
 */
 
@@ -199,8 +331,10 @@ enum status  start_Play(enum status cur_status)
     }
     else  {
 
-        /* it's a song so set global flag to normal play (not repeat play) */
+        /* it's a song so set global flags to normal play (not repeat play */
+        /*    or play all) */
         rpt_play = FALSE;
+        play_all = FALSE;
 
         /* and start playing and update the status */
         cur_status = init_Play(cur_status);
@@ -238,10 +372,11 @@ enum status  start_Play(enum status cur_status)
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: rpt_play - set to TRUE.
+   Shared Variables: play_all - set to FALSE.
+                     rpt_play - set to TRUE.
 
    Author:           Glen George
-   Last Modified:    June 5, 2003
+   Last Modified:    June 15, 2016
 
 */
 
@@ -259,6 +394,7 @@ enum status  start_RptPlay(enum status cur_status)
 
         /* set global flags to repeat play */
         rpt_play = TRUE;
+        play_all = FALSE;
 
         /* now start playing and get the status */
         cur_status = init_Play(cur_status);
@@ -320,6 +456,56 @@ enum status  cont_RptPlay(enum status cur_status)
 
 
 
+/*
+   cont_PlayAll
+
+   Description:      This function handles the <Play> key when already
+                     playing a track.  It switches to playing all the tracks
+                     in the directory by setting the locally global variable
+                     play_all (and clearing rpt_play).  The update function
+                     takes care of going on to the next track at the end of
+                     the track without stopping the audio.
+
+   Arguments:        cur_status (enum status) - the current system status (not
+                                                used).
+   Return Value:     (enum status) - the new system status (STAT_PLAY).
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: play_all - set to TRUE (playing all tracks).
+                     rpt_play - set to FALSE (not repeating the track).
+
+   Author:           Tim Liu
+   Last Modified:    June 15, 2016
+
+*/
+
+enum status  cont_PlayAll(enum status cur_status)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* now playing all tracks, not repeating this one */
+    play_all = TRUE;
+    rpt_play = FALSE;
+
+
+    /* done setting up for play all - return the status (STAT_PLAY) */
+    return  STAT_PLAY;
+
+}
+
+
+
+
 /*
    begin_Play
 
@@ -416,8 +602,12 @@ enum status  begin_RptPlay(enum status cur_status)
    stop_Play
 
    Description:      This function handles the <Stop> key when playing.  It
-                     halts the audio system, resets the track to the start of
-                     the track, and changes the current status to idle.
+                     halts the audio system, waits for any buffer fill to
+                     finish, resets the track to the start of the track, and
+                     changes the current status to idle.  If playing all
+                     tracks and the next track was already started (but not
+                     yet heard) its title and artist are displayed since it
+                     is now the current track.
 
    Arguments:        cur_status (enum status) - the current system status (not
                                                 used).
@@ -431,34 +621,32 @@ enum status  begin_RptPlay(enum status cur_status)
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: None.
+   Shared Variables: buffer_mem   - freed (PC version only).
+                     fill_pending - cleared when the buffer fill is done.
+                     new_track    - accessed and cleared.
 
    Author:           Glen George
-   Last Modified:    June 5, 2003
+   Last Modified:    June 16, 2016
 
 */
 
 enum status  stop_Play(enum status cur_status)
 {
     /* variables */
-#ifdef  PCVERSION
-    int  i;             /* loop index */
-#else
-    /* none */
-#endif
+      /* none */
 
 
 
     /* first halt the audio output */
     audio_halt();
 
+    /* the disk may still be filling a buffer, wait for it */
+    while (fill_pending)
+        check_fill();
+
     /* if the PC version need to free memory */
 #ifdef PCVERSION
-    for (i = 0; i < NO_BUFFERS; i++)  {
-        /* free the buffer */
-        farfree(buffers[i].p);
-    }
-    farfree(empty_buffer);
+    farfree(buffer_mem);
 #endif
 
     /* reset to the start of the current track */
@@ -467,6 +655,13 @@ enum status  stop_Play(enum status cur_status)
     /* display the new track time */
     display_time(get_track_time());
 
+    /* if already on the next track, display it too */
+    if (new_track)  {
+        display_title(get_track_title());
+        display_artist(get_track_artist());
+        new_track = FALSE;
+    }
+
 
     /* return with the new status */
     return  STAT_IDLE;
@@ -476,15 +671,90 @@ enum status  stop_Play(enum status cur_status)
 
 
 
+/*
+   set_play_buffers
+
+   Description:      This function sets the configuration of the buffer
+                     ring used for playing: the starting number of buffers
+                     in the ring (its depth) and the size of each buffer in
+                     blocks.  The ring (plus the empty buffer) must fit in
+                     the DRAM set aside for audio buffers (AUDIO_BUFFER_SIZE
+                     words).  The new configuration is used starting with
+                     the next track played.  While playing the ring may grow
+                     deeper than the configured depth if the disk is slow
+                     (see check_fill()).
+
+   Arguments:        depth (int)  - number of buffers to start the ring
+                                    with (at least MIN_BUFFERS).
+                     blocks (int) - number of blocks in each buffer (from
+                                    MIN_BUFFER_BLOCKS to BUFFER_BLOCKS).
+   Return Value:     (char) - TRUE if the configuration can't be used (the
+                     previous configuration is kept), FALSE otherwise.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   Configurations that don't fit in the DRAM budget are
+                     rejected and an error is returned.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: base_depth - set to the configured ring depth.
+                     new_blocks - set to the configured buffer size.
+                     reset_ring - set to use the new configuration.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+char  set_play_buffers(int depth, int blocks)
+{
+    /* variables */
+    char  error;                /* configuration can't be used */
+
+
+
+    /* check the configuration fits in the audio buffer DRAM */
+    /* (the ring needs depth buffers plus the empty buffer) */
+    error = (blocks < MIN_BUFFER_BLOCKS) || (blocks > BUFFER_BLOCKS) ||
+            (depth < MIN_BUFFERS) || (depth > MAX_BUFFERS) ||
+            (((depth + 1L) * blocks * IDE_BLOCK_SIZE) > AUDIO_BUFFER_SIZE);
+
+    /* if it fits, use it for the next track played */
+    if (!error)  {
+        base_depth = depth;
+        new_blocks = blocks;
+        reset_ring = TRUE;
+    }
+
+
+    /* return whether there was an error */
+    return  error;
+
+}
+
+
+
+
 /*
    init_Play
 
    Description:      This function handles starting a track playing for the
-                     <Play> and <Repeat Play> keys.  It starts playing the
-                     track at the current position.  If there is no time
-                     remaining on the track (for example, it is at the end)
-                     the function returns with the current status, otherwise
-                     it returns with the status set to STAT_PLAY.
+                     <Play> and <Repeat Play> keys.  It sets up the buffer
+                     ring and starts playing the track at the current
+                     position.  If there is no time remaining on the track
+                     (for example, it is at the end) the function returns
+                     with the current status, otherwise it returns with the
+                     status set to STAT_PLAY.  A new ring configuration (from
+                     set_play_buffers()) is picked up here, otherwise if the
+                     last track played never had a slow buffer fill the ring
+                     is made one buffer shallower (down to the configured
+                     depth).  So the audio starts quickly only a small first
+                     buffer (PRIME_BLOCKS blocks) is read before starting the
+                     audio, the following fills (in update_Play()) double in
+                     size until they are full buffers.
 
    Arguments:        cur_status (enum status) - the current system status.
    Return Value:     (enum status) - the new system status: STAT_PLAY if there
@@ -499,14 +769,34 @@ enum status  stop_Play(enum status cur_status)
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: buffers        - initialized with data.
+   Shared Variables: base_depth     - accessed to get the configured depth.
+                     buffer_blocks  - set to the buffer size in blocks.
+                     buffer_mem     - set to the allocated buffers (PC only).
+                     buffers        - initialized with data.
                      empty_buffer   - filled with NO_MP3_DATA signal.
                      current_buffer - set to first buffer (0).
+                     end_play       - cleared (not at the end of play).
+                     fill_block     - set to the track's current block.
+                     fill_buffer    - set to the buffer after those read.
+                     fill_bytes     - set to the bytes left in the track.
+                     fill_count     - set to the buffers waiting to play.
+                     fill_limit     - set to the priming read size.
+                     fill_pending   - cleared (no buffer fill in progress).
+                     fill_skip      - set to the words to skip.
+                     grow_ring      - cleared (ring not growing).
+                     max_depth      - set to the deepest ring that fits.
+                     new_blocks     - accessed to get the configured size.
+                     new_track      - cleared (on the track being played).
+                     old_data       - cleared (no previous iteration).
                      play_time      - set to the current track time.
+                     queued         - set to the first buffer (1).
+                     reset_ring     - accessed and cleared.
+                     ring_depth     - set to the ring depth for this track.
                      rpt_play       - used to determine normal or repeat play.
+                     slow_fill      - accessed and cleared.
 
    Author:           Glen George
-   Last Modified:    June 6, 2006
+   Last Modified:    June 16, 2016
 
 */
 
@@ -514,132 +804,109 @@ static  enum status  init_Play(enum status cur_status)
 {
     /* variables */
     int           blocks_to_read;       /* number of blocks to read */
-    int           blocks_read;          /* blocks actually read from disk */
-    int           tot_blocks_read = 0;  /* total number of blocks read */
-
-    long int      bytes_left;           /* bytes left in the track */
 
-    int           have_buffer = FALSE;  /* have a buffer with data */
-    int           end_track = FALSE;    /* at the end of the track */
+    unsigned int  buffer_words;         /* size of a buffer in words */
 
-    unsigned int  tmp;                  /* temporary variable for intermediate results */
-                                        /*    (seems to fix a compiler bug) */
+    int           have_buffer;          /* have a buffer with data */
 
     int           i;                    /* loop index */
 
 
 
+    /* no buffer is being filled asynchronously yet */
+    /* (get_file_blocks() finishes any fill left from before) */
+    fill_pending = FALSE;
+    /* playing the current track and not at its end */
+    new_track = FALSE;
+    old_data = FALSE;
+    end_play = FALSE;
+    grow_ring = FALSE;
+
+
+    /* figure out the ring for this track */
+    if (reset_ring)  {
+        /* new configuration - start over with it */
+        buffer_blocks = new_blocks;
+        ring_depth = base_depth;
+        reset_ring = FALSE;
+        /* and get the deepest ring that fits (leaving the empty buffer) */
+        max_depth = (int) (AUDIO_BUFFER_SIZE / ((long int) buffer_blocks * IDE_BLOCK_SIZE)) - 1;
+        if (max_depth > MAX_BUFFERS)
+            max_depth = MAX_BUFFERS;
+    }
+    else if (!slow_fill && (ring_depth > base_depth))  {
+        /* the disk kept up last time, give back a buffer */
+        ring_depth--;
+    }
+    /* no slow fills on this track yet */
+    slow_fill = FALSE;
+
+    /* get the buffer size in words */
+    buffer_words = buffer_blocks * IDE_BLOCK_SIZE;
+
+
     /* first initialize the buffer pointers and buffer structure */
-    for (i = 0; i < NO_BUFFERS; i++)  {
+    /* all of the buffers the ring could grow to are set up */
+#ifdef  PCVERSION
+    /* in the PC version, allocate the buffers (remember they are words) */
+    buffer_mem = (unsigned short int far *) farmalloc(AUDIO_BUFFER_SIZE * sizeof(short int));
+#endif
+    for (i = 0; i < max_depth; i++)  {
         /* nothing in the buffer, it isn't the end, and point to DRAM */
         buffers[i].size = 0;
         buffers[i].done = FALSE;
+        buffers[i].p    = audio_dram((unsigned long int) i * buffer_words);
     }
 
-    /* allocate the buffer - remember it is words (short ints) */
-    /* unroll the loop to workaround a possible compiler problem */
-#ifdef  PCVERSION
-    /* in PC version, allocate the buffer */
-    buffers[0].p    = (unsigned short int far *) farmalloc(BUFFER_SIZE * sizeof(short int));
-    buffers[1].p    = (unsigned short int far *) farmalloc(BUFFER_SIZE * sizeof(short int));
-    buffers[2].p    = (unsigned short int far *) farmalloc(BUFFER_SIZE * sizeof(short int));
-#else
-    buffers[0].p    = (unsigned short int far *) MAKE_FARPTR(DRAM_STARTSEG, 0UL);
-    buffers[1].p    = (unsigned short int far *) MAKE_FARPTR(DRAM_STARTSEG, 1UL * BUFFER_SIZE * sizeof(short int));
-    buffers[2].p    = (unsigned short int far *) MAKE_FARPTR(DRAM_STARTSEG, 2UL * BUFFER_SIZE * sizeof(short int));
-#endif
-
-    /* need to setup empty buffer too */
+    /* need to setup empty buffer too, it follows the deepest ring */
     /* first the pointer */
-#ifdef  PCVERSION
-    /* in the PC version have to allocate the buffer */
-    empty_buffer = (unsigned short int far *) farmalloc(BUFFER_SIZE);
-#else
-    empty_buffer = (unsigned short int far *) MAKE_FARPTR(DRAM_STARTSEG, (unsigned long int) NO_BUFFERS * BUFFER_SIZE);
-#endif
+    empty_buffer = audio_dram((unsigned long int) max_depth * buffer_words);
     /* now fill it */
-    for (i = 0; i < BUFFER_SIZE; i++)
+    for (i = 0; i < buffer_words; i++)
         empty_buffer[i] = NO_MP3_DATA;
 
 
     /* now setup the playing time */
     play_time = get_track_time() * TIME_SCALE;
+    /* and how long a block of the track plays for */
+    set_block_time();
 
 
-    /* now get the two buffers for the track from the disk */
-    for (i = 0 ; (i < 2); i++)  {
+    /* start filling at the current position with an empty ring */
+    fill_start();
+    fill_buffer = 0;
+    fill_count = 0;
+    /* starting with a small read so the audio starts right away */
+    fill_limit = PRIME_BLOCKS;
 
-        /* first check if at end of track */
-        if (get_track_remaining_length() == 0)  {
-            /* at end of track - check if repeat playing */
-            if (rpt_play)  {
-                /* at end and repeat playing - restart at beginning */
-                init_track();
-                /* need to reset total number of blocks read for track too */
-                tot_blocks_read = 0;
-            }
-            else  {
-                /* at end, but not repeating, so set flag */
-                end_track = TRUE;
-            }
-        }
-
-        /* if not at end, read the blocks for this buffer */
-        if (!end_track)  {
-
-            /* compute the number of blocks to read (block size is in words) */
-            bytes_left = get_track_remaining_length() - (2 * IDE_BLOCK_SIZE * tot_blocks_read);
-            blocks_to_read = (bytes_left + (2 * IDE_BLOCK_SIZE - 1)) / (2 * IDE_BLOCK_SIZE);
-            /* but only read up to BUFFER_BLOCKS blocks */
-            if (blocks_to_read > BUFFER_BLOCKS)
-                blocks_to_read = BUFFER_BLOCKS;
-
-            /* now read the blocks */
-            blocks_read = get_file_blocks(get_track_block_position() + tot_blocks_read, blocks_to_read, buffers[i].p);
-
-            /* check if read anything */
-            if (blocks_read > 0)  {
-                /* did read something, store how much (in words, not bytes) */
-                if (bytes_left >= (2 * IDE_BLOCK_SIZE * blocks_read))
-                    /* all of the blocks are data */
-                    tmp = blocks_read * IDE_BLOCK_SIZE;
-                else
-                    /* remember the buffer size is in words */
-                    tmp = (bytes_left + 1) / 2;
-                /* now store the buffer size */
-                buffers[i].size = tmp;
-                /* also set the flag that we read data */
-                have_buffer = TRUE;
-            }
-            else  {
-                /* couldn't read anything, it is the end of the track */
-                end_track = TRUE;
-            }
-
-            /* update number of blocks read so far */
-            tot_blocks_read += blocks_read;
-        }
+    /* now get the first buffer for the track from the disk */
+    /* (or the empty buffer if at the end) */
+    if (fill_setup(&blocks_to_read))
+        fill_done(get_file_blocks(fill_block, blocks_to_read, buffers[fill_buffer].p));
 
-        /* if at the end of the track need to play the empty buffer */
-        if (end_track)  {
-            buffers[i].size = BUFFER_SIZE;
-            buffers[i].done = TRUE;
-            buffers[i].p = empty_buffer;
-        }
-    }
 
+    /* have data if the first buffer isn't the empty buffer */
+    have_buffer = (buffers[0].p != empty_buffer);
 
     /* got a buffer, start the audio output if there is anything to output */
     if (have_buffer)  {
         /* have audio data - play it */
         audio_play(buffers[0].p, buffers[0].size);
-        /* on the first buffer */
+        /* on the first buffer, it is no longer waiting */
         current_buffer = 0;
+        queued = 1;
+        fill_count--;
         /* also update the time display */
         display_time(play_time / TIME_SCALE);
         /* and reset the elapsed time */
         elapsed_time();
     }
+#ifdef  PCVERSION
+    else  {
+        /* nothing to play, free the buffers in the PC version */
+        farfree(buffer_mem);
+    }
+#endif
 
 
     /* finally, return with the proper status */
@@ -659,14 +926,28 @@ static  enum status  init_Play(enum status cur_status)
    update_Play
 
    Description:      This function handles updates when playing or repeat
-                     playing.  It first checks if it is time for an update (by
-                     calling the function update) and if so it gets the next
-                     buffer to output and updates the time as is appropriate.
-                     When it reaches the end of the track (when not in repeat
-                     play mode) it uses the empty_buffer, which was previously
-                     filled with NO_MP3_DATA signal, to fill out the track and
-                     make sure all of the "good" signal has made it all the
-                     way through the pipeline.
+                     playing.  It first charges the elapsed time to any
+                     buffer fill in progress and checks if that fill has
+                     finished.  If the audio queue ran low while a fill was
+                     still in progress (after the fills have ramped up to
+                     full buffers) the ring is set to grow.  Then it
+                     updates the track position for each buffer the audio
+                     output has finished (audio_done()) and queues all of
+                     the filled buffers the audio output will take (by
+                     calling audio_queue()).  Last, if no fill is in
+                     progress and there is a free buffer in the ring it
+                     starts filling it.
+                     The disk read is not waited on, it is checked on later
+                     calls.  When it reaches the end of the track (when not
+                     in repeat play mode) it uses the empty_buffer, which
+                     was previously filled with NO_MP3_DATA signal, to fill
+                     out the track and make sure all of the "good" signal
+                     has made it all the way through the pipeline.  When
+                     playing all tracks, at the end of the track the next
+                     file in the directory is made the current track and its
+                     data follows the last buffer of the track (marked done
+                     as in repeat play) so the audio doesn't stop.  Its
+                     information is displayed once the audio gets to it.
 
    Arguments:        cur_status (enum status) - the current system status.
    Return Value:     (enum status) - the new system status: STAT_IDLE if have
@@ -678,18 +959,40 @@ static  enum status  init_Play(enum status cur_status)
    Error Handling:   None.
 
    Algorithms:       None.
-   Data Structures:  None.
-
-   Shared Variables: buffers        - used for track data and filled.
+   Data Structures:  The buffers form a ring of ring_depth buffers.  The
+                     audio output has the queued buffers up to and including
+                     current_buffer (the oldest is playing), the fill_count
+                     buffers after current_buffer are filled and waiting,
+                     and fill_buffer is the next one to fill.
+
+   Shared Variables: buffer_mem     - freed at the end (PC only).
+                     buffers        - used for track data and filled.
                      empty_buffer   - output at the end of the track.
-                     current_buffer - set to the buffer now being played.
+                     current_buffer - set to the last buffer queued.
+                     end_play       - accessed to check for the end of play.
+                     fill_block     - accessed to get where to read.
+                     fill_buffer    - accessed to get the buffer to fill.
+                     fill_count     - decremented when a buffer is handed to
+                                      the audio output.
+                     fill_limit     - accessed to check if still ramping up.
+                     fill_pending   - set when a buffer fill is started.
+                     fill_time      - reset when a fill is started and
+                                      updated while it is in progress.
+                     grow_ring      - set if the audio queue ran low.
+                     max_depth      - accessed to get the deepest ring.
+                     new_track      - accessed and cleared when the next
+                                      track starts playing.
+                     old_data       - accessed and cleared when the previous
+                                      iteration (or track) is done playing.
                      play_time      - updated to the time the track has left
-                                      to play.
-                     rpt_play       - accessed to determine normal or repeat
-                                      play mode.
+                                      to play (reset for a new track).
+                     queued         - updated as buffers are queued and
+                                      finished.
+                     ring_depth     - accessed to wrap around the ring.
+                     slow_fill      - set if the audio queue ran low.
 
    Author:           Glen George
-   Last Modified:    March 15, 2013
+   Last Modified:    June 16, 2016
 
 */
 
@@ -697,165 +1000,145 @@ enum status  update_Play(enum status cur_status)
 {
     /* variables */
     long int  old_play_time = play_time;    /* previous time value */
+    long int  elapsed;                      /* time since the last update */
 
     int       next_buffer;                  /* next buffer to play */
-    int       previous_buffer;              /* buffer that just finished */
-    int       fill_buffer;                  /* next buffer to fill */
+    int       previous_buffer;              /* buffer that finished/is playing */
 
-    long int  start_pos;                    /* starting position for read */
-    int       blocks_to_read;               /* number of blocks to read */
-    int       blocks_read;                  /* blocks actually read from disk */
+    int       done;                         /* buffers the audio finished */
+    int       queue_it;                     /* buffer was queued */
 
-    long int  bytes_left;                   /* bytes left in the track */
-    long int  words_read;                   /* words read and waiting to play */
+    int       blocks_to_read;               /* number of blocks to read */
 
-    int       end_play = FALSE;             /* done playing (out of data) */
 
-#ifdef  PCVERSION
-    int       i;                            /* loop index (needed in PC version only) */
-#endif
 
+    /* get the time since the last update */
+    elapsed = elapsed_time();
+    play_time -= elapsed;
+    /* it all counts against the buffer fill if there is one */
+    if (fill_pending)
+        fill_time += elapsed;
 
+    /* now check if a buffer fill has finished */
+    check_fill();
 
-    /* figure out the next buffer */
-    next_buffer = current_buffer + 1;
-    /* check if wrapping around the end of the buffers */
-    if (next_buffer >= NO_BUFFERS)
-        next_buffer -= NO_BUFFERS;
 
+    /* if the audio queue ran low while the disk is still reading the */
+    /*    next buffer, the disk isn't keeping ahead - grow the ring */
+    /* (the queue is always low while the fills are still ramping up) */
+    if (audio_low() && fill_pending && (fill_count == 0) && (fill_limit >= buffer_blocks))  {
+        slow_fill = TRUE;
+        if (ring_depth < max_depth)
+            grow_ring = TRUE;
+    }
 
-    /* check if it is time to do an update */
-    if (update(buffers[next_buffer].p, buffers[next_buffer].size))  {
 
-        /* system was ready for the buffer - need to do an update */
+    /* update the track position for the buffers the audio has finished */
+    for (done = audio_done(); done > 0; done--)  {
 
-        /* update the track position */
-        /* get the buffer that just finished */
-        previous_buffer = current_buffer - 1;
-        /* take care of wrapping around start of array */
+        /* get the buffer that finished (the oldest one queued) */
+        previous_buffer = current_buffer - queued + 1;
+        /* take care of wrapping around start of the ring */
         if (previous_buffer < 0)
-            previous_buffer += NO_BUFFERS;
-        /* now update the position if not starting over on a repeat play */
-        /* this is necessary because previous_buffer and/or current_buffer */
-        /* could be from the last iteration of the repeat play */
-        if (!(buffers[previous_buffer].done || buffers[current_buffer].done))
-            /* not finishing an iteration - update the position */
+            previous_buffer += ring_depth;
+        /* and it is no longer queued */
+        queued--;
+
+        /* now update the position if not finishing the buffers from */
+        /*    before a repeat play restart (or the last track) */
+        if (old_data)  {
+            /* check if the last buffer of the old data is done */
+            if (buffers[previous_buffer].done)  {
+                /* it is, from now on the buffers are for the track */
+                old_data = FALSE;
+                /* check if the next track (when playing all) is now playing */
+                if (new_track)  {
+                    /* the next track's first buffer is playing, display it */
+                    new_track = FALSE;
+                    display_title(get_track_title());
+                    display_artist(get_track_artist());
+                    /* and start its time */
+                    play_time = get_track_time() * TIME_SCALE;
+                    old_play_time = play_time + TIME_SCALE;
+                }
+            }
+        }
+        else  {
+            /* buffer was part of this track - update the position */
             /* remember that buffer size is in words and track position is */
             /* maintained in bytes */
             update_track_position(2 * buffers[previous_buffer].size);
+        }
+    }
+
 
-        /* check if at the end of the track (if now outputting done buffer */
-        /* this guarantees last buffer with data has been output) */
-        if (buffers[current_buffer].done && !rpt_play)  {
+    /* get the oldest buffer still queued (the one playing) */
+    previous_buffer = current_buffer - queued + 1;
+    if (previous_buffer < 0)
+        previous_buffer += ring_depth;
 
-            /* done with this track - turn off audio output */
-            audio_halt();
+    /* check if at the end of the track (if now outputting the empty */
+    /* buffer, or out of buffers, this guarantees last buffer with data */
+    /* has been output) */
+    if (end_play && ((queued == 0) || (buffers[previous_buffer].p == empty_buffer)))  {
 
-            /* if the PC version need to free memory */
+        /* done with this track - turn off audio output */
+        audio_halt();
+
+        /* if the PC version need to free memory */
 #ifdef  PCVERSION
-            for (i = 0; i < NO_BUFFERS; i++)  {
-                /* free the buffer */
-                farfree(buffers[i].p);
-            }
-            farfree(empty_buffer);
+        farfree(buffer_mem);
 #endif
 
-            /* reset to start of track */
-            init_track();
+        /* reset to start of track */
+        init_track();
 
-            /* set status back to idle */
-            cur_status = STAT_IDLE;
-        }
-        else  {
+        /* set status back to idle */
+        cur_status = STAT_IDLE;
+    }
+    else  {
 
-            /* not done playing */
-
-            /* get the next buffer to fill */
-            fill_buffer = current_buffer + 2;
-            /* watch out for wrapping */
-            if (fill_buffer >= NO_BUFFERS)
-                fill_buffer -= NO_BUFFERS;
-
-            /* attempt to get another buffer */
-
-            /* first figure out where the buffer is and how big it is */
-            /* the next buffer has to be part of the newest iteration */
-            words_read = buffers[next_buffer].size;
-            /* only include the current buffer if it wasn't the end of the previous iteration */
-            if (!(buffers[current_buffer].done))
-                words_read += buffers[current_buffer].size;
-            /* now compute the number of bytes left and starting position */
-            bytes_left = get_track_remaining_length() - (2 * words_read);
-            start_pos = get_track_block_position() + (words_read / IDE_BLOCK_SIZE);
-
-            /* check if out of data */
-            if (bytes_left <= 0)  {
-                /* nothing left to play, check if repeating */
-                if (rpt_play)  {
-                    /* repeating, so can reinitialize the track */
-                    init_track();
-                    /* and recompute the number of bytes left */
-                    bytes_left = get_track_remaining_length();
-                    /* and the starting position */
-                    start_pos = get_track_block_position();
-                    /* the block just sent was last one of the iteration */
-                    buffers[next_buffer].done = TRUE;
-                }
-                else  {
-                    /* not repeating, we're done */
-                    end_play = TRUE;
-                }
+        /* not done playing, queue as many of the filled buffers as the */
+        /*    audio will take */
+        do  {
+            /* figure out the next buffer */
+            next_buffer = current_buffer + 1;
+            /* check if wrapping around the end of the ring */
+            if (next_buffer >= ring_depth)
+                next_buffer -= ring_depth;
+
+            /* it can only be queued once it has been filled */
+            queue_it = (fill_count > 0) &&
+                       audio_queue(buffers[next_buffer].p, buffers[next_buffer].size, buffers[next_buffer].done);
+
+            /* if queued, it is the newest buffer the audio has */
+            if (queue_it)  {
+                current_buffer = next_buffer;
+                queued++;
+                /* and it is no longer waiting */
+                fill_count--;
             }
 
-            /* if still playing, can get the data */
-            if (!end_play)  {
-
-                /* compute the number of blocks to read */
-                blocks_to_read = (bytes_left + (2 * IDE_BLOCK_SIZE - 1)) / (2 * IDE_BLOCK_SIZE);
-                /* but only read up to BUFFER_BLOCKS blocks */
-                if (blocks_to_read > BUFFER_BLOCKS)
-                    blocks_to_read = BUFFER_BLOCKS;
-
-                /* now read the blocks */
-                blocks_read = get_file_blocks(start_pos, blocks_to_read, buffers[fill_buffer].p);
-
-                /* check if read anything */
-                if (blocks_read > 0)  {
-                    /* did read something, store how much (words, not bytes) */
-                    if (bytes_left >= (2 * IDE_BLOCK_SIZE * blocks_read))
-                        /* all of the blocks are data */
-                        buffers[fill_buffer].size = blocks_read * IDE_BLOCK_SIZE;
-                    else
-                        /* only play the real data */
-                        /* remember that buffer sizes are in words, not bytes */
-                        buffers[fill_buffer].size = (bytes_left + 1) / 2;
-                    /* this block is not the last one */
-                    buffers[fill_buffer].done = FALSE;
-                }
-                else  {
-                    /* couldn't read anything, it is the end of the track */
-                    end_play = TRUE;
-                }
-            }
+        } while (queue_it);
+    }
 
-            /* if at the end of play, need to play the empty buffer */
-            if (end_play)  {
-                buffers[fill_buffer].p = empty_buffer;
-                buffers[fill_buffer].size = BUFFER_SIZE;
-                buffers[fill_buffer].done = TRUE;
-            }
 
+    /* keep the ring full - fill the next buffer if there is a free one */
+    /* (not queued or waiting to be queued) and not already filling one */
+    if ((cur_status != STAT_IDLE) && !fill_pending && ((queued + fill_count) < ring_depth))  {
 
-            /* finally, update the current buffer */
-            current_buffer = next_buffer;
+        /* get the next buffer (or the empty buffer at the end) */
+        if (fill_setup(&blocks_to_read))  {
+            /* there is data, start reading it, check_fill() finishes up */
+            fill_pending = TRUE;
+            fill_time = 0;
+            get_file_blocks_start(fill_block, blocks_to_read, buffers[fill_buffer].p);
         }
     }
 
 
     /* always update the displayed time */
 
-    /* get the elapsed time */
-    play_time -= elapsed_time();
     /* see if we need to update the display */
     if ((play_time / TIME_SCALE) != (old_play_time / TIME_SCALE))
         /* the time has changed - update the display */
@@ -866,3 +1149,572 @@ enum status  update_Play(enum status cur_status)
     return  cur_status;
 
 }
+
+
+
+
+/*
+   check_fill
+
+   Description:      This function checks if the asynchronous read filling
+                     a buffer has finished.  When it has, the buffer is
+                     finished by fill_done().  If the read took more than
+                     RING_GROW_PERCENT of the time the data read plays for,
+                     the disk is barely keeping up with the audio so the ring
+                     is set to grow by a buffer (if it fits).
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   A failed read is treated as the end of the track.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: block_time   - accessed to get the play time of a block.
+                     fill_pending - cleared when the fill has finished.
+                     fill_time    - accessed to get the time of the fill.
+                     grow_ring    - set if the ring should grow.
+                     max_depth    - accessed to get the deepest ring.
+                     ring_depth   - accessed to get the ring depth.
+                     slow_fill    - set if the fill was slow.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  check_fill()
+{
+    /* variables */
+    int  blocks_read;           /* blocks actually read from disk */
+
+
+
+    /* only need to check if filling a buffer */
+    if (fill_pending)  {
+
+        /* see if the read has finished */
+        blocks_read = get_file_blocks_poll();
+
+        if (blocks_read != IDE_BUSY)  {
+
+            /* the read is done, no longer filling the buffer */
+            fill_pending = FALSE;
+
+            /* check if the read was slow compared to the play time */
+            if ((blocks_read > 0) &&
+                ((100 * fill_time) >= ((long int) RING_GROW_PERCENT * blocks_read * block_time)))  {
+                /* it was, remember that and grow the ring if possible */
+                slow_fill = TRUE;
+                if (ring_depth < max_depth)
+                    grow_ring = TRUE;
+            }
+
+            /* now finish up the buffer */
+            fill_done(blocks_read);
+        }
+    }
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   fill_setup
+
+   Description:      This function gets ready to fill the next buffer in the
+                     ring (fill_buffer).  If the track is out of data, repeat
+                     play restarts the track and play all moves to the next
+                     track, marking the last buffer filled as done (the end
+                     of the old data).  If there is data to read the number
+                     of blocks to read is returned through the passed pointer
+                     and TRUE is returned.  The reads start small after
+                     init_Play() and each one doubles fill_limit until it
+                     is a full buffer.  The buffer is pointed at its place
+                     in the ring (the first buffer may have been moved past
+                     a skip).  Otherwise it is the end of play and the
+                     empty buffer is put in the ring (there is no read to
+                     do) and FALSE is returned.
+
+   Arguments:        blocks (int *) - pointer to where to store the number
+                                      of blocks to read.
+   Return Value:     (char) - TRUE if there are blocks to read, FALSE if at
+                     the end of play.
+
+   Input:            The directory and ID3 tag may be read from the disk
+                     (next_track()).
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: buffer_blocks - accessed to get the buffer size.
+                     buffers       - the last buffer filled may be marked
+                                     done, the buffer filled is pointed at
+                                     its place in the ring.
+                     buffer_mem    - accessed to find the ring (PC only).
+                     end_play      - accessed and set at the end of play.
+                     fill_block    - set when restarting or changing tracks.
+                     fill_buffer   - accessed to find the last buffer filled.
+                     fill_bytes    - accessed and set when restarting or
+                                     changing tracks.
+                     fill_skip     - set when restarting or changing tracks.
+                     fill_limit    - accessed and doubled (up to a buffer).
+                     new_track     - set when the next track is started.
+                     old_data      - set when restarting or changing tracks.
+                     play_all      - accessed to determine if playing all
+                                     tracks.
+                     ring_depth    - accessed to wrap around the ring.
+                     rpt_play      - accessed to determine normal or repeat
+                                     play mode.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  char  fill_setup(int *blocks)
+{
+    /* variables */
+    int   last_buffer;          /* last buffer filled */
+
+    char  read_it;              /* there are blocks to read */
+
+
+
+    /* check if out of data on the track */
+    if (!end_play && (fill_bytes <= 0))  {
+
+        /* get the last buffer filled in case it's the end of the old data */
+        last_buffer = fill_buffer - 1;
+        if (last_buffer < 0)
+            last_buffer += ring_depth;
+
+        /* nothing left to play, check if repeating */
+        if (rpt_play)  {
+            /* repeating, so can reinitialize the track */
+            init_track();
+            /* the last block filled was the last one of the iteration */
+            buffers[last_buffer].done = TRUE;
+            old_data = TRUE;
+        }
+        else if (play_all && next_track())  {
+            /* playing all and have the next track (next_track() reset */
+            /*    its position) so get its play time for a block */
+            set_block_time();
+            /* the last block filled was the last one of the track */
+            buffers[last_buffer].done = TRUE;
+            old_data = TRUE;
+            /* and the next track isn't playing yet */
+            new_track = TRUE;
+        }
+        else  {
+            /* not repeating, we're done */
+            end_play = TRUE;
+        }
+
+        /* if still playing, read from the start of the track */
+        fill_start();
+    }
+
+
+    /* check if still playing */
+    if (!end_play)  {
+        /* compute the number of blocks to read */
+        *blocks = (fill_bytes + (2 * IDE_BLOCK_SIZE - 1)) / (2 * IDE_BLOCK_SIZE);
+        /* but only read up to a buffer's worth of blocks */
+        if (*blocks > buffer_blocks)
+            *blocks = buffer_blocks;
+        /* and no more than the current read size when starting up */
+        if (*blocks > fill_limit)
+            *blocks = fill_limit;
+
+        /* ramp up the read size, doubling it until it is a full buffer */
+        if (fill_limit < buffer_blocks)  {
+            fill_limit *= 2;
+            if (fill_limit > buffer_blocks)
+                fill_limit = buffer_blocks;
+        }
+
+        /* the buffer is its place in the ring (a skip may have moved it) */
+        buffers[fill_buffer].p = audio_dram((unsigned long int) fill_buffer * buffer_blocks * IDE_BLOCK_SIZE);
+
+        /* and its blocks have to be read */
+        read_it = TRUE;
+    }
+    else  {
+        /* at the end of play, need to play the empty buffer */
+        fill_done(0);
+        /* and there is nothing to read */
+        read_it = FALSE;
+    }
+
+
+    /* return whether there is something to read */
+    return  read_it;
+
+}
+
+
+
+
+/*
+   fill_start
+
+   Description:      This function sets up to start filling buffers at the
+                     current position on the track.  The position may be in
+                     the middle of a block (the start of the track's audio,
+                     or a frame found by fast forward or reverse), so the
+                     words of the block before it are skipped.  The bytes
+                     left to read are counted from the start of the block,
+                     up to the end of the track's audio.
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: fill_block - set to the block holding the position.
+                     fill_bytes - set to the bytes left from that block.
+                     fill_skip  - set to the words of the block to skip.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  fill_start()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* start at the block holding the current position */
+    fill_block = get_track_block_position();
+    /* skip the words of that block before the position */
+    fill_skip = (int) ((get_track_position() % (2 * IDE_BLOCK_SIZE)) / 2);
+
+    /* the bytes left count from the start of the block (if not at the end) */
+    fill_bytes = get_track_remaining_length();
+    if (fill_bytes > 0)
+        fill_bytes = get_track_length() - 2L * IDE_BLOCK_SIZE * fill_block;
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   fill_done
+
+   Description:      This function finishes filling the buffer fill_buffer
+                     with the passed number of blocks read and moves on to
+                     the next buffer in the ring.  The size of the buffer is
+                     set from the number of blocks read.
+                     If play started in the middle of a block the words
+                     before the start are skipped.  The frames in the data
+                     are added to the frame index.  If nothing was read
+                     it is the end of play and the empty buffer is played
+                     instead.  If the ring is to grow and fill_buffer is the
+                     last buffer of the ring, the new buffer is added after
+                     it.
+
+   Arguments:        blocks_read (int) - number of blocks read into the
+                                         buffer (0 if nothing).
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  A buffer is only added right after the last buffer
+                     of the ring as it is filled, so the buffers in use
+                     (which end with it) don't wrap around the ring and
+                     stay in order.
+
+   Shared Variables: buffer_blocks  - accessed to get the buffer size.
+                     buffers        - the buffer filled is updated.
+                     empty_buffer   - used if nothing was read.
+                     end_play       - set if nothing was read.
+                     fill_block     - updated past the blocks read.
+                     fill_buffer    - set to the next buffer to fill.
+                     fill_bytes     - updated past the blocks read.
+                     fill_count     - incremented.
+                     fill_skip      - accessed and cleared.
+                     grow_ring      - accessed and cleared when the ring
+                                      grows.
+                     ring_depth     - incremented when the ring grows.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  fill_done(int blocks_read)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* check if read anything */
+    if (blocks_read > 0)  {
+        /* did read something, store how much (words, not bytes) */
+        if (fill_bytes >= (2 * IDE_BLOCK_SIZE * blocks_read))
+            /* all of the blocks are data */
+            buffers[fill_buffer].size = blocks_read * IDE_BLOCK_SIZE;
+        else
+            /* only play the real data */
+            /* remember that buffer sizes are in words, not bytes */
+            buffers[fill_buffer].size = (fill_bytes + 1) / 2;
+        /* this block is not the last one */
+        buffers[fill_buffer].done = FALSE;
+
+        /* skip the start of the block if play starts in the middle of it */
+        if (fill_skip != 0)  {
+            buffers[fill_buffer].p += fill_skip;
+            buffers[fill_buffer].size -= fill_skip;
+        }
+
+        /* index the frames in the data (the position is in bytes) */
+        index_frames(buffers[fill_buffer].p, buffers[fill_buffer].size,
+                     2L * IDE_BLOCK_SIZE * fill_block + 2 * fill_skip);
+        fill_skip = 0;
+
+        /* and the next fill follows this one */
+        fill_block += blocks_read;
+        fill_bytes -= 2L * IDE_BLOCK_SIZE * blocks_read;
+    }
+    else  {
+        /* couldn't read anything, it is the end of play */
+        end_play = TRUE;
+        /* so need to play the empty buffer */
+        buffers[fill_buffer].p = empty_buffer;
+        buffers[fill_buffer].size = buffer_blocks * IDE_BLOCK_SIZE;
+        buffers[fill_buffer].done = TRUE;
+    }
+
+    /* the buffer is waiting to play */
+    fill_count++;
+
+
+    /* move to the next buffer to fill */
+    fill_buffer++;
+    /* check if wrapping around the end of the ring */
+    if (fill_buffer >= ring_depth)  {
+        /* at the end, grow here if need to */
+        if (grow_ring)  {
+            /* add the buffer, it is the one to fill */
+            ring_depth++;
+            grow_ring = FALSE;
+        }
+        else  {
+            /* not growing, wrap around */
+            fill_buffer = 0;
+        }
+    }
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   set_block_time
+
+   Description:      This function computes how long a block of the current
+                     track plays for from its length and total time.  If
+                     the track time isn't known a typical bit rate is
+                     assumed (DEF_BLOCK_TIME).
+
+   Arguments:        None.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: block_time - set to the play time of a block in ms.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  void  set_block_time()
+{
+    /* variables */
+    unsigned int  time;         /* total time of the track */
+    long int      blocks;       /* blocks in the track */
+
+
+
+    /* get the total time and size of the track */
+    time = get_track_total_time();
+    blocks = (get_track_length() - get_track_start() + (2 * IDE_BLOCK_SIZE - 1)) / (2 * IDE_BLOCK_SIZE);
+
+    /* compute the time for a block if the track time is known */
+    if ((time != TIME_NONE) && (time != 0) && (blocks > 0))
+        block_time = (time * TIME_SCALE) / blocks;
+    else
+        block_time = DEF_BLOCK_TIME;
+
+    /* make sure a block takes some time */
+    if (block_time == 0)
+        block_time = 1;
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   next_track
+
+   Description:      This function moves to the next track in the directory
+                     for playing all tracks.  Directories and empty files are
+                     skipped until a file with data is found, its track
+                     information is loaded (the track is at its start) and
+                     TRUE is returned.  If the end of the directory is
+                     reached first, the current entry is left unchanged and
+                     FALSE is returned.
+
+   Arguments:        None.
+   Return Value:     (char) - TRUE if moved to the next track, FALSE
+                     otherwise.
+
+   Input:            The directory and ID3 tag may be read from the disk.
+   Output:           None.
+
+   Error Handling:   If an entry can't be read it is treated as the end of
+                     the directory.
+
+   Algorithms:       At the end of the directory get_next_dir_entry() stays
+                     on the last entry and at_dir_end() reports it.
+   Data Structures:  None.
+
+   Shared Variables: None.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  char  next_track()
+{
+    /* variables */
+    int   moved = 0;                /* entries moved forward */
+    char  at_next;                  /* moved to the next entry */
+    char  have_track = FALSE;       /* have a next track to play */
+
+
+
+    /* move forward until find a track or the end of the directory */
+    do  {
+        /* try to move to the next entry, it moved unless there was an */
+        /*    error or it was already at the end of the directory */
+        at_next = !get_next_dir_entry() && !at_dir_end();
+
+        /* if it moved, it's a track if it is a file with something in it */
+        if (at_next)  {
+            moved++;
+            have_track = !cur_isDir() && (get_cur_file_size() > 0);
+        }
+
+    } while (at_next && !have_track);
+
+
+    /* check if have a track */
+    if (have_track)
+        /* have the next track, load its information */
+        setup_cur_track_info();
+    else if (moved > 0)
+        /* only moved onto things that can't be played, go back */
+        (void) move_dir_entry(-moved);
+
+
+    /* return whether moved to the next track */
+    return  have_track;
+
+}
+
+
+
+
+/*
+   audio_dram
+
+   Description:      This function returns a pointer to the passed word
+                     offset in the audio buffer DRAM (the memory allocated
+                     for the buffers in the PC version).
+
+   Arguments:        words (unsigned long int) - offset (in words) into the
+                                                 audio buffer DRAM.
+   Return Value:     (unsigned short int far *) - pointer to that word.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: buffer_mem - accessed to get the buffers (PC only).
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+static  unsigned short int far  *audio_dram(unsigned long int words)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* compute and return the pointer (remember the buffers are words) */
+#ifdef  PCVERSION
+    return  buffer_mem + words;
+#else
+    return  (unsigned short int far *) MAKE_FARPTR(DRAM_STARTSEG, words * sizeof(short int));
+#endif
+
+}
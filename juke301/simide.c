@@ -11,13 +11,15 @@
    This file contains a function for simulation an IDE hard drive for the MP3
    Jukebox project.  This function can be used to test the software without a
    physical hard drive being connected.  The functions included are:
-      get_blocks - retrieve blocks of data from the simulated hard drive.
+      get_blocks       - retrieve blocks of data from the simulated hard drive.
+      get_blocks_poll  - get the result of get_blocks_start().
+      get_blocks_start - start retrieving blocks from the simulated drive.
 
    The local functions included are:
       none
 
    The locally global variable definitions included are:
-      none
+      blocks_read      - number of blocks read by get_blocks_start()
 
 
    Revision History
@@ -38,6 +40,8 @@
                                  instead of bytes.
       3/20/13  Glen George       Updated the function to match the new code
                                  that uses ID3 tags and FAT entries.
+      6/7/16   Tim Liu           Added get_blocks_start() and get_blocks_poll()
+                                 to simulate asynchronous reads.
 */
 
 
@@ -61,6 +65,11 @@
 
 
 
+/* locally global variables */
+static  int  blocks_read;       /* blocks read by get_blocks_start() */
+
+
+
 
 /*
    get_blocks
@@ -421,3 +430,95 @@ int  get_blocks(unsigned long int block, int length, unsigned short int far *des
     return  no_blocks;
 
 }
+
+
+
+
+/*
+   get_blocks_start
+
+   Description:      This function simulates starting an asynchronous read of
+                     blocks from an IDE hard drive.  The simulated drive is
+                     always ready, so the blocks are read immediately with
+                     get_blocks() and the result is saved for
+                     get_blocks_poll().
+
+   Arguments:        block (unsigned long int)       - block number at which
+                                                       to start the read.
+                     length (int)                    - number of blocks to be
+                                                       read.
+                     dest (unsigned short int far *) - pointer to the memory
+                                                       where the read data is
+                                                       to be written.
+   Return Value:     None.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: blocks_read - set to the number of blocks read.
+
+   Author:           Tim Liu
+   Last Modified:    June 7, 2016
+
+*/
+
+void  get_blocks_start(unsigned long int block, int length, unsigned short int far *dest)
+{
+    /* variables */
+      /* none */
+
+
+
+    /* just do the read now and remember how much was read */
+    blocks_read = get_blocks(block, length, dest);
+
+
+    /* all done, return */
+    return;
+
+}
+
+
+
+
+/*
+   get_blocks_poll
+
+   Description:      This function returns the number of blocks read by the
+                     last call to get_blocks_start().  The simulated read is
+                     never busy so IDE_BUSY is never returned.
+
+   Arguments:        None.
+   Return Value:     (int) - number of blocks read.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: blocks_read - accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 7, 2016
+
+*/
+
+int  get_blocks_poll()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* return the result of the last read */
+    return  blocks_read;
+
+}
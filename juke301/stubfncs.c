@@ -23,6 +23,9 @@
       get_blocks     - get data from the hard drive
       audio_play     - start audio output
       audio_halt     - halt audio input or output
+      audio_queue    - queue a buffer for audio output
+      audio_done     - get the number of buffers output
+      audio_low      - check if the audio queue ran low
 
    The local functions included are:
       none
@@ -42,6 +45,8 @@
       4/29/06  Glen George       Updated definitions of get_blocks(),
                                  update(), and audio_play() to use words
 				 instead of bytes.
+      6/16/16  Tim Liu           Added audio_queue(), audio_done(), and
+                                 audio_low() for the audio descriptor queue.
 */
 
 
@@ -133,3 +138,18 @@ void  audio_halt()
     return;
 }
 
+unsigned char  audio_queue(unsigned short int far *p, int n, int end)
+{
+    return  FALSE;
+}
+
+int  audio_done()
+{
+    return  0;
+}
+
+unsigned char  audio_low()
+{
+    return  FALSE;
+}
+
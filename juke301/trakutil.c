@@ -17,9 +17,11 @@
       get_track_position         - get the current position on the track
       get_track_block_position   - get the current block position on the track
       get_track_remaining_length - get number of bytes left on current track
+      get_track_start            - get where the audio starts on the track
       get_track_time             - return the current time for a track
       get_track_total_time       - return the total time for a track
       get_track_title            - return the title of the current track
+      get_track_toc              - return the seek table of the current track
       init_track                 - initialize to the start of the track
       init_tracks                - initialize the track information
       setup_cur_track_info       - setup info buffer for current track
@@ -89,12 +91,47 @@
       3/15/13  Glen George       Changed functions to use ID3 tags to get song
                                  information instead of the filename and to
                                  handle new track_header structure.
+      6/16/16  Tim Liu           Changed get_track_time() to get the time in
+                                 the middle of a track from the frame index
+                                 (so it is right for variable bit rates).
+      6/16/16  Tim Liu           setup_cur_track_info() probes the first frame
+                                 of a file (probe_track()) for its time,
+                                 frame count, bit rate, and seek table, the
+                                 time is used if the ID3 tag doesn't have
+                                 one.  Added get_track_toc() (and #include
+                                 of stddef.h for NULL).
+      6/16/16  Tim Liu           The track only covers the audio in the file:
+                                 it starts after any ID3v2 tag (at the first
+                                 frame found by probe_track()) and its length
+                                 ends before any ID3v1 tag.  Added
+                                 get_track_start().
+      6/16/16  Tim Liu           setup_cur_track_info() uses the title and
+                                 artist from an ID3v2 tag (found by
+                                 probe_track()) and only reads the ID3 tag at
+                                 the end of the file if there isn't one.
+      6/16/16  Tim Liu           Fixed the <null> at the end of a filename
+                                 title being written past the end of the
+                                 title, removed the declaration of the
+                                 get_track_info() function that no longer
+                                 exists (a warning in the Linux host build).
+      6/16/16  Tim Liu           setup_cur_track_info() uses the probe
+                                 results saved in the library index
+                                 (get_saved_probe()) instead of probing the
+                                 file when they are there.
+      6/16/16  Tim Liu           setup_cur_track_info() always checks the end
+                                 of the file for an ID3v1 tag (so the track
+                                 length always ends before it), an ID3v2
+                                 title only decides where the title and
+                                 artist come from.
+      6/16/16  Tim Liu           setup_cur_track_info() saves the probe
+                                 results (save_probe()) so they are cached
+                                 with the ID3 tag.
 */
 
 
 
 /* library include files */
-  /* none */
+#include  <stddef.h>
 
 /* local include files */
 #include  "interfac.h"
@@ -103,6 +140,7 @@
 #include  "fatutil.h"
 #include  "vfat.h"
 #include  "id3info.h"
+#include  "frameidx.h"
 
 
 
@@ -116,7 +154,7 @@ static char                 track_info_buffer[MAX_LFN_LEN + 2]; /* buffer holdin
 
 
 /* local function declarations */
-void  get_track_info(void);      /* read the track information from disk */
+  /* none */
 
 
 
@@ -126,7 +164,8 @@ void  get_track_info(void);      /* read the track information from disk */
 
    Description:      This function initializes the current track to the start
                      of the track.  The current position (curpos element) is
-                     set to the start of the track.
+                     set to the start of the track's audio (after any ID3v2
+                     tag).
 
    Arguments:        None.
    Return Value:     None.
@@ -139,10 +178,11 @@ void  get_track_info(void);      /* read the track information from disk */
    Algorithms:       None.
    Data Structures:  None.
 
-   Shared Variables: track_info - the curpos element is reset.
+   Shared Variables: track_info - the curpos element is reset to the start
+                                  element.
 
    Author:           Glen George
-   Last Modified:    June 6, 2000
+   Last Modified:    June 16, 2016
 
 */
 
@@ -154,7 +194,7 @@ void  init_track()
 
 
     /* initialize the current position to the start of the track */
-    track_info.curpos = 0;
+    track_info.curpos = track_info.start;
 
 
     /* all done, return */
@@ -243,6 +283,47 @@ const char *  get_track_title()
 
 
 
+/*
+   get_track_start
+
+   Description:      This function returns where the audio starts on the
+                     current track (after any ID3v2 tag).  This is the
+                     position of the start of the track.
+
+   Arguments:        None.
+   Return Value:     (long int) - offset (in bytes) of the start of the audio
+                     in the file.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: track_info - the start element is returned.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+long int  get_track_start()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* just return the start of the audio */
+    return  track_info.start;
+
+}
+
+
+
+
 /*
    get_track_length
 
@@ -354,8 +435,7 @@ long int  get_track_block_position()
 
 
     /* return the current position (within the file, in blocks) */
-    /* this assumes that only complete blocks are read, thus curpos */
-    /*    is evenly divisible by IDE_BLOCK_SIZE                     */
+    /* this is the block holding curpos, it may be in the middle of it */
     /* remember that IDE_BLOCK_SIZE is in words, but curpos is in bytes */
     return  track_info.curpos / (2 * IDE_BLOCK_SIZE);
 
@@ -417,9 +497,9 @@ long int  get_track_remaining_length()
 
    Description:      This function returns the current time (time remaining)
                      for the passed track.  If the track has a total time
-                     defined for it, the current time is computed by taking
-                     the ratio of the current position to the total track
-                     length and multiplying that by the total time.
+                     defined for it, the current time is computed by
+                     subtracting the time at the current position (from the
+                     frame index) from the total time.
 
    Arguments:        None.
    Return Value:     (int) - the remaining time for the passed track (in
@@ -429,7 +509,7 @@ long int  get_track_remaining_length()
    Input:            None.
    Output:           None.
 
-   Error Handling:   There is no checking for overflow.
+   Error Handling:   The remaining time is limited to be at least 0.
 
    Algorithms:       None.
    Data Structures:  None.
@@ -438,14 +518,14 @@ long int  get_track_remaining_length()
                                   curpos, and length elements.
 
    Author:           Glen George
-   Last Modified:    March 15, 2013
+   Last Modified:    June 16, 2016
 
 */
 
 int  get_track_time()
 {
     /* variables */
-      /* none */
+    long int  time_left;        /* time remaining in the middle of a track */
 
 
 
@@ -454,12 +534,17 @@ int  get_track_time()
     if ((track_info.time != TIME_NONE) && (track_info.time != 0) && (track_info.length > track_info.time))  {
         /* have time on the track, compute time remaining */
         /* check if at start of the track or in middle */
-        if (track_info.curpos == 0)
+        if (track_info.curpos <= track_info.start)
             /* at start, just return total time */
             return  track_info.time;
-        else
-            /* in middle, compute time remaining */
-            return  (track_info.length - track_info.curpos) / (track_info.length / track_info.time);
+        else  {
+            /* in middle, compute time remaining from the time at this position */
+            time_left = track_info.time - frame_time(track_info.curpos) / TIME_SCALE;
+            /* the estimate could be past the end of the track */
+            if (time_left < 0)
+                time_left = 0;
+            return  (int) time_left;
+        }
     }
     else  {
         /* else, no time or length information on track - return it (0 or TIME_NONE) */
@@ -511,6 +596,53 @@ int  get_track_total_time()
 
 
 
+/*
+   get_track_toc
+
+   Description:      This function returns the seek table for the current
+                     track (from its Xing header).  The table has the
+                     position (in 256ths of the track length) at each
+                     percent (SEEK_TOC_SIZE entries) of the track's time.
+
+   Arguments:        None.
+   Return Value:     (const unsigned char *) - the seek table, NULL if the
+                     track doesn't have one or its time isn't known.
+
+   Input:            None.
+   Output:           None.
+
+   Error Handling:   None.
+
+   Algorithms:       None.
+   Data Structures:  None.
+
+   Shared Variables: track_info - the has_toc, toc, time, and length elements
+                                  are accessed.
+
+   Author:           Tim Liu
+   Last Modified:    June 16, 2016
+
+*/
+
+const unsigned char  *get_track_toc()
+{
+    /* variables */
+      /* none */
+
+
+
+    /* only have a usable table if know the time and length */
+    if (track_info.has_toc && (track_info.time != TIME_NONE) &&
+        (track_info.time != 0) && (track_info.length > 0))
+        return  track_info.toc;
+    else
+        return  NULL;
+
+}
+
+
+
+
 /*
    update_track_position
 
@@ -547,8 +679,8 @@ void  update_track_position(long int delta)
     track_info.curpos += delta;
 
     /* make sure not out of range */
-    if (track_info.curpos < 0)
-        track_info.curpos = 0;
+    if (track_info.curpos < track_info.start)
+        track_info.curpos = track_info.start;
     if (track_info.curpos > track_info.length)
         track_info.curpos = track_info.length;
 
@@ -566,8 +698,18 @@ void  update_track_position(long int delta)
 
    Description:      This function loads the information for the current
                      track/file from the hard drive and initializes the track
-                     information data structure.  The track is positioned to
-                     the start of the track.
+                     information data structure.  For a file the first frame
+                     is probed for the frame count, bit rate, seek table,
+                     and time (used if the ID3 tag has no time), unless the
+                     probe results are saved (in the library index).  The
+                     ID3 tag at the end of the file is always checked for
+                     (from the library index, the tag cache, or one sector
+                     read) so the track covers only the audio, from the
+                     first frame (after any ID3v2 tag) to before any ID3v1
+                     tag.  If the probe finds an ID3v2 tag with a title, the
+                     title and artist come from it, otherwise from the ID3
+                     tag at the end or the filename.  The track is
+                     positioned to the start of the track.
 
    Arguments:        None.
    Return Value:     None.
@@ -584,7 +726,7 @@ void  update_track_position(long int delta)
                      track_info_buffer - updated.
 
    Author:           Glen George
-   Last Modified:    March 15, 2013
+   Last Modified:    June 16, 2016
 
 */
 
@@ -592,6 +734,9 @@ void  setup_cur_track_info()
 {
     /* variables */
     char         have_ID3_tag;  /* keep track of if have ID3 tag or not */
+    char         have_ID3v2_tag;/* have an ID3v2 tag with a title */
+
+    unsigned int  probe_time;   /* time probed from the first frame */
 
     const char  *s;             /* general string pointer */
 
@@ -600,25 +745,74 @@ void  setup_cur_track_info()
 
 
     /* get the track/file information from either the disk directory */
-    /* information (directories) or the ID3 tag in the file          */
+    /* information (directories), an ID3v2 tag at the start of the file, */
+    /* or the ID3 tag at the end of the file                             */
+
+    /* fill in the numeric values from directory information */
+    /* length (in bytes) of the song/file */
+    track_info.length = get_cur_file_size();
+    /* and starts at the start of the file unless probing finds otherwise */
+    track_info.start = 0;
+
+    /* no tags yet */
+    have_ID3v2_tag = FALSE;
+    have_ID3_tag = FALSE;
 
-    /* first get the filename or ID3 tag */
 
-    /* if not a directory should try to get an ID3 tag */
-    if (!cur_isDir())  {
-        /* it is a file so get the ID3 tag */
+    /* get the time and tags for a song/file - watch out for directories */
+    if (cur_isDir())  {
+        /* currently on a directory, not a song - so there is no time */
+        track_info.time = TIME_NONE;
+        /* or anything else about frames */
+        track_info.frames = 0;
+        track_info.bit_rate = 0;
+        track_info.has_toc = FALSE;
+    }
+    else  {
+        /* on a song/file - probe the first frame for its time, frame count, */
+        /*    bit rate, seek table, and where the audio starts, this also */
+        /*    gets the title and artist from an ID3v2 tag (the file isn't */
+        /*    read if the probe results are saved) */
+        if (get_saved_probe(&track_info))
+            probe_time = track_info.time;
+        else
+            probe_time = probe_track(&track_info);
+        have_ID3v2_tag = (track_info.title[0] != '\0');
+
+        /* always check for an ID3 tag at the end of the file, even with */
+        /*    an ID3v2 title, since the audio ends before it */
         get_ID3_tag(track_info_buffer);
         /* check if actually got an ID3 tag */
         have_ID3_tag = ((track_info_buffer[0] == 'T') &&
                         (track_info_buffer[1] == 'A') &&
                         (track_info_buffer[2] == 'G'));
+
+        /* save the probe results so coming back to the track (with its */
+        /*    tag cached now) doesn't read the file */
+        save_probe(&track_info, probe_time);
+
+        /* the audio ends before an ID3 tag at the end of the file */
+        if (have_ID3_tag && (track_info.length >= ID3_TAG_SIZE))
+            track_info.length -= ID3_TAG_SIZE;
+
+        /* get the length (in tenths of seconds) */
+        if (have_ID3_tag && (track_info_buffer[ID3_TAG_TIME_OFFSET] == 0) &&
+            ((track_info_buffer[ID3_TAG_TIME_OFFSET + 1] & 0xC0) == 0x40) &&
+            ((track_info_buffer[ID3_TAG_TIME_OFFSET + 2] & 0xC0) == 0x40) &&
+            ((track_info_buffer[ID3_TAG_TIME_OFFSET + 3] & 0xC0) == 0x40))
+            /* have an ID3 tag and time is stored there (our extension of ID3) */
+            track_info.time = 10 * (((track_info_buffer[ID3_TAG_TIME_OFFSET + 1] & 0x3F) << 12) |
+                                    ((track_info_buffer[ID3_TAG_TIME_OFFSET + 2] & 0x3F) << 6) |
+                                    (track_info_buffer[ID3_TAG_TIME_OFFSET + 3] & 0x3F));
+        else
+            /* no ID3 tag time information so use the probed time (0 if */
+            /*    it couldn't be found) */
+            track_info.time = probe_time;
     }
 
-    /* if a directory or didn't get an ID3 tag, get the filename */
-    if (cur_isDir() || !have_ID3_tag)  {
 
-        /* don't have an ID3 tag */
-        have_ID3_tag = FALSE;
+    /* if a directory or didn't get any ID3 tag, get the filename */
+    if (!have_ID3v2_tag && !have_ID3_tag)  {
 
         /* need to get the filename */
         s = get_cur_file_name();
@@ -645,37 +839,14 @@ void  setup_cur_track_info()
     }
 
 
-    /* fill in the numeric values from directory information */
-    /* length (in bytes) of the song/file */
-    track_info.length = get_cur_file_size();
+    /* now setup the title and artist */
 
+    /* check if there is an ID3 tag (an ID3v2 title comes first) */
+    if (have_ID3v2_tag)  {
 
-    /* get the time from the ID3 tag if it exists */
-    /* length (in time) of the song/file - watch out for directories */
-    if (cur_isDir())  {
-        /* currently on a directory, not a song - so there is no time */
-        track_info.time = TIME_NONE;
+        /* the title and artist are already set from the ID3v2 tag */
     }
-    else  {
-        /* on a song/file - get the length (in tenths of seconds) */
-        if (have_ID3_tag && (track_info_buffer[ID3_TAG_TIME_OFFSET] == 0) &&
-            ((track_info_buffer[ID3_TAG_TIME_OFFSET + 1] & 0xC0) == 0x40) &&
-            ((track_info_buffer[ID3_TAG_TIME_OFFSET + 2] & 0xC0) == 0x40) &&
-            ((track_info_buffer[ID3_TAG_TIME_OFFSET + 3] & 0xC0) == 0x40))
-            /* have an ID3 tag and time is stored there (our extension of ID3) */
-            track_info.time = 10 * (((track_info_buffer[ID3_TAG_TIME_OFFSET + 1] & 0x3F) << 12) |
-                                    ((track_info_buffer[ID3_TAG_TIME_OFFSET + 2] & 0x3F) << 6) |
-                                    (track_info_buffer[ID3_TAG_TIME_OFFSET + 3] & 0x3F));
-        else
-            /* no ID3 tag time information so set the time to 0 */
-            track_info.time = 0;
-    }
-
-
-    /* now setup the title and artist */
-
-    /* check if there is an ID3 tag */
-    if (have_ID3_tag)  {
+    else if (have_ID3_tag)  {
 
         /* have an ID3 tag, copy the title from it */
         strncpy(track_info.title, &(track_info_buffer[ID3_TAG_TITLE_OFFSET]),
@@ -694,7 +865,7 @@ void  setup_cur_track_info()
         /* no ID3 tag so the title is the filename */
         strncpy(track_info.title, track_info_buffer, MAX_TITLE_LEN);
         /* make sure it is <null> terminated */
-        track_info.title[MAX_TITLE_LEN] = '\0';
+        track_info.title[MAX_TITLE_LEN - 1] = '\0';
 
         /* there is no artist in this case */
         track_info.artist[0] = '\0';
@@ -702,7 +873,7 @@ void  setup_cur_track_info()
 
 
     /* always reset to the start of the track */
-    track_info.curpos = 0;
+    track_info.curpos = track_info.start;
 
 
     /* finally done so return */
@@ -735,7 +906,7 @@ void  setup_cur_track_info()
    Shared Variables: track_info - updated.
 
    Author:           Glen George
-   Last Modified:    March 15, 2013
+   Last Modified:    June 16, 2016
 
 */
 
@@ -747,8 +918,12 @@ void  setup_error_track_info()
 
 
     /* fill in the track information buffer */
+    track_info.start = 0;
     track_info.length = 9999;
     track_info.time = TIME_NONE;
+    track_info.frames = 0;
+    track_info.bit_rate = 0;
+    track_info.has_toc = FALSE;
 
     /* use "Error" for title and artist */
     track_info.title[0] = 'E';
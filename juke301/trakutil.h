@@ -32,6 +32,10 @@
                                  setup_error_track_info() and removed
                                  constants associated with old index file
                                  scheme for getting song information.
+      6/16/16  Tim Liu           Added function prototype for
+                                 get_track_toc().
+      6/16/16  Tim Liu           Added function prototype for
+                                 get_track_start().
 */
 
 
@@ -75,12 +79,14 @@ void  update_track_position(long int);  /* update the current position of the tr
 /* track accessor functions */
 long int     get_track_position(void);          /* get the current position of the track (relative to start in bytes) */
 long int     get_track_block_position(void);    /* get the current position of the track (in blocks on hard drive) */
-long int     get_track_length(void);            /* get the length of the track */
+long int     get_track_start(void);             /* get where the audio starts on the track */
+long int     get_track_length(void);            /* get the length of the track (where the audio ends) */
 long int     get_track_remaining_length(void);  /* get the remaining length of the track */
 const char  *get_track_title(void);             /* get the title of the track */
 const char  *get_track_artist(void);            /* get the artist for the track */
 int          get_track_time(void);              /* get the current time for the track */
 int          get_track_total_time(void);        /* get the total time for the track */
+const unsigned char  *get_track_toc(void);      /* get the seek table for the track */
 
 /* setup functions */
 void   setup_cur_track_info(void);              /* setup information for current track/file */
@@ -17,6 +17,7 @@
       6/4/00   Glen George       Initial revision (from the 3/6/99 version of
                                  updatfnc.h for the Digital Audio Recorder
                                  Project).
+      6/16/16  Tim Liu           Added declaration for set_play_buffers().
 */
 
 
@@ -53,5 +54,7 @@ enum status  update_Play(enum status);     /* update play, fill another buffer *
 enum status  update_FastFwd(enum status);  /* update fast forward, decrement the time */
 enum status  update_Reverse(enum status);  /* update reverse, increment the time */
 
+char         set_play_buffers(int, int);   /* set the play buffer ring depth and size */
+
 
 #endif
@@ -52,6 +52,10 @@
                                 instead of word indices).
       3/15/13  Glen George      Added constants, macros, and structures to
                                 support FAT32.
+      6/12/16  Tim Liu          Added FDATE macro.
+      6/16/16  Tim Liu          Added DELETED_ENTRY.
+      6/16/16  Tim Liu          Added FAT32_MASK and masked FAT32_BAD to the
+                                28 bits of a FAT32 entry.
 */
 
 
@@ -101,7 +105,10 @@
 
 /* bad cluster marker for FAT16 and FAT32 */
 #define  FAT16_BAD  0xFFF7
-#define  FAT32_BAD  0xFFFFFFF7
+#define  FAT32_BAD  0x0FFFFFF7
+
+/* only the low 28 bits of a FAT32 entry are the cluster number */
+#define  FAT32_MASK  0x0FFFFFFFUL
 
 
 /* directory constants */
@@ -112,6 +119,9 @@
 /* directory entries per sector */
 #define  ENTRIES_PER_SECTOR (IDE_BLOCK_SIZE / DIR_ENTRY_SIZE)
 
+/* first filename character of a deleted entry */
+#define  DELETED_ENTRY      0xE5
+
 
 /* length of filenames of extensions in DOS (standard 8.3 filename) */
 #define  DOS_FILENAME_LEN   8
@@ -347,6 +357,7 @@ union  VFAT_dir_entry  {
   #define  EXTENSION(e, i)     ((((e).words[4 + ((i) / 2)]) >> (8 * ((i) % 2))) & 0xFF)
   #define  ATTR(e)             (((e).words[5] >> 8) & 0xFF)
   #define  FTIME(e)            (((e).words[11]) & 0xFFFF)
+  #define  FDATE(e)            (((e).words[12]) & 0xFFFF)
   #define  FSIZE(e)            (((long int) (((e).words[14]) & 0xFFFF)) | (((long int) (((e).words[15]) & 0xFFFF)) << 16))
   #define  START_CLUSTER(e)    (((e).words[13]) & 0xFFFF)
   #define  START_CLUSTER32(e)  (((long int) (((e).words[13]) & 0xFFFF)) | (((long int) (((e).words[10]) & 0xFFFF)) << 16))
@@ -361,6 +372,7 @@ union  VFAT_dir_entry  {
   #define  EXTENSION(e, i)     ((e).d.extension[i])
   #define  ATTR(e)             ((e).d.attr)
   #define  FTIME(e)            ((e).d.tstamp.time)
+  #define  FDATE(e)            ((e).d.tstamp.date)
   #define  FSIZE(e)            ((e).d.size)
   #define  START_CLUSTER(e)    ((e).d.start_cluster)
   #define  START_CLUSTER32(e)  (((long int) ((e).f.start_cluster_lo)) | ((long int) ((e).f.start_cluster_hi) << 16))
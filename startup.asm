@@ -29,6 +29,8 @@
 ;    5/7/16   Tim Liu       Added call to InitClock
 ;    5/19/16  Tim Liu       Added commented out call to InstallDreqHandler
 ;    5/30/16  Tim Liu       Removed commented out external function calls
+;    6/7/16   Tim Liu       Added calls to install and initialize IDE interrupts
+;    6/16/16  Tim Liu       Added call to InitAudioDMA
 ; local include files
 
 $INCLUDE(INITREG.INC)
@@ -61,6 +63,9 @@ CODE    SEGMENT  WORD  PUBLIC  'CODE'
         EXTRN    InstallTimer1Handler:NEAR  ;install timer 1 handler
         EXTRN    InitTimer1:NEAR            ;start up timer 1
         EXTRN    InstallDreqHandler:NEAR    ;install audio data request handler
+        EXTRN    InstallIDEHandlers:NEAR    ;install IDE and DMA0 handlers
+        EXTRN    InitIDE:NEAR               ;initialize IDE reads and interrupts
+        EXTRN    InitAudioDMA:NEAR          ;select MP3 data output mode
 
 START:
 
@@ -94,6 +99,9 @@ BEGIN:                                  ;start the program
         CALL    InitTimer0              ;initialize timer0 for button interrupt
         CALL    InitTimer1              ;initialize timer1 for DRAM refresh
         CALL    InstallDreqHandler      ;install handler for audio data request
+        CALL    InitAudioDMA            ;set up DMA1 or bit-bang audio output
+        CALL    InstallIDEHandlers      ;install handlers for IDE reads
+        CALL    InitIDE                 ;initialize IDE reads and interrupts
 
         STI                             ;enable interrupts
 
@@ -30,6 +30,7 @@
 ;       4/5/16      Tim Liu     Changed name to Timer0M for MP3 player
 ;       4/21/16     Tim Liu     Changed MuxKeypandEventHandler to ButtonEH
 ;       5/5/16      Tim Liu     Added call to UpdateClock to ButtonEH
+;       6/8/16      Tim Liu     Added call to IDETimerTick to ButtonEH
 
 
 ; local include files
@@ -51,6 +52,7 @@ CODE SEGMENT PUBLIC 'CODE'
 
         EXTRN       ButtonDebounce:NEAR      ;scan and check keypad
         EXTRN       UpdateClock:NEAR         ;update clock tracking milliseconds
+        EXTRN       IDETimerTick:NEAR        ;IDE command retry and timeout
 
 
 ; InitTimer0
@@ -129,13 +131,15 @@ InitTimer0       ENDP
 ;                    calls ButtonDebounce. Every call to ButtonDebounce
 ;                    scans the buttons and checks for a button press.
 ;                    The procedure also calls UpdateClock, which updates
-;                    the number of milliseconds that have elapsed.
-;                    The function then pops the stack
+;                    the number of milliseconds that have elapsed, and
+;                    IDETimerTick, which retries IDE commands and times
+;                    out stuck IDE reads. The function then pops the stack
 ;                    and sends an EOI.
 ;
 ; Operation:         Save all the registers and call ButtonDebounce to scan 
 ;                    the 8 UI buttons for key presses. Call UpdateClock
-;                    to increment the MP3 timer Send an EOI at the end.
+;                    to increment the MP3 timer and IDETimerTick to count
+;                    down the IDE timeout. Send an EOI at the end.
 ;                    
 ; Arguments:         None.
 ; Return Value:      None.
@@ -154,7 +158,7 @@ InitTimer0       ENDP
 ; Registers Changed: None
 ;
 ; Author:            Timothy Liu
-; Last Modified:     5/5/16
+; Last Modified:     6/8/16
 
 ButtonEH                    PROC    NEAR
                             PUBLIC  ButtonEH
@@ -164,6 +168,7 @@ ButtonEH                    PROC    NEAR
         PUSH    DX                      ;
         Call    ButtonDebounce          ;check the keypad
         CALL    UpdateClock             ;increment milliseconds elapsed
+        CALL    IDETimerTick            ;retry or time out IDE commands
 
 
 EndButtonEH:                            ;done taking care of the timer